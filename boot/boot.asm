@@ -216,5 +216,97 @@ isr_common_stub:
     add esp, 8                    ; Pop int_no and err_code
     iret
 
+; Fast syscall entry (SYSENTER). IA32_SYSENTER_ESP tracks the current task's
+; kernel stack top (see vsyscall_set_kernel_stack). The vsyscall trampoline
+; has already saved ecx/edx/ebp on the user stack and put the user esp in
+; ebp, so this builds the same frame int 0x80 would and reuses the C path.
+SYSENTER_FRAME equ 2                ; err_code tag: entered through SYSENTER
+
+global sysenter_entry
+global sysenter_entry_end
+extern sysenter_return_eip
+sysenter_entry:
+    push dword 0x23                 ; user ss
+    push ebp                        ; user esp
+sysenter_entry_end:                 ; a TF trap lands before here (see interrupts.c)
+    pushfd
+    or dword [esp], 0x200           ; user code runs with IF set
+    push dword 0x1B                 ; user cs
+    push dword [sysenter_return_eip]
+    push dword SYSENTER_FRAME
+    push dword 0x80
+    pusha
+    push ds
+    push es
+    push fs
+    push gs
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    cld
+    push esp
+    call interrupt_handler
+    add esp, 4
+    mov esp, eax
+    ; SYSEXIT can only return to the trampoline, in user mode, without TF/NT.
+    ; Anything else (signal delivery, execve, a switch to a task that entered
+    ; through an interrupt) goes out through iret.
+    mov eax, [sysenter_return_eip]
+    cmp [esp + 56], eax             ; frame->eip
+    jne .iret
+    cmp dword [esp + 60], 0x1B      ; frame->cs
+    jne .iret
+    test dword [esp + 64], 0x4100   ; frame->eflags: NT | TF
+    jnz .iret
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popa
+    add esp, 8                      ; int_no, err_code
+    ; The trampoline restores ecx/edx itself, so they carry eip/esp here.
+    mov edx, [esp]                  ; eip
+    mov ecx, [esp + 12]             ; user esp
+    and dword [esp + 8], ~0x200
+    push dword [esp + 8]
+    popfd
+    sti                             ; takes effect after SYSEXIT
+    sysexit
+.iret:
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popa
+    add esp, 8
+    iret
+
+; vsyscall page templates, copied to VDSO_SYSCALL_VA by vsyscall_init().
+; Both preserve every register but eax, like int 0x80.
+global vsyscall_sysenter_start
+global vsyscall_sysenter_ret
+global vsyscall_sysenter_end
+global vsyscall_int80_start
+global vsyscall_int80_end
+vsyscall_sysenter_start:
+    push ecx
+    push edx
+    push ebp
+    mov ebp, esp
+    sysenter
+vsyscall_sysenter_ret:
+    pop ebp
+    pop edx
+    pop ecx
+    ret
+vsyscall_sysenter_end:
+
+vsyscall_int80_start:
+    int 0x80
+    ret
+vsyscall_int80_end:
+
 ; Mark stack as non-executable (for linker)
 section .note.GNU-stack noalloc noexec nowrite progbits
@@ -0,0 +1,35 @@
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include "types.h"
+
+// Sector buffer cache shared by the disk filesystems (minixfs, fatdisk).
+// Buffers are hashed by (device, LBA) and recycled in LRU order. Writes
+// only dirty the buffer; a kernel thread writes back buffers that have been
+// dirty for BCACHE_FLUSH_MS, and bcache_sync() writes everything out.
+//
+// Like the filesystems above it, the cache is not reentrant: callers run
+// with interrupts off (syscall context or the flush thread).
+
+#define BCACHE_SECTOR_SIZE 512u
+#define BCACHE_BUFFERS     256u
+#define BCACHE_FLUSH_MS    2000u
+
+// The primary ATA disk, the only block device so far.
+#define BCACHE_DEV_ATA0 0u
+
+typedef struct bcache_stats {
+    uint32_t buffers;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t writebacks;   // sectors written to the device
+    uint32_t dirty;        // buffers waiting for write-back
+} bcache_stats_t;
+
+bool bcache_read(uint32_t dev, uint32_t lba, void* out);
+bool bcache_write(uint32_t dev, uint32_t lba, const void* in);
+// Write back every dirty buffer, then flush the drive's own cache.
+bool bcache_sync(void);
+void bcache_get_stats(bcache_stats_t* out);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include "types.h"
+#include "vfs.h"
+
+// Dentry cache in front of the VFS backends. Each entry caches the result
+// of looking up one name in its parent directory: the backend, node and
+// file type it names, or that it does not exist (a negative entry).
+// Entries form a tree rooted at "/", hashed by (parent, name), so resolving
+// a path is one hash probe per component once it is warm.
+//
+// Backends report namespace changes: minixfs names the directory entry
+// that changed, ramfs (whose directories are implicit) only that something
+// changed. Invalidating an entry also invalidates everything below it.
+// Like the VFS, the cache runs with interrupts off.
+
+#define DCACHE_ENTRIES 512u
+
+enum {
+    DCACHE_FS_INITRAMFS = 0,
+    DCACHE_FS_RAMFS = 1,
+    DCACHE_FS_MINIXFS = 2,
+    DCACHE_FS_COUNT = 3,
+};
+
+typedef enum {
+    DENTRY_UNKNOWN = 0,
+    DENTRY_NEGATIVE,
+    DENTRY_POSITIVE,
+} dentry_state_t;
+
+typedef struct dentry {
+    struct dentry* parent;          // NULL for "/"
+    struct dentry* hash_next;
+    struct dentry* lru_prev;        // towards the most recently used
+    struct dentry* lru_next;
+    uint32_t children;              // entries pointing here; only leaves are evicted
+    uint32_t epoch;                 // bumped when invalidated
+    uint32_t parent_epoch;          // parent's epoch when this was filled
+    uint32_t fs_gen;                // backend generation when filled
+    uint32_t name_hash;
+    dentry_state_t state;
+    uint8_t fs;                     // DCACHE_FS_*
+    bool is_dir;
+    bool is_symlink;
+    uint32_t node;                  // minixfs inode number, 0 elsewhere
+    char name[VFS_NAME_MAX];
+} dentry_t;
+
+dentry_t* dcache_root(void);
+// Find or add the entry for `name` (`len` bytes, not NUL-terminated) under
+// `parent`. A new entry is DENTRY_UNKNOWN. NULL if the name is too long or
+// every entry is in use.
+dentry_t* dcache_child(dentry_t* parent, const char* name, uint32_t len);
+// True if `d` holds a lookup result that is still current.
+bool dcache_valid(const dentry_t* d);
+void dcache_set_negative(dentry_t* d, uint8_t fs);
+void dcache_set_positive(dentry_t* d, uint8_t fs, uint32_t node, bool is_dir, bool is_symlink);
+
+// Notifications from the backends.
+void dcache_dir_changed(uint8_t fs, uint32_t dir_node, const char* name);
+void dcache_fs_changed(uint8_t fs);
+// Mounts or the root changed.
+void dcache_invalidate_all(void);
+
+#endif
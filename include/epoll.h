@@ -0,0 +1,44 @@
+#ifndef EPOLL_H
+#define EPOLL_H
+
+#include "types.h"
+#include "pollwait.h"
+
+// epoll instances. Each watched descriptor hooks an item onto its object's
+// poll head; a wakeup moves the item to the ready list, so epoll_wait only
+// looks at descriptors that changed. Level-triggered items stay on the list
+// while they are ready; EPOLLET items are reported once per wakeup.
+
+#define EPOLL_IN      POLL_IN
+#define EPOLL_OUT     POLL_OUT
+#define EPOLL_ERR     POLL_ERR
+#define EPOLL_HUP     POLL_HUP
+#define EPOLL_ONESHOT 0x40000000u
+#define EPOLL_ET      0x80000000u
+
+enum {
+    EPOLL_CTL_ADD = 1,
+    EPOLL_CTL_DEL = 2,
+    EPOLL_CTL_MOD = 3,
+};
+
+// Matches the user ABI (packed, as on Linux/i386).
+typedef struct __attribute__((packed)) epoll_event_user {
+    uint32_t events;
+    uint64_t data;
+} epoll_event_user_t;
+
+typedef struct epoll epoll_t;
+
+epoll_t* epoll_create(void);
+void epoll_get(epoll_t* ep);
+void epoll_put(epoll_t* ep);
+poll_head_t* epoll_poll_head(epoll_t* ep);
+bool epoll_has_ready(epoll_t* ep);
+
+// `fd` is a descriptor of the calling process.
+int32_t epoll_ctl(epoll_t* ep, int32_t op, int32_t fd, const epoll_event_user_t* ev);
+// Returns the number of events stored, 0 on timeout, or -errno.
+int32_t epoll_wait(epoll_t* ep, epoll_event_user_t* events_user, int32_t max, int32_t timeout_ms);
+
+#endif
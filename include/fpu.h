@@ -0,0 +1,32 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include "types.h"
+
+// FXSAVE image (also big enough for the legacy FNSAVE layout).
+#define FPU_STATE_SIZE 512u
+
+typedef struct fpu_state {
+    uint8_t data[FPU_STATE_SIZE];
+} __attribute__((aligned(16))) fpu_state_t;
+
+// Enable the x87 FPU and, when present, SSE (CR4.OSFXSR/OSXMMEXCPT), then
+// set CR0.TS so the first FPU instruction of any task raises #NM.
+void fpu_init(void);
+
+bool fpu_present(void);
+bool fpu_has_sse(void);
+
+// Copy the power-on register image (FNINIT + default MXCSR) into `st`.
+void fpu_init_state(fpu_state_t* st);
+
+// Save the live registers to `st` / load them from `st`. fpu_save() leaves
+// the registers usable afterwards.
+void fpu_save(fpu_state_t* st);
+void fpu_restore(const fpu_state_t* st);
+
+// CR0.TS: while set, FPU/SSE instructions trap with #NM.
+void fpu_set_ts(void);
+void fpu_clear_ts(void);
+
+#endif
@@ -3,8 +3,12 @@
 
 #include "types.h"
 
+// Selector of the per-thread TLS segment (GDT slot 6, RPL 3).
+#define GDT_TLS_SELECTOR 0x33u
+
 void gdt_init(void);
 void tss_set_kernel_stack(uint32_t stack_top);
+void gdt_set_tls_base(uint32_t base);
 
 extern void gdt_flush(uint32_t gdt_ptr);
 extern void tss_flush(uint16_t tss_selector);
@@ -17,6 +17,7 @@
 #define ENOMEM  12
 #define EACCES  13
 #define EFAULT  14
+#define EBUSY   16
 #define EEXIST  17
 #define EXDEV   18
 #define ENODEV  19
@@ -26,6 +27,7 @@
 #define ENFILE  23
 #define EMFILE  24
 #define ENOTTY  25
+#define ENOSPC  28
 #define ESPIPE  29
 #define EROFS   30
 #define EPIPE   32
@@ -34,6 +36,7 @@
 #define ENOTEMPTY 90
 #define ENAMETOOLONG 91
 #define ELOOP   92
+#define ETIMEDOUT 116
 #define EOVERFLOW 139
 #define ENOTSUP 95
 
@@ -2,6 +2,7 @@
 #define KEYBOARD_H
 
 #include "types.h"
+#include "pollwait.h"
 
 // Special key codes (negative values to avoid conflict with printable chars)
 #define KEY_UP      (-1)
@@ -61,4 +62,7 @@ void keyboard_idle_poll(void);
 // Inject raw bytes into the keyboard input buffer (used by mouse/serial helpers).
 void keyboard_inject_bytes(const uint8_t* bytes, size_t len);
 
+// Fires POLL_IN whenever a byte is queued: keys, mouse reports, serial input.
+poll_head_t* keyboard_poll_head(void);
+
 #endif
@@ -148,6 +148,20 @@ bool minixfs_statfs(uint32_t* total_blocks, uint32_t* free_blocks, uint32_t* tot
 // Stat a file/directory by path (relative to minixfs root)
 bool minixfs_stat(const char* path, minixfs_stat_t* out);
 
+// Inode number of a path, or 0 if it does not exist
+uint32_t minixfs_lookup(const char* path);
+
+// Inode number of entry `name` ("." and ".." included) in directory
+// `dir_ino`, or 0 if it does not exist
+uint32_t minixfs_lookup_at(uint32_t dir_ino, const char* name);
+
+// Generation of inode number `ino`; it changes whenever the inode is freed,
+// so an inode number kept together with its generation goes stale on reuse
+uint32_t minixfs_generation(uint32_t ino);
+
+// Stat by inode number
+bool minixfs_stat_ino(uint32_t ino, minixfs_stat_t* out);
+
 // Check if path is a directory
 bool minixfs_is_dir(const char* path);
 
@@ -161,18 +175,39 @@ uint8_t* minixfs_read_file(const char* path, uint32_t* out_size);
 // Write file contents (creates or overwrites)
 bool minixfs_write_file(const char* path, const uint8_t* data, uint32_t size);
 
+// The *_at() calls below name an entry `name` in directory `dir_ino`
+// instead of a path. Names are single components other than "." and "..".
+
+// Create an empty regular file; returns its inode, or 0 if it exists
+uint32_t minixfs_create_at(uint32_t dir_ino, const char* name);
+
+// Read up to len bytes at off; holes read as zeros
+// Returns bytes read (0 at EOF) or -1 on error
+int32_t minixfs_pread(uint32_t ino, uint32_t off, uint8_t* buf, uint32_t len);
+
+// Write len bytes at off, allocating zones and growing the file as needed
+// Returns bytes written (short when the disk fills up) or -1 on error
+int32_t minixfs_pwrite(uint32_t ino, uint32_t off, const uint8_t* buf, uint32_t len);
+
+// Set a regular file's size, freeing the zones past the new end
+bool minixfs_truncate(uint32_t ino, uint32_t size);
+
 // Create directory
 bool minixfs_mkdir(const char* path);
+bool minixfs_mkdir_at(uint32_t dir_ino, const char* name);
 
 // Remove file
 bool minixfs_unlink(const char* path);
+bool minixfs_unlink_at(uint32_t dir_ino, const char* name);
 
 // Remove directory (must be empty)
 bool minixfs_rmdir(const char* path);
+bool minixfs_rmdir_at(uint32_t dir_ino, const char* name);
 
 // List directory contents
 // Returns number of entries, fills out array up to max_entries
 uint32_t minixfs_readdir(const char* path, minixfs_dirent_t* out, uint32_t max_entries);
+uint32_t minixfs_readdir_ino(uint32_t ino, minixfs_dirent_t* out, uint32_t max_entries);
 
 // Read symbolic link target
 bool minixfs_readlink(const char* path, char* buf, uint32_t bufsize);
@@ -182,12 +217,16 @@ bool minixfs_symlink(const char* target, const char* linkpath);
 
 // Change file permissions
 bool minixfs_chmod(const char* path, uint16_t mode);
+bool minixfs_chmod_ino(uint32_t ino, uint16_t mode);
 
 // Change file owner
 bool minixfs_chown(const char* path, uint16_t uid, uint16_t gid);
+bool minixfs_chown_ino(uint32_t ino, uint16_t uid, uint16_t gid);
 
 // Rename/move file
 bool minixfs_rename(const char* oldpath, const char* newpath);
+bool minixfs_rename_at(uint32_t old_dir_ino, const char* old_name,
+                       uint32_t new_dir_ino, const char* new_name);
 
 // Sync filesystem (flush caches)
 void minixfs_sync(void);
@@ -0,0 +1,47 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include "types.h"
+
+// Page cache for minixfs regular files. Every open handle of an inode shares
+// one pagecache_inode_t; reads fault in PAGECACHE_PAGE_SIZE pages on demand
+// and writes only dirty the pages they touch. Dirty pages are written back
+// with minixfs_pwrite() on fsync, on eviction and when the last handle
+// closes, so a file's data is never held in memory as a whole.
+//
+// Pages of all inodes share one LRU list capped at PAGECACHE_MAX_PAGES.
+// Like the filesystem below it, the cache runs with interrupts off.
+
+#define PAGECACHE_PAGE_SIZE 4096u
+#define PAGECACHE_MAX_PAGES 1024u
+
+typedef struct pagecache_inode pagecache_inode_t;
+
+// Take a reference on the cache of minixfs inode `ino`. NULL if the inode
+// cannot be read or there is no memory.
+pagecache_inode_t* pagecache_get(uint32_t ino);
+// Drop a reference. The last one writes back the dirty pages and frees the
+// inode's pages. Returns 0 or -EIO.
+int32_t pagecache_put(pagecache_inode_t* pi);
+
+uint32_t pagecache_size(const pagecache_inode_t* pi);
+// Return 0 or -errno; *out_done is the byte count.
+int32_t pagecache_read(pagecache_inode_t* pi, uint32_t off, void* dst, uint32_t len, uint32_t* out_done);
+int32_t pagecache_write(pagecache_inode_t* pi, uint32_t off, const void* src, uint32_t len, uint32_t* out_done);
+int32_t pagecache_truncate(pagecache_inode_t* pi, uint32_t size);
+// Borrow the data at `off` up to the end of its page. The page is pinned
+// (never evicted) until pagecache_unpin() with the same offset, so other
+// cache calls may run in between. *out_len is 0 at EOF, with nothing pinned.
+int32_t pagecache_peek(pagecache_inode_t* pi, uint32_t off, const uint8_t** out_data, uint32_t* out_len);
+void pagecache_unpin(pagecache_inode_t* pi, uint32_t off);
+// Write back the inode's dirty pages (not the buffer cache below).
+int32_t pagecache_sync(pagecache_inode_t* pi);
+// Same for every inode with open handles (reboot, halt).
+int32_t pagecache_sync_all(void);
+
+// The inode was freed (unlink, rename over it): its pages are never written
+// back again. Handles still open on it see what is cached and zeros
+// elsewhere.
+void pagecache_forget(uint32_t ino);
+
+#endif
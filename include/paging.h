@@ -28,8 +28,16 @@ uint32_t* paging_create_user_directory(void);
 // Switches the current address space by loading CR3.
 void paging_switch_directory(uint32_t* dir);
 
-// Validate that a virtual address range is mapped as user-accessible in the
-// current address space. If `write` is true, also requires PAGE_RW.
-bool paging_user_accessible_range(uint32_t vaddr, uint32_t size, bool write);
+// A zeroed page for a page directory or table, below USER_BASE so it is
+// reachable through the shared identity mapping. NULL when out of memory.
+uint32_t* paging_alloc_table(void);
+
+// True while a user address space is loaded. Inside the user range it then
+// maps nothing but user pages, so the user-copy routines need no page walk.
+bool paging_in_user_space(void);
+
+// Translate a user virtual address in the current address space to its
+// physical address. Returns false if the page is not mapped for user access.
+bool paging_user_virt_to_phys(uint32_t vaddr, uint32_t* out_paddr);
 
 #endif
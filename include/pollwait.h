@@ -0,0 +1,68 @@
+#ifndef POLLWAIT_H
+#define POLLWAIT_H
+
+#include "types.h"
+
+// Readiness notification. Objects whose readiness can change (pipes, the
+// keyboard buffer, epoll instances) embed a poll_head_t and call poll_wake()
+// when it does. select, poll and epoll hook entries onto those heads and
+// sleep until one fires, instead of rescanning every descriptor on every
+// interrupt.
+
+// Event bits, same values as the poll() ABI.
+#define POLL_IN  0x0001u
+#define POLL_OUT 0x0004u
+#define POLL_ERR 0x0008u
+#define POLL_HUP 0x0010u
+
+typedef struct poll_entry poll_entry_t;
+
+// Called with interrupts off, possibly from an IRQ handler.
+typedef void (*poll_func_t)(poll_entry_t* e, uint32_t events);
+
+typedef struct poll_head {
+    poll_entry_t* first;
+    // Optional: pull in input from a source that raises no interrupt.
+    // Waiters call it each time they wake up.
+    void (*poll)(void);
+} poll_head_t;
+
+struct poll_entry {
+    poll_entry_t* next;
+    poll_head_t* head;   // NULL when not hooked
+    poll_func_t func;
+};
+
+void poll_add(poll_head_t* h, poll_entry_t* e, poll_func_t func);
+void poll_remove(poll_entry_t* e);
+void poll_wake(poll_head_t* h, uint32_t events);
+// The object owning `h` is going away: wake and unhook everything on it.
+void poll_head_detach(poll_head_t* h);
+
+// A blocked select/poll/epoll_wait call, hooked onto each distinct head it
+// is waiting for. Lives on the caller's kernel stack.
+#define POLL_WAITER_SLOTS 16u
+
+typedef struct poll_waiter poll_waiter_t;
+
+typedef struct poll_slot {
+    poll_entry_t entry;  // first, so callbacks can recover the slot
+    poll_waiter_t* owner;
+} poll_slot_t;
+
+struct poll_waiter {
+    volatile bool woken;
+    bool overflow;       // more heads than slots: wake on every interrupt
+    uint32_t count;
+    poll_slot_t slots[POLL_WAITER_SLOTS];
+};
+
+void poll_waiter_init(poll_waiter_t* w);
+// Watch `h`; a NULL head (readiness never changes) is ignored.
+void poll_waiter_watch(poll_waiter_t* w, poll_head_t* h);
+void poll_waiter_release(poll_waiter_t* w);
+// Sleep until a watched head fires, timer tick `deadline` passes (0 = no
+// deadline) or a signal is pending. The caller rechecks all three.
+void poll_waiter_wait(poll_waiter_t* w, uint32_t deadline);
+
+#endif
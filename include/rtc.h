@@ -14,5 +14,7 @@ typedef struct rtc_datetime {
 
 bool rtc_read_datetime(rtc_datetime_t* out);
 bool rtc_set_datetime(const rtc_datetime_t* dt);
+// Seconds since 1970-01-01 00:00:00 UTC.
+uint32_t rtc_datetime_to_unix(const rtc_datetime_t* dt);
 
 #endif
@@ -4,5 +4,8 @@
 #include "interrupts.h"
 
 interrupt_frame_t* syscall_handle(interrupt_frame_t* frame);
+// Finish latency accounting for the current task's syscall if `frame` is the
+// one it entered with. Called on every return to a task.
+void syscall_account_return(interrupt_frame_t* frame);
 
 #endif
@@ -8,16 +8,27 @@
 // Kept intentionally finite to avoid unbounded kernel allocations.
 #define VOS_EXEC_MAX_ARGS 4096u
 
+// Size of every task's kernel stack (a guard page sits below each one).
+#define TASK_KSTACK_SIZE (16u * 1024u)
+
 void tasking_init(void);
 bool tasking_is_enabled(void);
 
 // Called from the IRQ0 (timer) path to perform a timeslice switch.
 interrupt_frame_t* tasking_on_timer_tick(interrupt_frame_t* frame);
 
+// Device-not-available (#NM) trap: give the current task the FPU, saving
+// the previous owner's registers. Returns false if the trap can't be served.
+bool tasking_fpu_trap(void);
+
 // Voluntary context switches (used by syscalls).
 interrupt_frame_t* tasking_yield(interrupt_frame_t* frame);
 interrupt_frame_t* tasking_exit(interrupt_frame_t* frame, int32_t exit_code);
 
+// Exit only the calling thread. The main thread instead waits for the rest of
+// its group and returns 0 (-EINTR if a signal woke it) so it can exit normally.
+interrupt_frame_t* tasking_thread_exit(interrupt_frame_t* frame, int32_t exit_code);
+
 // Create a user-mode task that starts at `entry` with user stack pointer `user_esp`.
 bool tasking_spawn_user(uint32_t entry, uint32_t user_esp, uint32_t* page_directory, uint32_t user_brk);
 
@@ -31,6 +42,8 @@ typedef enum {
     TASK_STATE_ZOMBIE   = 3,
 } task_state_t;
 
+#define TASK_STATE_COUNT 4u
+
 typedef struct task_info {
     uint32_t pid;
     bool user;
@@ -42,9 +55,21 @@ typedef struct task_info {
     uint32_t wake_tick;
     uint32_t wait_pid;
     char name[16];
+    // Extended fields (ps/top/sysview).
+    uint32_t tgid;
+    uint32_t ppid;
+    uint32_t uid;
+    uint32_t sys_ticks;
+    uint32_t rss_pages;   // user pages mapped in the address space
+    uint32_t faults;
+    uint32_t switches;
+    uint32_t start_tick;
+    uint32_t state_ticks[TASK_STATE_COUNT];  // includes the current state so far
 } task_info_t;
 
+// Process id (thread group id) and per-thread id of the current task.
 uint32_t tasking_current_pid(void);
+uint32_t tasking_current_tid(void);
 uint32_t tasking_current_ppid(void);
 uint32_t tasking_getpgrp(void);
 int tasking_current_console(void);
@@ -55,12 +80,51 @@ int32_t tasking_setuid(uint32_t uid);
 int32_t tasking_setgid(uint32_t gid);
 uint32_t tasking_task_count(void);
 bool tasking_get_task_info(uint32_t index, task_info_t* out);
+// Fill up to `max` records, skipping the first `start` tasks, in one pass
+// with interrupts off so the set is consistent. Tasks are listed starting
+// from the caller, so successive calls from one task page through the same
+// order. Returns the total number of tasks.
+uint32_t tasking_task_snapshot(task_info_t* out, uint32_t start, uint32_t max);
 
 // Introspection for sysview
 uint32_t tasking_context_switch_count(void);
+// Kernel stacks owned by tasks, ready in the warm cache, and the deepest
+// stack use observed (bytes out of the per-task kernel stack size).
+void tasking_get_kstack_stats(uint32_t* in_use, uint32_t* cached, uint32_t* max_depth);
 void tasking_get_state_counts(uint32_t* runnable, uint32_t* sleeping,
                               uint32_t* waiting, uint32_t* zombie);
 
+// Start a kernel task at `entry`. Returns its pid (0 on failure).
+uint32_t tasking_spawn_kernel(void (*entry)(void), const char* name);
+
+// Make a sleeping task runnable right away.
+void tasking_wake(uint32_t pid);
+
+// Process context (address space, fd table, cwd, credentials) captured at
+// syscall time so a kernel worker can finish the call on the task's behalf.
+typedef struct task_io_ctx task_io_ctx_t;
+task_io_ctx_t* tasking_io_ctx_get(void);
+void tasking_io_ctx_hold(task_io_ctx_t* ctx);
+void tasking_io_ctx_put(task_io_ctx_t* ctx);
+// Run the current kernel task inside `ctx` until the matching leave.
+void tasking_io_ctx_enter(task_io_ctx_t* ctx);
+void tasking_io_ctx_leave(task_io_ctx_t* ctx);
+
+// Per-process SYS_URING_SETUP ring (kept with the address space).
+struct uring;
+struct uring* tasking_uring(void);
+bool tasking_set_uring(struct uring* r);
+
+// Syscall the current task is inside of, kept for latency accounting until
+// its frame is resumed (which may be long after a blocking call switched away).
+typedef struct task_syscall {
+    interrupt_frame_t* frame;   // NULL when no syscall is in progress
+    uint64_t start_tsc;
+    uint32_t num;
+    uint32_t args[5];           // ebx, ecx, edx, esi, edi at entry
+} task_syscall_t;
+task_syscall_t* tasking_current_syscall(void);
+
 // Check whether the current task has a deferred kill pending.
 // If true, *out_exit_code receives the exit code to use.
 bool tasking_current_should_exit(int32_t* out_exit_code);
@@ -89,6 +153,17 @@ bool tasking_tty_handle_input_char(uint8_t c);
 // Put the current task to sleep until `wake_tick` (timer_get_ticks() units).
 interrupt_frame_t* tasking_sleep_until(interrupt_frame_t* frame, uint32_t wake_tick);
 
+// Futexes, keyed by the physical address of an aligned user word.
+// Block while *uaddr == val, until woken (EAX = 0), `wake_tick` passes
+// (-ETIMEDOUT; 0 = no timeout) or a signal arrives (-EINTR).
+interrupt_frame_t* tasking_futex_wait(interrupt_frame_t* frame, const void* uaddr, uint32_t val, uint32_t wake_tick);
+// Wake up to `nr_wake` waiters. Returns the number woken or -errno.
+int32_t tasking_futex_wake(const void* uaddr, uint32_t nr_wake);
+// Wake up to `nr_wake` waiters on `uaddr` and move up to `nr_requeue` others to
+// `uaddr2`. With `cmp`, fail with -EAGAIN unless *uaddr == cmp_val.
+int32_t tasking_futex_requeue(const void* uaddr, uint32_t nr_wake, const void* uaddr2, uint32_t nr_requeue,
+                              bool cmp, uint32_t cmp_val);
+
 // Wait for a task to exit (returns exit code in EAX via the syscall frame).
 interrupt_frame_t* tasking_wait(interrupt_frame_t* frame, uint32_t pid);
 
@@ -112,15 +187,73 @@ interrupt_frame_t* tasking_sbrk(interrupt_frame_t* frame, int32_t increment);
 // Minimal fd-based API for syscalls (per-task).
 int32_t tasking_fd_open(const char* path, uint32_t flags);
 int32_t tasking_fd_close(int32_t fd);
+
+// *at() calls: relative paths start at directory fd `dirfd`, or at the cwd
+// for VOS_AT_FDCWD. Values follow Linux.
+#define VOS_AT_FDCWD            (-100)
+#define VOS_AT_SYMLINK_NOFOLLOW 0x100u
+#define VOS_AT_REMOVEDIR        0x200u
+
+int32_t tasking_fd_openat(int32_t dirfd, const char* path, uint32_t flags);
+int32_t tasking_fstatat(int32_t dirfd, const char* path, void* st_user, uint32_t flags);
+int32_t tasking_mkdirat(int32_t dirfd, const char* path);
+int32_t tasking_unlinkat(int32_t dirfd, const char* path, uint32_t flags);
+int32_t tasking_renameat(int32_t old_dirfd, const char* old_path, int32_t new_dirfd, const char* new_path);
 int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len);
 int32_t tasking_fd_write(int32_t fd, const void* src_user, uint32_t len);
 int32_t tasking_fd_lseek(int32_t fd, int32_t offset, int32_t whence);
+// pread/pwrite leave the file position alone; -ESPIPE on pipes and TTYs.
+int32_t tasking_fd_pread(int32_t fd, void* dst_user, uint32_t len, int32_t off);
+int32_t tasking_fd_pwrite(int32_t fd, const void* src_user, uint32_t len, int32_t off);
+
+// Kernel-side copies between descriptors. sendfile reads from a file into
+// any writable fd; splice needs a pipe on one side. A non-NULL offset
+// pointer (user memory) replaces and is advanced instead of the file
+// position.
+int32_t tasking_sendfile(int32_t out_fd, int32_t in_fd, int32_t* off_user, uint32_t count);
+int32_t tasking_splice(int32_t in_fd, int32_t* in_off_user, int32_t out_fd, int32_t* out_off_user,
+                       uint32_t len);
+
+// readv/writev segment (struct iovec on i386).
+typedef struct vos_iovec {
+    uint32_t base;
+    uint32_t len;
+} vos_iovec_t;
+
+#define VOS_IOV_MAX 64u
+
+int32_t tasking_fd_readv(int32_t fd, const void* iov_user, int32_t iovcnt);
+int32_t tasking_fd_writev(int32_t fd, const void* iov_user, int32_t iovcnt);
 int32_t tasking_fd_fstat(int32_t fd, void* st_user);
 int32_t tasking_stat(const char* path, void* st_user);
 int32_t tasking_lstat(const char* path, void* st_user);
 int32_t tasking_statfs(const char* path, void* st_user);
 int32_t tasking_mkdir(const char* path);
 int32_t tasking_readdir(int32_t fd, void* dirent_user);
+
+// getdents record: a fixed header, then the NUL-terminated name, padded so
+// the next record starts on a 4-byte boundary.
+typedef struct vos_dirent_rec {
+    uint16_t reclen;
+    uint8_t type;       // VOS_DT_*
+    uint8_t name_len;
+    uint16_t mode;      // permission bits
+    uint16_t wtime;     // FAT-style last write time/date
+    uint16_t wdate;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t uid;
+    uint32_t gid;
+    char name[];
+} vos_dirent_rec_t;
+
+#define VOS_DT_DIR 4u
+#define VOS_DT_REG 8u
+#define VOS_DT_LNK 10u
+
+// Fill `buf_user` with as many records as fit. Returns the bytes used, 0 at
+// end of directory, or -EINVAL if not even the next entry fits.
+int32_t tasking_getdents(int32_t fd, void* buf_user, uint32_t len);
 int32_t tasking_chdir(const char* path);
 int32_t tasking_getcwd(void* dst_user, uint32_t len);
 int32_t tasking_fd_ioctl(int32_t fd, uint32_t req, void* argp_user);
@@ -130,6 +263,11 @@ int32_t tasking_rmdir(const char* path);
 int32_t tasking_truncate(const char* path, uint32_t new_size);
 int32_t tasking_fd_ftruncate(int32_t fd, uint32_t new_size);
 int32_t tasking_fd_fsync(int32_t fd);
+// 1 if `fd` is an open file on the disk filesystem, 0 if not, or -EBADF.
+int32_t tasking_fd_on_disk(int32_t fd);
+// 1 if reading or writing `fd` can wait indefinitely on another process or
+// the keyboard (stdin, tty, pipe), 0 if not, or -EBADF.
+int32_t tasking_fd_can_block(int32_t fd);
 int32_t tasking_symlink(const char* target, const char* linkpath);
 int32_t tasking_readlink(const char* path, void* dst_user, uint32_t cap);
 int32_t tasking_chmod(const char* path, uint16_t mode);
@@ -151,6 +289,15 @@ int32_t tasking_fd_is_readable(int32_t fd);
 // Returns 1 if writable, 0 if not, -1 if fd invalid.
 int32_t tasking_fd_is_writable(int32_t fd);
 
+// Poll head that fires when the readiness of `fd` changes, or NULL when it
+// never does (files, /dev/null, ...) or `fd` is invalid.
+struct poll_head* tasking_fd_poll_head(int32_t fd);
+
+// epoll descriptors. tasking_fd_epoll() returns a referenced instance (drop
+// it with epoll_put) or NULL when `fd` is not one.
+int32_t tasking_epoll_create(uint32_t flags);
+struct epoll* tasking_fd_epoll(int32_t fd);
+
 // Check if an fd refers to a terminal (TTY).
 // Returns 1 if TTY, 0 if not.
 int32_t tasking_fd_isatty(int32_t fd);
@@ -169,6 +316,16 @@ int32_t tasking_mprotect(uint32_t addr, uint32_t length, uint32_t prot);
 
 // fork/exec (POSIX-ish).
 int32_t tasking_fork(interrupt_frame_t* frame);
+
+// Linux-style clone(): CLONE_VM/FILES/SIGHAND/THREAD share the address space,
+// fd table and signal handlers; CLONE_SETTLS installs `tls` as the child's TLS
+// segment base. Returns the child tid (>0) or -errno.
+int32_t tasking_clone(interrupt_frame_t* frame, uint32_t flags, uint32_t child_stack,
+                      void* parent_tid_user, uint32_t tls, void* child_tid_user);
+
+// Set the current thread's TLS segment base. Returns the selector to load
+// into %gs (already loaded on return from the syscall).
+int32_t tasking_set_tls(interrupt_frame_t* frame, uint32_t base);
 int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* const* argv, uint32_t argc,
                        const char* const* envp, uint32_t envc);
 
@@ -7,6 +7,22 @@ void timer_init(uint32_t hz);
 uint32_t timer_get_hz(void);
 uint32_t timer_get_ticks(void);
 uint32_t timer_uptime_ms(void);
+
+// Nanoseconds since boot: PIT ticks interpolated with the calibrated TSC
+// when it is usable, plain tick resolution otherwise.
+uint64_t timer_monotonic_ns(void);
+void timer_ns_split(uint64_t ns, uint32_t* sec, uint32_t* nsec);
+// Tick at which a sleeper with an absolute monotonic deadline should wake.
+uint32_t timer_deadline_tick(uint64_t deadline_ns);
+// TSC frequency, or 0 when the TSC isn't the clock source.
+uint32_t timer_tsc_khz(void);
+// Raw cycle counter for interval timing, or 0 under the same condition.
+uint64_t timer_read_tsc(void);
+
+// Wall clock: the RTC read at sync time advanced by the monotonic clock.
+// Synced at boot and whenever the RTC is set.
+bool timer_sync_realtime(void);
+bool timer_realtime_ns(uint64_t* out);
 void timer_sleep_ms(uint32_t ms);
 
 #endif
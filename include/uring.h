@@ -0,0 +1,75 @@
+#ifndef URING_H
+#define URING_H
+
+#include "types.h"
+
+// Batched syscall rings (io_uring-style). A process hands the kernel one
+// block of its own memory holding a header, the submission queue and the
+// completion queue; SYS_URING_ENTER consumes queued entries and posts a
+// completion for each. Operations that have to wait on the disk are passed
+// to a kernel worker and complete asynchronously.
+
+enum {
+    URING_OP_NOP   = 0,
+    URING_OP_READ  = 1,
+    URING_OP_WRITE = 2,
+    URING_OP_OPEN  = 3,
+    URING_OP_CLOSE = 4,
+    URING_OP_STAT  = 5,
+    URING_OP_FSTAT = 6,
+    URING_OP_FSYNC = 7,
+};
+
+// Always hand the operation to the worker. READ/WRITE on a descriptor that
+// can block indefinitely (tty, pipe) complete with -EAGAIN instead.
+#define URING_SQE_ASYNC  0x01u
+#define URING_OFF_CUR    0xFFFFFFFFu  // READ/WRITE at the current file position
+#define URING_ENTER_GETEVENTS 0x01u   // wait for min_complete completions
+
+#define URING_MAX_ENTRIES 4096u
+
+// Shared header at the start of the ring memory. Followed by sq_entries
+// submission entries and then cq_entries completion entries.
+typedef struct uring_header {
+    volatile uint32_t sq_head;     // written by the kernel
+    volatile uint32_t sq_tail;     // written by user space
+    volatile uint32_t cq_head;     // written by user space
+    volatile uint32_t cq_tail;     // written by the kernel
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    volatile uint32_t cq_overflow; // completions dropped for lack of room
+    uint32_t reserved;
+} uring_header_t;
+
+typedef struct uring_sqe {
+    uint8_t opcode;
+    uint8_t flags;                 // URING_SQE_*
+    uint16_t reserved;
+    int32_t fd;
+    uint32_t off;                  // file offset; stat buffer for STAT
+    uint32_t addr;                 // data buffer, or path for OPEN/STAT
+    uint32_t len;
+    uint32_t op_flags;             // open flags for OPEN
+    uint64_t user_data;            // copied into the completion
+} uring_sqe_t;
+
+typedef struct uring_cqe {
+    uint64_t user_data;
+    int32_t res;                   // syscall-style result or -errno
+    uint32_t flags;
+} uring_cqe_t;
+
+typedef struct uring uring_t;
+
+// Install `ring_user` as the calling process's ring. Returns 0 or -errno.
+int32_t uring_setup(uint32_t ring_user, uint32_t sq_entries, uint32_t cq_entries);
+
+// Submit up to `to_submit` queued entries and, with URING_ENTER_GETEVENTS,
+// wait until `min_complete` completions are ready. Returns the number of
+// entries consumed or -errno.
+int32_t uring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+
+// Free a ring once the address space that owns it is gone.
+void uring_release(uring_t* r);
+
+#endif
@@ -1,14 +1,33 @@
 #ifndef USERCOPY_H
 #define USERCOPY_H
 
+#include "interrupts.h"
 #include "types.h"
 
-// Copy bytes from a user pointer into kernel memory. Returns false if the user
-// range is not mapped/user-accessible in the current address space.
+// Copy bytes from a user pointer into kernel memory. Returns false if the
+// range is outside user space or faults part way.
 bool copy_from_user(void* dst, const void* src_user, uint32_t len);
 
-// Copy bytes from kernel memory into a user pointer. Returns false if the user
-// range is not mapped/user-writable in the current address space.
+// Copy bytes from kernel memory into a user pointer. Returns false if the
+// range is outside user space or faults part way (unmapped or read-only).
 bool copy_to_user(void* dst_user, const void* src, uint32_t len);
 
+// True if [user, user+len) lies in user space. Syscalls that take arrays of
+// user buffers use it to reject the whole call before copying anything.
+bool access_ok(const void* user, uint32_t len);
+
+// Copy a NUL-terminated user string into `dst` (capacity `cap`, terminator
+// included). Returns the string length, -EFAULT, or -ENAMETOOLONG when no
+// terminator fits (dst is then truncated but still terminated).
+int32_t strncpy_from_user(char* dst, const char* src_user, uint32_t cap);
+
+// Length of a user string, scanning at most `cap` bytes (terminator
+// included). Returns -EFAULT or -ENAMETOOLONG like strncpy_from_user().
+int32_t strnlen_user(const char* src_user, uint32_t cap);
+
+// The copy routines only check the address range; a fault on a bad page is
+// caught by the page-fault handler, which calls this to resume at the copy's
+// recovery path. Returns false if `frame` didn't fault in a user-copy routine.
+bool usercopy_fixup(interrupt_frame_t* frame);
+
 #endif
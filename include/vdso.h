@@ -0,0 +1,37 @@
+#ifndef VDSO_H
+#define VDSO_H
+
+#include "types.h"
+
+// Read-only page mapped at the same address in every process so clock reads
+// don't need a syscall. The kernel rewrites it on every timer tick; readers
+// retry while `seq` is odd or changes under them (seqlock).
+// Keep in sync with user/syscall.h (vos_time_page_t).
+#define VDSO_TIME_VA      0xED000000u
+#define VDSO_TIME_VERSION 1u
+
+#define VDSO_TIME_TSC      0x1u   // tick_tsc/tsc_* interpolate between ticks
+#define VDSO_TIME_REALTIME 0x2u   // realtime_base_ns is valid
+
+typedef struct vdso_time {
+    volatile uint32_t seq;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t ns_per_tick;
+    uint64_t ticks;              // PIT ticks since boot
+    uint64_t tick_tsc;           // TSC at the last tick
+    uint32_t tsc_per_tick;
+    uint32_t tsc_mult;           // ns = (cycles * tsc_mult) >> tsc_shift
+    uint32_t tsc_shift;
+    uint32_t reserved;
+    uint64_t realtime_base_ns;   // CLOCK_REALTIME = realtime_base_ns + monotonic
+} vdso_time_t;
+
+// Syscall trampoline page. The first word holds the address of the entry
+// point; user code does `call *VDSO_SYSCALL_VA` with the int 0x80 register
+// ABI. The entry uses SYSENTER when the CPU has it and int 0x80 otherwise,
+// and preserves every register but eax.
+// Keep in sync with user/syscall.h (VOS_SYSCALL).
+#define VDSO_SYSCALL_VA   0xED001000u
+
+#endif
@@ -90,6 +90,16 @@ void vfs_ref(vfs_handle_t* h);
 int32_t vfs_close(vfs_handle_t* h);
 int32_t vfs_read(vfs_handle_t* h, void* dst, uint32_t len, uint32_t* out_read);
 int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_written);
+// Positional variants: like read/write at `off`, leaving the handle's file
+// position alone (and ignoring O_APPEND).
+int32_t vfs_pread(vfs_handle_t* h, void* dst, uint32_t len, uint32_t off, uint32_t* out_read);
+int32_t vfs_pwrite(vfs_handle_t* h, const void* src, uint32_t len, uint32_t off, uint32_t* out_written);
+// Borrow the file data from `off` without copying (sendfile/splice): up to
+// EOF, or to the end of the page for page-cached files. Valid until
+// vfs_peek_done() with the same offset, which must follow every successful
+// peek with *out_len != 0; *out_len is 0 at EOF.
+int32_t vfs_peek(vfs_handle_t* h, uint32_t off, const uint8_t** out_data, uint32_t* out_len);
+void vfs_peek_done(vfs_handle_t* h, uint32_t off);
 int32_t vfs_lseek(vfs_handle_t* h, int32_t offset, int32_t whence, uint32_t* out_new_off);
 int32_t vfs_fstat(vfs_handle_t* h, vfs_stat_t* out);
 
@@ -102,6 +112,17 @@ int32_t vfs_unlink_path(const char* cwd, const char* path);
 int32_t vfs_rmdir_path(const char* cwd, const char* path);
 int32_t vfs_rename_path(const char* cwd, const char* old_path, const char* new_path);
 int32_t vfs_truncate_path(const char* cwd, const char* path, uint32_t new_size);
+
+// *at() variants. A relative `path` starts at directory handle `dir`, or at
+// `cwd` when `dir` is NULL. On minixfs it is looked up from the inode the
+// handle holds, so renaming the directory does not break the lookup, and
+// removing it gives -ENOENT even if the inode number is reused.
+int32_t vfs_open_at(const char* cwd, vfs_handle_t* dir, const char* path, uint32_t flags, vfs_handle_t** out);
+int32_t vfs_stat_at(const char* cwd, vfs_handle_t* dir, const char* path, bool follow, vfs_stat_t* out);
+int32_t vfs_mkdir_at(const char* cwd, vfs_handle_t* dir, const char* path);
+int32_t vfs_unlink_at(const char* cwd, vfs_handle_t* dir, const char* path, bool rmdir);
+int32_t vfs_rename_at(const char* cwd, vfs_handle_t* old_dir, const char* old_path,
+                      vfs_handle_t* new_dir, const char* new_path);
 int32_t vfs_ftruncate(vfs_handle_t* h, uint32_t new_size);
 int32_t vfs_fsync(vfs_handle_t* h);
 int32_t vfs_fchmod(vfs_handle_t* h, uint16_t mode);
@@ -111,4 +132,9 @@ int32_t vfs_fchown(vfs_handle_t* h, uint32_t uid, uint32_t gid);
 uint32_t vfs_handle_flags(vfs_handle_t* h);
 int32_t vfs_handle_set_flags(vfs_handle_t* h, uint32_t flags);
 
+// True when a path (or open handle) lives on the MinixFS disk rather than in
+// memory, i.e. opening, stat-ing or syncing it has to wait for the drive.
+bool vfs_path_on_disk(const char* cwd, const char* path);
+bool vfs_handle_on_disk(const vfs_handle_t* h);
+
 #endif
@@ -0,0 +1,26 @@
+#ifndef VSYSCALL_H
+#define VSYSCALL_H
+
+#include "interrupts.h"
+#include "types.h"
+
+// err_code of a syscall frame built by the SYSENTER stub (int 0x80 pushes 0).
+#define SYSCALL_FRAME_SYSENTER 2u
+
+// Program the SYSENTER MSRs when the CPU supports them and publish the
+// matching trampoline at VDSO_SYSCALL_VA.
+void vsyscall_init(void);
+bool vsyscall_has_sysenter(void);
+
+// Keep IA32_SYSENTER_ESP on the current task's kernel stack.
+void vsyscall_set_kernel_stack(uint32_t stack_top);
+
+// The trampoline parks the caller's ebp on the user stack; put it back in the
+// frame so syscalls see the same registers as through int 0x80.
+void vsyscall_fixup_frame(interrupt_frame_t* frame);
+
+// True if `eip` is in the part of the SYSENTER stub that still runs with the
+// caller's TF (a single-step trap there must be dismissed).
+bool vsyscall_in_entry(uint32_t eip);
+
+#endif
@@ -0,0 +1,264 @@
+#include "bcache.h"
+#include "ata.h"
+#include "io.h"
+#include "serial.h"
+#include "string.h"
+#include "task.h"
+#include "timer.h"
+
+#define BCACHE_HASH_SIZE 128u   // power of two
+
+// Syscall number the flush thread uses to sleep (see kernel/syscall.c).
+#define BCACHE_SYS_SLEEP 3u
+
+typedef struct bcache_buf {
+    uint32_t dev;
+    uint32_t lba;
+    bool valid;
+    bool dirty;
+    uint32_t dirty_tick;            // when it last went from clean to dirty
+    struct bcache_buf* hash_next;
+    struct bcache_buf* lru_prev;    // towards the most recently used
+    struct bcache_buf* lru_next;
+    uint8_t data[BCACHE_SECTOR_SIZE];
+} bcache_buf_t;
+
+static bcache_buf_t g_bufs[BCACHE_BUFFERS];
+static bcache_buf_t* g_hash[BCACHE_HASH_SIZE];
+static bcache_buf_t* g_lru_head = NULL;    // most recently used
+static bcache_buf_t* g_lru_tail = NULL;
+static bool g_ready = false;
+static bcache_stats_t g_stats;
+static uint32_t g_flush_pid = 0;
+
+static uint32_t bcache_hash(uint32_t dev, uint32_t lba) {
+    return (lba ^ (dev * 0x9E3779B1u)) & (BCACHE_HASH_SIZE - 1u);
+}
+
+static bool dev_read(uint32_t dev, uint32_t lba, uint8_t* out) {
+    return dev == BCACHE_DEV_ATA0 && ata_read_sector(lba, out);
+}
+
+static bool dev_write(uint32_t dev, uint32_t lba, const uint8_t* in) {
+    return dev == BCACHE_DEV_ATA0 && ata_write_sector(lba, in);
+}
+
+static void lru_unlink(bcache_buf_t* b) {
+    if (b->lru_prev) {
+        b->lru_prev->lru_next = b->lru_next;
+    } else {
+        g_lru_head = b->lru_next;
+    }
+    if (b->lru_next) {
+        b->lru_next->lru_prev = b->lru_prev;
+    } else {
+        g_lru_tail = b->lru_prev;
+    }
+    b->lru_prev = NULL;
+    b->lru_next = NULL;
+}
+
+static void lru_push_front(bcache_buf_t* b) {
+    b->lru_prev = NULL;
+    b->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = b;
+    } else {
+        g_lru_tail = b;
+    }
+    g_lru_head = b;
+}
+
+static void bcache_init(void) {
+    memset(g_bufs, 0, sizeof(g_bufs));
+    memset(g_hash, 0, sizeof(g_hash));
+    g_lru_head = NULL;
+    g_lru_tail = NULL;
+    for (uint32_t i = 0; i < BCACHE_BUFFERS; i++) {
+        lru_push_front(&g_bufs[i]);
+    }
+    g_stats.buffers = BCACHE_BUFFERS;
+    g_ready = true;
+}
+
+static void hash_remove(bcache_buf_t* b) {
+    for (bcache_buf_t** pp = &g_hash[bcache_hash(b->dev, b->lba)]; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == b) {
+            *pp = b->hash_next;
+            break;
+        }
+    }
+    b->hash_next = NULL;
+}
+
+static bcache_buf_t* bcache_lookup(uint32_t dev, uint32_t lba) {
+    for (bcache_buf_t* b = g_hash[bcache_hash(dev, lba)]; b; b = b->hash_next) {
+        if (b->dev == dev && b->lba == lba) {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+static bool bcache_writeback(bcache_buf_t* b) {
+    if (!dev_write(b->dev, b->lba, b->data)) {
+        serial_write_string("[BCACHE] write-back failed\n");
+        return false;
+    }
+    b->dirty = false;
+    g_stats.dirty--;
+    g_stats.writebacks++;
+    return true;
+}
+
+// Take the least recently used buffer for (dev, lba), writing it back first
+// if it is dirty. The contents are left stale for the caller to fill.
+static bcache_buf_t* bcache_claim(uint32_t dev, uint32_t lba) {
+    bcache_buf_t* b = g_lru_tail;
+    while (b && b->dirty && !bcache_writeback(b)) {
+        b = b->lru_prev;   // keep data we failed to write; try an older buffer
+    }
+    if (!b) {
+        return NULL;
+    }
+    if (b->valid) {
+        hash_remove(b);
+    }
+    b->dev = dev;
+    b->lba = lba;
+    b->valid = false;
+    uint32_t h = bcache_hash(dev, lba);
+    b->hash_next = g_hash[h];
+    g_hash[h] = b;
+    return b;
+}
+
+static void bcache_touch(bcache_buf_t* b) {
+    if (g_lru_head != b) {
+        lru_unlink(b);
+        lru_push_front(b);
+    }
+}
+
+bool bcache_read(uint32_t dev, uint32_t lba, void* out) {
+    if (!out) {
+        return false;
+    }
+    if (!g_ready) {
+        bcache_init();
+    }
+
+    bcache_buf_t* b = bcache_lookup(dev, lba);
+    if (b && b->valid) {
+        g_stats.hits++;
+        bcache_touch(b);
+        memcpy(out, b->data, BCACHE_SECTOR_SIZE);
+        return true;
+    }
+
+    g_stats.misses++;
+    if (!b) {
+        b = bcache_claim(dev, lba);
+    }
+    if (!b) {
+        return dev_read(dev, lba, (uint8_t*)out);
+    }
+    if (!dev_read(dev, lba, b->data)) {
+        hash_remove(b);
+        return false;
+    }
+    b->valid = true;
+    bcache_touch(b);
+    memcpy(out, b->data, BCACHE_SECTOR_SIZE);
+    return true;
+}
+
+static void bflush_thread(void);
+
+bool bcache_write(uint32_t dev, uint32_t lba, const void* in) {
+    if (!in) {
+        return false;
+    }
+    if (!g_ready) {
+        bcache_init();
+    }
+
+    bcache_buf_t* b = bcache_lookup(dev, lba);
+    if (!b) {
+        b = bcache_claim(dev, lba);
+    }
+    if (!b) {
+        return dev_write(dev, lba, (const uint8_t*)in);
+    }
+    memcpy(b->data, in, BCACHE_SECTOR_SIZE);
+    b->valid = true;
+    if (!b->dirty) {
+        b->dirty = true;
+        b->dirty_tick = timer_get_ticks();
+        g_stats.dirty++;
+    }
+    bcache_touch(b);
+
+    if (g_flush_pid == 0 && tasking_is_enabled()) {
+        g_flush_pid = tasking_spawn_kernel(bflush_thread, "bflushd");
+    }
+    return true;
+}
+
+// Write back the buffers that went dirty before tick `before`, or all of
+// them. Returns false if any write failed.
+static bool bcache_flush(bool all, uint32_t before) {
+    bool ok = true;
+    for (bcache_buf_t* b = g_lru_tail; b && g_stats.dirty != 0; b = b->lru_prev) {
+        if (!b->dirty) {
+            continue;
+        }
+        if (!all && (int32_t)(before - b->dirty_tick) < 0) {
+            continue;
+        }
+        if (!bcache_writeback(b)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool bcache_sync(void) {
+    if (!g_ready) {
+        return true;
+    }
+    bool ok = bcache_flush(true, 0);
+    if (!ata_flush()) {
+        ok = false;
+    }
+    return ok;
+}
+
+static void bflush_thread(void) {
+    for (;;) {
+        // Same rules as a syscall body: the disk driver is not reentrant.
+        cli();
+        if (g_stats.dirty != 0) {
+            uint32_t hz = timer_get_hz();
+            uint32_t age = hz ? (BCACHE_FLUSH_MS * hz) / 1000u : 0;
+            uint32_t now = timer_get_ticks();
+            if (bcache_flush(false, now - age) && g_stats.dirty == 0) {
+                (void)ata_flush();
+            }
+        }
+        uint32_t ret;
+        __asm__ volatile ("int $0x80" : "=a"(ret) : "a"(BCACHE_SYS_SLEEP), "b"(BCACHE_FLUSH_MS / 2u) : "memory");
+        (void)ret;
+        sti();
+    }
+}
+
+void bcache_get_stats(bcache_stats_t* out) {
+    if (!out) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    *out = g_stats;
+    out->buffers = BCACHE_BUFFERS;
+    irq_restore(flags);
+}
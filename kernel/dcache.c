@@ -0,0 +1,222 @@
+#include "dcache.h"
+#include "string.h"
+
+#define DCACHE_HASH_SIZE 256u   // power of two
+
+static dentry_t g_entries[DCACHE_ENTRIES];
+static dentry_t* g_hash[DCACHE_HASH_SIZE];
+static dentry_t* g_free = NULL;          // unused entries, linked by hash_next
+static dentry_t* g_lru_head = NULL;      // most recently used
+static dentry_t* g_lru_tail = NULL;
+static uint32_t g_fs_gen[DCACHE_FS_COUNT];
+static bool g_ready = false;
+
+static dentry_t g_root;
+
+static uint32_t name_hash(const char* name, uint32_t len) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (uint32_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t bucket(const dentry_t* parent, uint32_t hash) {
+    return (hash ^ ((uint32_t)parent >> 4)) & (DCACHE_HASH_SIZE - 1u);
+}
+
+static void lru_unlink(dentry_t* d) {
+    if (d->lru_prev) {
+        d->lru_prev->lru_next = d->lru_next;
+    } else {
+        g_lru_head = d->lru_next;
+    }
+    if (d->lru_next) {
+        d->lru_next->lru_prev = d->lru_prev;
+    } else {
+        g_lru_tail = d->lru_prev;
+    }
+    d->lru_prev = NULL;
+    d->lru_next = NULL;
+}
+
+static void lru_push_front(dentry_t* d) {
+    d->lru_prev = NULL;
+    d->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = d;
+    } else {
+        g_lru_tail = d;
+    }
+    g_lru_head = d;
+}
+
+static void dcache_init(void) {
+    memset(g_entries, 0, sizeof(g_entries));
+    memset(g_hash, 0, sizeof(g_hash));
+    g_free = NULL;
+    for (uint32_t i = 0; i < DCACHE_ENTRIES; i++) {
+        g_entries[i].hash_next = g_free;
+        g_free = &g_entries[i];
+    }
+    memset(&g_root, 0, sizeof(g_root));
+    g_root.name[0] = '/';
+    g_ready = true;
+}
+
+dentry_t* dcache_root(void) {
+    if (!g_ready) {
+        dcache_init();
+    }
+    return &g_root;
+}
+
+static void hash_remove(dentry_t* d) {
+    for (dentry_t** pp = &g_hash[bucket(d->parent, d->name_hash)]; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == d) {
+            *pp = d->hash_next;
+            break;
+        }
+    }
+    d->hash_next = NULL;
+}
+
+// Free the least recently used entry that nothing points to, other than
+// `keep`.
+static dentry_t* evict_leaf(const dentry_t* keep) {
+    for (dentry_t* d = g_lru_tail; d; d = d->lru_prev) {
+        if (d->children == 0 && d != keep) {
+            hash_remove(d);
+            lru_unlink(d);
+            d->parent->children--;
+            return d;
+        }
+    }
+    return NULL;
+}
+
+dentry_t* dcache_child(dentry_t* parent, const char* name, uint32_t len) {
+    if (!parent || !name || len == 0 || len >= VFS_NAME_MAX) {
+        return NULL;
+    }
+    uint32_t hash = name_hash(name, len);
+    uint32_t b = bucket(parent, hash);
+    for (dentry_t* d = g_hash[b]; d; d = d->hash_next) {
+        if (d->parent == parent && d->name_hash == hash &&
+            strncmp(d->name, name, len) == 0 && d->name[len] == '\0') {
+            if (g_lru_head != d) {
+                lru_unlink(d);
+                lru_push_front(d);
+            }
+            return d;
+        }
+    }
+
+    dentry_t* d = g_free;
+    if (d) {
+        g_free = d->hash_next;
+    } else {
+        d = evict_leaf(parent);
+        if (!d) {
+            return NULL;
+        }
+        // The victim may have shared our bucket.
+        b = bucket(parent, hash);
+    }
+
+    memset(d, 0, sizeof(*d));
+    d->parent = parent;
+    d->name_hash = hash;
+    memcpy(d->name, name, len);
+    d->name[len] = '\0';
+    parent->children++;
+    d->hash_next = g_hash[b];
+    g_hash[b] = d;
+    lru_push_front(d);
+    return d;
+}
+
+bool dcache_valid(const dentry_t* d) {
+    if (!d || d->state == DENTRY_UNKNOWN) {
+        return false;
+    }
+    if (d->parent && d->parent_epoch != d->parent->epoch) {
+        return false;
+    }
+    return d->fs_gen == g_fs_gen[d->fs];
+}
+
+static void set_common(dentry_t* d, dentry_state_t state, uint8_t fs) {
+    if (fs >= DCACHE_FS_COUNT) {
+        fs = DCACHE_FS_INITRAMFS;
+    }
+    // Whatever was cached below the old result is stale now.
+    d->epoch++;
+    d->state = state;
+    d->fs = fs;
+    d->fs_gen = g_fs_gen[fs];
+    d->parent_epoch = d->parent ? d->parent->epoch : 0;
+}
+
+void dcache_set_negative(dentry_t* d, uint8_t fs) {
+    if (!d) {
+        return;
+    }
+    set_common(d, DENTRY_NEGATIVE, fs);
+    d->node = 0;
+    d->is_dir = false;
+    d->is_symlink = false;
+}
+
+void dcache_set_positive(dentry_t* d, uint8_t fs, uint32_t node, bool is_dir, bool is_symlink) {
+    if (!d) {
+        return;
+    }
+    set_common(d, DENTRY_POSITIVE, fs);
+    d->node = node;
+    d->is_dir = is_dir;
+    d->is_symlink = is_symlink;
+}
+
+static void invalidate(dentry_t* d) {
+    d->state = DENTRY_UNKNOWN;
+    d->epoch++;
+}
+
+void dcache_dir_changed(uint8_t fs, uint32_t dir_node, const char* name) {
+    if (!g_ready || !name) {
+        return;
+    }
+    uint32_t len = (uint32_t)strlen(name);
+    uint32_t hash = name_hash(name, len);
+    // The same directory can appear under several paths (/disk/x and, with
+    // the root pivoted, /x), so match on the node rather than the path.
+    for (uint32_t i = 0; i < DCACHE_ENTRIES; i++) {
+        dentry_t* d = &g_entries[i];
+        dentry_t* p = d->parent;
+        if (!p || d->state == DENTRY_UNKNOWN || d->name_hash != hash) {
+            continue;
+        }
+        if (p->state == DENTRY_POSITIVE && p->fs == fs && p->node == dir_node && strcmp(d->name, name) == 0) {
+            invalidate(d);
+        }
+    }
+}
+
+void dcache_fs_changed(uint8_t fs) {
+    if (fs < DCACHE_FS_COUNT) {
+        g_fs_gen[fs]++;
+    }
+}
+
+void dcache_invalidate_all(void) {
+    if (!g_ready) {
+        return;
+    }
+    invalidate(&g_root);
+    for (uint32_t i = 0; i < DCACHE_ENTRIES; i++) {
+        if (g_entries[i].parent) {
+            invalidate(&g_entries[i]);
+        }
+    }
+}
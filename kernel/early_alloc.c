@@ -22,8 +22,9 @@ void* early_alloc(size_t size, size_t align) {
     if (new_ptr < aligned) {
         return NULL;
     }
-    // Check we don't exceed kernel space
-    if (new_ptr > 0xC0000000u) {
+    // Early memory is identity-mapped for the kernel only, so it must stay
+    // below the user address range (USER_BASE).
+    if (new_ptr > 0x02000000u) {
         return NULL;
     }
     early_ptr = new_ptr;
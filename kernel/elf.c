@@ -365,6 +365,8 @@ bool elf_load_user_image(const uint8_t* image, uint32_t size, uint32_t* out_entr
         uint32_t map_start = align_down(seg_start, PAGE_SIZE);
         uint32_t map_end = align_up(seg_end, PAGE_SIZE);
 
+        // Fill the pages through a writable mapping (the kernel honours
+        // CR0.WP), then drop write access for read-only segments.
         paging_prepare_range(map_start, map_end - map_start, map_flags);
 
         for (uint32_t va = map_start; va < map_end; va += PAGE_SIZE) {
@@ -375,7 +377,7 @@ bool elf_load_user_image(const uint8_t* image, uint32_t size, uint32_t* out_entr
                 elf_cleanup_range(map_start, va);
                 goto fail_cleanup;
             }
-            paging_map_page(va, frame, map_flags);
+            paging_map_page(va, frame, map_flags | PAGE_RW);
             memset((void*)va, 0, PAGE_SIZE);
         }
 
@@ -392,6 +394,15 @@ bool elf_load_user_image(const uint8_t* image, uint32_t size, uint32_t* out_entr
         if (bss_len) {
             memset((void*)bss_start, 0, bss_len);
         }
+
+        if ((map_flags & PAGE_RW) == 0) {
+            for (uint32_t va = map_start; va < map_end; va += PAGE_SIZE) {
+                uint32_t frame = 0;
+                if (paging_user_virt_to_phys(va, &frame)) {
+                    paging_map_page(va, frame & ~(PAGE_SIZE - 1u), map_flags);
+                }
+            }
+        }
     }
 
     uint32_t user_esp = 0;
@@ -0,0 +1,334 @@
+#include "epoll.h"
+#include "io.h"
+#include "kerrno.h"
+#include "kheap.h"
+#include "string.h"
+#include "task.h"
+#include "timer.h"
+#include "usercopy.h"
+
+#define EPOLL_MAX_ITEMS 256u
+
+typedef struct epoll_item {
+    poll_entry_t entry;             // first: recovered in the wakeup callback
+    struct epoll_item* next;        // interest list
+    struct epoll_item* ready_next;  // ready list
+    epoll_t* ep;
+    int32_t fd;
+    uint32_t events;                // requested EPOLL_* bits
+    uint64_t data;
+    bool on_ready;
+    bool disarmed;                  // EPOLLONESHOT fired; re-armed by MOD
+} epoll_item_t;
+
+struct epoll {
+    uint32_t refs;
+    uint32_t count;
+    epoll_item_t* items;
+    epoll_item_t* ready;
+    epoll_item_t* ready_tail;
+    poll_head_t poll;               // POLL_IN while the ready list is non-empty
+};
+
+// Callers hold interrupts off.
+static void epoll_mark_ready(epoll_item_t* it) {
+    if (it->on_ready || it->disarmed) {
+        return;
+    }
+    epoll_t* ep = it->ep;
+    it->on_ready = true;
+    it->ready_next = NULL;
+    if (ep->ready_tail) {
+        ep->ready_tail->ready_next = it;
+    } else {
+        ep->ready = it;
+    }
+    ep->ready_tail = it;
+    poll_wake(&ep->poll, POLL_IN);
+}
+
+static void epoll_item_func(poll_entry_t* e, uint32_t events) {
+    epoll_item_t* it = (epoll_item_t*)e;
+    if ((events & (it->events | EPOLL_ERR | EPOLL_HUP)) != 0) {
+        epoll_mark_ready(it);
+    }
+}
+
+static void epoll_unready(epoll_t* ep, epoll_item_t* it) {
+    if (!it->on_ready) {
+        return;
+    }
+    epoll_item_t* prev = NULL;
+    for (epoll_item_t* cur = ep->ready; cur; prev = cur, cur = cur->ready_next) {
+        if (cur == it) {
+            if (prev) {
+                prev->ready_next = cur->ready_next;
+            } else {
+                ep->ready = cur->ready_next;
+            }
+            if (ep->ready_tail == cur) {
+                ep->ready_tail = prev;
+            }
+            break;
+        }
+    }
+    it->on_ready = false;
+    it->ready_next = NULL;
+}
+
+static void epoll_item_free(epoll_t* ep, epoll_item_t* it) {
+    poll_remove(&it->entry);
+    uint32_t flags = irq_save();
+    epoll_unready(ep, it);
+    for (epoll_item_t** pp = &ep->items; *pp; pp = &(*pp)->next) {
+        if (*pp == it) {
+            *pp = it->next;
+            break;
+        }
+    }
+    ep->count--;
+    irq_restore(flags);
+    kfree(it);
+}
+
+epoll_t* epoll_create(void) {
+    epoll_t* ep = (epoll_t*)kmalloc(sizeof(*ep));
+    if (!ep) {
+        return NULL;
+    }
+    memset(ep, 0, sizeof(*ep));
+    ep->refs = 1;
+    return ep;
+}
+
+void epoll_get(epoll_t* ep) {
+    if (ep) {
+        uint32_t flags = irq_save();
+        ep->refs++;
+        irq_restore(flags);
+    }
+}
+
+void epoll_put(epoll_t* ep) {
+    if (!ep) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    bool last = --ep->refs == 0;
+    irq_restore(flags);
+    if (!last) {
+        return;
+    }
+    while (ep->items) {
+        epoll_item_free(ep, ep->items);
+    }
+    poll_head_detach(&ep->poll);
+    kfree(ep);
+}
+
+poll_head_t* epoll_poll_head(epoll_t* ep) {
+    return ep ? &ep->poll : NULL;
+}
+
+bool epoll_has_ready(epoll_t* ep) {
+    return ep && ep->ready != NULL;
+}
+
+static epoll_item_t* epoll_find(epoll_t* ep, int32_t fd) {
+    for (epoll_item_t* it = ep->items; it; it = it->next) {
+        if (it->fd == fd) {
+            return it;
+        }
+    }
+    return NULL;
+}
+
+int32_t epoll_ctl(epoll_t* ep, int32_t op, int32_t fd, const epoll_event_user_t* ev) {
+    if (!ep) {
+        return -EBADF;
+    }
+    if (tasking_fd_is_readable(fd) < 0 && tasking_fd_is_writable(fd) < 0) {
+        return -EBADF;
+    }
+    epoll_t* target = tasking_fd_epoll(fd);
+    epoll_put(target);
+    if (target == ep) {
+        return -EINVAL;
+    }
+
+    epoll_item_t* it = epoll_find(ep, fd);
+    switch (op) {
+        case EPOLL_CTL_ADD: {
+            if (it) {
+                return -EEXIST;
+            }
+            if (!ev) {
+                return -EFAULT;
+            }
+            if (ep->count >= EPOLL_MAX_ITEMS) {
+                return -ENOSPC;
+            }
+            it = (epoll_item_t*)kmalloc(sizeof(*it));
+            if (!it) {
+                return -ENOMEM;
+            }
+            memset(it, 0, sizeof(*it));
+            it->ep = ep;
+            it->fd = fd;
+            it->events = ev->events;
+            it->data = ev->data;
+
+            uint32_t flags = irq_save();
+            it->next = ep->items;
+            ep->items = it;
+            ep->count++;
+            // Check it on the next wait: it may already be ready.
+            epoll_mark_ready(it);
+            irq_restore(flags);
+
+            poll_add(tasking_fd_poll_head(fd), &it->entry, epoll_item_func);
+            return 0;
+        }
+        case EPOLL_CTL_MOD: {
+            if (!it) {
+                return -ENOENT;
+            }
+            if (!ev) {
+                return -EFAULT;
+            }
+            uint32_t flags = irq_save();
+            it->events = ev->events;
+            it->data = ev->data;
+            it->disarmed = false;
+            epoll_mark_ready(it);
+            irq_restore(flags);
+            return 0;
+        }
+        case EPOLL_CTL_DEL:
+            if (!it) {
+                return -ENOENT;
+            }
+            epoll_item_free(ep, it);
+            return 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+// Report ready items into `out`. Interrupts are off in the caller.
+static int32_t epoll_collect(epoll_t* ep, epoll_event_user_t* out, int32_t max) {
+    int32_t n = 0;
+    // Level-triggered items that are still ready go back on the list after
+    // this pass, so each wait sees every one of them once.
+    epoll_item_t* keep = NULL;
+    epoll_item_t* keep_tail = NULL;
+
+    while (n < max && ep->ready) {
+        epoll_item_t* it = ep->ready;
+        ep->ready = it->ready_next;
+        if (!ep->ready) {
+            ep->ready_tail = NULL;
+        }
+        it->on_ready = false;
+        it->ready_next = NULL;
+
+        int32_t r = tasking_fd_is_readable(it->fd);
+        int32_t w = tasking_fd_is_writable(it->fd);
+        if (r < 0 && w < 0) {
+            // The descriptor was closed: drop it, like Linux does.
+            epoll_item_free(ep, it);
+            continue;
+        }
+        uint32_t revents = 0;
+        if (r > 0) {
+            revents |= EPOLL_IN;
+        }
+        if (w > 0) {
+            revents |= EPOLL_OUT;
+        }
+        revents &= it->events;
+        if (revents == 0) {
+            continue;  // a later wakeup puts it back
+        }
+
+        out[n].events = revents;
+        out[n].data = it->data;
+        n++;
+
+        if (it->events & EPOLL_ONESHOT) {
+            it->disarmed = true;
+        } else if ((it->events & EPOLL_ET) == 0) {
+            it->on_ready = true;
+            if (keep_tail) {
+                keep_tail->ready_next = it;
+            } else {
+                keep = it;
+            }
+            keep_tail = it;
+        }
+    }
+
+    if (keep) {
+        if (ep->ready_tail) {
+            ep->ready_tail->ready_next = keep;
+        } else {
+            ep->ready = keep;
+        }
+        ep->ready_tail = keep_tail;
+    }
+    return n;
+}
+
+#define EPOLL_BATCH 16
+
+int32_t epoll_wait(epoll_t* ep, epoll_event_user_t* events_user, int32_t max, int32_t timeout_ms) {
+    if (!ep) {
+        return -EBADF;
+    }
+    if (max <= 0 || !events_user) {
+        return -EINVAL;
+    }
+    if (max > EPOLL_BATCH) {
+        max = EPOLL_BATCH;
+    }
+
+    uint32_t deadline = 0;
+    uint32_t hz = timer_get_hz();
+    if (timeout_ms > 0 && hz > 0) {
+        deadline = timer_get_ticks() + ((uint32_t)timeout_ms * hz + 999u) / 1000u;
+    }
+
+    poll_waiter_t waiter;
+    poll_waiter_init(&waiter);
+    poll_waiter_watch(&waiter, &ep->poll);
+    // Sources without an interrupt (serial input) have to be polled while
+    // we sleep.
+    for (epoll_item_t* it = ep->items; it; it = it->next) {
+        if (it->entry.head && it->entry.head->poll) {
+            poll_waiter_watch(&waiter, it->entry.head);
+        }
+    }
+
+    epoll_event_user_t out[EPOLL_BATCH];
+    int32_t rc;
+    for (;;) {
+        uint32_t flags = irq_save();
+        int32_t n = epoll_collect(ep, out, max);
+        irq_restore(flags);
+        if (n > 0) {
+            rc = copy_to_user(events_user, out, (uint32_t)n * sizeof(out[0])) ? n : -EFAULT;
+            break;
+        }
+        if (timeout_ms == 0 || (deadline != 0 && timer_get_ticks() >= deadline)) {
+            rc = 0;
+            break;
+        }
+        if (tasking_current_should_interrupt()) {
+            rc = -EINTR;
+            break;
+        }
+        poll_waiter_wait(&waiter, deadline);
+    }
+    poll_waiter_release(&waiter);
+    return rc;
+}
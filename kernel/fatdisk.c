@@ -1,5 +1,6 @@
 #include "fatdisk.h"
 #include "ata.h"
+#include "bcache.h"
 #include "ctype.h"
 #include "io.h"
 #include "kheap.h"
@@ -92,11 +93,12 @@ static void fat_dirent_best_ts(const uint8_t e[32], uint16_t* out_wtime, uint16_
 }
 
 static bool disk_read(uint32_t lba, uint8_t* out) {
-    return ata_read_sector(lba, out);
+    return bcache_read(BCACHE_DEV_ATA0, lba, out);
 }
 
+// Write-back: the sector reaches the disk within BCACHE_FLUSH_MS, or on sync.
 static bool disk_write(uint32_t lba, const uint8_t* in) {
-    return ata_write_sector(lba, in);
+    return bcache_write(BCACHE_DEV_ATA0, lba, in);
 }
 
 static const char* skip_slashes(const char* p) {
@@ -255,7 +257,6 @@ static void fat_root_best_ts(uint16_t* out_wtime, uint16_t* out_wdate) {
             if (!disk_write(lba, sec)) {
                 serial_write_string("[FATDISK] warning: timestamp update write failed\n");
             }
-            (void)ata_flush();
         }
     }
 
@@ -1533,7 +1534,6 @@ bool fatdisk_stat_ex(const char* abs_path, bool* out_is_dir, uint32_t* out_size,
         if (wdate != 0) {
             fat_stamp_dirent(ent, wtime, wdate, true);
             (void)write_dir_entry_at(loc, ent);
-            (void)ata_flush();
         }
     }
 
@@ -1606,7 +1606,6 @@ bool fatdisk_set_meta(const char* abs_path, bool is_symlink, uint16_t mode) {
     if (!write_dir_entry_at(loc, ent)) {
         return false;
     }
-    (void)ata_flush();
     return true;
 }
 
@@ -1639,7 +1638,6 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
     uint32_t count = 0;
     uint8_t sec[SECTOR_SIZE];
 
-    bool wrote_any = false;
     lfn_state_t lfn;
     lfn_reset(&lfn);
     char long_name[256];
@@ -1658,13 +1656,8 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
                     if (dirty_sector) {
                         if (!disk_write(lba, sec)) {
                             serial_write_string("[FATDISK] warning: timestamp update write failed\n");
-                        } else {
-                            wrote_any = true;
                         }
                     }
-                    if (wrote_any) {
-                        (void)ata_flush();
-                    }
                     return count;
                 }
                 if (e[0] == 0xE5) {
@@ -1715,14 +1708,9 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
             if (dirty_sector) {
                 if (!disk_write(lba, sec)) {
                     serial_write_string("[FATDISK] warning: timestamp update write failed\n");
-                } else {
-                    wrote_any = true;
                 }
             }
         }
-        if (wrote_any) {
-            (void)ata_flush();
-        }
         return count;
     }
 
@@ -1736,9 +1724,6 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
         for (uint32_t si = 0; si < g_fs.sectors_per_cluster && count < max; si++) {
             uint32_t lba = base + si;
             if (!disk_read(lba, sec)) {
-                if (wrote_any) {
-                    (void)ata_flush();
-                }
                 return count;
             }
             bool dirty_sector = false;
@@ -1748,13 +1733,8 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
                     if (dirty_sector) {
                         if (!disk_write(lba, sec)) {
                             serial_write_string("[FATDISK] warning: timestamp update write failed\n");
-                        } else {
-                            wrote_any = true;
                         }
                     }
-                    if (wrote_any) {
-                        (void)ata_flush();
-                    }
                     return count;
                 }
                 if (e[0] == 0xE5) {
@@ -1805,8 +1785,6 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
             if (dirty_sector) {
                 if (!disk_write(lba, sec)) {
                     serial_write_string("[FATDISK] warning: timestamp update write failed\n");
-                } else {
-                    wrote_any = true;
                 }
             }
         }
@@ -1818,9 +1796,6 @@ uint32_t fatdisk_list_dir(const char* abs_path, fatdisk_dirent_t* out, uint32_t
         cluster = next;
     }
 
-    if (wrote_any) {
-        (void)ata_flush();
-    }
     return count;
 }
 
@@ -1966,7 +1941,6 @@ bool fatdisk_write_file(const char* abs_path, const uint8_t* data, uint32_t size
         }
     }
 
-    (void)ata_flush();
     return true;
 }
 
@@ -2060,7 +2034,6 @@ bool fatdisk_mkdir(const char* abs_path) {
         return false;
     }
 
-    (void)ata_flush();
     return true;
 }
 
@@ -2102,7 +2075,6 @@ bool fatdisk_rename(const char* abs_old, const char* abs_new) {
         return false;
     }
 
-    (void)ata_flush();
     return true;
 }
 
@@ -2215,7 +2187,6 @@ bool fatdisk_unlink(const char* abs_path) {
         return false;
     }
 
-    (void)ata_flush();
     return true;
 }
 
@@ -2252,6 +2223,5 @@ bool fatdisk_rmdir(const char* abs_path) {
         return false;
     }
 
-    (void)ata_flush();
     return true;
 }
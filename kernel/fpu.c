@@ -0,0 +1,131 @@
+#include "fpu.h"
+#include "serial.h"
+#include "string.h"
+
+#define CR0_MP (1u << 1)
+#define CR0_EM (1u << 2)
+#define CR0_TS (1u << 3)
+#define CR0_NE (1u << 5)
+
+#define CR4_OSFXSR     (1u << 9)
+#define CR4_OSXMMEXCPT (1u << 10)
+
+#define CPUID_EDX_FPU  (1u << 0)
+#define CPUID_EDX_FXSR (1u << 24)
+#define CPUID_EDX_SSE  (1u << 25)
+
+#define MXCSR_DEFAULT 0x1F80u   // all exceptions masked, round to nearest
+
+static bool present = false;
+static bool use_fxsr = false;
+static bool sse = false;
+static fpu_state_t initial_state;
+
+static inline uint32_t read_cr0(void) {
+    uint32_t v;
+    __asm__ volatile ("mov %%cr0, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr0(uint32_t v) {
+    __asm__ volatile ("mov %0, %%cr0" : : "r"(v) : "memory");
+}
+
+static inline uint32_t read_cr4(void) {
+    uint32_t v;
+    __asm__ volatile ("mov %%cr4, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr4(uint32_t v) {
+    __asm__ volatile ("mov %0, %%cr4" : : "r"(v) : "memory");
+}
+
+static uint32_t cpuid_edx(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0u), "c"(0u));
+    if (eax < 1u) {
+        return 0;
+    }
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1u), "c"(0u));
+    return edx;
+}
+
+void fpu_init(void) {
+    uint32_t edx = cpuid_edx();
+    present = (edx & CPUID_EDX_FPU) != 0;
+    if (!present) {
+        serial_write_string("[FPU] no x87 unit\n");
+        return;
+    }
+    use_fxsr = (edx & CPUID_EDX_FXSR) != 0;
+    sse = use_fxsr && (edx & CPUID_EDX_SSE) != 0;
+
+    // Native error reporting, WAIT honours TS, no emulation.
+    uint32_t cr0 = read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+
+    if (use_fxsr) {
+        uint32_t cr4 = read_cr4() | CR4_OSFXSR;
+        if (sse) {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+        write_cr4(cr4);
+    }
+
+    __asm__ volatile ("fninit");
+    if (sse) {
+        uint32_t mxcsr = MXCSR_DEFAULT;
+        __asm__ volatile ("ldmxcsr %0" : : "m"(mxcsr));
+    }
+    memset(&initial_state, 0, sizeof(initial_state));
+    fpu_save(&initial_state);
+
+    fpu_set_ts();
+
+    serial_write_string("[FPU] x87");
+    serial_write_string(use_fxsr ? " fxsr" : "");
+    serial_write_string(sse ? " sse" : "");
+    serial_write_string(", lazy switching\n");
+}
+
+bool fpu_present(void) {
+    return present;
+}
+
+bool fpu_has_sse(void) {
+    return sse;
+}
+
+void fpu_init_state(fpu_state_t* st) {
+    if (st) {
+        memcpy(st, &initial_state, sizeof(*st));
+    }
+}
+
+void fpu_save(fpu_state_t* st) {
+    if (use_fxsr) {
+        __asm__ volatile ("fxsave %0" : "=m"(*st));
+    } else {
+        // FNSAVE reinitializes the unit; reload so the registers stay live.
+        __asm__ volatile ("fnsave %0; frstor %0" : "+m"(*st));
+    }
+}
+
+void fpu_restore(const fpu_state_t* st) {
+    if (use_fxsr) {
+        __asm__ volatile ("fxrstor %0" : : "m"(*st));
+    } else {
+        __asm__ volatile ("frstor %0" : : "m"(*st));
+    }
+}
+
+void fpu_set_ts(void) {
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+void fpu_clear_ts(void) {
+    __asm__ volatile ("clts");
+}
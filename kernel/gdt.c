@@ -1,5 +1,6 @@
 #include "gdt.h"
 #include "string.h"
+#include "vsyscall.h"
 
 typedef struct gdt_entry {
     uint16_t limit_low;
@@ -45,7 +46,7 @@ typedef struct tss_entry {
     uint16_t iomap_base;
 } __attribute__((packed)) tss_entry_t;
 
-static gdt_entry_t gdt[6];
+static gdt_entry_t gdt[7];
 static gdt_ptr_t gdtp;
 static tss_entry_t tss;
 
@@ -74,6 +75,15 @@ static void write_tss(int num, uint16_t ss0, uint32_t esp0) {
 
 void tss_set_kernel_stack(uint32_t stack_top) {
     tss.esp0 = stack_top;
+    vsyscall_set_kernel_stack(stack_top);
+}
+
+void gdt_set_tls_base(uint32_t base) {
+    // Only the base changes; the new value takes effect the next time a
+    // segment register is loaded with GDT_TLS_SELECTOR (the iret path pops gs).
+    gdt[6].base_low = (uint16_t)(base & 0xFFFFu);
+    gdt[6].base_middle = (uint8_t)((base >> 16) & 0xFFu);
+    gdt[6].base_high = (uint8_t)((base >> 24) & 0xFFu);
 }
 
 void gdt_init(void) {
@@ -92,6 +102,8 @@ void gdt_init(void) {
     gdt_set_gate(4, 0, 0xFFFFFu, 0xF2u, 0xCFu);
     // 5: TSS
     write_tss(5, 0x10, 0);
+    // 6: user TLS data segment (base is per-thread, see gdt_set_tls_base)
+    gdt_set_gate(6, 0, 0xFFFFFu, 0xF2u, 0xCFu);
 
     gdt_flush((uint32_t)&gdtp);
     tss_flush(0x28);
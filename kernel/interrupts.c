@@ -5,6 +5,7 @@
 #include "task.h"
 #include "screen.h"
 #include "usercopy.h"
+#include "vsyscall.h"
 #include "string.h"
 
 static irq_handler_t irq_handlers[16] = {0};
@@ -121,11 +122,40 @@ static void print_user_backtrace(uint32_t ebp) {
     }
 }
 
+// Return to whichever task owns `frame`, closing out its syscall timing
+// before signal delivery can rewrite the frame.
+static interrupt_frame_t* interrupt_resume(interrupt_frame_t* frame) {
+    syscall_account_return(frame);
+    interrupt_frame_t* next = tasking_deliver_pending_signals(frame);
+    if (next != frame) {
+        syscall_account_return(next);
+    }
+    return next;
+}
+
 interrupt_frame_t* interrupt_handler(interrupt_frame_t* frame) {
     if (!frame) {
         panic("interrupt_handler: NULL frame");
     }
 
+    // SYSENTER leaves TF alone, so a single-stepped trampoline traps on the
+    // first kernel instruction. Drop TF and carry on.
+    if (frame->int_no == 1 && !frame_from_user(frame) && vsyscall_in_entry(frame->eip)) {
+        frame->eflags &= ~0x100u;
+        return frame;
+    }
+
+    // A kernel fault inside copy_from_user() and friends means a bad user
+    // pointer: resume at the copy's recovery path, which reports -EFAULT.
+    if (frame->int_no == 14 && !frame_from_user(frame) && usercopy_fixup(frame)) {
+        return frame;
+    }
+
+    // #NM from user code is the lazy FPU switch, not an error.
+    if (frame->int_no == 7 && frame_from_user(frame) && tasking_fpu_trap()) {
+        return frame;
+    }
+
     if (frame->int_no < 32) {
         if (frame_from_user(frame)) {
             screen_set_color(VGA_YELLOW, VGA_BLUE);
@@ -151,15 +181,20 @@ interrupt_frame_t* interrupt_handler(interrupt_frame_t* frame) {
             screen_set_color(VGA_LIGHT_RED, VGA_BLUE);
             screen_println("  -> killing user task");
             screen_set_color(VGA_WHITE, VGA_BLUE);
-            return tasking_exit(frame, -(int32_t)frame->int_no);
+            frame = tasking_exit(frame, -(int32_t)frame->int_no);
+            syscall_account_return(frame);
+            return frame;
         }
 
         panic_with_frame(exception_names[frame->int_no], frame);
     }
 
     if (frame->int_no == 0x80) {
+        if (frame->err_code == SYSCALL_FRAME_SYSENTER) {
+            vsyscall_fixup_frame(frame);
+        }
         frame = syscall_handle(frame);
-        return tasking_deliver_pending_signals(frame);
+        return interrupt_resume(frame);
     }
 
     if (frame->int_no >= 32 && frame->int_no < 48) {
@@ -172,12 +207,12 @@ interrupt_frame_t* interrupt_handler(interrupt_frame_t* frame) {
         pic_send_eoi(irq);
         if (irq == 0) {
             frame = tasking_on_timer_tick(frame);
-            return tasking_deliver_pending_signals(frame);
+            return interrupt_resume(frame);
         }
-        return tasking_deliver_pending_signals(frame);
+        return interrupt_resume(frame);
     }
 
-    return tasking_deliver_pending_signals(frame);
+    return interrupt_resume(frame);
 }
 
 void irq_get_counts(uint32_t out[16]) {
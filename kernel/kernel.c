@@ -26,6 +26,8 @@
 #include "speaker.h"
 #include "dma.h"
 #include "sb16.h"
+#include "fpu.h"
+#include "vsyscall.h"
 
 // Multiboot magic number
 #define MULTIBOOT_MAGIC 0x2BADB002
@@ -267,11 +269,13 @@ void kernel_main(uint32_t magic, uint32_t* mboot_info) {
     }
 
     system_init(magic, mboot_info);
+    fpu_init();
 
     gdt_init();
     tss_set_kernel_stack((uint32_t)&stack_top);
 
     idt_init();
+    vsyscall_init();
     screen_set_color(VGA_LIGHT_GREEN, VGA_BLUE);
     screen_print("[OK] ");
     screen_set_color(VGA_WHITE, VGA_BLUE);
@@ -6,6 +6,7 @@
 #include "ctype.h"
 #include "string.h"
 #include "serial.h"
+#include "pollwait.h"
 
 // Keyboard ports
 #define KEYBOARD_DATA_PORT   0x60
@@ -27,6 +28,9 @@ static bool extended_key = false;
 
 static void (*idle_hook)(void) = 0;
 
+static void keyboard_poll_serial(void);
+static poll_head_t keyboard_poll = { NULL, keyboard_poll_serial };
+
 // Spanish keyboard scancode to ASCII mapping (lowercase/unshifted)
 // Scancode index: 0x00-0x3F
 static const char scancode_to_ascii[] = {
@@ -85,6 +89,7 @@ static void buffer_push(char c) {
     if (next != buffer_start) {
         keyboard_buffer[buffer_end] = c;
         buffer_end = next;
+        poll_wake(&keyboard_poll, POLL_IN);
     }
 }
 
@@ -263,6 +268,21 @@ void keyboard_handler(void) {
     // PIC EOI is sent by the common IRQ handler.
 }
 
+// Serial input raises no interrupt; move whatever arrived into the buffer so
+// pollers waiting on the keyboard see it.
+static void keyboard_poll_serial(void) {
+    char c;
+    while (serial_try_read_char(&c)) {
+        uint32_t flags = irq_save();
+        buffer_push(c);
+        irq_restore(flags);
+    }
+}
+
+poll_head_t* keyboard_poll_head(void) {
+    return &keyboard_poll;
+}
+
 bool keyboard_has_key(void) {
     return buffer_start != buffer_end;
 }
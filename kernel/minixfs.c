@@ -1,6 +1,7 @@
 // Minix filesystem driver
 #include "minixfs.h"
-#include "ata.h"
+#include "bcache.h"
+#include "dcache.h"
 #include "kheap.h"
 #include "screen.h"
 #include "string.h"
@@ -53,82 +54,229 @@ typedef struct {
 
 static minixfs_t g_fs;
 
-// Cached blocks for bitmaps
-static uint8_t* g_imap = NULL;
-static uint8_t* g_zmap = NULL;
-
-// Read a block from the partition
+// In-memory copy of the inode or zone bitmap
+typedef struct {
+    uint8_t* bits;
+    uint32_t nbits;             // bits that stand for an inode or zone
+    uint32_t first_block;       // where the bitmap starts on disk
+    uint16_t nblocks;
+    uint16_t* block_free;       // free bits in each bitmap block
+    bool* block_dirty;          // changed since the last write_bitmaps()
+    uint32_t nfree;
+    uint32_t cursor;            // just past the last allocation
+} minix_bitmap_t;
+
+static minix_bitmap_t g_imap;
+static minix_bitmap_t g_zmap;
+
+// Generation of each inode number, bumped when the inode is freed, so a
+// holder of an inode number can tell a reused one from the one it had
+static uint16_t* g_igen;
+
+// Read a block from the partition (through the buffer cache)
 static bool read_block(uint32_t block, void* buf) {
     // Each block is 1024 bytes = 2 sectors
     uint32_t lba = g_fs.partition_lba + block * 2;
-    if (!ata_read_sector(lba, buf)) return false;
-    if (!ata_read_sector(lba + 1, (uint8_t*)buf + 512)) return false;
+    if (!bcache_read(BCACHE_DEV_ATA0, lba, buf)) return false;
+    if (!bcache_read(BCACHE_DEV_ATA0, lba + 1, (uint8_t*)buf + 512)) return false;
     return true;
 }
 
-// Write a block to the partition
+// Write a block to the partition; written back later by the buffer cache
 static bool write_block(uint32_t block, const void* buf) {
     uint32_t lba = g_fs.partition_lba + block * 2;
-    if (!ata_write_sector(lba, buf)) return false;
-    if (!ata_write_sector(lba + 1, (const uint8_t*)buf + 512)) return false;
+    if (!bcache_write(BCACHE_DEV_ATA0, lba, buf)) return false;
+    if (!bcache_write(BCACHE_DEV_ATA0, lba + 1, (const uint8_t*)buf + 512)) return false;
     return true;
 }
 
-// Get inode from inode number
-static bool read_inode_v1(uint32_t ino, minix_inode_v1_t* out) {
-    if (ino < 1 || ino > g_fs.ninodes) return false;
+static uint32_t inode_size(void) {
+    return g_fs.version == 1 ? sizeof(minix_inode_v1_t) : sizeof(minix_inode_v2_t);
+}
 
-    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / sizeof(minix_inode_v1_t);
+// Read or write inode `ino` in the inode table, bypassing the inode cache
+static bool disk_read_inode(uint32_t ino, void* out) {
+    uint32_t isize = inode_size();
+    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / isize;
     uint32_t block = g_fs.inode_table_block + (ino - 1) / inodes_per_block;
-    uint32_t offset = ((ino - 1) % inodes_per_block) * sizeof(minix_inode_v1_t);
+    uint32_t offset = ((ino - 1) % inodes_per_block) * isize;
 
     uint8_t buf[MINIX_BLOCK_SIZE];
     if (!read_block(block, buf)) return false;
 
-    memcpy(out, buf + offset, sizeof(minix_inode_v1_t));
+    memcpy(out, buf + offset, isize);
     return true;
 }
 
-static bool read_inode_v2(uint32_t ino, minix_inode_v2_t* out) {
-    if (ino < 1 || ino > g_fs.ninodes) return false;
-
-    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / sizeof(minix_inode_v2_t);
+static bool disk_write_inode(uint32_t ino, const void* in) {
+    uint32_t isize = inode_size();
+    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / isize;
     uint32_t block = g_fs.inode_table_block + (ino - 1) / inodes_per_block;
-    uint32_t offset = ((ino - 1) % inodes_per_block) * sizeof(minix_inode_v2_t);
+    uint32_t offset = ((ino - 1) % inodes_per_block) * isize;
 
     uint8_t buf[MINIX_BLOCK_SIZE];
     if (!read_block(block, buf)) return false;
 
-    memcpy(out, buf + offset, sizeof(minix_inode_v2_t));
+    memcpy(buf + offset, in, isize);
+    return write_block(block, buf);
+}
+
+// In-memory inode cache, keyed by inode number. An entry is referenced
+// while an operation works on it; writes to a referenced inode only dirty
+// the cached copy and the last iput() writes it back, so a multi-step
+// update (write_file, pwrite, truncate) costs one inode table write.
+// Unreferenced entries are clean unless a write-back failed; they are
+// recycled least recently used.
+#define ICACHE_SIZE 128u
+#define ICACHE_HASH_SIZE 64u   // power of two
+
+typedef struct icache_entry {
+    uint32_t ino;                   // 0: unused
+    uint32_t refs;
+    bool dirty;
+    struct icache_entry* hash_next;
+    struct icache_entry* lru_prev;  // towards the most recently used
+    struct icache_entry* lru_next;
+    uint8_t data[sizeof(minix_inode_v2_t)];  // v1 uses the first 32 bytes
+} icache_entry_t;
+
+static icache_entry_t g_icache[ICACHE_SIZE];
+static icache_entry_t* g_ihash[ICACHE_HASH_SIZE];
+static icache_entry_t* g_ilru_head = NULL;  // most recently used
+static icache_entry_t* g_ilru_tail = NULL;
+
+static void icache_lru_unlink(icache_entry_t* e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else g_ilru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else g_ilru_tail = e->lru_prev;
+    e->lru_prev = NULL;
+    e->lru_next = NULL;
+}
+
+static void icache_lru_push_front(icache_entry_t* e) {
+    e->lru_prev = NULL;
+    e->lru_next = g_ilru_head;
+    if (g_ilru_head) g_ilru_head->lru_prev = e;
+    else g_ilru_tail = e;
+    g_ilru_head = e;
+}
+
+// Drop every entry; called when a filesystem is mounted.
+static void icache_reset(void) {
+    memset(g_icache, 0, sizeof(g_icache));
+    memset(g_ihash, 0, sizeof(g_ihash));
+    g_ilru_head = NULL;
+    g_ilru_tail = NULL;
+    for (uint32_t i = 0; i < ICACHE_SIZE; i++) {
+        icache_lru_push_front(&g_icache[i]);
+    }
+}
+
+static void icache_hash_remove(icache_entry_t* e) {
+    for (icache_entry_t** pp = &g_ihash[e->ino & (ICACHE_HASH_SIZE - 1)]; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == e) {
+            *pp = e->hash_next;
+            break;
+        }
+    }
+    e->hash_next = NULL;
+}
+
+static bool icache_writeback(icache_entry_t* e) {
+    if (!disk_write_inode(e->ino, e->data)) return false;
+    e->dirty = false;
     return true;
 }
 
-static bool write_inode_v1(uint32_t ino, const minix_inode_v1_t* inode) {
-    if (ino < 1 || ino > g_fs.ninodes) return false;
+// Take a reference on inode `ino`, reading it in if `fill`. NULL if it
+// cannot be read or every entry is referenced.
+static icache_entry_t* iget(uint32_t ino, bool fill) {
+    if (ino < 1 || ino > g_fs.ninodes) return NULL;
 
-    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / sizeof(minix_inode_v1_t);
-    uint32_t block = g_fs.inode_table_block + (ino - 1) / inodes_per_block;
-    uint32_t offset = ((ino - 1) % inodes_per_block) * sizeof(minix_inode_v1_t);
+    uint32_t h = ino & (ICACHE_HASH_SIZE - 1);
+    icache_entry_t* e;
+    for (e = g_ihash[h]; e; e = e->hash_next) {
+        if (e->ino == ino) break;
+    }
 
-    uint8_t buf[MINIX_BLOCK_SIZE];
-    if (!read_block(block, buf)) return false;
+    if (!e) {
+        // Recycle the least recently used entry nobody holds
+        for (e = g_ilru_tail; e; e = e->lru_prev) {
+            if (e->refs == 0 && (!e->dirty || icache_writeback(e))) break;
+        }
+        if (!e) return NULL;
+        if (e->ino != 0) icache_hash_remove(e);
+        e->ino = 0;
+        e->dirty = false;
+        if (fill && !disk_read_inode(ino, e->data)) return NULL;
+        e->ino = ino;
+        e->hash_next = g_ihash[h];
+        g_ihash[h] = e;
+    }
 
-    memcpy(buf + offset, inode, sizeof(minix_inode_v1_t));
-    return write_block(block, buf);
+    e->refs++;
+    if (g_ilru_head != e) {
+        icache_lru_unlink(e);
+        icache_lru_push_front(e);
+    }
+    return e;
 }
 
-static bool write_inode_v2(uint32_t ino, const minix_inode_v2_t* inode) {
+// Drop a reference; the last one writes a dirty inode back. Returns false
+// if that write failed (the entry stays dirty and is retried).
+static bool iput(icache_entry_t* e) {
+    if (!e) return true;
+    if (--e->refs != 0 || !e->dirty) return true;
+    return icache_writeback(e);
+}
+
+// Write back every dirty inode, referenced or not.
+static bool icache_flush(void) {
+    bool ok = true;
+    for (uint32_t i = 0; i < ICACHE_SIZE; i++) {
+        icache_entry_t* e = &g_icache[i];
+        if (e->ino != 0 && e->dirty && !icache_writeback(e)) ok = false;
+    }
+    return ok;
+}
+
+// Get inode from inode number
+static bool read_inode_any(uint32_t ino, void* out) {
     if (ino < 1 || ino > g_fs.ninodes) return false;
 
-    uint32_t inodes_per_block = MINIX_BLOCK_SIZE / sizeof(minix_inode_v2_t);
-    uint32_t block = g_fs.inode_table_block + (ino - 1) / inodes_per_block;
-    uint32_t offset = ((ino - 1) % inodes_per_block) * sizeof(minix_inode_v2_t);
+    icache_entry_t* e = iget(ino, true);
+    if (!e) return disk_read_inode(ino, out);
+    memcpy(out, e->data, inode_size());
+    iput(e);
+    return true;
+}
 
-    uint8_t buf[MINIX_BLOCK_SIZE];
-    if (!read_block(block, buf)) return false;
+static bool write_inode_any(uint32_t ino, const void* inode) {
+    if (ino < 1 || ino > g_fs.ninodes) return false;
 
-    memcpy(buf + offset, inode, sizeof(minix_inode_v2_t));
-    return write_block(block, buf);
+    // The whole inode is replaced, so a miss need not read it first
+    icache_entry_t* e = iget(ino, false);
+    if (!e) return disk_write_inode(ino, inode);
+    memcpy(e->data, inode, inode_size());
+    e->dirty = true;
+    return iput(e);
+}
+
+static bool read_inode_v1(uint32_t ino, minix_inode_v1_t* out) {
+    return read_inode_any(ino, out);
+}
+
+static bool read_inode_v2(uint32_t ino, minix_inode_v2_t* out) {
+    return read_inode_any(ino, out);
+}
+
+static bool write_inode_v1(uint32_t ino, const minix_inode_v1_t* inode) {
+    return write_inode_any(ino, inode);
+}
+
+static bool write_inode_v2(uint32_t ino, const minix_inode_v2_t* inode) {
+    return write_inode_any(ino, inode);
 }
 
 // Get zone (block) number for a given file position
@@ -300,63 +448,197 @@ static uint32_t lookup_path(const char* path) {
     return current_ino;
 }
 
-// Bitmap operations
-static bool inode_is_used(uint32_t ino) {
-    if (!g_imap || ino < 1 || ino > g_fs.ninodes) return true;
-    uint32_t byte = (ino - 1) / 8;
-    uint32_t bit = (ino - 1) % 8;
-    return (g_imap[byte] & (1 << bit)) != 0;
+// Scan directory `dir_ino` for the entry called `name`. Returns the entry's
+// inode or 0.
+static uint32_t dir_find(uint32_t dir_ino, const char* name) {
+    uint8_t inode_buf[64];
+    if (!read_inode_any(dir_ino, inode_buf)) return 0;
+    uint16_t mode = (g_fs.version == 1) ? ((minix_inode_v1_t*)inode_buf)->i_mode
+                                        : ((minix_inode_v2_t*)inode_buf)->i_mode;
+    if (!MINIX_S_ISDIR(mode)) return 0;
+    uint32_t dir_size = (g_fs.version == 1) ? ((minix_inode_v1_t*)inode_buf)->i_size
+                                            : ((minix_inode_v2_t*)inode_buf)->i_size;
+
+    uint8_t block_buf[MINIX_BLOCK_SIZE];
+    for (uint32_t offset = 0; offset < dir_size; ) {
+        uint32_t zone_idx = offset / MINIX_BLOCK_SIZE;
+        uint32_t zone = (g_fs.version == 1) ? get_zone_v1((minix_inode_v1_t*)inode_buf, zone_idx)
+                                            : get_zone_v2((minix_inode_v2_t*)inode_buf, zone_idx);
+        if (zone == 0 || !read_block(zone, block_buf)) return 0;
+
+        for (uint32_t block_offset = offset % MINIX_BLOCK_SIZE;
+             block_offset < MINIX_BLOCK_SIZE && offset < dir_size;
+             block_offset += g_fs.dirent_size, offset += g_fs.dirent_size) {
+            uint16_t entry_ino = *(uint16_t*)(block_buf + block_offset);
+            char entry_name[32];
+            memcpy(entry_name, block_buf + block_offset + 2, g_fs.name_len);
+            entry_name[g_fs.name_len] = '\0';
+            if (entry_ino != 0 && strcmp(entry_name, name) == 0) return entry_ino;
+        }
+    }
+    return 0;
+}
+
+// A name that can be stored as one directory entry
+static bool entry_name_ok(const char* name) {
+    if (!name || name[0] == '\0' || strchr(name, '/')) return false;
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) return false;
+    return strlen(name) <= g_fs.name_len;
 }
 
-static void inode_set_used(uint32_t ino, bool used) {
-    if (!g_imap || ino < 1 || ino > g_fs.ninodes) return;
-    uint32_t byte = (ino - 1) / 8;
-    uint32_t bit = (ino - 1) % 8;
-    if (used) {
-        g_imap[byte] |= (1 << bit);
-    } else {
-        g_imap[byte] &= ~(1 << bit);
+// Bitmap operations. Bit i of the inode bitmap is inode i + 1 and bit i of
+// the zone bitmap is zone firstdatazone + i. Allocation scans a word at a
+// time from a goal, skipping bitmap blocks whose free count is zero, and
+// only the blocks that changed are written back.
+#define BITMAP_BITS_PER_BLOCK (MINIX_BLOCK_SIZE * 8u)
+#define BITMAP_WORDS_PER_BLOCK (MINIX_BLOCK_SIZE / 4u)
+#define BITMAP_NONE 0xFFFFFFFFu
+
+static uint32_t popcount32(uint32_t v) {
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+static void bitmap_release(minix_bitmap_t* bm) {
+    if (bm->bits) kfree(bm->bits);
+    if (bm->block_free) kfree(bm->block_free);
+    if (bm->block_dirty) kfree(bm->block_dirty);
+    memset(bm, 0, sizeof(*bm));
+}
+
+// Read `nblocks` bitmap blocks starting at `first_block` and count the free
+// bits among the first `nbits`.
+static bool bitmap_load(minix_bitmap_t* bm, uint32_t first_block, uint16_t nblocks, uint32_t nbits) {
+    memset(bm, 0, sizeof(*bm));
+    if (nbits > (uint32_t)nblocks * BITMAP_BITS_PER_BLOCK) nbits = (uint32_t)nblocks * BITMAP_BITS_PER_BLOCK;
+    bm->first_block = first_block;
+    bm->nblocks = nblocks;
+    bm->nbits = nbits;
+
+    bm->bits = (uint8_t*)kmalloc((uint32_t)nblocks * MINIX_BLOCK_SIZE);
+    bm->block_free = (uint16_t*)kmalloc((uint32_t)nblocks * sizeof(uint16_t));
+    bm->block_dirty = (bool*)kmalloc((uint32_t)nblocks * sizeof(bool));
+    if (!bm->bits || !bm->block_free || !bm->block_dirty) {
+        bitmap_release(bm);
+        return false;
+    }
+
+    const uint32_t* words = (const uint32_t*)bm->bits;
+    for (uint16_t b = 0; b < nblocks; b++) {
+        if (!read_block(first_block + b, bm->bits + (uint32_t)b * MINIX_BLOCK_SIZE)) {
+            bitmap_release(bm);
+            return false;
+        }
+        uint32_t used = 0;
+        uint32_t start = (uint32_t)b * BITMAP_BITS_PER_BLOCK;
+        uint32_t end = start + BITMAP_BITS_PER_BLOCK;
+        if (end > nbits) end = nbits;
+        for (uint32_t bit = start; bit < end; bit += 32) {
+            uint32_t w = words[bit / 32];
+            if (end - bit < 32) w &= (1u << (end - bit)) - 1u;
+            used += popcount32(w);
+        }
+        uint32_t total = end > start ? end - start : 0;
+        bm->block_free[b] = (uint16_t)(total - used);
+        bm->block_dirty[b] = false;
+        bm->nfree += total - used;
     }
+    return true;
 }
 
-static bool zone_is_used(uint32_t zone) {
-    if (!g_zmap || zone < g_fs.firstdatazone || zone >= g_fs.nzones) return true;
-    uint32_t idx = zone - g_fs.firstdatazone;
-    uint32_t byte = idx / 8;
-    uint32_t bit = idx % 8;
-    return (g_zmap[byte] & (1 << bit)) != 0;
+static bool bitmap_test(const minix_bitmap_t* bm, uint32_t bit) {
+    if (!bm->bits || bit >= bm->nbits) return true;
+    return (bm->bits[bit / 8] & (1u << (bit % 8))) != 0;
 }
 
-static void zone_set_used(uint32_t zone, bool used) {
-    if (!g_zmap || zone < g_fs.firstdatazone || zone >= g_fs.nzones) return;
-    uint32_t idx = zone - g_fs.firstdatazone;
-    uint32_t byte = idx / 8;
-    uint32_t bit = idx % 8;
+static void bitmap_set(minix_bitmap_t* bm, uint32_t bit, bool used) {
+    if (!bm->bits || bit >= bm->nbits || bitmap_test(bm, bit) == used) return;
+    uint32_t b = bit / BITMAP_BITS_PER_BLOCK;
     if (used) {
-        g_zmap[byte] |= (1 << bit);
+        bm->bits[bit / 8] |= (uint8_t)(1u << (bit % 8));
+        bm->block_free[b]--;
+        bm->nfree--;
     } else {
-        g_zmap[byte] &= ~(1 << bit);
+        bm->bits[bit / 8] &= (uint8_t)~(1u << (bit % 8));
+        bm->block_free[b]++;
+        bm->nfree++;
     }
+    bm->block_dirty[b] = true;
 }
 
-static uint32_t alloc_inode(void) {
-    for (uint32_t i = 1; i <= g_fs.ninodes; i++) {
-        if (!inode_is_used(i)) {
-            inode_set_used(i, true);
-            return i;
+// Find and take the first free bit at or after `goal`, wrapping around.
+// BITMAP_NONE when the bitmap is full.
+static uint32_t bitmap_alloc(minix_bitmap_t* bm, uint32_t goal) {
+    if (!bm->bits || bm->nfree == 0) return BITMAP_NONE;
+    if (goal >= bm->nbits) goal = 0;
+
+    const uint32_t* words = (const uint32_t*)bm->bits;
+    uint32_t nwords = (bm->nbits + 31) / 32;
+    uint32_t first = goal / BITMAP_BITS_PER_BLOCK;
+
+    // The goal's block is visited twice: from the goal, then (after the
+    // others) from its start.
+    for (uint32_t n = 0; n <= bm->nblocks; n++) {
+        uint32_t b = (first + n) % bm->nblocks;
+        if (bm->block_free[b] == 0) continue;
+
+        uint32_t w = n == 0 ? goal / 32 : b * BITMAP_WORDS_PER_BLOCK;
+        uint32_t end = (b + 1) * BITMAP_WORDS_PER_BLOCK;
+        if (end > nwords) end = nwords;
+        for (; w < end; w++) {
+            uint32_t free_bits = ~words[w];
+            if (n == 0 && w == goal / 32) free_bits &= ~0u << (goal % 32);
+            if (free_bits == 0) continue;
+            uint32_t bit = w * 32 + (uint32_t)__builtin_ctz(free_bits);
+            if (bit >= bm->nbits) break;
+            bitmap_set(bm, bit, true);
+            bm->cursor = bit + 1;
+            return bit;
         }
     }
-    return 0;
+    return BITMAP_NONE;
 }
 
-static uint32_t alloc_zone(void) {
-    for (uint32_t z = g_fs.firstdatazone; z < g_fs.nzones; z++) {
-        if (!zone_is_used(z)) {
-            zone_set_used(z, true);
-            return z;
+// Write back the bitmap blocks changed since the last call
+static bool bitmap_write(minix_bitmap_t* bm) {
+    bool ok = true;
+    for (uint16_t b = 0; b < bm->nblocks; b++) {
+        if (!bm->block_dirty[b]) continue;
+        if (write_block(bm->first_block + b, bm->bits + (uint32_t)b * MINIX_BLOCK_SIZE)) {
+            bm->block_dirty[b] = false;
+        } else {
+            ok = false;
         }
     }
-    return 0;
+    return ok;
+}
+
+static void inode_set_used(uint32_t ino, bool used) {
+    if (ino < 1) return;
+    bitmap_set(&g_imap, ino - 1, used);
+}
+
+static void zone_set_used(uint32_t zone, bool used) {
+    if (zone < g_fs.firstdatazone || zone >= g_fs.nzones) return;
+    bitmap_set(&g_zmap, zone - g_fs.firstdatazone, used);
+}
+
+// Allocate an inode, preferably right after `near` (the parent directory)
+// so that they share an inode table block; 0 means no preference.
+static uint32_t alloc_inode(uint32_t near) {
+    uint32_t goal = (near >= 1 && near <= g_fs.ninodes) ? near : g_imap.cursor;
+    uint32_t bit = bitmap_alloc(&g_imap, goal);
+    return bit == BITMAP_NONE ? 0 : bit + 1;
+}
+
+// Allocate a zone, preferably right after `near` (the previous zone of the
+// same file); 0 means continue where the last allocation ended.
+static uint32_t alloc_zone(uint32_t near) {
+    uint32_t goal = (near >= g_fs.firstdatazone && near < g_fs.nzones)
+                        ? near - g_fs.firstdatazone + 1 : g_zmap.cursor;
+    uint32_t bit = bitmap_alloc(&g_zmap, goal);
+    return bit == BITMAP_NONE ? 0 : g_fs.firstdatazone + bit;
 }
 
 static void free_zone(uint32_t zone) {
@@ -365,26 +647,22 @@ static void free_zone(uint32_t zone) {
 
 static void free_inode(uint32_t ino) {
     inode_set_used(ino, false);
+    if (g_igen && ino >= 1 && ino <= g_fs.ninodes) g_igen[ino]++;
 }
 
-// Write bitmaps to disk
+// Write changed bitmap blocks to disk
 static bool write_bitmaps(void) {
-    // Write inode bitmap
-    for (uint16_t i = 0; i < g_fs.imap_blocks; i++) {
-        if (!write_block(2 + i, g_imap + i * MINIX_BLOCK_SIZE)) return false;
-    }
-    // Write zone bitmap
-    for (uint16_t i = 0; i < g_fs.zmap_blocks; i++) {
-        if (!write_block(2 + g_fs.imap_blocks + i, g_zmap + i * MINIX_BLOCK_SIZE)) return false;
-    }
-    return true;
+    bool ok = bitmap_write(&g_imap);
+    if (!bitmap_write(&g_zmap)) ok = false;
+    return ok;
 }
 
 bool minixfs_init(uint32_t partition_lba_start) {
     memset(&g_fs, 0, sizeof(g_fs));
+    icache_reset();
 
-    if (g_imap) { kfree(g_imap); g_imap = NULL; }
-    if (g_zmap) { kfree(g_zmap); g_zmap = NULL; }
+    bitmap_release(&g_imap);
+    bitmap_release(&g_zmap);
 
     g_fs.partition_lba = partition_lba_start;
 
@@ -447,38 +725,22 @@ bool minixfs_init(uint32_t partition_lba_start) {
     g_fs.dirents_per_block = MINIX_BLOCK_SIZE / g_fs.dirent_size;
 
     // Load bitmaps
-    uint32_t imap_size = (uint32_t)g_fs.imap_blocks * MINIX_BLOCK_SIZE;
-    uint32_t zmap_size = (uint32_t)g_fs.zmap_blocks * MINIX_BLOCK_SIZE;
-
-    g_imap = (uint8_t*)kmalloc(imap_size);
-    g_zmap = (uint8_t*)kmalloc(zmap_size);
-
-    if (!g_imap || !g_zmap) {
-        if (g_imap) kfree(g_imap);
-        if (g_zmap) kfree(g_zmap);
-        g_imap = g_zmap = NULL;
+    if (!bitmap_load(&g_imap, 2, g_fs.imap_blocks, g_fs.ninodes) ||
+        !bitmap_load(&g_zmap, 2 + g_fs.imap_blocks, g_fs.zmap_blocks, g_fs.nzones - g_fs.firstdatazone)) {
+        bitmap_release(&g_imap);
         return false;
     }
 
-    // Read inode bitmap
-    for (uint16_t i = 0; i < g_fs.imap_blocks; i++) {
-        if (!read_block(2 + i, g_imap + i * MINIX_BLOCK_SIZE)) {
-            kfree(g_imap); kfree(g_zmap);
-            g_imap = g_zmap = NULL;
-            return false;
-        }
-    }
-
-    // Read zone bitmap
-    for (uint16_t i = 0; i < g_fs.zmap_blocks; i++) {
-        if (!read_block(2 + g_fs.imap_blocks + i, g_zmap + i * MINIX_BLOCK_SIZE)) {
-            kfree(g_imap); kfree(g_zmap);
-            g_imap = g_zmap = NULL;
-            return false;
-        }
+    if (g_igen) kfree(g_igen);
+    g_igen = (uint16_t*)kcalloc((uint32_t)g_fs.ninodes + 1u, sizeof(uint16_t));
+    if (!g_igen) {
+        bitmap_release(&g_imap);
+        bitmap_release(&g_zmap);
+        return false;
     }
 
     g_fs.mounted = true;
+    dcache_invalidate_all();
 
     screen_print("[MINIXFS] Mounted v");
     screen_print_dec(g_fs.version);
@@ -503,30 +765,36 @@ bool minixfs_statfs(uint32_t* total_blocks, uint32_t* free_blocks, uint32_t* tot
     if (total_blocks) *total_blocks = g_fs.nzones - g_fs.firstdatazone;
     if (total_inodes) *total_inodes = g_fs.ninodes;
 
-    if (free_blocks) {
-        uint32_t free = 0;
-        for (uint32_t z = g_fs.firstdatazone; z < g_fs.nzones; z++) {
-            if (!zone_is_used(z)) free++;
-        }
-        *free_blocks = free;
-    }
-
-    if (free_inodes) {
-        uint32_t free = 0;
-        for (uint32_t i = 1; i <= g_fs.ninodes; i++) {
-            if (!inode_is_used(i)) free++;
-        }
-        *free_inodes = free;
-    }
+    if (free_blocks) *free_blocks = g_zmap.nfree;
+    if (free_inodes) *free_inodes = g_imap.nfree;
 
     return true;
 }
 
+uint32_t minixfs_lookup(const char* path) {
+    return lookup_path(path);
+}
+
+uint32_t minixfs_lookup_at(uint32_t dir_ino, const char* name) {
+    if (!g_fs.mounted || !name || name[0] == '\0' || strlen(name) > g_fs.name_len) return 0;
+    return dir_find(dir_ino, name);
+}
+
+uint32_t minixfs_generation(uint32_t ino) {
+    if (!g_igen || ino < 1 || ino > g_fs.ninodes) return 0;
+    return g_igen[ino];
+}
+
 bool minixfs_stat(const char* path, minixfs_stat_t* out) {
     if (!g_fs.mounted || !path || !out) return false;
 
     uint32_t ino = lookup_path(path);
     if (ino == 0) return false;
+    return minixfs_stat_ino(ino, out);
+}
+
+bool minixfs_stat_ino(uint32_t ino, minixfs_stat_t* out) {
+    if (!g_fs.mounted || !out) return false;
 
     memset(out, 0, sizeof(*out));
     out->ino = ino;
@@ -572,74 +840,32 @@ uint8_t* minixfs_read_file(const char* path, uint32_t* out_size) {
     uint32_t ino = lookup_path(path);
     if (ino == 0) return NULL;
 
-    uint8_t inode_buf[64];
-    uint32_t file_size;
-    uint16_t mode;
-
-    if (g_fs.version == 1) {
-        minix_inode_v1_t* inode = (minix_inode_v1_t*)inode_buf;
-        if (!read_inode_v1(ino, inode)) return NULL;
-        if (!MINIX_S_ISREG(inode->i_mode) && !MINIX_S_ISLNK(inode->i_mode)) return NULL;
-        file_size = inode->i_size;
-        mode = inode->i_mode;
-    } else {
-        minix_inode_v2_t* inode = (minix_inode_v2_t*)inode_buf;
-        if (!read_inode_v2(ino, inode)) return NULL;
-        if (!MINIX_S_ISREG(inode->i_mode) && !MINIX_S_ISLNK(inode->i_mode)) return NULL;
-        file_size = inode->i_size;
-        mode = inode->i_mode;
-    }
-    (void)mode;
-
-    if (file_size == 0) {
-        *out_size = 0;
-        return (uint8_t*)kmalloc(1); // Return valid pointer for empty file
-    }
+    minixfs_stat_t st;
+    if (!minixfs_stat_ino(ino, &st)) return NULL;
+    if (!MINIX_S_ISREG(st.mode) && !MINIX_S_ISLNK(st.mode)) return NULL;
 
-    uint8_t* data = (uint8_t*)kmalloc(file_size);
+    // Valid pointer for an empty file
+    uint8_t* data = (uint8_t*)kmalloc(st.size ? st.size : 1);
     if (!data) return NULL;
-
-    uint32_t offset = 0;
-    while (offset < file_size) {
-        uint32_t zone_idx = offset / MINIX_BLOCK_SIZE;
-        uint32_t zone;
-
-        if (g_fs.version == 1) {
-            zone = get_zone_v1((minix_inode_v1_t*)inode_buf, zone_idx);
-        } else {
-            zone = get_zone_v2((minix_inode_v2_t*)inode_buf, zone_idx);
-        }
-
-        if (zone == 0) {
-            // Sparse file - fill with zeros
-            uint32_t to_copy = MINIX_BLOCK_SIZE;
-            if (offset + to_copy > file_size) to_copy = file_size - offset;
-            memset(data + offset, 0, to_copy);
-            offset += to_copy;
-            continue;
-        }
-
-        uint8_t block_buf[MINIX_BLOCK_SIZE];
-        if (!read_block(zone, block_buf)) {
-            kfree(data);
-            return NULL;
-        }
-
-        uint32_t to_copy = MINIX_BLOCK_SIZE;
-        if (offset + to_copy > file_size) to_copy = file_size - offset;
-        memcpy(data + offset, block_buf, to_copy);
-        offset += to_copy;
+    if (st.size != 0 && minixfs_pread(ino, 0, data, st.size) != (int32_t)st.size) {
+        kfree(data);
+        return NULL;
     }
 
-    *out_size = file_size;
+    *out_size = st.size;
     return data;
 }
 
 uint32_t minixfs_readdir(const char* path, minixfs_dirent_t* out, uint32_t max_entries) {
-    if (!g_fs.mounted || !path || !out || max_entries == 0) return 0;
+    if (!g_fs.mounted || !path) return 0;
 
     uint32_t ino = lookup_path(path);
     if (ino == 0) return 0;
+    return minixfs_readdir_ino(ino, out, max_entries);
+}
+
+uint32_t minixfs_readdir_ino(uint32_t ino, minixfs_dirent_t* out, uint32_t max_entries) {
+    if (!g_fs.mounted || ino == 0 || !out || max_entries == 0) return 0;
 
     uint8_t inode_buf[64];
     uint32_t dir_size;
@@ -742,6 +968,11 @@ bool minixfs_chmod(const char* path, uint16_t mode) {
 
     uint32_t ino = lookup_path(path);
     if (ino == 0) return false;
+    return minixfs_chmod_ino(ino, mode);
+}
+
+bool minixfs_chmod_ino(uint32_t ino, uint16_t mode) {
+    if (!g_fs.mounted || ino == 0) return false;
 
     if (g_fs.version == 1) {
         minix_inode_v1_t inode;
@@ -763,6 +994,11 @@ bool minixfs_chown(const char* path, uint16_t uid, uint16_t gid) {
 
     uint32_t ino = lookup_path(path);
     if (ino == 0) return false;
+    return minixfs_chown_ino(ino, uid, gid);
+}
+
+bool minixfs_chown_ino(uint32_t ino, uint16_t uid, uint16_t gid) {
+    if (!g_fs.mounted || ino == 0) return false;
 
     if (g_fs.version == 1) {
         minix_inode_v1_t inode;
@@ -783,8 +1019,9 @@ bool minixfs_chown(const char* path, uint16_t uid, uint16_t gid) {
 
 void minixfs_sync(void) {
     if (!g_fs.mounted) return;
+    icache_flush();
     write_bitmaps();
-    ata_flush();
+    bcache_sync();
 }
 
 // Helper: set zone pointer for v2 inode, allocating indirect blocks as needed
@@ -800,7 +1037,7 @@ static bool set_zone_v2(minix_inode_v2_t* inode, uint32_t zone_idx, uint32_t zon
     if (zone_idx < ptrs_per_block) {
         // Indirect block
         if (inode->i_zone[7] == 0) {
-            uint32_t indirect = alloc_zone();
+            uint32_t indirect = alloc_zone(zone_num);
             if (indirect == 0) return false;
             inode->i_zone[7] = indirect;
             uint8_t zero[MINIX_BLOCK_SIZE];
@@ -821,7 +1058,7 @@ static bool set_zone_v2(minix_inode_v2_t* inode, uint32_t zone_idx, uint32_t zon
 
         // Allocate double indirect block if needed
         if (inode->i_zone[8] == 0) {
-            uint32_t dbl_indirect = alloc_zone();
+            uint32_t dbl_indirect = alloc_zone(zone_num);
             if (dbl_indirect == 0) return false;
             inode->i_zone[8] = dbl_indirect;
             uint8_t zero[MINIX_BLOCK_SIZE];
@@ -836,7 +1073,7 @@ static bool set_zone_v2(minix_inode_v2_t* inode, uint32_t zone_idx, uint32_t zon
         // Get or allocate the secondary indirect block
         uint32_t* dbl_ptrs = (uint32_t*)dbl_buf;
         if (dbl_ptrs[indirect_idx] == 0) {
-            uint32_t sec_indirect = alloc_zone();
+            uint32_t sec_indirect = alloc_zone(zone_num);
             if (sec_indirect == 0) return false;
             dbl_ptrs[indirect_idx] = sec_indirect;
             if (!write_block(inode->i_zone[8], dbl_buf)) return false;
@@ -856,6 +1093,136 @@ static bool set_zone_v2(minix_inode_v2_t* inode, uint32_t zone_idx, uint32_t zon
     return false;
 }
 
+// Zone mapping for one pread/pwrite call. The indirect blocks on the way
+// are read once per call instead of once per zone, and the ones that gain
+// zone pointers are written back once, by map_flush().
+typedef struct {
+    uint32_t block;             // block held in ptrs[], 0 if none
+    bool dirty;
+    uint32_t ptrs[MINIX_BLOCK_SIZE / sizeof(uint32_t)];
+} map_block_t;
+
+static map_block_t g_map_ind;   // single indirect, or a block under the double one
+static map_block_t g_map_dbl;   // double indirect
+static bool g_map_allocated;    // zones were taken from the bitmap
+static uint32_t g_map_last;     // last zone mapped; new zones go after it
+
+static void map_begin(void) {
+    g_map_ind.block = 0;
+    g_map_ind.dirty = false;
+    g_map_dbl.block = 0;
+    g_map_dbl.dirty = false;
+    g_map_allocated = false;
+    g_map_last = 0;
+}
+
+static bool map_writeback(map_block_t* m) {
+    if (!m->dirty) return true;
+    if (!write_block(m->block, m->ptrs)) return false;
+    m->dirty = false;
+    return true;
+}
+
+static bool map_load(map_block_t* m, uint32_t block) {
+    if (m->block == block) return true;
+    if (!map_writeback(m)) return false;
+    if (!read_block(block, m->ptrs)) {
+        m->block = 0;
+        return false;
+    }
+    m->block = block;
+    return true;
+}
+
+// Allocate an empty indirect block into `m`. Returns its zone or 0.
+static uint32_t map_new_block(map_block_t* m) {
+    if (!map_writeback(m)) return 0;
+    uint32_t zone = alloc_zone(g_map_last);
+    if (zone == 0) return 0;
+    g_map_allocated = true;
+    memset(m->ptrs, 0, sizeof(m->ptrs));
+    m->block = zone;
+    m->dirty = true;
+    return zone;
+}
+
+// Zone holding block `zone_idx` of the file, or 0 for a hole. With `alloc`
+// the zone and any indirect blocks leading to it are allocated; *is_new
+// tells the caller the zone has no data yet.
+static uint32_t map_zone(minix_inode_v2_t* inode, uint32_t zone_idx, bool alloc, bool* is_new) {
+    const uint32_t ptrs_per_block = MINIX_BLOCK_SIZE / sizeof(uint32_t);
+    uint32_t* slot;
+
+    if (is_new) *is_new = false;
+
+    if (zone_idx < 7) {
+        // The inode is packed, so no pointer into i_zone[]
+        if (inode->i_zone[zone_idx] == 0 && alloc) {
+            uint32_t near = g_map_last ? g_map_last : (zone_idx ? inode->i_zone[zone_idx - 1] : 0);
+            uint32_t zone = alloc_zone(near);
+            if (zone == 0) return 0;
+            g_map_allocated = true;
+            inode->i_zone[zone_idx] = zone;
+            if (is_new) *is_new = true;
+        }
+        if (inode->i_zone[zone_idx] != 0) g_map_last = inode->i_zone[zone_idx];
+        return inode->i_zone[zone_idx];
+    }
+
+    if (zone_idx - 7 < ptrs_per_block) {
+        if (inode->i_zone[7] == 0) {
+            if (!alloc) return 0;
+            inode->i_zone[7] = map_new_block(&g_map_ind);
+            if (inode->i_zone[7] == 0) return 0;
+        } else if (!map_load(&g_map_ind, inode->i_zone[7])) {
+            return 0;
+        }
+        slot = &g_map_ind.ptrs[zone_idx - 7];
+    } else if (zone_idx - 7 - ptrs_per_block < ptrs_per_block * ptrs_per_block) {
+        uint32_t idx = zone_idx - 7 - ptrs_per_block;
+        if (inode->i_zone[8] == 0) {
+            if (!alloc) return 0;
+            inode->i_zone[8] = map_new_block(&g_map_dbl);
+            if (inode->i_zone[8] == 0) return 0;
+        } else if (!map_load(&g_map_dbl, inode->i_zone[8])) {
+            return 0;
+        }
+        uint32_t* sec = &g_map_dbl.ptrs[idx / ptrs_per_block];
+        if (*sec == 0) {
+            if (!alloc) return 0;
+            *sec = map_new_block(&g_map_ind);
+            if (*sec == 0) return 0;
+            g_map_dbl.dirty = true;
+        } else if (!map_load(&g_map_ind, *sec)) {
+            return 0;
+        }
+        slot = &g_map_ind.ptrs[idx % ptrs_per_block];
+    } else {
+        return 0;   // triple indirect not implemented
+    }
+
+    if (*slot == 0 && alloc) {
+        uint32_t near = g_map_last ? g_map_last : (slot != g_map_ind.ptrs ? slot[-1] : 0);
+        uint32_t zone = alloc_zone(near);
+        if (zone == 0) return 0;
+        g_map_allocated = true;
+        *slot = zone;
+        g_map_ind.dirty = true;
+        if (is_new) *is_new = true;
+    }
+    if (*slot != 0) g_map_last = *slot;
+    return *slot;
+}
+
+// Write back the indirect blocks changed since map_begin(), and the
+// bitmaps if zones were allocated.
+static bool map_flush(void) {
+    bool ok = map_writeback(&g_map_ind);
+    if (!map_writeback(&g_map_dbl)) ok = false;
+    if (g_map_allocated && !write_bitmaps()) ok = false;
+    return ok;
+}
+
 // Helper: find parent directory and base name from path
 static bool split_path(const char* path, uint32_t* parent_ino, char* base_name, uint32_t base_max) {
     if (!path || path[0] == '\0') return false;
@@ -893,6 +1260,7 @@ static bool split_path(const char* path, uint32_t* parent_ino, char* base_name,
 // Helper: add directory entry to a directory
 static bool add_dir_entry(uint32_t dir_ino, const char* name, uint32_t entry_ino) {
     if (g_fs.version != 2) return false; // Only v2 supported for writes
+    dcache_dir_changed(DCACHE_FS_MINIXFS, dir_ino, name);
 
     minix_inode_v2_t dir_inode;
     if (!read_inode_v2(dir_ino, &dir_inode)) return false;
@@ -938,7 +1306,7 @@ static bool add_dir_entry(uint32_t dir_ino, const char* name, uint32_t entry_ino
 
     // Need to extend directory - allocate new zone
     uint32_t zone_idx = dir_size / MINIX_BLOCK_SIZE;
-    uint32_t new_zone = alloc_zone();
+    uint32_t new_zone = alloc_zone(zone_idx != 0 && zone_idx <= 7 ? dir_inode.i_zone[zone_idx - 1] : 0);
     if (new_zone == 0) return false;
 
     if (!set_zone_v2(&dir_inode, zone_idx, new_zone)) {
@@ -967,6 +1335,7 @@ static bool add_dir_entry(uint32_t dir_ino, const char* name, uint32_t entry_ino
 // Helper: remove directory entry
 static bool remove_dir_entry(uint32_t dir_ino, const char* name) {
     if (g_fs.version != 2) return false;
+    dcache_dir_changed(DCACHE_FS_MINIXFS, dir_ino, name);
 
     minix_inode_v2_t dir_inode;
     if (!read_inode_v2(dir_ino, &dir_inode)) return false;
@@ -1014,32 +1383,68 @@ static bool remove_dir_entry(uint32_t dir_ino, const char* name) {
     return false;
 }
 
-// Helper: free all zones used by an inode
-static void free_inode_zones_v2(minix_inode_v2_t* inode) {
-    uint32_t num_zones = (inode->i_size + MINIX_BLOCK_SIZE - 1) / MINIX_BLOCK_SIZE;
+// Helper: free the zones from zone index `first` on, and the indirect
+// blocks that no longer map anything
+static void free_zones_from_v2(minix_inode_v2_t* inode, uint32_t first) {
+    uint32_t ptrs_per_block = MINIX_BLOCK_SIZE / sizeof(uint32_t);
 
-    for (uint32_t i = 0; i < 7 && i < num_zones; i++) {
+    for (uint32_t i = first; i < 7; i++) {
         if (inode->i_zone[i] != 0) {
             free_zone(inode->i_zone[i]);
             inode->i_zone[i] = 0;
         }
     }
 
-    // Free indirect block and its contents
-    if (inode->i_zone[7] != 0) {
-        uint8_t buf[MINIX_BLOCK_SIZE];
-        if (read_block(inode->i_zone[7], buf)) {
-            uint32_t ptrs_per_block = MINIX_BLOCK_SIZE / sizeof(uint32_t);
-            for (uint32_t i = 0; i < ptrs_per_block; i++) {
-                uint32_t z = ((uint32_t*)buf)[i];
-                if (z != 0) free_zone(z);
+    // Indirect block
+    uint32_t start = first > 7 ? first - 7 : 0;
+    if (inode->i_zone[7] != 0 && start < ptrs_per_block) {
+        uint32_t ptrs[MINIX_BLOCK_SIZE / sizeof(uint32_t)];
+        if (read_block(inode->i_zone[7], ptrs)) {
+            for (uint32_t i = start; i < ptrs_per_block; i++) {
+                if (ptrs[i] != 0) free_zone(ptrs[i]);
+                ptrs[i] = 0;
             }
+            if (start != 0) write_block(inode->i_zone[7], ptrs);
+        }
+        if (start == 0) {
+            free_zone(inode->i_zone[7]);
+            inode->i_zone[7] = 0;
         }
-        free_zone(inode->i_zone[7]);
-        inode->i_zone[7] = 0;
     }
 
-    // Don't bother with double/triple indirect for now
+    // Double indirect block
+    start = first > 7 + ptrs_per_block ? first - 7 - ptrs_per_block : 0;
+    if (inode->i_zone[8] != 0 && start < ptrs_per_block * ptrs_per_block) {
+        uint32_t dbl[MINIX_BLOCK_SIZE / sizeof(uint32_t)];
+        if (read_block(inode->i_zone[8], dbl)) {
+            for (uint32_t j = start / ptrs_per_block; j < ptrs_per_block; j++) {
+                if (dbl[j] == 0) continue;
+                uint32_t k0 = (j == start / ptrs_per_block) ? start % ptrs_per_block : 0;
+                uint32_t sec[MINIX_BLOCK_SIZE / sizeof(uint32_t)];
+                if (read_block(dbl[j], sec)) {
+                    for (uint32_t k = k0; k < ptrs_per_block; k++) {
+                        if (sec[k] != 0) free_zone(sec[k]);
+                        sec[k] = 0;
+                    }
+                    if (k0 != 0) write_block(dbl[j], sec);
+                }
+                if (k0 == 0) {
+                    free_zone(dbl[j]);
+                    dbl[j] = 0;
+                }
+            }
+            if (start != 0) write_block(inode->i_zone[8], dbl);
+        }
+        if (start == 0) {
+            free_zone(inode->i_zone[8]);
+            inode->i_zone[8] = 0;
+        }
+    }
+}
+
+// Helper: free all zones used by an inode
+static void free_inode_zones_v2(minix_inode_v2_t* inode) {
+    free_zones_from_v2(inode, 0);
 }
 
 bool minixfs_write_file(const char* path, const uint8_t* data, uint32_t size) {
@@ -1051,84 +1456,177 @@ bool minixfs_write_file(const char* path, const uint8_t* data, uint32_t size) {
     if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
 
     uint32_t ino = lookup_path(path);
-    minix_inode_v2_t inode;
+    if (ino == 0) {
+        ino = minixfs_create_at(parent_ino, base_name);
+        if (ino == 0) return false;
+    } else if (!minixfs_is_file(path)) {
+        return false;
+    }
+
+    // Overwrite in place: the zones already there are reused, pwrite
+    // allocates the ones past the old end and truncate frees the ones past
+    // the new end. Holding the inode writes it back once, at the end.
+    icache_entry_t* ie = iget(ino, true);
+    bool ok = (!data || size == 0 || minixfs_pwrite(ino, 0, data, size) == (int32_t)size) &&
+              minixfs_truncate(ino, size);
+    if (!iput(ie)) ok = false;
+    return ok;
+}
+
+uint32_t minixfs_create_at(uint32_t dir_ino, const char* name) {
+    if (!g_fs.mounted || g_fs.version != 2) return 0;
+    if (!entry_name_ok(name) || dir_find(dir_ino, name) != 0) return 0;
+
+    uint32_t ino = alloc_inode(dir_ino);
+    if (ino == 0) return 0;
 
     uint32_t now = get_current_time();
+    minix_inode_v2_t inode;
+    memset(&inode, 0, sizeof(inode));
+    inode.i_mode = MINIX_S_IFREG | 0644;
+    inode.i_nlinks = 1;
+    inode.i_uid = 0;
+    inode.i_gid = 0;
+    inode.i_size = 0;
+    inode.i_atime = now;
+    inode.i_mtime = now;
+    inode.i_ctime = now;
 
-    if (ino == 0) {
-        // Create new file
-        ino = alloc_inode();
-        if (ino == 0) return false;
+    if (!write_inode_v2(ino, &inode) || !add_dir_entry(dir_ino, name, ino)) {
+        free_inode(ino);
+        write_bitmaps();
+        return 0;
+    }
+    write_bitmaps();
+    return ino;
+}
 
-        memset(&inode, 0, sizeof(inode));
-        inode.i_mode = MINIX_S_IFREG | 0644;
-        inode.i_nlinks = 1;
-        inode.i_uid = 0;
-        inode.i_gid = 0;
-        inode.i_size = 0;
-        inode.i_atime = now;
-        inode.i_mtime = now;
-        inode.i_ctime = now;
+int32_t minixfs_pread(uint32_t ino, uint32_t off, uint8_t* buf, uint32_t len) {
+    if (!g_fs.mounted || (!buf && len != 0)) return -1;
 
-        if (!add_dir_entry(parent_ino, base_name, ino)) {
-            free_inode(ino);
-            write_bitmaps();
-            return false;
-        }
+    uint8_t inode_buf[64];
+    uint32_t file_size;
+    if (g_fs.version == 1) {
+        minix_inode_v1_t* inode = (minix_inode_v1_t*)inode_buf;
+        if (!read_inode_v1(ino, inode)) return -1;
+        if (!MINIX_S_ISREG(inode->i_mode) && !MINIX_S_ISLNK(inode->i_mode)) return -1;
+        file_size = inode->i_size;
     } else {
-        if (!read_inode_v2(ino, &inode)) return false;
-        if (!MINIX_S_ISREG(inode.i_mode)) return false;
-
-        // Free old zones
-        free_inode_zones_v2(&inode);
-        // Update modification time
-        inode.i_mtime = now;
-        inode.i_ctime = now;
+        minix_inode_v2_t* inode = (minix_inode_v2_t*)inode_buf;
+        if (!read_inode_v2(ino, inode)) return -1;
+        if (!MINIX_S_ISREG(inode->i_mode) && !MINIX_S_ISLNK(inode->i_mode)) return -1;
+        file_size = inode->i_size;
     }
 
-    // Write new data
-    inode.i_size = size;
-    uint32_t offset = 0;
-    uint32_t zone_idx = 0;
+    if (off >= file_size) return 0;
+    if (len > file_size - off) len = file_size - off;
 
-    while (offset < size) {
-        uint32_t zone = alloc_zone();
-        if (zone == 0) {
-            // Out of space
-            inode.i_size = offset;
-            write_inode_v2(ino, &inode);
-            write_bitmaps();
-            return false;
+    map_begin();
+    uint32_t done = 0;
+    while (done < len) {
+        uint32_t pos = off + done;
+        uint32_t block_off = pos % MINIX_BLOCK_SIZE;
+        uint32_t n = MINIX_BLOCK_SIZE - block_off;
+        if (n > len - done) n = len - done;
+
+        uint32_t zone;
+        if (g_fs.version == 1) {
+            zone = get_zone_v1((minix_inode_v1_t*)inode_buf, pos / MINIX_BLOCK_SIZE);
+        } else {
+            zone = map_zone((minix_inode_v2_t*)inode_buf, pos / MINIX_BLOCK_SIZE, false, NULL);
         }
 
-        if (!set_zone_v2(&inode, zone_idx, zone)) {
-            free_zone(zone);
-            inode.i_size = offset;
-            write_inode_v2(ino, &inode);
-            write_bitmaps();
-            return false;
+        if (zone == 0) {
+            memset(buf + done, 0, n);  // sparse
+        } else {
+            uint8_t block_buf[MINIX_BLOCK_SIZE];
+            if (!read_block(zone, block_buf)) return done ? (int32_t)done : -1;
+            memcpy(buf + done, block_buf + block_off, n);
         }
+        done += n;
+    }
+    return (int32_t)done;
+}
 
-        uint8_t block_buf[MINIX_BLOCK_SIZE];
-        memset(block_buf, 0, MINIX_BLOCK_SIZE);
-        uint32_t to_write = size - offset;
-        if (to_write > MINIX_BLOCK_SIZE) to_write = MINIX_BLOCK_SIZE;
-        if (data) memcpy(block_buf, data + offset, to_write);
+int32_t minixfs_pwrite(uint32_t ino, uint32_t off, const uint8_t* buf, uint32_t len) {
+    if (!g_fs.mounted || g_fs.version != 2 || (!buf && len != 0)) return -1;
+    if (off + len < off) return -1;
 
-        if (!write_block(zone, block_buf)) {
-            inode.i_size = offset;
-            write_inode_v2(ino, &inode);
-            write_bitmaps();
-            return false;
+    minix_inode_v2_t inode;
+    if (!read_inode_v2(ino, &inode)) return -1;
+    if (!MINIX_S_ISREG(inode.i_mode)) return -1;
+
+    // Existing zones are overwritten in place; only holes and the zones
+    // past the end are allocated.
+    map_begin();
+    uint32_t done = 0;
+    while (done < len) {
+        uint32_t pos = off + done;
+        uint32_t block_off = pos % MINIX_BLOCK_SIZE;
+        uint32_t n = MINIX_BLOCK_SIZE - block_off;
+        if (n > len - done) n = len - done;
+
+        bool is_new;
+        uint32_t zone = map_zone(&inode, pos / MINIX_BLOCK_SIZE, true, &is_new);
+        if (zone == 0) break;  // out of space
+
+        uint8_t block_buf[MINIX_BLOCK_SIZE];
+        if (is_new) {
+            memset(block_buf, 0, MINIX_BLOCK_SIZE);
+        } else if (n != MINIX_BLOCK_SIZE && !read_block(zone, block_buf)) {
+            break;
         }
 
-        offset += MINIX_BLOCK_SIZE;
-        zone_idx++;
+        memcpy(block_buf + block_off, buf + done, n);
+        if (!write_block(zone, block_buf)) break;
+        done += n;
     }
 
-    if (!write_inode_v2(ino, &inode)) return false;
-    write_bitmaps();
-    return true;
+    if (done != 0) {
+        if (off + done > inode.i_size) inode.i_size = off + done;
+        uint32_t now = get_current_time();
+        inode.i_mtime = now;
+        inode.i_ctime = now;
+    }
+    if (!map_flush()) done = 0;
+    if ((done != 0 || g_map_allocated) && !write_inode_v2(ino, &inode)) done = 0;
+
+    if (done == 0 && len != 0) return -1;
+    return (int32_t)done;
+}
+
+bool minixfs_truncate(uint32_t ino, uint32_t size) {
+    if (!g_fs.mounted || g_fs.version != 2) return false;
+
+    minix_inode_v2_t inode;
+    if (!read_inode_v2(ino, &inode)) return false;
+    if (!MINIX_S_ISREG(inode.i_mode)) return false;
+
+    bool freed = false;
+    if (size < inode.i_size) {
+        free_zones_from_v2(&inode, (size + MINIX_BLOCK_SIZE - 1) / MINIX_BLOCK_SIZE);
+        freed = true;
+
+        // Growing the file again must read zeros past the old end.
+        uint32_t tail = size % MINIX_BLOCK_SIZE;
+        uint32_t zone = tail ? get_zone_v2(&inode, size / MINIX_BLOCK_SIZE) : 0;
+        if (zone != 0) {
+            uint8_t block_buf[MINIX_BLOCK_SIZE];
+            if (read_block(zone, block_buf)) {
+                memset(block_buf + tail, 0, MINIX_BLOCK_SIZE - tail);
+                write_block(zone, block_buf);
+            }
+        }
+    }
+
+    // Growing leaves a hole; pread() returns zeros for it.
+    inode.i_size = size;
+    uint32_t now = get_current_time();
+    inode.i_mtime = now;
+    inode.i_ctime = now;
+    bool ok = write_inode_v2(ino, &inode);
+    if (freed) write_bitmaps();
+    return ok;
 }
 
 bool minixfs_mkdir(const char* path) {
@@ -1138,13 +1636,18 @@ bool minixfs_mkdir(const char* path) {
     uint32_t parent_ino;
     char base_name[32];
     if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
+    return minixfs_mkdir_at(parent_ino, base_name);
+}
 
-    if (lookup_path(path) != 0) return false; // Already exists
+bool minixfs_mkdir_at(uint32_t parent_ino, const char* base_name) {
+    if (!g_fs.mounted || g_fs.version != 2) return false;
+    if (!entry_name_ok(base_name)) return false;
+    if (dir_find(parent_ino, base_name) != 0) return false; // Already exists
 
-    uint32_t ino = alloc_inode();
+    uint32_t ino = alloc_inode(parent_ino);
     if (ino == 0) return false;
 
-    uint32_t zone = alloc_zone();
+    uint32_t zone = alloc_zone(0);
     if (zone == 0) {
         free_inode(ino);
         return false;
@@ -1201,7 +1704,11 @@ bool minixfs_mkdir(const char* path) {
         return false;
     }
 
+    // Hold the parent so the new entry and the link count reach the inode
+    // table in one write
+    icache_entry_t* parent = iget(parent_ino, true);
     if (!add_dir_entry(parent_ino, base_name, ino)) {
+        iput(parent);
         free_zone(zone);
         free_inode(ino);
         return false;
@@ -1213,6 +1720,7 @@ bool minixfs_mkdir(const char* path) {
         parent_inode.i_nlinks++;
         write_inode_v2(parent_ino, &parent_inode);
     }
+    iput(parent);
 
     write_bitmaps();
     return true;
@@ -1222,17 +1730,23 @@ bool minixfs_unlink(const char* path) {
     if (!g_fs.mounted || g_fs.version != 2) return false;
     if (!path || path[0] == '\0') return false;
 
-    uint32_t ino = lookup_path(path);
+    uint32_t parent_ino;
+    char base_name[32];
+    if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
+    return minixfs_unlink_at(parent_ino, base_name);
+}
+
+bool minixfs_unlink_at(uint32_t parent_ino, const char* base_name) {
+    if (!g_fs.mounted || g_fs.version != 2) return false;
+    if (!entry_name_ok(base_name)) return false;
+
+    uint32_t ino = dir_find(parent_ino, base_name);
     if (ino == 0) return false;
 
     minix_inode_v2_t inode;
     if (!read_inode_v2(ino, &inode)) return false;
     if (!MINIX_S_ISREG(inode.i_mode) && !MINIX_S_ISLNK(inode.i_mode)) return false;
 
-    uint32_t parent_ino;
-    char base_name[32];
-    if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
-
     if (!remove_dir_entry(parent_ino, base_name)) return false;
 
     inode.i_nlinks--;
@@ -1251,7 +1765,17 @@ bool minixfs_rmdir(const char* path) {
     if (!g_fs.mounted || g_fs.version != 2) return false;
     if (!path || path[0] == '\0') return false;
 
-    uint32_t ino = lookup_path(path);
+    uint32_t parent_ino;
+    char base_name[32];
+    if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
+    return minixfs_rmdir_at(parent_ino, base_name);
+}
+
+bool minixfs_rmdir_at(uint32_t parent_ino, const char* base_name) {
+    if (!g_fs.mounted || g_fs.version != 2) return false;
+    if (!entry_name_ok(base_name)) return false;
+
+    uint32_t ino = dir_find(parent_ino, base_name);
     if (ino == 0) return false;
     if (ino == MINIX_ROOT_INO) return false; // Can't remove root
 
@@ -1297,10 +1821,6 @@ bool minixfs_rmdir(const char* path) {
 
     if (entry_count > 0) return false; // Directory not empty
 
-    uint32_t parent_ino;
-    char base_name[32];
-    if (!split_path(path, &parent_ino, base_name, sizeof(base_name))) return false;
-
     if (!remove_dir_entry(parent_ino, base_name)) return false;
 
     free_inode_zones_v2(&inode);
@@ -1327,7 +1847,7 @@ bool minixfs_symlink(const char* target, const char* linkpath) {
 
     if (lookup_path(linkpath) != 0) return false; // Already exists
 
-    uint32_t ino = alloc_inode();
+    uint32_t ino = alloc_inode(parent_ino);
     if (ino == 0) return false;
 
     uint32_t target_len = (uint32_t)strlen(target);
@@ -1346,7 +1866,7 @@ bool minixfs_symlink(const char* target, const char* linkpath) {
 
     // Allocate zone for symlink target
     if (target_len > 0) {
-        uint32_t zone = alloc_zone();
+        uint32_t zone = alloc_zone(0);
         if (zone == 0) {
             free_inode(ino);
             return false;
@@ -1383,16 +1903,23 @@ bool minixfs_rename(const char* oldpath, const char* newpath) {
     if (!g_fs.mounted || g_fs.version != 2) return false;
     if (!oldpath || !newpath) return false;
 
-    uint32_t ino = lookup_path(oldpath);
-    if (ino == 0) return false;
-
     uint32_t old_parent_ino, new_parent_ino;
     char old_base[32], new_base[32];
     if (!split_path(oldpath, &old_parent_ino, old_base, sizeof(old_base))) return false;
     if (!split_path(newpath, &new_parent_ino, new_base, sizeof(new_base))) return false;
+    return minixfs_rename_at(old_parent_ino, old_base, new_parent_ino, new_base);
+}
+
+bool minixfs_rename_at(uint32_t old_parent_ino, const char* old_base,
+                       uint32_t new_parent_ino, const char* new_base) {
+    if (!g_fs.mounted || g_fs.version != 2) return false;
+    if (!entry_name_ok(old_base) || !entry_name_ok(new_base)) return false;
+
+    uint32_t ino = dir_find(old_parent_ino, old_base);
+    if (ino == 0) return false;
 
     // Check if destination exists
-    uint32_t dest_ino = lookup_path(newpath);
+    uint32_t dest_ino = dir_find(new_parent_ino, new_base);
     if (dest_ino != 0) {
         // Remove destination first
         minix_inode_v2_t dest_inode;
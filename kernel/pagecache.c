@@ -0,0 +1,406 @@
+#include "pagecache.h"
+#include "kerrno.h"
+#include "kheap.h"
+#include "minixfs.h"
+#include "serial.h"
+#include "string.h"
+
+#define PAGECACHE_HASH_SIZE 256u   // power of two
+
+typedef struct pc_page {
+    pagecache_inode_t* owner;
+    uint32_t index;                 // file offset / PAGECACHE_PAGE_SIZE
+    bool dirty;
+    uint16_t pins;                  // borrowed by pagecache_peek()
+    struct pc_page* hash_next;
+    struct pc_page* lru_prev;       // towards the most recently used
+    struct pc_page* lru_next;
+    struct pc_page* owner_next;     // the owner's pages
+    uint8_t data[PAGECACHE_PAGE_SIZE];
+} pc_page_t;
+
+struct pagecache_inode {
+    uint32_t ino;
+    uint32_t refs;
+    uint32_t size;
+    bool dead;                      // freed on disk; never write back
+    pc_page_t* pages;
+    pagecache_inode_t* next;
+};
+
+static pagecache_inode_t* g_inodes = NULL;
+static pc_page_t* g_hash[PAGECACHE_HASH_SIZE];
+static pc_page_t* g_lru_head = NULL;    // most recently used
+static pc_page_t* g_lru_tail = NULL;
+static uint32_t g_pages = 0;
+
+static uint32_t pc_hash(const pagecache_inode_t* pi, uint32_t index) {
+    return (index ^ ((uint32_t)pi >> 4) * 0x9E3779B1u) & (PAGECACHE_HASH_SIZE - 1u);
+}
+
+static void lru_unlink(pc_page_t* p) {
+    if (p->lru_prev) {
+        p->lru_prev->lru_next = p->lru_next;
+    } else {
+        g_lru_head = p->lru_next;
+    }
+    if (p->lru_next) {
+        p->lru_next->lru_prev = p->lru_prev;
+    } else {
+        g_lru_tail = p->lru_prev;
+    }
+    p->lru_prev = NULL;
+    p->lru_next = NULL;
+}
+
+static void lru_push_front(pc_page_t* p) {
+    p->lru_prev = NULL;
+    p->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = p;
+    } else {
+        g_lru_tail = p;
+    }
+    g_lru_head = p;
+}
+
+static void page_touch(pc_page_t* p) {
+    if (g_lru_head != p) {
+        lru_unlink(p);
+        lru_push_front(p);
+    }
+}
+
+static pc_page_t* page_lookup(pagecache_inode_t* pi, uint32_t index) {
+    for (pc_page_t* p = g_hash[pc_hash(pi, index)]; p; p = p->hash_next) {
+        if (p->owner == pi && p->index == index) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Bytes of page `index` that lie inside the file.
+static uint32_t page_valid_len(const pagecache_inode_t* pi, uint32_t index) {
+    uint32_t start = index * PAGECACHE_PAGE_SIZE;
+    if (start >= pi->size) {
+        return 0;
+    }
+    uint32_t n = pi->size - start;
+    return n < PAGECACHE_PAGE_SIZE ? n : PAGECACHE_PAGE_SIZE;
+}
+
+static bool page_writeback(pc_page_t* p) {
+    pagecache_inode_t* pi = p->owner;
+    uint32_t n = page_valid_len(pi, p->index);
+    if (!pi->dead && n != 0 &&
+        minixfs_pwrite(pi->ino, p->index * PAGECACHE_PAGE_SIZE, p->data, n) != (int32_t)n) {
+        serial_write_string("[PAGECACHE] write-back failed\n");
+        return false;
+    }
+    p->dirty = false;
+    return true;
+}
+
+static void page_free(pc_page_t* p) {
+    for (pc_page_t** pp = &g_hash[pc_hash(p->owner, p->index)]; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == p) {
+            *pp = p->hash_next;
+            break;
+        }
+    }
+    for (pc_page_t** pp = &p->owner->pages; *pp; pp = &(*pp)->owner_next) {
+        if (*pp == p) {
+            *pp = p->owner_next;
+            break;
+        }
+    }
+    lru_unlink(p);
+    g_pages--;
+    kfree(p);
+}
+
+// Free the least recently used unpinned page that is clean or can be
+// written back.
+static bool page_evict(void) {
+    for (pc_page_t* p = g_lru_tail; p; p = p->lru_prev) {
+        if (p->pins != 0) {
+            continue;
+        }
+        if (!p->dirty || page_writeback(p)) {
+            page_free(p);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find or read in page `index`. Pages past EOF come back zeroed.
+static pc_page_t* page_get(pagecache_inode_t* pi, uint32_t index, bool fill) {
+    pc_page_t* p = page_lookup(pi, index);
+    if (p) {
+        page_touch(p);
+        return p;
+    }
+
+    if (g_pages >= PAGECACHE_MAX_PAGES) {
+        (void)page_evict();
+    }
+    p = (pc_page_t*)kmalloc(sizeof(*p));
+    if (!p && page_evict()) {
+        p = (pc_page_t*)kmalloc(sizeof(*p));
+    }
+    if (!p) {
+        return NULL;
+    }
+
+    uint32_t n = fill && !pi->dead ? page_valid_len(pi, index) : 0;
+    if (n != 0 && minixfs_pread(pi->ino, index * PAGECACHE_PAGE_SIZE, p->data, n) != (int32_t)n) {
+        kfree(p);
+        return NULL;
+    }
+    memset(p->data + n, 0, PAGECACHE_PAGE_SIZE - n);
+
+    p->owner = pi;
+    p->index = index;
+    p->dirty = false;
+    p->pins = 0;
+    uint32_t h = pc_hash(pi, index);
+    p->hash_next = g_hash[h];
+    g_hash[h] = p;
+    p->owner_next = pi->pages;
+    pi->pages = p;
+    lru_push_front(p);
+    g_pages++;
+    return p;
+}
+
+pagecache_inode_t* pagecache_get(uint32_t ino) {
+    for (pagecache_inode_t* pi = g_inodes; pi; pi = pi->next) {
+        if (pi->ino == ino && !pi->dead) {
+            pi->refs++;
+            return pi;
+        }
+    }
+
+    minixfs_stat_t st;
+    if (!minixfs_stat_ino(ino, &st)) {
+        return NULL;
+    }
+    pagecache_inode_t* pi = (pagecache_inode_t*)kmalloc(sizeof(*pi));
+    if (!pi) {
+        return NULL;
+    }
+    memset(pi, 0, sizeof(*pi));
+    pi->ino = ino;
+    pi->refs = 1;
+    pi->size = st.size;
+    pi->next = g_inodes;
+    g_inodes = pi;
+    return pi;
+}
+
+int32_t pagecache_sync(pagecache_inode_t* pi) {
+    if (!pi) {
+        return -EINVAL;
+    }
+    int32_t rc = 0;
+    for (pc_page_t* p = pi->pages; p; p = p->owner_next) {
+        if (p->dirty && !page_writeback(p)) {
+            rc = -EIO;
+        }
+    }
+    return rc;
+}
+
+int32_t pagecache_sync_all(void) {
+    int32_t rc = 0;
+    for (pagecache_inode_t* pi = g_inodes; pi; pi = pi->next) {
+        if (pagecache_sync(pi) != 0) {
+            rc = -EIO;
+        }
+    }
+    return rc;
+}
+
+int32_t pagecache_put(pagecache_inode_t* pi) {
+    if (!pi) {
+        return -EINVAL;
+    }
+    if (--pi->refs != 0) {
+        return 0;
+    }
+
+    int32_t rc = pagecache_sync(pi);
+    while (pi->pages) {
+        page_free(pi->pages);
+    }
+    for (pagecache_inode_t** pp = &g_inodes; *pp; pp = &(*pp)->next) {
+        if (*pp == pi) {
+            *pp = pi->next;
+            break;
+        }
+    }
+    kfree(pi);
+    return rc;
+}
+
+uint32_t pagecache_size(const pagecache_inode_t* pi) {
+    return pi ? pi->size : 0;
+}
+
+int32_t pagecache_read(pagecache_inode_t* pi, uint32_t off, void* dst, uint32_t len, uint32_t* out_done) {
+    if (out_done) {
+        *out_done = 0;
+    }
+    if (!pi || (!dst && len != 0)) {
+        return -EINVAL;
+    }
+    if (off >= pi->size) {
+        return 0;
+    }
+    if (len > pi->size - off) {
+        len = pi->size - off;
+    }
+
+    uint32_t done = 0;
+    while (done < len) {
+        uint32_t pos = off + done;
+        uint32_t page_off = pos % PAGECACHE_PAGE_SIZE;
+        uint32_t n = PAGECACHE_PAGE_SIZE - page_off;
+        if (n > len - done) {
+            n = len - done;
+        }
+        pc_page_t* p = page_get(pi, pos / PAGECACHE_PAGE_SIZE, true);
+        if (!p) {
+            break;
+        }
+        memcpy((uint8_t*)dst + done, p->data + page_off, n);
+        done += n;
+    }
+
+    if (out_done) {
+        *out_done = done;
+    }
+    return (done == 0 && len != 0) ? -EIO : 0;
+}
+
+int32_t pagecache_write(pagecache_inode_t* pi, uint32_t off, const void* src, uint32_t len, uint32_t* out_done) {
+    if (out_done) {
+        *out_done = 0;
+    }
+    if (!pi || (!src && len != 0)) {
+        return -EINVAL;
+    }
+    uint32_t end = off + len;
+    if (end < off) {
+        return -EOVERFLOW;
+    }
+
+    uint32_t done = 0;
+    int32_t err = -ENOMEM;
+    while (done < len) {
+        uint32_t pos = off + done;
+        uint32_t page_off = pos % PAGECACHE_PAGE_SIZE;
+        uint32_t n = PAGECACHE_PAGE_SIZE - page_off;
+        if (n > len - done) {
+            n = len - done;
+        }
+        // A page that is overwritten whole need not be read first.
+        pc_page_t* p = page_get(pi, pos / PAGECACHE_PAGE_SIZE, n != PAGECACHE_PAGE_SIZE);
+        if (!p) {
+            break;
+        }
+        if (pos + n > pi->size) {
+            // Grow before dirtying: write-back stops at pi->size, so a page
+            // evicted later in this loop would otherwise lose its data. The
+            // inode grows too, so that stat() by path agrees; reads of a
+            // hole return zeros until the data is written back.
+            if (!pi->dead && !minixfs_truncate(pi->ino, pos + n)) {
+                err = -EIO;
+                break;
+            }
+            pi->size = pos + n;
+        }
+        memcpy(p->data + page_off, (const uint8_t*)src + done, n);
+        p->dirty = true;
+        done += n;
+    }
+
+    if (out_done) {
+        *out_done = done;
+    }
+    return (done == 0 && len != 0) ? err : 0;
+}
+
+int32_t pagecache_truncate(pagecache_inode_t* pi, uint32_t size) {
+    if (!pi) {
+        return -EINVAL;
+    }
+    if (!pi->dead && !minixfs_truncate(pi->ino, size)) {
+        return -EIO;
+    }
+
+    uint32_t keep = (size + PAGECACHE_PAGE_SIZE - 1u) / PAGECACHE_PAGE_SIZE;
+    pc_page_t* p = pi->pages;
+    while (p) {
+        pc_page_t* next = p->owner_next;
+        if (p->index >= keep && p->pins == 0) {
+            page_free(p);
+        } else if (p->index >= keep) {
+            // Still borrowed: keep it, but past EOF it reads as zeros.
+            memset(p->data, 0, PAGECACHE_PAGE_SIZE);
+        } else if (p->index == keep - 1u && size % PAGECACHE_PAGE_SIZE != 0) {
+            uint32_t tail = size % PAGECACHE_PAGE_SIZE;
+            memset(p->data + tail, 0, PAGECACHE_PAGE_SIZE - tail);
+        }
+        p = next;
+    }
+    pi->size = size;
+    return 0;
+}
+
+int32_t pagecache_peek(pagecache_inode_t* pi, uint32_t off, const uint8_t** out_data, uint32_t* out_len) {
+    if (!pi || !out_data || !out_len) {
+        return -EINVAL;
+    }
+    *out_data = NULL;
+    *out_len = 0;
+    if (off >= pi->size) {
+        return 0;
+    }
+    pc_page_t* p = page_get(pi, off / PAGECACHE_PAGE_SIZE, true);
+    if (!p) {
+        return -EIO;
+    }
+    uint32_t page_off = off % PAGECACHE_PAGE_SIZE;
+    uint32_t n = PAGECACHE_PAGE_SIZE - page_off;
+    if (n > pi->size - off) {
+        n = pi->size - off;
+    }
+    p->pins++;
+    *out_data = p->data + page_off;
+    *out_len = n;
+    return 0;
+}
+
+void pagecache_unpin(pagecache_inode_t* pi, uint32_t off) {
+    if (!pi) {
+        return;
+    }
+    pc_page_t* p = page_lookup(pi, off / PAGECACHE_PAGE_SIZE);
+    if (p && p->pins != 0) {
+        p->pins--;
+    }
+}
+
+void pagecache_forget(uint32_t ino) {
+    for (pagecache_inode_t* pi = g_inodes; pi; pi = pi->next) {
+        if (pi->ino == ino && !pi->dead) {
+            pi->dead = true;
+            for (pc_page_t* p = pi->pages; p; p = p->owner_next) {
+                p->dirty = false;
+            }
+        }
+    }
+}
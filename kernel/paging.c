@@ -1,7 +1,9 @@
 #include "paging.h"
 #include "early_alloc.h"
+#include "pmm.h"
 #include "string.h"
 #include "serial.h"
+#include "panic.h"
 
 static uint32_t* page_directory = NULL;
 static uint32_t* kernel_directory = NULL;
@@ -24,6 +26,22 @@ static bool is_kernel_vaddr(uint32_t vaddr) {
 
 static uint32_t* ensure_page_table(uint32_t* dir, uint32_t dir_index, uint32_t map_flags);
 
+uint32_t* paging_alloc_table(void) {
+    // Before pmm_init() only the early allocator exists. Afterwards take
+    // frames below USER_BASE: they are reachable through the shared identity
+    // mapping and never show up inside the user range.
+    uint32_t* table = NULL;
+    if (pmm_total_frames() != 0) {
+        table = (uint32_t*)pmm_alloc_frame_below(USER_BASE);
+    } else {
+        table = (uint32_t*)early_alloc(PAGE_SIZE, PAGE_SIZE);
+    }
+    if (table) {
+        memset(table, 0, PAGE_SIZE);
+    }
+    return table;
+}
+
 static void copy_shared_kernel_pdes(uint32_t* dst) {
     if (!dst || !kernel_directory || dst == kernel_directory) {
         return;
@@ -42,19 +60,9 @@ static void copy_shared_kernel_pdes(uint32_t* dst) {
         dst[i] = kernel_directory[i];
     }
 
-    // Keep the early allocator region visible to the kernel even when running
-    // on a user page directory. Large initramfs/modules can push early_alloc()
-    // above USER_BASE, and we still need to access page tables/directories
-    // stored there while setting up user mappings.
-    uint32_t early_start = early_alloc_start();
-    uint32_t early_end = early_alloc_current();
-    if (early_end > early_start) {
-        uint32_t start_idx = early_start >> 22;
-        uint32_t end_idx = (early_end - 1u) >> 22;
-        for (uint32_t i = start_idx; i <= end_idx && i < high_start; i++) {
-            dst[i] = kernel_directory[i];
-        }
-    }
+    // Nothing else is shared: page tables and directories live below
+    // USER_BASE (paging_alloc_table), so a user address space maps only user
+    // pages inside the user range.
 }
 
 void paging_prepare_range(uint32_t vaddr, uint32_t size, uint32_t flags) {
@@ -92,8 +100,10 @@ static uint32_t* ensure_page_table(uint32_t* dir, uint32_t dir_index, uint32_t m
         return (uint32_t*)(entry & 0xFFFFF000u);
     }
 
-    uint32_t* table = (uint32_t*)early_alloc(PAGE_SIZE, PAGE_SIZE);
-    memset(table, 0, PAGE_SIZE);
+    uint32_t* table = paging_alloc_table();
+    if (!table) {
+        return NULL;
+    }
     uint32_t pde_flags = PAGE_PRESENT | PAGE_RW;
     if (map_flags & PAGE_USER) {
         pde_flags |= PAGE_USER;
@@ -116,6 +126,7 @@ void paging_map_page(uint32_t vaddr, uint32_t paddr, uint32_t flags) {
         return;
     }
     table[tbl_index] = (paddr & 0xFFFFF000u) | (flags & 0xFFFu);
+    __asm__ volatile ("invlpg (%0)" : : "r"(vaddr) : "memory");
 
     // Keep kernel mappings shared across all address spaces.
     if (dir == kernel_directory && page_directory && page_directory != kernel_directory) {
@@ -167,46 +178,25 @@ static void enable_paging(uint32_t dir_paddr) {
     __asm__ volatile ("mov %0, %%cr3" : : "r"(dir_paddr) : "memory");
     uint32_t cr0;
     __asm__ volatile ("mov %%cr0, %0" : "=r"(cr0));
-    cr0 |= 0x80000000u;
+    // PG, plus WP so read-only user pages also stop kernel writes (a bad
+    // copy_to_user() target then faults instead of scribbling on it).
+    cr0 |= 0x80010000u;
     __asm__ volatile ("mov %0, %%cr0" : : "r"(cr0) : "memory");
 }
 
 void paging_init(const multiboot_info_t* mbi) {
-    page_directory = (uint32_t*)early_alloc(PAGE_SIZE, PAGE_SIZE);
-    memset(page_directory, 0, PAGE_SIZE);
+    page_directory = paging_alloc_table();
+    if (!page_directory) {
+        panic("paging: no early memory below 32 MiB for the page directory");
+    }
     kernel_directory = page_directory;
 
-    // Identity-map enough low physical memory to cover:
-    // - The kernel + early boot data
-    // - Multiboot structures/modules
-    // - early_alloc() allocations (page tables, etc.)
-    //
-    // Historically we mapped a fixed 16 MiB, but large initramfs/modules can
-    // push early_alloc() above that, causing faults immediately after paging
-    // is enabled (before IDT is set up).
-    uint32_t mapped_end = 0;
-    for (;;) {
-        uint32_t target_end = USER_BASE;
-
-        uint32_t early_end = early_alloc_current();
-        if (early_end > target_end) {
-            target_end = early_end;
-        }
-
-        // Round up to a 4 MiB boundary to avoid repeated small extensions.
-        target_end = (target_end + 0x3FFFFFu) & ~0x3FFFFFu;
-
-        if (mapped_end >= target_end) {
-            break;
-        }
-
-        paging_map_range(mapped_end, mapped_end, target_end - mapped_end, PAGE_PRESENT | PAGE_RW);
-        mapped_end = target_end;
-
-        // Mapping additional regions may allocate new page tables, which bumps
-        // early_alloc_current(). Loop until the mapping covers it.
-        if (mapped_end >= early_alloc_current()) {
-            break;
+    // Identity-map everything below USER_BASE: the kernel, early boot data
+    // and every early_alloc() allocation, which early_alloc() keeps below it.
+    paging_map_range(0, 0, USER_BASE, PAGE_PRESENT | PAGE_RW);
+    for (uint32_t i = 0; i < (USER_BASE >> 22); i++) {
+        if ((page_directory[i] & PAGE_PRESENT) == 0) {
+            panic("paging: kernel and boot modules leave no early memory below 32 MiB");
         }
     }
 
@@ -260,8 +250,10 @@ uint32_t* paging_create_user_directory(void) {
         return NULL;
     }
 
-    uint32_t* dir = (uint32_t*)early_alloc(PAGE_SIZE, PAGE_SIZE);
-    memset(dir, 0, PAGE_SIZE);
+    uint32_t* dir = paging_alloc_table();
+    if (!dir) {
+        return NULL;
+    }
 
     copy_shared_kernel_pdes(dir);
 
@@ -286,54 +278,31 @@ void paging_switch_directory(uint32_t* dir) {
     __asm__ volatile ("mov %0, %%cr3" : : "r"((uint32_t)dir & 0xFFFFF000u) : "memory");
 }
 
-bool paging_user_accessible_range(uint32_t vaddr, uint32_t size, bool write) {
-    if (size == 0) {
-        return true;
-    }
-
-    uint32_t end = vaddr + size;
-    if (end < vaddr) {
-        return false;
-    }
+bool paging_in_user_space(void) {
+    return page_directory && page_directory != kernel_directory;
+}
 
-    // VOS user address range (matches kernel/elf.c).
-    if (vaddr < USER_BASE) {
-        return false;
-    }
-    if (end > USER_LIMIT) {
+bool paging_user_virt_to_phys(uint32_t vaddr, uint32_t* out_paddr) {
+    if (vaddr < USER_BASE || vaddr >= USER_LIMIT) {
         return false;
     }
 
-    uint32_t start_v = page_align_down(vaddr);
-    uint32_t end_v = page_align_up(end);
-
     uint32_t cr3 = paging_get_cr3();
     uint32_t* dir = (uint32_t*)(cr3 & 0xFFFFF000u);
 
-    for (uint32_t va = start_v; va < end_v; va += PAGE_SIZE) {
-        uint32_t dir_index = (va >> 22) & 0x3FFu;
-        uint32_t tbl_index = (va >> 12) & 0x3FFu;
-
-        uint32_t pde = dir[dir_index];
-        if ((pde & PAGE_PRESENT) == 0) {
-            return false;
-        }
-        if ((pde & PAGE_USER) == 0) {
-            return false;
-        }
+    uint32_t pde = dir[(vaddr >> 22) & 0x3FFu];
+    if ((pde & (PAGE_PRESENT | PAGE_USER)) != (PAGE_PRESENT | PAGE_USER)) {
+        return false;
+    }
 
-        uint32_t* table = (uint32_t*)(pde & 0xFFFFF000u);
-        uint32_t pte = table[tbl_index];
-        if ((pte & PAGE_PRESENT) == 0) {
-            return false;
-        }
-        if ((pte & PAGE_USER) == 0) {
-            return false;
-        }
-        if (write && ((pte & PAGE_RW) == 0)) {
-            return false;
-        }
+    uint32_t* table = (uint32_t*)(pde & 0xFFFFF000u);
+    uint32_t pte = table[(vaddr >> 12) & 0x3FFu];
+    if ((pte & (PAGE_PRESENT | PAGE_USER)) != (PAGE_PRESENT | PAGE_USER)) {
+        return false;
     }
 
+    if (out_paddr) {
+        *out_paddr = (pte & 0xFFFFF000u) | (vaddr & 0xFFFu);
+    }
     return true;
 }
@@ -0,0 +1,139 @@
+#include "pollwait.h"
+#include "io.h"
+#include "task.h"
+#include "timer.h"
+
+void poll_add(poll_head_t* h, poll_entry_t* e, poll_func_t func) {
+    if (!h || !e) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    e->func = func;
+    e->head = h;
+    e->next = h->first;
+    h->first = e;
+    irq_restore(flags);
+}
+
+void poll_remove(poll_entry_t* e) {
+    if (!e) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    poll_head_t* h = e->head;
+    if (h) {
+        for (poll_entry_t** pp = &h->first; *pp; pp = &(*pp)->next) {
+            if (*pp == e) {
+                *pp = e->next;
+                break;
+            }
+        }
+        e->head = NULL;
+        e->next = NULL;
+    }
+    irq_restore(flags);
+}
+
+void poll_wake(poll_head_t* h, uint32_t events) {
+    if (!h) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    poll_entry_t* e = h->first;
+    while (e) {
+        // The callback may unhook its own entry.
+        poll_entry_t* next = e->next;
+        if (e->func) {
+            e->func(e, events);
+        }
+        e = next;
+    }
+    irq_restore(flags);
+}
+
+void poll_head_detach(poll_head_t* h) {
+    if (!h) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    poll_wake(h, POLL_IN | POLL_OUT | POLL_HUP);
+    poll_entry_t* e = h->first;
+    while (e) {
+        poll_entry_t* next = e->next;
+        e->head = NULL;
+        e->next = NULL;
+        e = next;
+    }
+    h->first = NULL;
+    irq_restore(flags);
+}
+
+static void poll_waiter_func(poll_entry_t* e, uint32_t events) {
+    (void)events;
+    ((poll_slot_t*)e)->owner->woken = true;
+}
+
+void poll_waiter_init(poll_waiter_t* w) {
+    w->woken = false;
+    w->overflow = false;
+    w->count = 0;
+}
+
+void poll_waiter_watch(poll_waiter_t* w, poll_head_t* h) {
+    if (!h) {
+        return;
+    }
+    for (uint32_t i = 0; i < w->count; i++) {
+        if (w->slots[i].entry.head == h) {
+            return;
+        }
+    }
+    if (w->count >= POLL_WAITER_SLOTS) {
+        w->overflow = true;
+        return;
+    }
+    poll_slot_t* s = &w->slots[w->count++];
+    s->owner = w;
+    s->entry.next = NULL;
+    s->entry.head = NULL;
+    poll_add(h, &s->entry, poll_waiter_func);
+}
+
+void poll_waiter_release(poll_waiter_t* w) {
+    for (uint32_t i = 0; i < w->count; i++) {
+        poll_remove(&w->slots[i].entry);
+    }
+    w->count = 0;
+}
+
+void poll_waiter_wait(poll_waiter_t* w, uint32_t deadline) {
+    bool were_enabled = irq_are_enabled();
+    if (!were_enabled) {
+        sti();
+    }
+    for (;;) {
+        for (uint32_t i = 0; i < w->count; i++) {
+            poll_head_t* h = w->slots[i].entry.head;
+            if (h && h->poll) {
+                h->poll();
+            }
+        }
+        if (w->woken) {
+            break;
+        }
+        if (deadline != 0 && timer_get_ticks() >= deadline) {
+            break;
+        }
+        if (tasking_current_should_interrupt()) {
+            break;
+        }
+        hlt();
+        if (w->overflow) {
+            break;
+        }
+    }
+    if (!were_enabled) {
+        cli();
+    }
+    w->woken = false;
+}
@@ -1,4 +1,5 @@
 #include "ramfs.h"
+#include "dcache.h"
 #include "kheap.h"
 #include "rtc.h"
 #include "string.h"
@@ -404,6 +405,9 @@ bool ramfs_set_meta(const char* path, bool is_symlink, uint16_t mode) {
 
     int fidx = find_file_rel(rel);
     if (fidx >= 0) {
+        if (files[fidx].is_symlink != is_symlink) {
+            dcache_fs_changed(DCACHE_FS_RAMFS);
+        }
         files[fidx].is_symlink = is_symlink;
         files[fidx].mode = mode;
         return true;
@@ -639,6 +643,7 @@ bool ramfs_mkdir(const char* path) {
         dirs[slot].mode = 0755u;
         dirs[slot].wtime = wtime;
         dirs[slot].wdate = wdate;
+        dcache_fs_changed(DCACHE_FS_RAMFS);
     }
 
     return true;
@@ -691,6 +696,7 @@ bool ramfs_write_file(const char* path, const uint8_t* data, uint32_t size, bool
         files[idx].mode = 0644u;
         files[idx].wtime = 0;
         files[idx].wdate = 0;
+        dcache_fs_changed(DCACHE_FS_RAMFS);
     } else {
         if (files[idx].data) {
             kfree(files[idx].data);
@@ -764,6 +770,7 @@ bool ramfs_rename(const char* old_path, const char* new_path) {
     }
     kfree(files[idx].path);
     files[idx].path = dup;
+    dcache_fs_changed(DCACHE_FS_RAMFS);
     return true;
 }
 
@@ -798,6 +805,7 @@ bool ramfs_unlink(const char* path) {
     files[idx].mode = 0;
     files[idx].wtime = 0;
     files[idx].wdate = 0;
+    dcache_fs_changed(DCACHE_FS_RAMFS);
     return true;
 }
 
@@ -850,6 +858,7 @@ bool ramfs_rmdir(const char* path) {
         }
     }
 
+    dcache_fs_changed(DCACHE_FS_RAMFS);
     return true;
 }
 
@@ -212,3 +212,17 @@ bool rtc_set_datetime(const rtc_datetime_t* dt) {
     cmos_write(0x0B, regb);
     return true;
 }
+
+uint32_t rtc_datetime_to_unix(const rtc_datetime_t* dt) {
+    uint32_t days = 0;
+    for (uint16_t y = 1970; y < dt->year; y++) {
+        days += is_leap_year(y) ? 366u : 365u;
+    }
+    for (uint8_t m = 1; m < dt->month && m <= 12; m++) {
+        days += days_in_month(dt->year, m);
+    }
+    if (dt->day > 0) {
+        days += dt->day - 1u;
+    }
+    return days * 86400u + dt->hour * 3600u + dt->minute * 60u + dt->second;
+}
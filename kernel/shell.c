@@ -19,6 +19,8 @@
 #include "editor.h"
 #include "microrl.h"
 #include "minixfs.h"
+#include "bcache.h"
+#include "pagecache.h"
 #include "kheap.h"
 #include "speaker.h"
 
@@ -1000,9 +1002,21 @@ static void cmd_fetch(void) {
     print_neofetch_like_banner();
 }
 
+// Write every cache level out before the machine goes away: dirty file
+// pages, then minixfs inodes and bitmaps, then the buffer cache. The caches
+// are not reentrant, so keep bflushd out while this runs.
+static void sync_filesystems(void) {
+    uint32_t flags = irq_save();
+    (void)pagecache_sync_all();
+    minixfs_sync();
+    (void)bcache_sync();
+    irq_restore(flags);
+}
+
 // Reboot command
 static void cmd_reboot(void) {
     screen_println("Rebooting...");
+    sync_filesystems();
 
     // Try keyboard controller reset
     uint8_t good = 0x02;
@@ -1017,6 +1031,7 @@ static void cmd_reboot(void) {
 
 // Halt command
 static void cmd_halt(void) {
+    sync_filesystems();
     screen_println("System halted. You can safely power off.");
     cli();
     for (;;) {
@@ -19,6 +19,10 @@
 #include "speaker.h"
 #include "sb16.h"
 #include "minixfs.h"
+#include "bcache.h"
+#include "uring.h"
+#include "epoll.h"
+#include "pollwait.h"
 
 // Keep syscall argv marshalling bounded (argv strings are copied into
 // kernel memory before switching address spaces for exec/spawn).
@@ -143,7 +147,31 @@ enum {
     SYS_DISK_INFO = 100,
     SYS_SET_CONSOLE = 101,
     SYS_PIVOT_ROOT = 102,
-    SYS_MAX = 103,
+    SYS_CLONE = 103,
+    SYS_THREAD_EXIT = 104,
+    SYS_GETTID = 105,
+    SYS_SET_TLS = 106,
+    SYS_FUTEX = 107,
+    SYS_URING_SETUP = 108,
+    SYS_URING_ENTER = 109,
+    SYS_SYSCALL_TRACE = 110,
+    SYS_EPOLL_CREATE = 111,
+    SYS_EPOLL_CTL = 112,
+    SYS_EPOLL_WAIT = 113,
+    SYS_READV = 114,
+    SYS_WRITEV = 115,
+    SYS_PREAD = 116,
+    SYS_PWRITE = 117,
+    SYS_SENDFILE = 118,
+    SYS_SPLICE = 119,
+    SYS_GETDENTS = 120,
+    SYS_OPENAT = 121,
+    SYS_FSTATAT = 122,
+    SYS_MKDIRAT = 123,
+    SYS_UNLINKAT = 124,
+    SYS_RENAMEAT = 125,
+    SYS_TASK_SNAPSHOT = 126,
+    SYS_MAX = 127,
 };
 
 // Syscall counters - track how many times each syscall is invoked
@@ -254,6 +282,30 @@ static const char* syscall_names[SYS_MAX] = {
     [SYS_DISK_INFO] = "disk_info",
     [SYS_SET_CONSOLE] = "set_console",
     [SYS_PIVOT_ROOT] = "pivot_root",
+    [SYS_CLONE] = "clone",
+    [SYS_THREAD_EXIT] = "thread_exit",
+    [SYS_GETTID] = "gettid",
+    [SYS_SET_TLS] = "set_tls",
+    [SYS_FUTEX] = "futex",
+    [SYS_URING_SETUP] = "uring_setup",
+    [SYS_URING_ENTER] = "uring_enter",
+    [SYS_SYSCALL_TRACE] = "syscall_trace",
+    [SYS_EPOLL_CREATE] = "epoll_create",
+    [SYS_EPOLL_CTL] = "epoll_ctl",
+    [SYS_EPOLL_WAIT] = "epoll_wait",
+    [SYS_READV] = "readv",
+    [SYS_WRITEV] = "writev",
+    [SYS_PREAD] = "pread",
+    [SYS_PWRITE] = "pwrite",
+    [SYS_SENDFILE] = "sendfile",
+    [SYS_SPLICE] = "splice",
+    [SYS_GETDENTS] = "getdents",
+    [SYS_OPENAT] = "openat",
+    [SYS_FSTATAT] = "fstatat",
+    [SYS_MKDIRAT] = "mkdirat",
+    [SYS_UNLINKAT] = "unlinkat",
+    [SYS_RENAMEAT] = "renameat",
+    [SYS_TASK_SNAPSHOT] = "task_snapshot",
 };
 
 typedef struct vos_task_info_user {
@@ -269,6 +321,38 @@ typedef struct vos_task_info_user {
     char name[16];
 } vos_task_info_user_t;
 
+// SYS_TASK_SNAPSHOT record: the SYS_TASK_INFO fields plus accounting.
+typedef struct vos_task_stat_user {
+    vos_task_info_user_t info;
+    uint32_t tgid;
+    uint32_t ppid;
+    uint32_t uid;
+    uint32_t sys_ticks;
+    uint32_t rss_pages;
+    uint32_t faults;
+    uint32_t switches;
+    uint32_t start_tick;
+    uint32_t state_ticks[TASK_STATE_COUNT];
+} vos_task_stat_user_t;
+
+// Records per SYS_TASK_SNAPSHOT call; callers page with the start index.
+#define TASK_SNAPSHOT_MAX 256u
+
+static void task_info_to_user(vos_task_info_user_t* out, const task_info_t* info) {
+    out->pid = info->pid;
+    out->user = info->user ? 1u : 0u;
+    out->state = (uint32_t)info->state;
+    out->cpu_ticks = info->cpu_ticks;
+    out->eip = info->eip;
+    out->esp = info->esp;
+    out->exit_code = info->exit_code;
+    out->wake_tick = info->wake_tick;
+    out->wait_pid = info->wait_pid;
+    for (uint32_t i = 0; i < (uint32_t)sizeof(out->name); i++) {
+        out->name[i] = info->name[i];
+    }
+}
+
 typedef struct vos_font_info_user {
     char name[32];
     uint32_t width;
@@ -306,6 +390,10 @@ typedef struct vos_sched_stats_user {
     uint32_t sleeping;
     uint32_t waiting;
     uint32_t zombie;
+    uint32_t kstacks_in_use;    // kernel stacks owned by tasks
+    uint32_t kstacks_cached;    // freed stacks kept mapped for reuse
+    uint32_t kstack_size;
+    uint32_t kstack_max_depth;  // deepest kernel stack use seen, in bytes
 } vos_sched_stats_user_t;
 
 typedef struct vos_descriptor_info_user {
@@ -316,13 +404,49 @@ typedef struct vos_descriptor_info_user {
     uint32_t tss_esp0;
 } vos_descriptor_info_user_t;
 
-#define VOS_SYSCALL_STATS_MAX 80
+#define VOS_SYSCALL_STATS_MAX 128
 typedef struct vos_syscall_stats_user {
     uint32_t num_syscalls;               // Total number of syscalls supported
+    uint32_t tsc_khz;                    // cycles per ms; 0 = timing unavailable
     uint32_t counts[VOS_SYSCALL_STATS_MAX]; // Count for each syscall
     char names[VOS_SYSCALL_STATS_MAX][16];  // Name of each syscall (truncated)
+    uint64_t total_cycles[VOS_SYSCALL_STATS_MAX];
+    uint64_t max_cycles[VOS_SYSCALL_STATS_MAX];
 } vos_syscall_stats_user_t;
 
+// SYS_SYSCALL_TRACE operations (ebx).
+enum {
+    VOS_STRACE_ATTACH = 0,  // ecx = pid to trace, 0 = stop
+    VOS_STRACE_READ = 1,    // ecx = entry buffer, edx = max entries
+    VOS_STRACE_HIST = 2,    // ecx = syscall number, edx = uint32_t[32]
+};
+
+#define VOS_STRACE_HIST_BUCKETS 32u
+
+typedef struct vos_strace_entry_user {
+    uint32_t seq;       // gaps mean the ring wrapped before it was read
+    uint32_t tid;
+    uint32_t num;
+    uint32_t args[5];
+    int32_t ret;
+    uint32_t reserved;
+    uint64_t cycles;
+} vos_strace_entry_user_t;
+
+// Latency accounting. A call is timed from entry until its frame is resumed,
+// so a blocking call includes the time it spent asleep. Bucket b of a
+// histogram counts calls that took [2^b, 2^(b+1)) TSC cycles.
+static uint64_t syscall_total_cycles[SYS_MAX];
+static uint64_t syscall_max_cycles[SYS_MAX];
+static uint32_t syscall_hist[SYS_MAX][VOS_STRACE_HIST_BUCKETS];
+
+// Completed calls of the traced process, overwritten oldest first.
+#define STRACE_RING_SIZE 256u
+static vos_strace_entry_user_t strace_ring[STRACE_RING_SIZE];
+static uint32_t strace_pid = 0;       // traced process, 0 = off
+static uint32_t strace_seq = 0;       // entries written since attach
+static uint32_t strace_read_seq = 0;  // next entry the reader gets
+
 // Disk/mount information structures
 #define VOS_MAX_DISKS 8
 typedef struct vos_disk_info_user {
@@ -339,6 +463,12 @@ typedef struct vos_disk_info_user {
 typedef struct vos_disks_info_user {
     uint32_t count;
     vos_disk_info_user_t disks[VOS_MAX_DISKS];
+    // Buffer cache shared by the disk filesystems.
+    uint32_t cache_buffers;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t cache_writebacks;
+    uint32_t cache_dirty;
 } vos_disks_info_user_t;
 
 // For select() syscall
@@ -374,10 +504,51 @@ typedef struct vos_timespec {
     int32_t tv_nsec;
 } vos_timespec_t;
 
+// Convert a relative timespec to timer ticks, rounding up so any non-zero
+// duration waits at least one tick. Returns 0 or -errno.
+static int32_t timespec_to_ticks(const vos_timespec_t* ts, uint32_t* out_ticks) {
+    if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000) {
+        return -EINVAL;
+    }
+
+    uint32_t hz = timer_get_hz();
+    if (hz == 0) {
+        return -EIO;
+    }
+
+    // Clamp so wake_tick comparisons stay well-defined.
+    const uint32_t max_ticks = 0x7FFFFFFFu;
+    uint32_t ns_per_tick = 1000000000u / hz;
+    uint32_t ticks = ((uint32_t)ts->tv_nsec + ns_per_tick - 1u) / ns_per_tick;
+    if ((uint32_t)ts->tv_sec >= (max_ticks - ticks) / hz) {
+        ticks = max_ticks;
+    } else {
+        ticks += (uint32_t)ts->tv_sec * hz;
+    }
+    *out_ticks = ticks;
+    return 0;
+}
+
+// futex() operations (Linux numbering)
+#define VOS_FUTEX_WAIT         0u
+#define VOS_FUTEX_WAKE         1u
+#define VOS_FUTEX_REQUEUE      3u
+#define VOS_FUTEX_CMP_REQUEUE  4u
+#define VOS_FUTEX_PRIVATE_FLAG 128u
+
 // Clock IDs for clock_gettime
 #define VOS_CLOCK_REALTIME  0
 #define VOS_CLOCK_MONOTONIC 1
 
+static int32_t realtime_now(uint32_t* sec, uint32_t* nsec) {
+    uint64_t ns = 0;
+    if (!timer_realtime_ns(&ns) && !(timer_sync_realtime() && timer_realtime_ns(&ns))) {
+        return -EIO;
+    }
+    timer_ns_split(ns, sec, nsec);
+    return 0;
+}
+
 // For access() syscall
 #define VOS_F_OK 0  // Test for existence
 #define VOS_R_OK 4  // Test for read permission
@@ -433,26 +604,10 @@ static int32_t copy_kernel_string_to_user(char* dst_user, uint32_t cap, const ch
 }
 
 static bool copy_user_cstring(char* dst, uint32_t dst_cap, const char* src_user) {
-    if (!dst || dst_cap == 0) {
-        return false;
-    }
     if (!src_user) {
         return false;
     }
-
-    for (uint32_t i = 0; i < dst_cap; i++) {
-        char c = 0;
-        if (!copy_from_user(&c, src_user + i, 1u)) {
-            return false;
-        }
-        dst[i] = c;
-        if (c == '\0') {
-            return true;
-        }
-    }
-
-    dst[dst_cap - 1u] = '\0';
-    return false; // unterminated / too long
+    return strncpy_from_user(dst, src_user, dst_cap) >= 0;
 }
 
 static int32_t dup_user_cstring(const char* src_user, uint32_t max_len, char** out_str, uint32_t* out_bytes) {
@@ -478,22 +633,11 @@ static int32_t dup_user_cstring(const char* src_user, uint32_t max_len, char** o
         return 0;
     }
 
-    bool found = false;
-    uint32_t len = 0;
-    for (; len < max_len; len++) {
-        char c = 0;
-        if (!copy_from_user(&c, src_user + len, 1u)) {
-            return -EFAULT;
-        }
-        if (c == '\0') {
-            found = true;
-            len++; // include terminator
-            break;
-        }
-    }
-    if (!found) {
-        return -ENAMETOOLONG;
+    int32_t n = strnlen_user(src_user, max_len);
+    if (n < 0) {
+        return n;
     }
+    uint32_t len = (uint32_t)n + 1u; // include terminator
 
     char* s = (char*)kmalloc(len);
     if (!s) {
@@ -503,6 +647,7 @@ static int32_t dup_user_cstring(const char* src_user, uint32_t max_len, char** o
         kfree(s);
         return -EFAULT;
     }
+    s[len - 1u] = '\0'; // the user may have changed it since the scan
 
     *out_str = s;
     if (out_bytes) {
@@ -511,6 +656,193 @@ static int32_t dup_user_cstring(const char* src_user, uint32_t max_len, char** o
     return 0;
 }
 
+// One pass of select(): fill `out_read`/`out_write` and return how many
+// descriptors are ready. With `watch`, also hook onto each descriptor's
+// poll head so the caller can sleep until one of them changes.
+static int32_t select_scan(int32_t nfds, const vos_fd_set_t* readfds, const vos_fd_set_t* writefds,
+                           vos_fd_set_t* out_read, vos_fd_set_t* out_write, poll_waiter_t* watch) {
+    memset(out_read, 0, sizeof(*out_read));
+    memset(out_write, 0, sizeof(*out_write));
+    int32_t nready = 0;
+    for (int32_t fd = 0; fd < nfds; fd++) {
+        bool want_read = readfds && fd_set_isset(readfds, fd);
+        bool want_write = writefds && fd_set_isset(writefds, fd);
+        if (!want_read && !want_write) {
+            continue;
+        }
+        if (watch) {
+            poll_waiter_watch(watch, tasking_fd_poll_head(fd));
+        }
+        if (want_read) {
+            int32_t r = tasking_fd_is_readable(fd);
+            if (r == 1) {
+                fd_set_set(out_read, fd);
+                nready++;
+            } else if (r < 0) {
+                return -EBADF;
+            }
+        }
+        if (want_write) {
+            int32_t w = tasking_fd_is_writable(fd);
+            if (w == 1) {
+                fd_set_set(out_write, fd);
+                nready++;
+            } else if (w < 0) {
+                return -EBADF;
+            }
+        }
+        // exceptfds not really supported, just clear
+    }
+    return nready;
+}
+
+// One pass of poll(); see select_scan().
+static int32_t poll_scan(vos_pollfd_t* fds, uint32_t nfds, poll_waiter_t* watch) {
+    int32_t nready = 0;
+    for (uint32_t i = 0; i < nfds; i++) {
+        fds[i].revents = 0;
+        int32_t fd = fds[i].fd;
+
+        if (fd < 0) {
+            continue;  // Negative fd is ignored
+        }
+
+        // Check if fd is valid
+        int32_t readable = tasking_fd_is_readable(fd);
+        int32_t writable = tasking_fd_is_writable(fd);
+
+        if (readable < 0 && writable < 0) {
+            fds[i].revents = VOS_POLLNVAL;
+            nready++;
+            continue;
+        }
+        if (watch) {
+            poll_waiter_watch(watch, tasking_fd_poll_head(fd));
+        }
+
+        if ((fds[i].events & VOS_POLLIN) && readable > 0) {
+            fds[i].revents |= VOS_POLLIN;
+            nready++;
+        }
+        if ((fds[i].events & VOS_POLLOUT) && writable > 0) {
+            fds[i].revents |= VOS_POLLOUT;
+            nready++;
+        }
+    }
+    return nready;
+}
+
+static uint32_t syscall_hist_bucket(uint64_t cycles) {
+    if (cycles >> 32) {
+        return VOS_STRACE_HIST_BUCKETS - 1u;
+    }
+    uint32_t c = (uint32_t)cycles;
+    return c ? 31u - (uint32_t)__builtin_clz(c) : 0u;
+}
+
+static void strace_record(const task_syscall_t* rec, int32_t ret, uint64_t cycles) {
+    vos_strace_entry_user_t* e = &strace_ring[strace_seq % STRACE_RING_SIZE];
+    e->seq = strace_seq++;
+    e->tid = tasking_current_tid();
+    e->num = rec->num;
+    memcpy(e->args, rec->args, sizeof(e->args));
+    e->ret = ret;
+    e->reserved = 0;
+    e->cycles = cycles;
+}
+
+void syscall_account_return(interrupt_frame_t* frame) {
+    task_syscall_t* rec = tasking_current_syscall();
+    if (!rec || !frame || rec->frame != frame) {
+        return;
+    }
+    rec->frame = NULL;
+
+    uint32_t num = rec->num;
+    uint64_t cycles = 0;
+    if (rec->start_tsc) {
+        uint64_t now = timer_read_tsc();
+        cycles = now > rec->start_tsc ? now - rec->start_tsc : 0;
+        syscall_total_cycles[num] += cycles;
+        if (cycles > syscall_max_cycles[num]) {
+            syscall_max_cycles[num] = cycles;
+        }
+        syscall_hist[num][syscall_hist_bucket(cycles)]++;
+    }
+    if (strace_pid != 0 && tasking_current_pid() == strace_pid) {
+        strace_record(rec, (int32_t)frame->eax, cycles);
+    }
+}
+
+static int32_t syscall_trace_ctl(uint32_t op, uint32_t arg0, uint32_t arg1) {
+    switch (op) {
+        case VOS_STRACE_ATTACH: {
+            if (arg0 > 0x7FFFFFFFu) {
+                return -EINVAL;
+            }
+            if (arg0 != 0) {
+                // Same rule as kill(): the target must exist and be ours.
+                int32_t rc = tasking_kill((int32_t)arg0, 0);
+                if (rc < 0) {
+                    return rc;
+                }
+            }
+            strace_pid = arg0;
+            strace_seq = 0;
+            strace_read_seq = 0;
+            return 0;
+        }
+        case VOS_STRACE_READ: {
+            vos_strace_entry_user_t* out = (vos_strace_entry_user_t*)arg0;
+            if (strace_seq - strace_read_seq > STRACE_RING_SIZE) {
+                strace_read_seq = strace_seq - STRACE_RING_SIZE;
+            }
+            uint32_t n = 0;
+            while (n < arg1 && strace_read_seq != strace_seq) {
+                const vos_strace_entry_user_t* e = &strace_ring[strace_read_seq % STRACE_RING_SIZE];
+                if (!copy_to_user(&out[n], e, sizeof(*e))) {
+                    return n ? (int32_t)n : -EFAULT;
+                }
+                strace_read_seq++;
+                n++;
+            }
+            return (int32_t)n;
+        }
+        case VOS_STRACE_HIST:
+            if (arg0 >= SYS_MAX) {
+                return -EINVAL;
+            }
+            if (!copy_to_user((void*)arg1, syscall_hist[arg0], sizeof(syscall_hist[arg0]))) {
+                return -EFAULT;
+            }
+            return 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+static bool syscall_stats_copy_out(vos_syscall_stats_user_t* out) {
+    uint32_t n = SYS_MAX < VOS_SYSCALL_STATS_MAX ? SYS_MAX : VOS_SYSCALL_STATS_MAX;
+    uint32_t header[2] = { SYS_MAX, timer_tsc_khz() };
+    if (!copy_to_user(out, header, sizeof(header)) ||
+        !copy_to_user(out->counts, syscall_counts, n * sizeof(out->counts[0])) ||
+        !copy_to_user(out->total_cycles, syscall_total_cycles, n * sizeof(out->total_cycles[0])) ||
+        !copy_to_user(out->max_cycles, syscall_max_cycles, n * sizeof(out->max_cycles[0]))) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        char name[16];
+        memset(name, 0, sizeof(name));
+        if (syscall_names[i]) {
+            strncpy(name, syscall_names[i], sizeof(name) - 1u);
+        }
+        if (!copy_to_user(out->names[i], name, sizeof(name))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
     if (!frame) {
         return frame;
@@ -526,6 +858,18 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
     // Track syscall invocation count
     if (num < SYS_MAX) {
         syscall_counts[num]++;
+
+        task_syscall_t* rec = tasking_current_syscall();
+        if (rec) {
+            rec->frame = frame;
+            rec->num = num;
+            rec->args[0] = frame->ebx;
+            rec->args[1] = frame->ecx;
+            rec->args[2] = frame->edx;
+            rec->args[3] = frame->esi;
+            rec->args[4] = frame->edi;
+            rec->start_tsc = timer_read_tsc();
+        }
     }
 
     switch (num) {
@@ -663,6 +1007,44 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             }
             return frame;
         }
+        case SYS_READV: {
+            int32_t n = tasking_fd_readv((int32_t)frame->ebx, (const void*)frame->ecx, (int32_t)frame->edx);
+            frame->eax = (uint32_t)n;
+            if ((frame->cs & 3u) == 3u && tasking_current_should_exit(&pending_exit)) {
+                return tasking_exit(frame, pending_exit);
+            }
+            return frame;
+        }
+        case SYS_WRITEV: {
+            int32_t n = tasking_fd_writev((int32_t)frame->ebx, (const void*)frame->ecx, (int32_t)frame->edx);
+            frame->eax = (uint32_t)n;
+            return frame;
+        }
+        case SYS_PREAD: {
+            int32_t n = tasking_fd_pread((int32_t)frame->ebx, (void*)frame->ecx, frame->edx,
+                                         (int32_t)frame->esi);
+            frame->eax = (uint32_t)n;
+            return frame;
+        }
+        case SYS_PWRITE: {
+            int32_t n = tasking_fd_pwrite((int32_t)frame->ebx, (const void*)frame->ecx, frame->edx,
+                                          (int32_t)frame->esi);
+            frame->eax = (uint32_t)n;
+            return frame;
+        }
+        case SYS_SENDFILE: {
+            int32_t n = tasking_sendfile((int32_t)frame->ebx, (int32_t)frame->ecx, (int32_t*)frame->edx,
+                                         frame->esi);
+            frame->eax = (uint32_t)n;
+            return frame;
+        }
+        case SYS_SPLICE: {
+            // splice() flags are only hints here; O_NONBLOCK on either fd is honoured.
+            int32_t n = tasking_splice((int32_t)frame->ebx, (int32_t*)frame->ecx, (int32_t)frame->edx,
+                                       (int32_t*)frame->esi, frame->edi);
+            frame->eax = (uint32_t)n;
+            return frame;
+        }
         case SYS_CLOSE: {
             int32_t fd = (int32_t)frame->ebx;
             int32_t rc = tasking_fd_close(fd);
@@ -746,6 +1128,11 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             frame->eax = (uint32_t)rc;
             return frame;
         }
+        case SYS_GETDENTS: {
+            int32_t rc = tasking_getdents((int32_t)frame->ebx, (void*)frame->ecx, frame->edx);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
         case SYS_CHDIR: {
             const char* path_user = (const char*)frame->ebx;
 
@@ -802,6 +1189,47 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             frame->eax = (uint32_t)rc;
             return frame;
         }
+        case SYS_OPENAT:
+        case SYS_FSTATAT:
+        case SYS_MKDIRAT:
+        case SYS_UNLINKAT: {
+            int32_t dirfd = (int32_t)frame->ebx;
+            const char* path_user = (const char*)frame->ecx;
+
+            char path[128];
+            if (!copy_user_cstring(path, sizeof(path), path_user)) {
+                frame->eax = (uint32_t)-EINVAL;
+                return frame;
+            }
+
+            int32_t rc;
+            if (num == SYS_OPENAT) {
+                rc = tasking_fd_openat(dirfd, path, frame->edx);
+            } else if (num == SYS_FSTATAT) {
+                rc = tasking_fstatat(dirfd, path, (void*)frame->edx, frame->esi);
+            } else if (num == SYS_MKDIRAT) {
+                rc = tasking_mkdirat(dirfd, path);
+            } else {
+                rc = tasking_unlinkat(dirfd, path, frame->edx);
+            }
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
+        case SYS_RENAMEAT: {
+            const char* old_user = (const char*)frame->ecx;
+            const char* new_user = (const char*)frame->esi;
+
+            char oldp[128];
+            char newp[128];
+            if (!copy_user_cstring(oldp, sizeof(oldp), old_user) || !copy_user_cstring(newp, sizeof(newp), new_user)) {
+                frame->eax = (uint32_t)-EINVAL;
+                return frame;
+            }
+
+            int32_t rc = tasking_renameat((int32_t)frame->ebx, oldp, (int32_t)frame->edx, newp);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
         case SYS_RMDIR: {
             const char* path_user = (const char*)frame->ebx;
 
@@ -936,6 +1364,90 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             frame->eax = (uint32_t)pid;
             return frame;
         }
+        case SYS_CLONE: {
+            // Linux i386 argument order: flags, child stack, parent tid ptr,
+            // tls, child tid ptr.
+            uint32_t flags = frame->ebx;
+            uint32_t child_stack = frame->ecx;
+            void* parent_tid_user = (void*)frame->edx;
+            uint32_t tls = frame->esi;
+            void* child_tid_user = (void*)frame->edi;
+            int32_t tid = tasking_clone(frame, flags, child_stack, parent_tid_user, tls, child_tid_user);
+            frame->eax = (uint32_t)tid;
+            return frame;
+        }
+        case SYS_THREAD_EXIT:
+            frame->eax = 0;
+            return tasking_thread_exit(frame, (int32_t)frame->ebx);
+        case SYS_GETTID: {
+            frame->eax = tasking_current_tid();
+            return frame;
+        }
+        case SYS_SET_TLS: {
+            int32_t rc = tasking_set_tls(frame, frame->ebx);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
+        case SYS_FUTEX: {
+            // Linux i386 argument order: uaddr, op, val, timeout (or val2 for
+            // requeue), uaddr2, val3.
+            const void* uaddr = (const void*)frame->ebx;
+            uint32_t op = frame->ecx & ~VOS_FUTEX_PRIVATE_FLAG;
+            uint32_t val = frame->edx;
+            const void* uaddr2 = (const void*)frame->edi;
+
+            switch (op) {
+                case VOS_FUTEX_WAIT: {
+                    uint32_t wake_tick = 0;
+                    const vos_timespec_t* timeout_user = (const vos_timespec_t*)frame->esi;
+                    if (timeout_user) {
+                        vos_timespec_t timeout;
+                        if (!copy_from_user(&timeout, timeout_user, sizeof(timeout))) {
+                            frame->eax = (uint32_t)-EFAULT;
+                            return frame;
+                        }
+                        uint32_t ticks = 0;
+                        int32_t rc = timespec_to_ticks(&timeout, &ticks);
+                        if (rc == 0 && ticks == 0) {
+                            rc = -ETIMEDOUT;
+                        }
+                        if (rc != 0) {
+                            frame->eax = (uint32_t)rc;
+                            return frame;
+                        }
+                        wake_tick = timer_get_ticks() + ticks;
+                        if (wake_tick == 0) {
+                            wake_tick = 1; // 0 means "no timeout"
+                        }
+                    }
+                    return tasking_futex_wait(frame, uaddr, val, wake_tick);
+                }
+                case VOS_FUTEX_WAKE:
+                    frame->eax = (uint32_t)tasking_futex_wake(uaddr, val);
+                    return frame;
+                case VOS_FUTEX_REQUEUE:
+                case VOS_FUTEX_CMP_REQUEUE:
+                    frame->eax = (uint32_t)tasking_futex_requeue(uaddr, val, uaddr2, frame->esi,
+                                                                 op == VOS_FUTEX_CMP_REQUEUE, frame->ebp);
+                    return frame;
+                default:
+                    frame->eax = (uint32_t)-ENOSYS;
+                    return frame;
+            }
+        }
+        case SYS_URING_SETUP: {
+            int32_t rc = uring_setup(frame->ebx, frame->ecx, frame->edx);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
+        case SYS_URING_ENTER: {
+            int32_t rc = uring_enter(frame->ebx, frame->ecx, frame->edx);
+            frame->eax = (uint32_t)rc;
+            if ((frame->cs & 3u) == 3u && tasking_current_should_exit(&pending_exit)) {
+                return tasking_exit(frame, pending_exit);
+            }
+            return frame;
+        }
         case SYS_EXECVE: {
             const char* path_user = (const char*)frame->ebx;
             const char* const* argv_user = (const char* const*)frame->ecx;
@@ -1178,6 +1690,7 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 return frame;
             }
 
+            (void)timer_sync_realtime();
             statusbar_refresh();
             frame->eax = 0;
             return frame;
@@ -1201,18 +1714,7 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             }
 
             vos_task_info_user_t out;
-            out.pid = info.pid;
-            out.user = info.user ? 1u : 0u;
-            out.state = (uint32_t)info.state;
-            out.cpu_ticks = info.cpu_ticks;
-            out.eip = info.eip;
-            out.esp = info.esp;
-            out.exit_code = info.exit_code;
-            out.wake_tick = info.wake_tick;
-            out.wait_pid = info.wait_pid;
-            for (uint32_t i = 0; i < (uint32_t)sizeof(out.name); i++) {
-                out.name[i] = info.name[i];
-            }
+            task_info_to_user(&out, &info);
 
             if (!copy_to_user(out_user, &out, (uint32_t)sizeof(out))) {
                 frame->eax = (uint32_t)-EFAULT;
@@ -1222,6 +1724,57 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             frame->eax = 0;
             return frame;
         }
+        case SYS_TASK_SNAPSHOT: {
+            vos_task_stat_user_t* out_user = (vos_task_stat_user_t*)frame->ebx;
+            uint32_t max = frame->ecx;
+            uint32_t start = frame->edx;
+            if (max > TASK_SNAPSHOT_MAX) {
+                max = TASK_SNAPSHOT_MAX;
+            }
+            if (max != 0 && !access_ok(out_user, max * (uint32_t)sizeof(*out_user))) {
+                frame->eax = (uint32_t)-EFAULT;
+                return frame;
+            }
+
+            task_info_t* infos = NULL;
+            if (max != 0) {
+                infos = (task_info_t*)kmalloc(max * (uint32_t)sizeof(*infos));
+                if (!infos) {
+                    frame->eax = (uint32_t)-ENOMEM;
+                    return frame;
+                }
+            }
+
+            uint32_t total = tasking_task_snapshot(infos, start, max);
+            uint32_t n = total > start ? total - start : 0;
+            if (n > max) {
+                n = max;
+            }
+            int32_t rc = (int32_t)total;
+            for (uint32_t i = 0; i < n; i++) {
+                const task_info_t* info = &infos[i];
+                vos_task_stat_user_t out;
+                task_info_to_user(&out.info, info);
+                out.tgid = info->tgid;
+                out.ppid = info->ppid;
+                out.uid = info->uid;
+                out.sys_ticks = info->sys_ticks;
+                out.rss_pages = info->rss_pages;
+                out.faults = info->faults;
+                out.switches = info->switches;
+                out.start_tick = info->start_tick;
+                for (uint32_t s = 0; s < TASK_STATE_COUNT; s++) {
+                    out.state_ticks[s] = info->state_ticks[s];
+                }
+                if (!copy_to_user(&out_user[i], &out, (uint32_t)sizeof(out))) {
+                    rc = -EFAULT;
+                    break;
+                }
+            }
+            kfree(infos);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
         case SYS_SCREEN_IS_FB: {
             frame->eax = screen_is_framebuffer() ? 1u : 0u;
             return frame;
@@ -1529,6 +2082,9 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
             stats.task_count = tasking_task_count();
             tasking_get_state_counts(&stats.runnable, &stats.sleeping,
                                      &stats.waiting, &stats.zombie);
+            tasking_get_kstack_stats(&stats.kstacks_in_use, &stats.kstacks_cached,
+                                     &stats.kstack_max_depth);
+            stats.kstack_size = TASK_KSTACK_SIZE;
             if (!copy_to_user(stats_user, &stats, sizeof(stats))) {
                 frame->eax = (uint32_t)-EFAULT;
                 return frame;
@@ -1555,27 +2111,51 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
         }
         case SYS_SYSCALL_STATS: {
             vos_syscall_stats_user_t* stats_user = (vos_syscall_stats_user_t*)frame->ebx;
-            if (!stats_user) {
+            if (!stats_user || !syscall_stats_copy_out(stats_user)) {
                 frame->eax = (uint32_t)-EFAULT;
                 return frame;
             }
-            vos_syscall_stats_user_t stats;
-            memset(&stats, 0, sizeof(stats));
-            stats.num_syscalls = SYS_MAX;
-            for (uint32_t i = 0; i < SYS_MAX && i < VOS_SYSCALL_STATS_MAX; i++) {
-                stats.counts[i] = syscall_counts[i];
-                if (syscall_names[i]) {
-                    strncpy(stats.names[i], syscall_names[i], 15);
-                    stats.names[i][15] = '\0';
-                } else {
-                    stats.names[i][0] = '\0';
+            frame->eax = 0;
+            return frame;
+        }
+        case SYS_SYSCALL_TRACE:
+            frame->eax = (uint32_t)syscall_trace_ctl(frame->ebx, frame->ecx, frame->edx);
+            return frame;
+        case SYS_EPOLL_CREATE:
+            frame->eax = (uint32_t)tasking_epoll_create(frame->ebx);
+            return frame;
+        case SYS_EPOLL_CTL: {
+            // epoll_ctl(epfd, op, fd, event)
+            epoll_t* ep = tasking_fd_epoll((int32_t)frame->ebx);
+            if (!ep) {
+                frame->eax = (uint32_t)-EINVAL;
+                return frame;
+            }
+            epoll_event_user_t ev;
+            const epoll_event_user_t* evp = NULL;
+            if (frame->esi) {
+                if (!copy_from_user(&ev, (const void*)frame->esi, sizeof(ev))) {
+                    epoll_put(ep);
+                    frame->eax = (uint32_t)-EFAULT;
+                    return frame;
                 }
+                evp = &ev;
             }
-            if (!copy_to_user(stats_user, &stats, sizeof(stats))) {
-                frame->eax = (uint32_t)-EFAULT;
+            int32_t rc = epoll_ctl(ep, (int32_t)frame->ecx, (int32_t)frame->edx, evp);
+            epoll_put(ep);
+            frame->eax = (uint32_t)rc;
+            return frame;
+        }
+        case SYS_EPOLL_WAIT: {
+            // epoll_wait(epfd, events, maxevents, timeout_ms)
+            epoll_t* ep = tasking_fd_epoll((int32_t)frame->ebx);
+            if (!ep) {
+                frame->eax = (uint32_t)-EINVAL;
                 return frame;
             }
-            frame->eax = 0;
+            int32_t rc = epoll_wait(ep, (epoll_event_user_t*)frame->ecx, (int32_t)frame->edx, (int32_t)frame->esi);
+            epoll_put(ep);
+            frame->eax = (uint32_t)rc;
             return frame;
         }
         case SYS_SELECT: {
@@ -1632,85 +2212,45 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 deadline = start_tick + timeout_ticks;
             }
 
-            // Main select loop
-            for (;;) {
-                vos_fd_set_t out_read = {0}, out_write = {0}, out_except = {0};
-                int32_t nready = 0;
-
-                // Check each fd
-                for (int32_t fd = 0; fd < nfds; fd++) {
-                    if (readfds_user && fd_set_isset(&readfds, fd)) {
-                        int32_t r = tasking_fd_is_readable(fd);
-                        if (r == 1) {
-                            fd_set_set(&out_read, fd);
-                            nready++;
-                        } else if (r < 0) {
-                            frame->eax = (uint32_t)-EBADF;
-                            return frame;
-                        }
-                    }
-                    if (writefds_user && fd_set_isset(&writefds, fd)) {
-                        int32_t w = tasking_fd_is_writable(fd);
-                        if (w == 1) {
-                            fd_set_set(&out_write, fd);
-                            nready++;
-                        } else if (w < 0) {
-                            frame->eax = (uint32_t)-EBADF;
-                            return frame;
-                        }
-                    }
-                    // exceptfds not really supported, just clear
+            poll_waiter_t waiter;
+            poll_waiter_init(&waiter);
+            vos_fd_set_t out_read = {0}, out_write = {0}, out_except = {0};
+            int32_t nready = select_scan(nfds, readfds_user ? &readfds : NULL, writefds_user ? &writefds : NULL,
+                                         &out_read, &out_write, &waiter);
+            while (nready == 0 && timeout_ms != 0) {
+                if (timeout_ms > 0 && timer_get_ticks() >= deadline) {
+                    break;
                 }
-
-                if (nready > 0 || timeout_ms == 0) {
-                    // Copy results back
-                    if (readfds_user && !copy_to_user(readfds_user, &out_read, sizeof(out_read))) {
-                        frame->eax = (uint32_t)-EFAULT;
-                        return frame;
-                    }
-                    if (writefds_user && !copy_to_user(writefds_user, &out_write, sizeof(out_write))) {
-                        frame->eax = (uint32_t)-EFAULT;
-                        return frame;
-                    }
-                    if (exceptfds_user && !copy_to_user(exceptfds_user, &out_except, sizeof(out_except))) {
-                        frame->eax = (uint32_t)-EFAULT;
-                        return frame;
-                    }
-                    frame->eax = (uint32_t)nready;
-                    return frame;
-                }
-
-                // Check for timeout
-                if (timeout_ms > 0) {
-                    uint32_t now = timer_get_ticks();
-                    if (now >= deadline) {
-                        // Timed out, return 0 - check copy_to_user for errors
-                        if (readfds_user && !copy_to_user(readfds_user, &out_read, sizeof(out_read))) {
-                            frame->eax = (uint32_t)-EFAULT;
-                            return frame;
-                        }
-                        if (writefds_user && !copy_to_user(writefds_user, &out_write, sizeof(out_write))) {
-                            frame->eax = (uint32_t)-EFAULT;
-                            return frame;
-                        }
-                        if (exceptfds_user && !copy_to_user(exceptfds_user, &out_except, sizeof(out_except))) {
-                            frame->eax = (uint32_t)-EFAULT;
-                            return frame;
-                        }
-                        frame->eax = 0;
-                        return frame;
-                    }
-                }
-
-                // Check for signals
                 if (tasking_current_should_interrupt()) {
-                    frame->eax = (uint32_t)-EINTR;
-                    return frame;
+                    nready = -EINTR;
+                    break;
                 }
+                // Sleep until one of the descriptors changes, then rescan.
+                poll_waiter_wait(&waiter, timeout_ms > 0 ? deadline : 0u);
+                nready = select_scan(nfds, readfds_user ? &readfds : NULL, writefds_user ? &writefds : NULL,
+                                     &out_read, &out_write, NULL);
+            }
+            poll_waiter_release(&waiter);
+            if (nready < 0) {
+                frame->eax = (uint32_t)nready;
+                return frame;
+            }
 
-                // Wait a bit before checking again (yield to other tasks)
-                __asm__ volatile ("sti; hlt; cli");
+            // Copy results back (all empty on timeout)
+            if (readfds_user && !copy_to_user(readfds_user, &out_read, sizeof(out_read))) {
+                frame->eax = (uint32_t)-EFAULT;
+                return frame;
             }
+            if (writefds_user && !copy_to_user(writefds_user, &out_write, sizeof(out_write))) {
+                frame->eax = (uint32_t)-EFAULT;
+                return frame;
+            }
+            if (exceptfds_user && !copy_to_user(exceptfds_user, &out_except, sizeof(out_except))) {
+                frame->eax = (uint32_t)-EFAULT;
+                return frame;
+            }
+            frame->eax = (uint32_t)nready;
+            return frame;
         }
 
         // Color theme syscalls
@@ -1759,34 +2299,17 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 return frame;
             }
 
-            rtc_datetime_t dt;
-            if (!rtc_read_datetime(&dt)) {
-                frame->eax = (uint32_t)-EIO;
+            uint32_t sec = 0;
+            uint32_t nsec = 0;
+            int32_t rc = realtime_now(&sec, &nsec);
+            if (rc < 0) {
+                frame->eax = (uint32_t)rc;
                 return frame;
             }
 
-            // Convert to Unix timestamp (seconds since 1970-01-01)
-            // Simplified calculation - days since epoch
-            int32_t days = 0;
-            for (uint16_t y = 1970; y < dt.year; y++) {
-                days += (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 366 : 365;
-            }
-            static const int32_t mdays[] = {0,31,59,90,120,151,181,212,243,273,304,334};
-            days += mdays[dt.month - 1];
-            if (dt.month > 2 && (dt.year % 4 == 0 && (dt.year % 100 != 0 || dt.year % 400 == 0))) {
-                days++;
-            }
-            days += dt.day - 1;
-
-            int32_t secs = days * 86400 + dt.hour * 3600 + dt.minute * 60 + dt.second;
-
-            // Get microseconds from uptime (approximate sub-second precision)
-            uint32_t uptime_ms = timer_uptime_ms();
-            int32_t usec = (uptime_ms % 1000) * 1000;
-
             vos_timeval_t tv;
-            tv.tv_sec = secs;
-            tv.tv_usec = usec;
+            tv.tv_sec = (int32_t)sec;
+            tv.tv_usec = (int32_t)(nsec / 1000u);
 
             if (!copy_to_user(tv_user, &tv, sizeof(tv))) {
                 frame->eax = (uint32_t)-EFAULT;
@@ -1808,38 +2331,23 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
 
             vos_timespec_t ts;
 
+            uint32_t sec = 0;
+            uint32_t nsec = 0;
             if (clockid == VOS_CLOCK_MONOTONIC) {
-                // Monotonic clock: uptime since boot
-                uint32_t uptime_ms = timer_uptime_ms();
-                ts.tv_sec = (int32_t)(uptime_ms / 1000);
-                ts.tv_nsec = (int32_t)((uptime_ms % 1000) * 1000000);
+                // Monotonic clock: time since boot
+                timer_ns_split(timer_monotonic_ns(), &sec, &nsec);
             } else if (clockid == VOS_CLOCK_REALTIME) {
-                // Real time: wall clock
-                rtc_datetime_t dt;
-                if (!rtc_read_datetime(&dt)) {
-                    frame->eax = (uint32_t)-EIO;
+                int32_t rc = realtime_now(&sec, &nsec);
+                if (rc < 0) {
+                    frame->eax = (uint32_t)rc;
                     return frame;
                 }
-
-                // Same Unix timestamp calculation as gettimeofday
-                int32_t days = 0;
-                for (uint16_t y = 1970; y < dt.year; y++) {
-                    days += (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 366 : 365;
-                }
-                static const int32_t mdays[] = {0,31,59,90,120,151,181,212,243,273,304,334};
-                days += mdays[dt.month - 1];
-                if (dt.month > 2 && (dt.year % 4 == 0 && (dt.year % 100 != 0 || dt.year % 400 == 0))) {
-                    days++;
-                }
-                days += dt.day - 1;
-
-                ts.tv_sec = days * 86400 + dt.hour * 3600 + dt.minute * 60 + dt.second;
-                uint32_t uptime_ms = timer_uptime_ms();
-                ts.tv_nsec = (int32_t)((uptime_ms % 1000) * 1000000);
             } else {
                 frame->eax = (uint32_t)-EINVAL;
                 return frame;
             }
+            ts.tv_sec = (int32_t)sec;
+            ts.tv_nsec = (int32_t)nsec;
 
             if (!copy_to_user(tp_user, &ts, sizeof(ts))) {
                 frame->eax = (uint32_t)-EFAULT;
@@ -1869,29 +2377,16 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 frame->eax = (uint32_t)-EINVAL;
                 return frame;
             }
-
-            // Convert to milliseconds
-            uint32_t ms = (uint32_t)(req.tv_sec * 1000 + req.tv_nsec / 1000000);
-            if (ms == 0 && (req.tv_sec > 0 || req.tv_nsec > 0)) {
-                ms = 1;  // At least 1ms if any sleep was requested
-            }
-
-            if (ms == 0) {
+            if (req.tv_sec == 0 && req.tv_nsec == 0) {
                 frame->eax = 0;
                 return frame;
             }
 
-            uint32_t hz = timer_get_hz();
-            if (hz == 0) {
-                frame->eax = (uint32_t)-EIO;
-                return frame;
-            }
-
-            uint32_t ticks_to_wait = (ms * hz + 999u) / 1000u;
-            if (ticks_to_wait == 0) {
-                ticks_to_wait = 1;
-            }
-            uint32_t wake = timer_get_ticks() + ticks_to_wait;
+            // Sleep to an absolute deadline on the monotonic clock rather
+            // than counting whole ticks from a partially elapsed one.
+            uint64_t deadline = timer_monotonic_ns() +
+                                (uint64_t)(uint32_t)req.tv_sec * 1000000000u + (uint32_t)req.tv_nsec;
+            uint32_t wake = timer_deadline_tick(deadline);
 
             // If interrupted, write remaining time to rem
             if (rem_user) {
@@ -1993,71 +2488,33 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 deadline = start_tick + ((uint32_t)timeout_ms * hz + 999u) / 1000u;
             }
 
-            for (;;) {
-                int32_t nready = 0;
-
-                // Check each fd
-                for (uint32_t i = 0; i < nfds; i++) {
-                    fds[i].revents = 0;
-                    int32_t fd = fds[i].fd;
-
-                    if (fd < 0) {
-                        continue;  // Negative fd is ignored
-                    }
-
-                    // Check if fd is valid
-                    int32_t readable = tasking_fd_is_readable(fd);
-                    int32_t writable = tasking_fd_is_writable(fd);
-
-                    if (readable < 0 && writable < 0) {
-                        fds[i].revents = VOS_POLLNVAL;
-                        nready++;
-                        continue;
-                    }
-
-                    if ((fds[i].events & VOS_POLLIN) && readable > 0) {
-                        fds[i].revents |= VOS_POLLIN;
-                        nready++;
-                    }
-                    if ((fds[i].events & VOS_POLLOUT) && writable > 0) {
-                        fds[i].revents |= VOS_POLLOUT;
-                        nready++;
-                    }
-                }
-
-                if (nready > 0 || timeout_ms == 0) {
-                    // Copy results back
-                    if (!copy_to_user(fds_user, fds, copy_size)) {
-                        frame->eax = (uint32_t)-EFAULT;
-                        return frame;
-                    }
-                    frame->eax = (uint32_t)nready;
-                    return frame;
-                }
-
-                // Check for timeout
-                if (timeout_ms > 0) {
-                    uint32_t now = timer_get_ticks();
-                    if (now >= deadline) {
-                        // Copy results back (all revents should be 0)
-                        if (!copy_to_user(fds_user, fds, copy_size)) {
-                            frame->eax = (uint32_t)-EFAULT;
-                            return frame;
-                        }
-                        frame->eax = 0;
-                        return frame;
-                    }
+            poll_waiter_t waiter;
+            poll_waiter_init(&waiter);
+            int32_t nready = poll_scan(fds, nfds, &waiter);
+            while (nready == 0 && timeout_ms != 0) {
+                if (timeout_ms > 0 && timer_get_ticks() >= deadline) {
+                    break;
                 }
-
-                // Check for signals
                 if (tasking_current_should_interrupt()) {
-                    frame->eax = (uint32_t)-EINTR;
-                    return frame;
+                    nready = -EINTR;
+                    break;
                 }
+                poll_waiter_wait(&waiter, timeout_ms > 0 ? deadline : 0u);
+                nready = poll_scan(fds, nfds, NULL);
+            }
+            poll_waiter_release(&waiter);
+            if (nready < 0) {
+                frame->eax = (uint32_t)nready;
+                return frame;
+            }
 
-                // Wait a bit before checking again
-                __asm__ volatile ("sti; hlt; cli");
+            // Copy results back (all revents are 0 on timeout)
+            if (!copy_to_user(fds_user, fds, copy_size)) {
+                frame->eax = (uint32_t)-EFAULT;
+                return frame;
             }
+            frame->eax = (uint32_t)nready;
+            return frame;
         }
 
         case SYS_BEEP: {
@@ -2271,6 +2728,14 @@ interrupt_frame_t* syscall_handle(interrupt_frame_t* frame) {
                 info.count++;
             }
 
+            bcache_stats_t cache;
+            bcache_get_stats(&cache);
+            info.cache_buffers = cache.buffers;
+            info.cache_hits = cache.hits;
+            info.cache_misses = cache.misses;
+            info.cache_writebacks = cache.writebacks;
+            info.cache_dirty = cache.dirty;
+
             if (!copy_to_user(info_user, &info, sizeof(info))) {
                 frame->eax = (uint32_t)-EFAULT;
                 return frame;
@@ -5,7 +5,6 @@
 #include "timer.h"
 #include "io.h"
 #include "paging.h"
-#include "early_alloc.h"
 #include "pmm.h"
 #include "elf.h"
 #include "usercopy.h"
@@ -14,11 +13,18 @@
 #include "serial.h"
 #include "vfs.h"
 #include "keyboard.h"
+#include "fpu.h"
+#include "uring.h"
+#include "epoll.h"
+#include "pollwait.h"
 
-#define KSTACK_SIZE (16u * 1024u)
+#define KSTACK_SIZE TASK_KSTACK_SIZE
 #define TASK_NAME_LEN 15
-#define TASK_MAX_SCAN 256
 #define KSTACK_REGION_BASE 0xF0000000u
+#define KSTACK_REGION_END  0xF8000000u   // framebuffer/APIC identity maps live above
+#define KSTACK_SLOT_SIZE   (PAGE_SIZE + KSTACK_SIZE)   // guard page + stack
+#define KSTACK_SLOTS       ((KSTACK_REGION_END - KSTACK_REGION_BASE) / KSTACK_SLOT_SIZE)
+#define KSTACK_CACHE_MAX   8u
 #define TASK_MAX_FDS 64
 
 // Minimal signal support for userland ports (ne, etc.).
@@ -130,6 +136,7 @@ typedef enum {
     FD_KIND_TTY = 6,   // /dev/tty - reads from stdin, writes to stdout
     FD_KIND_NULL = 7,  // /dev/null - discards writes, returns EOF on read
     FD_KIND_ZERO = 8,  // /dev/zero - discards writes, returns zeros on read
+    FD_KIND_EPOLL = 9,
 } fd_kind_t;
 
 typedef struct pipe_obj pipe_obj_t;
@@ -141,6 +148,7 @@ typedef struct fd_entry {
     vfs_handle_t* handle;
     pipe_obj_t* pipe;
     bool pipe_write_end;
+    epoll_t* epoll;
     uint8_t pending[8];
     uint8_t pending_len;
     uint8_t pending_off;
@@ -164,8 +172,69 @@ typedef struct vos_sigframe {
 
 #define VOS_SIGFRAME_MAGIC 0x53494746u /* 'SIGF' */
 
+// clone() flags (Linux-compatible values). Only the subset needed for
+// pthread-style threads is honoured; anything else is rejected.
+enum {
+    VOS_CLONE_VM            = 0x00000100u,
+    VOS_CLONE_FS            = 0x00000200u,
+    VOS_CLONE_FILES         = 0x00000400u,
+    VOS_CLONE_SIGHAND       = 0x00000800u,
+    VOS_CLONE_THREAD        = 0x00010000u,
+    VOS_CLONE_SETTLS        = 0x00080000u,
+    VOS_CLONE_PARENT_SETTID = 0x00100000u,
+    VOS_CLONE_CHILD_CLEARTID = 0x00200000u,
+};
+
+#define VOS_CLONE_SUPPORTED (VOS_CLONE_VM | VOS_CLONE_FS | VOS_CLONE_FILES | VOS_CLONE_SIGHAND | \
+                             VOS_CLONE_THREAD | VOS_CLONE_SETTLS | VOS_CLONE_PARENT_SETTID | \
+                             VOS_CLONE_CHILD_CLEARTID)
+
+// User address space. Threads created with CLONE_VM share one of these; the
+// user pages are only released when the last reference goes away.
+typedef struct task_mm {
+    uint32_t refs;
+    uint32_t* page_directory;
+    vm_area_t* vm_areas;
+    uint32_t user_brk;
+    uint32_t user_brk_min;
+    uint32_t mmap_top;
+    uring_t* uring;          // SYS_URING_SETUP ring, if any
+} task_mm_t;
+
+// File descriptor table (shared by CLONE_FILES threads).
+typedef struct fd_table {
+    uint32_t refs;
+    fd_entry_t fds[TASK_MAX_FDS];
+} fd_table_t;
+
+// Signal dispositions (shared by CLONE_SIGHAND threads). Pending bits and the
+// mask stay per-thread.
+typedef struct sighand {
+    uint32_t refs;
+    uint32_t handlers[VOS_SIG_MAX];
+} sighand_t;
+
+// Working directories are immutable refcounted strings: fork and clone take
+// a reference, chdir swaps in a new one.
+typedef struct task_cwd {
+    uint32_t refs;
+    char path[];
+} task_cwd_t;
+
+// Canonical-mode line editing state belongs to the terminal, not to whichever
+// task is reading it, so there is one per virtual console.
+#define TTY_CONSOLES 4u
+
+typedef struct tty_ldisc {
+    uint8_t line[VOS_TTY_LINE_MAX];
+    uint16_t len;
+    uint16_t off;
+    bool ready;
+} tty_ldisc_t;
+
 typedef struct task {
     uint32_t id;
+    uint32_t tgid;           // thread group (process) id; == id for the main thread
     uint32_t ppid;
     uint32_t pgid;
     uint32_t esp;            // saved stack pointer (points to interrupt frame)
@@ -174,34 +243,47 @@ typedef struct task {
     bool user;
     uint32_t uid;
     uint32_t gid;
-    uint32_t user_brk;
-    uint32_t user_brk_min;
-    vm_area_t* vm_areas;
-    uint32_t mmap_top;
-    fd_entry_t fds[TASK_MAX_FDS];
-    char cwd[VFS_PATH_MAX];
+    task_mm_t* mm;           // user tasks only
+    fd_table_t* files;
+    uint32_t tls_base;       // base of the per-thread GDT TLS segment
+    void* clear_tid_user;    // CLONE_CHILD_CLEARTID: zeroed on thread exit
+    task_cwd_t* cwd;         // shared, immutable; see cwd_set()
     vos_termios_t tty;
-    uint8_t tty_line[VOS_TTY_LINE_MAX];
-    uint16_t tty_line_len;
-    uint16_t tty_line_off;
-    bool tty_line_ready;
     uint32_t sig_pending;
     uint32_t sig_mask;
-    uint32_t sig_handlers[VOS_SIG_MAX];
+    sighand_t* sighand;      // user tasks only
     task_state_t state;
     uint32_t wake_tick;
     uint32_t wait_pid;
+    uint32_t futex_key;      // physical address of the futex word; 0 = not queued
+    struct task* futex_next;
     void* wait_status_user; // waitpid-style status output (optional)
     bool wait_return_pid;   // true for waitpid-style return (pid), false for legacy wait (exit code)
     int32_t exit_code;
     bool waited;            // set once exit status has been delivered to a waiter; safe to reap
     bool kill_pending;
+    bool kill_alone;        // killed with its group: exits without re-killing it
     int32_t kill_exit_code;
     uint32_t alarm_tick; // 0 = disabled; timer_get_ticks() deadline for SIGALRM
     uint32_t cpu_ticks;
+    uint32_t sys_ticks;  // part of cpu_ticks spent in kernel mode
+    uint32_t switches;   // times scheduled in
+    uint32_t faults;     // recoverable faults taken (lazy FPU traps)
+    uint32_t start_tick;
+    uint32_t state_since;                // tick of the last state change
+    uint32_t state_ticks[TASK_STATE_COUNT];
     uint8_t console;     // Virtual console this task belongs to (0-3)
+    fpu_state_t* fpu;    // saved FPU/SSE registers; NULL until first use
+    task_syscall_t syscall;
     char name[TASK_NAME_LEN + 1];
-    struct task* next;
+    struct task* next;       // scheduler ring
+    struct task* prev;
+    struct task* hash_next;  // pid_hash bucket
+    struct task* pgrp_next;  // pgrp_hash bucket
+    struct task* children;   // child processes (ppid == our id)
+    struct task* sibling_next;
+    struct task* threads;    // leader only: the other threads of the group
+    struct task* thread_next;
 } task_t;
 
 extern uint8_t stack_top;
@@ -210,16 +292,57 @@ static task_t* current_task = NULL;
 static bool enabled = false;
 static uint32_t next_id = 1;
 static uint32_t tick_div = 0;
-static uint32_t next_kstack_region = KSTACK_REGION_BASE;
+
+// Kernel stack pool. Each slot is a guard page followed by KSTACK_SIZE bytes;
+// a set bit in kstack_slot_map means the slot belongs to a task or the cache.
+// Stacks are kept zero-filled while free, so the deepest non-zero word gives
+// the high-water mark and only that much needs scrubbing on reuse.
+static uint32_t kstack_slot_map[(KSTACK_SLOTS + 31u) / 32u];
+static uint32_t kstack_slot_hint = 0;
+static uint32_t kstack_cache[KSTACK_CACHE_MAX];   // tops of mapped, zeroed stacks
+static uint32_t kstack_cache_count = 0;
+static uint32_t kstack_in_use = 0;
+static uint32_t kstack_max_depth = 0;             // deepest use seen on a freed stack
 static volatile uint32_t tty_foreground_pgid = 0;  // volatile: accessed from interrupts
 static bool reap_pending = false;
+static uint32_t task_count = 0;          // tasks on the ring
+static task_cwd_t* cwd_root = NULL;
+static tty_ldisc_t tty_ldiscs[TTY_CONSOLES];
 static uint32_t context_switch_count = 0;
+static task_t* fpu_owner = NULL;         // task whose state is live in the FPU
 
 // Sentinel value used to wait for "any child" in waitpid-style syscalls.
 #define WAIT_ANY_PID 0xFFFFFFFFu
+// Sentinel used by a main thread parked in thread_exit until its group drains.
+#define WAIT_THREADS_PID 0xFFFFFFFEu
+// Sentinel used by a task blocked in FUTEX_WAIT.
+#define WAIT_FUTEX_PID 0xFFFFFFFDu
+
+// Futex wait queues, hashed by the physical address of the futex word so that
+// waiters in different address spaces sharing a page meet in the same queue.
+#define FUTEX_HASH_BITS 6u
+#define FUTEX_HASH_SIZE (1u << FUTEX_HASH_BITS)
+static task_t* futex_queues[FUTEX_HASH_SIZE];
+
+// Process lookup. Every task is hashed by pid and (if it has one) by process
+// group; each process links its child processes and each thread group leader
+// links its other threads, so lookups, kill and waitpid don't walk the ring.
+#define PID_HASH_BITS 8u
+#define PID_HASH_SIZE (1u << PID_HASH_BITS)
+static task_t* pid_hash[PID_HASH_SIZE];
+static task_t* pgrp_hash[PID_HASH_SIZE];
 #define FORK_COPY_VA 0xE0000000u
 
 static void task_close_fds(task_t* t);
+static void cwd_put(task_cwd_t* c);
+
+// Charge the ticks spent in the old state, then switch to `s`.
+static void task_set_state(task_t* t, task_state_t s) {
+    uint32_t now = timer_get_ticks();
+    t->state_ticks[t->state] += now - t->state_since;
+    t->state_since = now;
+    t->state = s;
+}
 
 static void task_free_vm_areas(vm_area_t* head) {
     vm_area_t* cur = head;
@@ -253,6 +376,28 @@ static vm_area_t* vm_clone_areas(const vm_area_t* head) {
     return out_head;
 }
 
+// User memory is mapped eagerly, so the resident set is every present user
+// page. Page tables are identity-mapped, like in free_user_pages_in_directory().
+static uint32_t user_pages_in_directory(const uint32_t* dir) {
+    if (!dir) {
+        return 0;
+    }
+    uint32_t pages = 0;
+    for (uint32_t dir_index = USER_BASE >> 22; dir_index < (USER_LIMIT >> 22); dir_index++) {
+        uint32_t pde = dir[dir_index];
+        if ((pde & PAGE_PRESENT) == 0 || (pde & PAGE_USER) == 0) {
+            continue;
+        }
+        const uint32_t* table = (const uint32_t*)(pde & 0xFFFFF000u);
+        for (uint32_t tbl_index = 0; tbl_index < 1024u; tbl_index++) {
+            if ((table[tbl_index] & (PAGE_PRESENT | PAGE_USER)) == (PAGE_PRESENT | PAGE_USER)) {
+                pages++;
+            }
+        }
+    }
+    return pages;
+}
+
 static void free_user_pages_in_directory(uint32_t* dir) {
     if (!dir) {
         return;
@@ -283,11 +428,103 @@ static void free_user_pages_in_directory(uint32_t* dir) {
     }
 }
 
+static task_mm_t* mm_create(uint32_t* page_directory, uint32_t user_brk) {
+    task_mm_t* mm = (task_mm_t*)kmalloc(sizeof(*mm));
+    if (!mm) {
+        return NULL;
+    }
+    memset(mm, 0, sizeof(*mm));
+    mm->refs = 1;
+    mm->page_directory = page_directory;
+    mm->vm_areas = NULL;
+    mm->user_brk = user_brk;
+    mm->user_brk_min = user_brk;
+    mm->mmap_top = USER_STACK_TOP - (USER_STACK_PAGES + 1u) * PAGE_SIZE;
+    return mm;
+}
+
+static void mm_get(task_mm_t* mm) {
+    if (!mm) {
+        return;
+    }
+    uint32_t f = irq_save();
+    mm->refs++;
+    irq_restore(f);
+}
+
+// Drop a reference; the last one tears down the user pages and mmap metadata.
+// (The page directory itself comes from paging_alloc_table() and is never
+// reclaimed.)
+static void mm_put(task_mm_t* mm) {
+    if (!mm) {
+        return;
+    }
+    uint32_t f = irq_save();
+    bool last = (--mm->refs == 0);
+    irq_restore(f);
+    if (!last) {
+        return;
+    }
+    uring_release(mm->uring);
+    free_user_pages_in_directory(mm->page_directory);
+    task_free_vm_areas(mm->vm_areas);
+    kfree(mm);
+}
+
 static void task_free_user_pages(task_t* t) {
-    if (!t || !t->user || !t->page_directory) {
+    if (!t || !t->user || !t->mm) {
+        return;
+    }
+    task_mm_t* mm = t->mm;
+    t->mm = NULL;
+    mm_put(mm);
+}
+
+static sighand_t* sighand_create(const sighand_t* src) {
+    sighand_t* sh = (sighand_t*)kmalloc(sizeof(*sh));
+    if (!sh) {
+        return NULL;
+    }
+    memset(sh, 0, sizeof(*sh));
+    sh->refs = 1;
+    if (src) {
+        memcpy(sh->handlers, src->handlers, sizeof(sh->handlers));
+    }
+    return sh;
+}
+
+static void sighand_put(sighand_t* sh) {
+    if (!sh) {
         return;
     }
-    free_user_pages_in_directory(t->page_directory);
+    uint32_t f = irq_save();
+    bool last = (--sh->refs == 0);
+    irq_restore(f);
+    if (last) {
+        kfree(sh);
+    }
+}
+
+// Bytes of the stack ending at `top` that have ever been written.
+static uint32_t kstack_depth(uint32_t top) {
+    const uint32_t* p = (const uint32_t*)(top - KSTACK_SIZE);
+    const uint32_t* end = (const uint32_t*)top;
+    while (p < end && *p == 0) {
+        p++;
+    }
+    return top - (uint32_t)p;
+}
+
+static void kstack_note_depth(uint32_t depth) {
+    if (depth <= kstack_max_depth) {
+        return;
+    }
+    kstack_max_depth = depth;
+    if (depth >= (KSTACK_SIZE / 4u) * 3u) {
+        serial_write_string("[TASK] kernel stack high-water mark: ");
+        serial_write_dec((int32_t)depth);
+        serial_write_string(" bytes\n");
+    }
 }
 
 static void task_free_kstack(task_t* t) {
@@ -296,55 +533,188 @@ static void task_free_kstack(task_t* t) {
     }
 
     // Only stacks allocated via kstack_alloc() live in the dedicated region.
-    if (t->kstack_top < (KSTACK_REGION_BASE + PAGE_SIZE + KSTACK_SIZE)) {
+    uint32_t top = t->kstack_top;
+    if (top < KSTACK_REGION_BASE + KSTACK_SLOT_SIZE || top > KSTACK_REGION_END) {
+        return;
+    }
+    uint32_t slot = (top - KSTACK_REGION_BASE) / KSTACK_SLOT_SIZE - 1u;
+
+    uint32_t flags = irq_save();
+    uint32_t depth = kstack_depth(top);
+    kstack_note_depth(depth);
+    kstack_in_use--;
+
+    if (kstack_cache_count < KSTACK_CACHE_MAX) {
+        // Keep the frames mapped; scrub only what was used.
+        memset((void*)(top - depth), 0, depth);
+        kstack_cache[kstack_cache_count++] = top;
+        irq_restore(flags);
         return;
     }
 
-    uint32_t bottom = t->kstack_top - KSTACK_SIZE;
-    for (uint32_t va = bottom; va < t->kstack_top; va += PAGE_SIZE) {
+    for (uint32_t va = top - KSTACK_SIZE; va < top; va += PAGE_SIZE) {
         uint32_t paddr = 0;
         if (paging_unmap_page(va, &paddr) && paddr) {
             pmm_free_frame(paddr);
         }
     }
+    kstack_slot_map[slot / 32u] &= ~(1u << (slot % 32u));
+    if (slot < kstack_slot_hint) {
+        kstack_slot_hint = slot;
+    }
+    irq_restore(flags);
 }
 
-static task_t* task_find_prev(task_t* target) {
-    if (!current_task || !target) {
+static uint32_t pid_hashfn(uint32_t id) {
+    return (id * 2654435761u) >> (32u - PID_HASH_BITS);
+}
+
+static task_t* task_find_by_pid(uint32_t pid) {
+    if (pid == 0) {
         return NULL;
     }
-
-    task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t || !t->next) {
-            return NULL;
+    for (task_t* t = pid_hash[pid_hashfn(pid)]; t; t = t->hash_next) {
+        if (t->id == pid) {
+            return t;
         }
-        if (t->next == target) {
+    }
+    return NULL;
+}
+
+static task_t* task_find_any_by_pgid(uint32_t pgid) {
+    if (pgid == 0) {
+        return NULL;
+    }
+    for (task_t* t = pgrp_hash[pid_hashfn(pgid)]; t; t = t->pgrp_next) {
+        if (t->pgid == pgid) {
             return t;
         }
-        t = t->next;
-        if (t == current_task) {
+    }
+    return NULL;
+}
+
+static void pgrp_link(task_t* t) {
+    if (t->pgid == 0) {
+        return;
+    }
+    task_t** head = &pgrp_hash[pid_hashfn(t->pgid)];
+    t->pgrp_next = *head;
+    *head = t;
+}
+
+static void pgrp_unlink(task_t* t) {
+    if (t->pgid == 0) {
+        return;
+    }
+    for (task_t** pp = &pgrp_hash[pid_hashfn(t->pgid)]; *pp; pp = &(*pp)->pgrp_next) {
+        if (*pp == t) {
+            *pp = t->pgrp_next;
             break;
         }
     }
-    return NULL;
+    t->pgrp_next = NULL;
 }
 
-static bool task_detach(task_t* target) {
-    if (!current_task || !target) {
-        return false;
+static void task_set_pgid(task_t* t, uint32_t pgid) {
+    pgrp_unlink(t);
+    t->pgid = pgid;
+    pgrp_link(t);
+}
+
+// Add a new task to the lookup structures. A thread joins its leader's thread
+// list; a process joins its parent's child list.
+static void task_link(task_t* t) {
+    task_t** head = &pid_hash[pid_hashfn(t->id)];
+    t->hash_next = *head;
+    *head = t;
+    pgrp_link(t);
+
+    t->children = NULL;
+    t->threads = NULL;
+    t->sibling_next = NULL;
+    t->thread_next = NULL;
+    if (t->tgid != t->id) {
+        task_t* leader = task_find_by_pid(t->tgid);
+        if (leader) {
+            t->thread_next = leader->threads;
+            leader->threads = t;
+        }
+    } else {
+        task_t* parent = task_find_by_pid(t->ppid);
+        if (parent) {
+            t->sibling_next = parent->children;
+            parent->children = t;
+        }
     }
-    if (target == current_task) {
-        return false;
+}
+
+// Hand `t`'s children to nobody. Zombies among them can no longer be waited
+// for, so they go straight to the reaper.
+static void task_orphan_children(task_t* t) {
+    task_t* c = t->children;
+    t->children = NULL;
+    while (c) {
+        task_t* next = c->sibling_next;
+        c->sibling_next = NULL;
+        c->ppid = 0;
+        if (c->state == TASK_STATE_ZOMBIE && !c->waited) {
+            c->waited = true;
+            reap_pending = true;
+        }
+        c = next;
+    }
+}
+
+static void task_unlink(task_t* t) {
+    for (task_t** pp = &pid_hash[pid_hashfn(t->id)]; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == t) {
+            *pp = t->hash_next;
+            break;
+        }
+    }
+    t->hash_next = NULL;
+    pgrp_unlink(t);
+
+    // The leader may already be gone; always look it up rather than caching it.
+    if (t->tgid != t->id) {
+        task_t* leader = task_find_by_pid(t->tgid);
+        for (task_t** pp = leader ? &leader->threads : NULL; pp && *pp; pp = &(*pp)->thread_next) {
+            if (*pp == t) {
+                *pp = t->thread_next;
+                break;
+            }
+        }
+    } else {
+        task_t* parent = task_find_by_pid(t->ppid);
+        for (task_t** pp = parent ? &parent->children : NULL; pp && *pp; pp = &(*pp)->sibling_next) {
+            if (*pp == t) {
+                *pp = t->sibling_next;
+                break;
+            }
+        }
+    }
+    t->sibling_next = NULL;
+    t->thread_next = NULL;
+
+    task_orphan_children(t);
+    for (task_t* th = t->threads; th;) {
+        task_t* next = th->thread_next;
+        th->thread_next = NULL;
+        th = next;
     }
+    t->threads = NULL;
+}
 
-    task_t* prev = task_find_prev(target);
-    if (!prev) {
+static bool task_detach(task_t* target) {
+    if (!current_task || !target || target == current_task || !target->next) {
         return false;
     }
 
-    prev->next = target->next;
+    target->prev->next = target->next;
+    target->next->prev = target->prev;
     target->next = NULL;
+    target->prev = NULL;
+    task_count--;
     return true;
 }
 
@@ -353,10 +723,17 @@ static void task_reap_detached(task_t* t) {
         return;
     }
 
+    task_unlink(t);
+    cwd_put(t->cwd);
+    t->cwd = NULL;
     task_close_fds(t);
-    task_free_vm_areas(t->vm_areas);
-    t->vm_areas = NULL;
     task_free_user_pages(t);
+    sighand_put(t->sighand);
+    t->sighand = NULL;
+    if (fpu_owner == t) {
+        fpu_owner = NULL;
+    }
+    kfree(t->fpu);
     task_free_kstack(t);
     kfree(t);
 }
@@ -368,30 +745,27 @@ static void task_reap_waited_zombies(void) {
 
     uint32_t irq_flags = irq_save();
 
-    task_t* prev = current_task;
     task_t* t = current_task->next;
 
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
+    for (;;) {
         if (!t || t == current_task) {
             break;
         }
 
         if (t->state == TASK_STATE_ZOMBIE && t->waited) {
-            prev->next = t->next;
             task_t* victim = t;
-            t = prev->next;
-            victim->next = NULL;
+            t = t->next;
+            (void)task_detach(victim);
             task_reap_detached(victim);
             continue;
         }
 
-        prev = t;
         t = t->next;
     }
 
-    // Best-effort: waited zombies should be fully drained in one scan on small
-    // systems. Clear the hint flag; it will be raised again if needed.
-    reap_pending = false;
+    // The scan never looks at current_task itself, so keep the hint raised if
+    // the task we're running on is a reapable zombie.
+    reap_pending = (current_task->state == TASK_STATE_ZOMBIE && current_task->waited);
     irq_restore(irq_flags);
 }
 
@@ -419,45 +793,148 @@ static void frame_set_user_ss(interrupt_frame_t* frame, uint32_t user_ss) {
     extra[1] = user_ss;
 }
 
-static task_t* task_find_by_pid(uint32_t pid) {
-    if (!current_task || pid == 0) {
-        return NULL;
+static bool task_is_thread(const task_t* t) {
+    return t && t->tgid != t->id;
+}
+
+// Members of a thread group: the leader, then the leader's thread list.
+static task_t* task_group_first(uint32_t tgid) {
+    task_t* leader = task_find_by_pid(tgid);
+    return (leader && leader->tgid == tgid) ? leader : NULL;
+}
+
+static task_t* task_group_next(const task_t* t) {
+    return (t->id == t->tgid) ? t->threads : t->thread_next;
+}
+
+// Mark every other thread of `self`'s group for termination. They exit one
+// by one: `self` may outlive them (execve), so none takes the group down.
+static void task_kill_group_siblings(task_t* self, int32_t exit_code) {
+    if (!current_task || !self) {
+        return;
     }
 
-    task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t) {
-            break;
+    uint32_t irq_flags = irq_save();
+    for (task_t* t = task_group_first(self->tgid); t; t = task_group_next(t)) {
+        if (t == self || t->state == TASK_STATE_ZOMBIE) {
+            continue;
         }
-        if (t->id == pid) {
-            return t;
+        t->kill_alone = true;
+        if (!t->kill_pending) {
+            t->kill_pending = true;
+            t->kill_exit_code = exit_code;
+            if (t->state != TASK_STATE_RUNNABLE) {
+                task_set_state(t, TASK_STATE_RUNNABLE);
+                t->wake_tick = 0;
+                t->wait_pid = 0;
+            }
         }
-        t = t->next;
-        if (t == current_task) {
-            break;
+    }
+    irq_restore(irq_flags);
+}
+
+// True if another thread of `self`'s group can still run user code. A main
+// thread parked in thread_exit does not count.
+static bool task_group_has_live_threads(const task_t* self) {
+    if (!self) {
+        return false;
+    }
+
+    for (const task_t* t = task_group_first(self->tgid); t; t = task_group_next(t)) {
+        if (t != self && t->state != TASK_STATE_ZOMBIE &&
+            !(t->state == TASK_STATE_WAITING && t->wait_pid == WAIT_THREADS_PID)) {
+            return true;
         }
     }
-    return NULL;
+    return false;
 }
 
-static task_t* task_find_any_by_pgid(uint32_t pgid) {
-    if (!current_task || pgid == 0) {
+static task_t* task_group_parked_leader(uint32_t tgid) {
+    task_t* leader = task_find_by_pid(tgid);
+    if (!leader || leader->state != TASK_STATE_WAITING || leader->wait_pid != WAIT_THREADS_PID) {
         return NULL;
     }
-    task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t) {
+    return leader;
+}
+
+static uint32_t futex_hash(uint32_t key) {
+    return ((key >> 2) * 2654435761u) >> (32u - FUTEX_HASH_BITS);
+}
+
+// A queued task can also be woken by a signal, a timeout or a group kill;
+// those paths clear wait_pid and leave the queue entry behind. Such stale
+// entries are skipped by wakers and dropped by futex_unqueue().
+static bool futex_is_waiting(const task_t* t) {
+    return (t->state == TASK_STATE_WAITING || t->state == TASK_STATE_SLEEPING) &&
+           t->wait_pid == WAIT_FUTEX_PID;
+}
+
+static void futex_enqueue(task_t* t, uint32_t key) {
+    task_t** pp = &futex_queues[futex_hash(key)];
+    while (*pp) {
+        pp = &(*pp)->futex_next; // FIFO: append at the tail
+    }
+    t->futex_key = key;
+    t->futex_next = NULL;
+    *pp = t;
+}
+
+static void futex_unqueue(task_t* t) {
+    if (!t || t->futex_key == 0) {
+        return;
+    }
+    for (task_t** pp = &futex_queues[futex_hash(t->futex_key)]; *pp; pp = &(*pp)->futex_next) {
+        if (*pp == t) {
+            *pp = t->futex_next;
             break;
         }
-        if (t->pgid == pgid) {
-            return t;
+    }
+    t->futex_key = 0;
+    t->futex_next = NULL;
+}
+
+// Wake up to `nr_wake` waiters on `key`, then move up to `nr_requeue` of the
+// remaining ones to `key2` (if non-zero). Returns the number woken plus requeued.
+static uint32_t futex_wake_key(uint32_t key, uint32_t nr_wake, uint32_t key2, uint32_t nr_requeue) {
+    uint32_t woken = 0;
+    uint32_t moved = 0;
+
+    task_t** pp = &futex_queues[futex_hash(key)];
+    while (*pp) {
+        task_t* t = *pp;
+        if (t->futex_key != key) {
+            pp = &t->futex_next;
+            continue;
         }
-        t = t->next;
-        if (t == current_task) {
+        if (!futex_is_waiting(t)) {
+            *pp = t->futex_next;
+            t->futex_key = 0;
+            t->futex_next = NULL;
+            continue;
+        }
+
+        if (woken < nr_wake) {
+            *pp = t->futex_next;
+            t->futex_key = 0;
+            t->futex_next = NULL;
+            interrupt_frame_t* f = (interrupt_frame_t*)t->esp;
+            f->eax = 0;
+            task_set_state(t, TASK_STATE_RUNNABLE);
+            t->wake_tick = 0;
+            t->wait_pid = 0;
+            woken++;
+            continue;
+        }
+
+        if (key2 == 0 || moved >= nr_requeue) {
             break;
         }
+        *pp = t->futex_next;
+        futex_enqueue(t, key2);
+        moved++;
     }
-    return NULL;
+
+    return woken + moved;
 }
 
 static void task_queue_signal(task_t* t, int32_t sig) {
@@ -483,7 +960,10 @@ static void task_queue_signal(task_t* t, int32_t sig) {
     }
 
     if (wake && t->state != TASK_STATE_RUNNABLE) {
-        t->state = TASK_STATE_RUNNABLE;
+        if (t->wait_pid == WAIT_FUTEX_PID && t->esp) {
+            ((interrupt_frame_t*)t->esp)->eax = (uint32_t)-EINTR;
+        }
+        task_set_state(t, TASK_STATE_RUNNABLE);
         t->wake_tick = 0;
         t->wait_pid = 0;
     }
@@ -508,6 +988,7 @@ struct pipe_obj {
     uint32_t used;
     uint32_t readers;
     uint32_t writers;
+    poll_head_t poll;    // POLL_IN/POLL_OUT as data or space appears
 };
 
 static void wait_for_event(void) {
@@ -561,8 +1042,11 @@ static void pipe_unref(pipe_obj_t* p, bool write_end) {
         }
     }
     free_now = (p->readers == 0 && p->writers == 0);
+    // The other end now sees EOF or EPIPE.
+    poll_wake(&p->poll, POLL_IN | POLL_OUT | POLL_HUP);
     irq_restore(f);
     if (free_now) {
+        poll_head_detach(&p->poll);
         kfree(p);
     }
 }
@@ -583,11 +1067,16 @@ static uint32_t pipe_read_some(pipe_obj_t* p, uint8_t* out, uint32_t max) {
         n = avail;
     }
 
-    for (uint32_t i = 0; i < n; i++) {
-        out[i] = p->buf[p->rpos];
-        p->rpos = (p->rpos + 1u) % PIPE_BUF_SIZE;
+    // At most two runs: up to the end of the ring, then from its start.
+    uint32_t first = PIPE_BUF_SIZE - p->rpos;
+    if (first > n) {
+        first = n;
     }
+    memcpy(out, p->buf + p->rpos, first);
+    memcpy(out + first, p->buf, n - first);
+    p->rpos = (p->rpos + n) % PIPE_BUF_SIZE;
     p->used -= n;
+    poll_wake(&p->poll, POLL_OUT);
     irq_restore(f);
     return n;
 }
@@ -619,11 +1108,15 @@ static int32_t pipe_write_some(pipe_obj_t* p, const uint8_t* src, uint32_t len,
         n = space;
     }
 
-    for (uint32_t i = 0; i < n; i++) {
-        p->buf[p->wpos] = src[i];
-        p->wpos = (p->wpos + 1u) % PIPE_BUF_SIZE;
+    uint32_t first = PIPE_BUF_SIZE - p->wpos;
+    if (first > n) {
+        first = n;
     }
+    memcpy(p->buf + p->wpos, src, first);
+    memcpy(p->buf, src + first, n - first);
+    p->wpos = (p->wpos + n) % PIPE_BUF_SIZE;
     p->used += n;
+    poll_wake(&p->poll, POLL_IN);
     irq_restore(f);
 
     if (out_written) {
@@ -632,23 +1125,37 @@ static int32_t pipe_write_some(pipe_obj_t* p, const uint8_t* src, uint32_t len,
     return 0;
 }
 
-static void fd_init(task_t* t) {
+static fd_table_t* fd_table_create(void) {
+    fd_table_t* ft = (fd_table_t*)kmalloc(sizeof(*ft));
+    if (!ft) {
+        return NULL;
+    }
+    memset(ft, 0, sizeof(*ft));
+    ft->refs = 1;
+    return ft;
+}
+
+static bool fd_init(task_t* t) {
     if (!t) {
-        return;
+        return false;
+    }
+    t->files = fd_table_create();
+    if (!t->files) {
+        return false;
     }
-    memset(t->fds, 0, sizeof(t->fds));
     if (TASK_MAX_FDS > 0) {
-        t->fds[0].kind = FD_KIND_STDIN;
-        t->fds[0].fl_flags = 0; // O_RDONLY
+        t->files->fds[0].kind = FD_KIND_STDIN;
+        t->files->fds[0].fl_flags = 0; // O_RDONLY
     }
     if (TASK_MAX_FDS > 1) {
-        t->fds[1].kind = FD_KIND_STDOUT;
-        t->fds[1].fl_flags = 1; // O_WRONLY
+        t->files->fds[1].kind = FD_KIND_STDOUT;
+        t->files->fds[1].fl_flags = 1; // O_WRONLY
     }
     if (TASK_MAX_FDS > 2) {
-        t->fds[2].kind = FD_KIND_STDERR;
-        t->fds[2].fl_flags = 1; // O_WRONLY
+        t->files->fds[2].kind = FD_KIND_STDERR;
+        t->files->fds[2].fl_flags = 1; // O_WRONLY
     }
+    return true;
 }
 
 static void fd_inherit(task_t* child, const task_t* parent) {
@@ -657,8 +1164,8 @@ static void fd_inherit(task_t* child, const task_t* parent) {
     }
 
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        const fd_entry_t* src = &parent->fds[fd];
-        fd_entry_t* dst = &child->fds[fd];
+        const fd_entry_t* src = &parent->files->fds[fd];
+        fd_entry_t* dst = &child->files->fds[fd];
 
         dst->pending_len = 0;
         dst->pending_off = 0;
@@ -670,6 +1177,7 @@ static void fd_inherit(task_t* child, const task_t* parent) {
             dst->handle = NULL;
             dst->pipe = NULL;
             dst->pipe_write_end = false;
+            dst->epoll = NULL;
             continue;
         }
 
@@ -696,17 +1204,26 @@ static void fd_inherit(task_t* child, const task_t* parent) {
         dst->handle = NULL;
         dst->pipe = NULL;
         dst->pipe_write_end = false;
+        dst->epoll = NULL;
+        if (src->kind == FD_KIND_EPOLL && src->epoll) {
+            dst->epoll = src->epoll;
+            epoll_get(dst->epoll);
+        }
     }
 }
 
-static void fd_clone(task_t* child, const task_t* parent) {
-    if (!child || !parent) {
-        return;
+static bool fd_clone(task_t* child, const task_t* parent) {
+    if (!child || !parent || !parent->files) {
+        return false;
+    }
+    child->files = fd_table_create();
+    if (!child->files) {
+        return false;
     }
 
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        const fd_entry_t* src = &parent->fds[fd];
-        fd_entry_t* dst = &child->fds[fd];
+        const fd_entry_t* src = &parent->files->fds[fd];
+        fd_entry_t* dst = &child->files->fds[fd];
 
         dst->pending_len = 0;
         dst->pending_off = 0;
@@ -718,6 +1235,7 @@ static void fd_clone(task_t* child, const task_t* parent) {
             dst->handle = NULL;
             dst->pipe = NULL;
             dst->pipe_write_end = false;
+            dst->epoll = NULL;
             continue;
         }
 
@@ -744,15 +1262,58 @@ static void fd_clone(task_t* child, const task_t* parent) {
         dst->handle = NULL;
         dst->pipe = NULL;
         dst->pipe_write_end = false;
+        dst->epoll = NULL;
+        if (src->kind == FD_KIND_EPOLL && src->epoll) {
+            dst->epoll = src->epoll;
+            epoll_get(dst->epoll);
+        }
+    }
+    return true;
+}
+
+static task_cwd_t* cwd_create(const char* path) {
+    uint32_t len = (uint32_t)strlen(path);
+    task_cwd_t* c = (task_cwd_t*)kmalloc(sizeof(*c) + len + 1u);
+    if (!c) {
+        return NULL;
+    }
+    c->refs = 1;
+    memcpy(c->path, path, len + 1u);
+    return c;
+}
+
+static void cwd_put(task_cwd_t* c) {
+    if (c && --c->refs == 0) {
+        kfree(c);
     }
 }
 
+// Point `t` at `c` (taking a reference). A NULL cwd reads as "/".
+static void cwd_set(task_t* t, task_cwd_t* c) {
+    if (c) {
+        c->refs++;
+    }
+    cwd_put(t->cwd);
+    t->cwd = c;
+}
+
+static const char* task_cwd(const task_t* t) {
+    return (t && t->cwd) ? t->cwd->path : "/";
+}
+
 static void cwd_init(task_t* t) {
     if (!t) {
         return;
     }
-    t->cwd[0] = '/';
-    t->cwd[1] = '\0';
+    if (!cwd_root) {
+        cwd_root = cwd_create("/"); // never released: keeps its initial reference
+    }
+    cwd_set(t, cwd_root);
+}
+
+static tty_ldisc_t* tty_ldisc_current(void) {
+    uint32_t console = current_task ? current_task->console : 0u;
+    return &tty_ldiscs[console < TTY_CONSOLES ? console : 0u];
 }
 
 static void tty_init(task_t* t) {
@@ -770,19 +1331,11 @@ static void tty_init(task_t* t) {
     t->tty.c_cc[VOS_VERASE] = 0x08u;  // backspace
     t->tty.c_cc[VOS_VTIME] = 0u;
     t->tty.c_cc[VOS_VMIN] = 1u;
-
-    t->tty_line_len = 0;
-    t->tty_line_off = 0;
-    t->tty_line_ready = false;
 }
 
-static void task_close_fds(task_t* t) {
-    if (!t) {
-        return;
-    }
-
+static void fd_table_close_all(fd_table_t* ft) {
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        fd_entry_t* ent = &t->fds[fd];
+        fd_entry_t* ent = &ft->fds[fd];
 
         if (ent->kind == FD_KIND_VFS && ent->handle) {
             vfs_handle_t* h = ent->handle;
@@ -809,6 +1362,14 @@ static void task_close_fds(task_t* t) {
             continue;
         }
 
+        if (ent->kind == FD_KIND_EPOLL && ent->epoll) {
+            epoll_t* ep = ent->epoll;
+            ent->kind = FD_KIND_FREE;
+            ent->epoll = NULL;
+            epoll_put(ep);
+            continue;
+        }
+
         if (ent->kind != FD_KIND_FREE) {
             ent->kind = FD_KIND_FREE;
             ent->handle = NULL;
@@ -820,6 +1381,31 @@ static void task_close_fds(task_t* t) {
     }
 }
 
+// Descriptors are closed once the last thread (or pending async I/O) sharing
+// the table lets go.
+static void fd_table_put(fd_table_t* ft) {
+    uint32_t f = irq_save();
+    bool last = (--ft->refs == 0);
+    irq_restore(f);
+    if (!last) {
+        return;
+    }
+
+    fd_table_close_all(ft);
+    kfree(ft);
+}
+
+// Drop the task's reference to its fd table.
+static void task_close_fds(task_t* t) {
+    if (!t || !t->files) {
+        return;
+    }
+
+    fd_table_t* ft = t->files;
+    t->files = NULL;
+    fd_table_put(ft);
+}
+
 static void task_set_name(task_t* t, const char* name) {
     if (!t) {
         return;
@@ -837,20 +1423,48 @@ static void idle_thread(void) {
     }
 }
 
+// Claim the lowest free slot at or above the hint; -1 when the region is full.
+static int32_t kstack_slot_claim(void) {
+    for (uint32_t w = kstack_slot_hint / 32u; w < (KSTACK_SLOTS + 31u) / 32u; w++) {
+        uint32_t free_bits = ~kstack_slot_map[w];
+        if (free_bits == 0) {
+            continue;
+        }
+        uint32_t slot = w * 32u + (uint32_t)__builtin_ctz(free_bits);
+        if (slot >= KSTACK_SLOTS) {
+            break;
+        }
+        kstack_slot_map[w] |= 1u << (slot % 32u);
+        kstack_slot_hint = slot + 1u;
+        return (int32_t)slot;
+    }
+    kstack_slot_hint = KSTACK_SLOTS;
+    return -1;
+}
+
 static bool kstack_alloc(uint32_t* out_stack_top) {
     if (!out_stack_top) {
         return false;
     }
 
-    uint32_t region_base = next_kstack_region;
-    uint32_t stack_bottom = region_base + PAGE_SIZE;          // guard page below
-    uint32_t stack_top = stack_bottom + KSTACK_SIZE;
+    uint32_t flags = irq_save();
+    if (kstack_cache_count > 0) {
+        *out_stack_top = kstack_cache[--kstack_cache_count];
+        kstack_in_use++;
+        irq_restore(flags);
+        return true;
+    }
 
-    if (stack_top < stack_bottom) {
+    int32_t slot = kstack_slot_claim();
+    if (slot < 0) {
+        irq_restore(flags);
         return false;
     }
+    kstack_in_use++;
+    irq_restore(flags);
 
-    next_kstack_region = stack_top;
+    uint32_t stack_bottom = KSTACK_REGION_BASE + (uint32_t)slot * KSTACK_SLOT_SIZE + PAGE_SIZE;  // guard page below
+    uint32_t stack_top = stack_bottom + KSTACK_SIZE;
 
     paging_prepare_range(stack_bottom, KSTACK_SIZE, PAGE_PRESENT | PAGE_RW);
 
@@ -865,7 +1479,13 @@ static bool kstack_alloc(uint32_t* out_stack_top) {
                     pmm_free_frame(paddr);
                 }
             }
-            next_kstack_region = region_base;
+            flags = irq_save();
+            kstack_slot_map[(uint32_t)slot / 32u] &= ~(1u << ((uint32_t)slot % 32u));
+            if ((uint32_t)slot < kstack_slot_hint) {
+                kstack_slot_hint = (uint32_t)slot;
+            }
+            kstack_in_use--;
+            irq_restore(flags);
             return false;
         }
         paging_map_page(va, frame, PAGE_PRESENT | PAGE_RW);
@@ -914,19 +1534,24 @@ static task_t* task_create_kernel(void (*entry)(void), const char* name) {
         return NULL;
     }
     memset(t, 0, sizeof(*t));
+    if (!fd_init(t)) {
+        kfree(t);
+        return NULL;
+    }
     t->id = ++next_id;
+    t->tgid = t->id;
     t->ppid = 0;
     t->pgid = 0;
     t->esp = (uint32_t)sp;
     t->kstack_top = stack_top_addr;
     t->page_directory = paging_kernel_directory();
     t->user = false;
-    t->user_brk = 0;
-    t->user_brk_min = 0;
-    fd_init(t);
+    t->mm = NULL;
     cwd_init(t);
     tty_init(t);
     t->state = TASK_STATE_RUNNABLE;
+    t->start_tick = timer_get_ticks();
+    t->state_since = t->start_tick;
     t->wake_tick = 0;
     t->wait_pid = 0;
     t->exit_code = 0;
@@ -978,21 +1603,31 @@ static task_t* task_create_user(uint32_t entry, uint32_t user_esp, uint32_t* pag
         return NULL;
     }
     memset(t, 0, sizeof(*t));
+    t->mm = mm_create(page_directory, user_brk);
+    t->sighand = sighand_create(NULL);
+    if (!t->mm || !t->sighand || !fd_init(t)) {
+        if (t->mm) {
+            kfree(t->mm);
+        }
+        if (t->sighand) {
+            kfree(t->sighand);
+        }
+        kfree(t);
+        return NULL;
+    }
     t->id = ++next_id;
+    t->tgid = t->id;
     t->ppid = 0;
     t->pgid = t->id;
     t->esp = (uint32_t)sp;
     t->kstack_top = stack_top_addr;
     t->page_directory = page_directory;
     t->user = true;
-    t->user_brk = user_brk;
-    t->user_brk_min = user_brk;
-    t->vm_areas = NULL;
-    t->mmap_top = USER_STACK_TOP - (USER_STACK_PAGES + 1u) * PAGE_SIZE;
-    fd_init(t);
     cwd_init(t);
     tty_init(t);
     t->state = TASK_STATE_RUNNABLE;
+    t->start_tick = timer_get_ticks();
+    t->state_since = t->start_tick;
     t->wake_tick = 0;
     t->wait_pid = 0;
     t->exit_code = 0;
@@ -1005,14 +1640,20 @@ static task_t* task_create_user(uint32_t entry, uint32_t user_esp, uint32_t* pag
 }
 
 static void task_append(task_t* t) {
+    task_link(t);
+    task_count++;
+
     if (!current_task) {
         current_task = t;
         t->next = t;
+        t->prev = t;
         return;
     }
 
     // Insert after current task (simple round-robin).
     t->next = current_task->next;
+    t->prev = current_task;
+    current_task->next->prev = t;
     current_task->next = t;
 }
 
@@ -1026,8 +1667,10 @@ static uint32_t* fork_ensure_child_table(uint32_t* dir, uint32_t dir_index) {
         return (uint32_t*)(entry & 0xFFFFF000u);
     }
 
-    uint32_t* table = (uint32_t*)early_alloc(PAGE_SIZE, PAGE_SIZE);
-    memset(table, 0, PAGE_SIZE);
+    uint32_t* table = paging_alloc_table();
+    if (!table) {
+        return NULL;
+    }
     dir[dir_index] = ((uint32_t)table & 0xFFFFF000u) | (PAGE_PRESENT | PAGE_RW | PAGE_USER);
     return table;
 }
@@ -1097,6 +1740,10 @@ static uint32_t* fork_clone_user_directory(const task_t* parent) {
 }
 
 uint32_t tasking_current_pid(void) {
+    return current_task ? current_task->tgid : 0;
+}
+
+uint32_t tasking_current_tid(void) {
     return current_task ? current_task->id : 0;
 }
 
@@ -1236,6 +1883,10 @@ bool tasking_current_should_interrupt(void) {
     return pending != 0;
 }
 
+task_syscall_t* tasking_current_syscall(void) {
+    return current_task ? &current_task->syscall : NULL;
+}
+
 uint32_t tasking_task_count(void) {
     uint32_t flags = irq_save();
 
@@ -1244,16 +1895,7 @@ uint32_t tasking_task_count(void) {
         return 0;
     }
 
-    uint32_t count = 0;
-    task_t* t = current_task;
-    do {
-        count++;
-        t = t->next;
-        if (!t) {
-            break;
-        }
-    } while (t != current_task && count < TASK_MAX_SCAN);
-
+    uint32_t count = task_count;
     irq_restore(flags);
     return count;
 }
@@ -1277,6 +1919,19 @@ static void fill_task_info(task_info_t* out, const task_t* t) {
         out->eip = f->eip;
         out->esp = (uint32_t)t->esp;
     }
+
+    out->tgid = t->tgid;
+    out->ppid = t->ppid;
+    out->uid = t->uid;
+    out->sys_ticks = t->sys_ticks;
+    out->rss_pages = (t->user && t->mm) ? user_pages_in_directory(t->mm->page_directory) : 0;
+    out->faults = t->faults;
+    out->switches = t->switches;
+    out->start_tick = t->start_tick;
+    for (uint32_t s = 0; s < TASK_STATE_COUNT; s++) {
+        out->state_ticks[s] = t->state_ticks[s];
+    }
+    out->state_ticks[t->state] += timer_get_ticks() - t->state_since;
 }
 
 bool tasking_get_task_info(uint32_t index, task_info_t* out) {
@@ -1301,7 +1956,7 @@ bool tasking_get_task_info(uint32_t index, task_info_t* out) {
         }
         t = t->next;
         i++;
-        if (!t || t == current_task || i >= TASK_MAX_SCAN) {
+        if (!t || t == current_task) {
             break;
         }
     }
@@ -1310,10 +1965,52 @@ bool tasking_get_task_info(uint32_t index, task_info_t* out) {
     return false;
 }
 
+uint32_t tasking_task_snapshot(task_info_t* out, uint32_t start, uint32_t max) {
+    uint32_t flags = irq_save();
+
+    if (!current_task) {
+        irq_restore(flags);
+        return 0;
+    }
+
+    uint32_t n = 0;
+    task_t* t = current_task;
+    do {
+        if (out && n >= start && n - start < max) {
+            fill_task_info(&out[n - start], t);
+        }
+        n++;
+        t = t->next;
+    } while (t && t != current_task);
+
+    irq_restore(flags);
+    return n;
+}
+
 uint32_t tasking_context_switch_count(void) {
     return context_switch_count;
 }
 
+void tasking_get_kstack_stats(uint32_t* in_use, uint32_t* cached, uint32_t* max_depth) {
+    uint32_t flags = irq_save();
+
+    // Freed stacks were folded into kstack_max_depth; sample the live ones.
+    if (current_task) {
+        task_t* t = current_task;
+        do {
+            if (t->kstack_top >= KSTACK_REGION_BASE + KSTACK_SLOT_SIZE && t->kstack_top <= KSTACK_REGION_END) {
+                kstack_note_depth(kstack_depth(t->kstack_top));
+            }
+            t = t->next;
+        } while (t && t != current_task);
+    }
+
+    if (in_use) *in_use = kstack_in_use;
+    if (cached) *cached = kstack_cache_count;
+    if (max_depth) *max_depth = kstack_max_depth;
+    irq_restore(flags);
+}
+
 void tasking_get_state_counts(uint32_t* runnable, uint32_t* sleeping,
                               uint32_t* waiting, uint32_t* zombie) {
     uint32_t r = 0, s = 0, w = 0, z = 0;
@@ -1322,7 +2019,7 @@ void tasking_get_state_counts(uint32_t* runnable, uint32_t* sleeping,
 
     if (current_task) {
         task_t* t = current_task;
-        for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
+        for (;;) {
             if (!t) {
                 break;
             }
@@ -1353,14 +2050,15 @@ static void wake_sleepers(uint32_t now_ticks) {
     }
 
     task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
+    for (;;) {
         if (!t) {
             break;
         }
         if (t->state == TASK_STATE_SLEEPING) {
             if ((int32_t)(now_ticks - t->wake_tick) >= 0) {
-                t->state = TASK_STATE_RUNNABLE;
+                task_set_state(t, TASK_STATE_RUNNABLE);
                 t->wake_tick = 0;
+                t->wait_pid = 0; // a timed-out futex waiter leaves its queue entry stale
             }
         }
         t = t->next;
@@ -1376,7 +2074,7 @@ static void check_alarms(uint32_t now_ticks) {
     }
 
     task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
+    for (;;) {
         if (!t) {
             break;
         }
@@ -1416,23 +2114,19 @@ static void wake_waiters(task_t* dead) {
     uint32_t irq_flags = irq_save();
     uint32_t* dead_dir = current_task->page_directory ? current_task->page_directory : paging_kernel_directory();
 
-    task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t) {
-            break;
-        }
-
+    // Only the parent process's threads may wait for `dead`.
+    for (task_t* t = task_group_first(dead_ppid); t; t = task_group_next(t)) {
         bool match = false;
         if (t->state == TASK_STATE_WAITING) {
             if (t->wait_pid == pid) {
                 match = true;
-            } else if (t->wait_pid == WAIT_ANY_PID && dead_ppid != 0 && t->id == dead_ppid) {
+            } else if (t->wait_pid == WAIT_ANY_PID) {
                 match = true;
             }
         }
 
         if (match) {
-            t->state = TASK_STATE_RUNNABLE;
+            task_set_state(t, TASK_STATE_RUNNABLE);
             t->wait_pid = 0;
 
             if (t->esp) {
@@ -1468,11 +2162,6 @@ static void wake_waiters(task_t* dead) {
             t->wait_return_pid = false;
             any_woken = true;
         }
-
-        t = t->next;
-        if (t == current_task) {
-            break;
-        }
     }
 
     if (any_woken && any_delivered) {
@@ -1485,7 +2174,7 @@ static void wake_waiters(task_t* dead) {
 
 static task_t* pick_next_runnable(task_t* start, const task_t* stop) {
     task_t* t = start;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
+    for (;;) {
         if (!t || t == stop) {
             return NULL;
         }
@@ -1507,25 +2196,29 @@ void tasking_init(void) {
         return;
     }
     memset(boot, 0, sizeof(*boot));
+    if (!fd_init(boot)) {
+        kfree(boot);
+        return;
+    }
     boot->id = next_id;
+    boot->tgid = boot->id;
     boot->esp = 0;
     boot->kstack_top = (uint32_t)&stack_top;
     boot->page_directory = paging_kernel_directory();
     boot->user = false;
-    boot->user_brk = 0;
-    boot->user_brk_min = 0;
-    fd_init(boot);
+    boot->mm = NULL;
     cwd_init(boot);
     tty_init(boot);
     boot->state = TASK_STATE_RUNNABLE;
+    boot->start_tick = timer_get_ticks();
+    boot->state_since = boot->start_tick;
     boot->wake_tick = 0;
     boot->wait_pid = 0;
     boot->exit_code = 0;
     boot->cpu_ticks = 0;
     boot->console = 0;
     task_set_name(boot, "boot");
-    boot->next = boot;
-    current_task = boot;
+    task_append(boot);
 
     task_t* idle = task_create_kernel(idle_thread, "idle");
     if (idle) {
@@ -1541,6 +2234,210 @@ bool tasking_is_enabled(void) {
     return enabled;
 }
 
+static interrupt_frame_t* task_switch_to(task_t* next) {
+    context_switch_count++;
+    next->switches++;
+    current_task = next;
+    // Lazy FPU switching: any other task traps with #NM on its first FPU
+    // instruction and only then gets its registers loaded.
+    if (fpu_present()) {
+        if (next == fpu_owner) {
+            fpu_clear_ts();
+        } else {
+            fpu_set_ts();
+        }
+    }
+    tss_set_kernel_stack(current_task->kstack_top);
+    gdt_set_tls_base(current_task->tls_base);
+    paging_switch_directory(current_task->page_directory);
+    return (interrupt_frame_t*)current_task->esp;
+}
+
+uint32_t tasking_spawn_kernel(void (*entry)(void), const char* name) {
+    task_t* t = task_create_kernel(entry, name);
+    if (!t) {
+        return 0;
+    }
+    uint32_t flags = irq_save();
+    task_append(t);
+    irq_restore(flags);
+    return t->id;
+}
+
+void tasking_wake(uint32_t pid) {
+    uint32_t flags = irq_save();
+    task_t* t = task_find_by_pid(pid);
+    if (t && t->state == TASK_STATE_SLEEPING) {
+        task_set_state(t, TASK_STATE_RUNNABLE);
+        t->wake_tick = 0;
+    }
+    irq_restore(flags);
+}
+
+struct task_io_ctx {
+    uint32_t refs;
+    task_mm_t* mm;
+    fd_table_t* files;
+    task_cwd_t* cwd;
+    uint32_t uid;
+    uint32_t gid;
+    uint8_t console;
+
+    // The worker's own state while it runs inside the context.
+    task_mm_t* saved_mm;
+    uint32_t* saved_dir;
+    fd_table_t* saved_files;
+    task_cwd_t* saved_cwd;
+    uint32_t saved_uid;
+    uint32_t saved_gid;
+    uint8_t saved_console;
+};
+
+task_io_ctx_t* tasking_io_ctx_get(void) {
+    if (!current_task) {
+        return NULL;
+    }
+    task_io_ctx_t* ctx = (task_io_ctx_t*)kmalloc(sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+
+    uint32_t flags = irq_save();
+    ctx->refs = 1;
+    ctx->mm = current_task->mm;
+    ctx->files = current_task->files;
+    ctx->cwd = current_task->cwd;
+    ctx->uid = current_task->uid;
+    ctx->gid = current_task->gid;
+    ctx->console = current_task->console;
+    if (ctx->mm) {
+        ctx->mm->refs++;
+    }
+    if (ctx->files) {
+        ctx->files->refs++;
+    }
+    if (ctx->cwd) {
+        ctx->cwd->refs++;
+    }
+    irq_restore(flags);
+    return ctx;
+}
+
+void tasking_io_ctx_hold(task_io_ctx_t* ctx) {
+    if (!ctx) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    ctx->refs++;
+    irq_restore(flags);
+}
+
+void tasking_io_ctx_put(task_io_ctx_t* ctx) {
+    if (!ctx) {
+        return;
+    }
+    uint32_t flags = irq_save();
+    bool last = (--ctx->refs == 0);
+    irq_restore(flags);
+    if (!last) {
+        return;
+    }
+    if (ctx->files) {
+        fd_table_put(ctx->files);
+    }
+    cwd_put(ctx->cwd);
+    mm_put(ctx->mm);
+    kfree(ctx);
+}
+
+void tasking_io_ctx_enter(task_io_ctx_t* ctx) {
+    if (!ctx || !current_task) {
+        return;
+    }
+    task_t* t = current_task;
+    uint32_t flags = irq_save();
+    ctx->saved_mm = t->mm;
+    ctx->saved_dir = t->page_directory;
+    ctx->saved_files = t->files;
+    ctx->saved_cwd = t->cwd;
+    ctx->saved_uid = t->uid;
+    ctx->saved_gid = t->gid;
+    ctx->saved_console = t->console;
+
+    t->mm = ctx->mm;
+    if (ctx->mm) {
+        t->page_directory = ctx->mm->page_directory;
+    }
+    if (ctx->files) {
+        t->files = ctx->files;
+    }
+    t->cwd = ctx->cwd;
+    t->uid = ctx->uid;
+    t->gid = ctx->gid;
+    t->console = ctx->console;
+    paging_switch_directory(t->page_directory);
+    irq_restore(flags);
+}
+
+void tasking_io_ctx_leave(task_io_ctx_t* ctx) {
+    if (!ctx || !current_task) {
+        return;
+    }
+    task_t* t = current_task;
+    uint32_t flags = irq_save();
+    t->mm = ctx->saved_mm;
+    t->page_directory = ctx->saved_dir;
+    t->files = ctx->saved_files;
+    t->cwd = ctx->saved_cwd;
+    t->uid = ctx->saved_uid;
+    t->gid = ctx->saved_gid;
+    t->console = ctx->saved_console;
+    paging_switch_directory(t->page_directory);
+    irq_restore(flags);
+}
+
+struct uring* tasking_uring(void) {
+    if (!current_task || !current_task->mm) {
+        return NULL;
+    }
+    return current_task->mm->uring;
+}
+
+bool tasking_set_uring(struct uring* r) {
+    if (!current_task || !current_task->mm) {
+        return false;
+    }
+    current_task->mm->uring = r;
+    return true;
+}
+
+bool tasking_fpu_trap(void) {
+    if (!fpu_present() || !current_task) {
+        return false;
+    }
+    current_task->faults++;
+
+    if (!current_task->fpu) {
+        current_task->fpu = (fpu_state_t*)kmalloc(sizeof(fpu_state_t));
+        if (!current_task->fpu) {
+            return false;
+        }
+        fpu_init_state(current_task->fpu);
+    }
+
+    fpu_clear_ts();
+    if (fpu_owner == current_task) {
+        return true;
+    }
+    if (fpu_owner) {
+        fpu_save(fpu_owner->fpu);
+    }
+    fpu_restore(current_task->fpu);
+    fpu_owner = current_task;
+    return true;
+}
+
 interrupt_frame_t* tasking_on_timer_tick(interrupt_frame_t* frame) {
     if (!enabled || !current_task || !frame) {
         return frame;
@@ -1554,6 +2451,9 @@ interrupt_frame_t* tasking_on_timer_tick(interrupt_frame_t* frame) {
     }
 
     current_task->cpu_ticks++;
+    if ((frame->cs & 3u) != 3u) {
+        current_task->sys_ticks++;
+    }
 
     uint32_t now = timer_get_ticks();
     wake_sleepers(now);
@@ -1574,11 +2474,7 @@ interrupt_frame_t* tasking_on_timer_tick(interrupt_frame_t* frame) {
         return frame;
     }
 
-    context_switch_count++;
-    current_task = next;
-    tss_set_kernel_stack(current_task->kstack_top);
-    paging_switch_directory(current_task->page_directory);
-    return (interrupt_frame_t*)current_task->esp;
+    return task_switch_to(next);
 }
 
 interrupt_frame_t* tasking_yield(interrupt_frame_t* frame) {
@@ -1586,32 +2482,111 @@ interrupt_frame_t* tasking_yield(interrupt_frame_t* frame) {
         return frame;
     }
 
-    task_reap_waited_zombies();
+    task_reap_waited_zombies();
+
+    current_task->esp = (uint32_t)frame;
+    task_t* next = pick_next_runnable(current_task->next, current_task);
+    if (!next) {
+        return frame;
+    }
+
+    return task_switch_to(next);
+}
+
+static void task_clear_child_tid(task_t* t) {
+    if (!t || !t->clear_tid_user) {
+        return;
+    }
+    // Runs in the exiting task's address space, so a plain usercopy works.
+    uint32_t zero = 0;
+    uint32_t key = 0;
+    if (copy_to_user(t->clear_tid_user, &zero, (uint32_t)sizeof(zero)) &&
+        paging_user_virt_to_phys((uint32_t)t->clear_tid_user, &key)) {
+        (void)futex_wake_key(key, 0xFFFFFFFFu, 0, 0); // pthread_join()
+    }
+    t->clear_tid_user = NULL;
+}
+
+static interrupt_frame_t* task_finish_exit(interrupt_frame_t* frame, int32_t exit_code) {
+    futex_unqueue(current_task);
+    task_clear_child_tid(current_task);
+    task_close_fds(current_task);
+    task_set_state(current_task, TASK_STATE_ZOMBIE);
+    current_task->exit_code = exit_code;
+    current_task->esp = (uint32_t)frame;
+
+    if (task_is_thread(current_task)) {
+        // Nobody waits for a non-leader thread: hand it straight to the reaper,
+        // and let a parked main thread finish once the last worker is gone.
+        current_task->waited = true;
+        reap_pending = true;
+        if (!task_group_has_live_threads(current_task)) {
+            task_t* leader = task_group_parked_leader(current_task->tgid);
+            if (leader) {
+                interrupt_frame_t* lf = (interrupt_frame_t*)leader->esp;
+                lf->eax = 0;
+                task_set_state(leader, TASK_STATE_RUNNABLE);
+                leader->wait_pid = 0;
+            }
+        }
+        return tasking_yield(frame);
+    }
+
+    task_orphan_children(current_task);
+    current_task->waited = false;
+    wake_waiters(current_task);
+
+    task_t* parent = task_find_by_pid(current_task->ppid);
+    if (!parent && current_task->user) {
+        // Orphan: nobody can wait for us, so don't linger as a zombie.
+        current_task->waited = true;
+        reap_pending = true;
+    } else if (parent && parent->user && parent->sighand) {
+        // SIGCHLD is ignored by default; only deliver it to a catching parent
+        // so blocking calls elsewhere aren't interrupted.
+        uint32_t handler = parent->sighand->handlers[VOS_SIGCHLD];
+        if (handler != VOS_SIG_DFL && handler != VOS_SIG_IGN) {
+            task_queue_signal(parent, VOS_SIGCHLD);
+        }
+    }
+    return tasking_yield(frame);
+}
+
+interrupt_frame_t* tasking_exit(interrupt_frame_t* frame, int32_t exit_code) {
+    if (!enabled || !current_task || !frame) {
+        return frame;
+    }
+
+    // Process exit: every other thread in the group goes down with us,
+    // unless we are one of those threads.
+    if (!current_task->kill_alone) {
+        task_kill_group_siblings(current_task, exit_code);
+    }
+    return task_finish_exit(frame, exit_code);
+}
 
-    current_task->esp = (uint32_t)frame;
-    task_t* next = pick_next_runnable(current_task->next, current_task);
-    if (!next) {
+interrupt_frame_t* tasking_thread_exit(interrupt_frame_t* frame, int32_t exit_code) {
+    if (!enabled || !current_task || !frame) {
         return frame;
     }
 
-    context_switch_count++;
-    current_task = next;
-    tss_set_kernel_stack(current_task->kstack_top);
-    paging_switch_directory(current_task->page_directory);
-    return (interrupt_frame_t*)current_task->esp;
-}
+    if (task_is_thread(current_task)) {
+        return task_finish_exit(frame, exit_code);
+    }
 
-interrupt_frame_t* tasking_exit(interrupt_frame_t* frame, int32_t exit_code) {
-    if (!enabled || !current_task || !frame) {
+    // The main thread carries the process exit status, so it only waits here
+    // for the other threads to finish; the caller then exits the process.
+    frame->eax = 0;
+    if (!task_group_has_live_threads(current_task)) {
         return frame;
     }
 
-    task_close_fds(current_task);
-    current_task->state = TASK_STATE_ZOMBIE;
-    current_task->exit_code = exit_code;
-    current_task->waited = false;
+    frame->eax = (uint32_t)-EINTR; // overwritten when the last thread exits
+    task_set_state(current_task, TASK_STATE_WAITING);
+    current_task->wait_pid = WAIT_THREADS_PID;
+    current_task->wait_status_user = NULL;
+    current_task->wait_return_pid = false;
     current_task->esp = (uint32_t)frame;
-    wake_waiters(current_task);
     return tasking_yield(frame);
 }
 
@@ -1619,44 +2594,124 @@ interrupt_frame_t* tasking_sleep_until(interrupt_frame_t* frame, uint32_t wake_t
     if (!enabled || !current_task || !frame) {
         return frame;
     }
-    current_task->state = TASK_STATE_SLEEPING;
+    task_set_state(current_task, TASK_STATE_SLEEPING);
     current_task->wake_tick = wake_tick;
     current_task->esp = (uint32_t)frame;
     return tasking_yield(frame);
 }
 
-interrupt_frame_t* tasking_wait(interrupt_frame_t* frame, uint32_t pid) {
+static int32_t futex_key_from_user(const void* uaddr, uint32_t* out_key) {
+    uint32_t addr = (uint32_t)uaddr;
+    if ((addr & 3u) != 0) {
+        return -EINVAL;
+    }
+    if (!paging_user_virt_to_phys(addr, out_key)) {
+        return -EFAULT;
+    }
+    return 0;
+}
+
+interrupt_frame_t* tasking_futex_wait(interrupt_frame_t* frame, const void* uaddr, uint32_t val, uint32_t wake_tick) {
     if (!enabled || !current_task || !frame) {
         return frame;
     }
-    if (pid == 0 || pid == current_task->id) {
-        frame->eax = (uint32_t)-1;
+
+    uint32_t irq_flags = irq_save();
+
+    uint32_t key = 0;
+    int32_t rc = futex_key_from_user(uaddr, &key);
+    uint32_t cur = 0;
+    if (rc == 0 && !copy_from_user(&cur, uaddr, (uint32_t)sizeof(cur))) {
+        rc = -EFAULT;
+    }
+    if (rc == 0 && cur != val) {
+        rc = -EAGAIN;
+    }
+    if (rc != 0) {
+        irq_restore(irq_flags);
+        frame->eax = (uint32_t)rc;
         return frame;
     }
 
-    task_t* target = NULL;
-    task_t* t = current_task;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t) {
-            break;
-        }
-        if (t->id == pid) {
-            target = t;
-            break;
+    // Interrupts stay off from the value check to the enqueue, so a waker on
+    // this CPU can't slip in between and the wakeup can't be lost.
+    futex_unqueue(current_task);
+    futex_enqueue(current_task, key);
+    current_task->wait_pid = WAIT_FUTEX_PID;
+    if (wake_tick != 0) {
+        task_set_state(current_task, TASK_STATE_SLEEPING);
+        current_task->wake_tick = wake_tick;
+        frame->eax = (uint32_t)-ETIMEDOUT; // overwritten by a wake or a signal
+    } else {
+        task_set_state(current_task, TASK_STATE_WAITING);
+        frame->eax = (uint32_t)-EINTR;
+    }
+    current_task->esp = (uint32_t)frame;
+
+    irq_restore(irq_flags);
+    return tasking_yield(frame);
+}
+
+int32_t tasking_futex_wake(const void* uaddr, uint32_t nr_wake) {
+    uint32_t key = 0;
+    int32_t rc = futex_key_from_user(uaddr, &key);
+    if (rc != 0) {
+        return rc;
+    }
+
+    uint32_t irq_flags = irq_save();
+    uint32_t n = futex_wake_key(key, nr_wake, 0, 0);
+    irq_restore(irq_flags);
+    return (int32_t)(n & 0x7FFFFFFFu);
+}
+
+int32_t tasking_futex_requeue(const void* uaddr, uint32_t nr_wake, const void* uaddr2, uint32_t nr_requeue,
+                              bool cmp, uint32_t cmp_val) {
+    uint32_t key = 0;
+    uint32_t key2 = 0;
+    int32_t rc = futex_key_from_user(uaddr, &key);
+    if (rc == 0) {
+        rc = futex_key_from_user(uaddr2, &key2);
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    uint32_t irq_flags = irq_save();
+    if (cmp) {
+        uint32_t cur = 0;
+        if (!copy_from_user(&cur, uaddr, (uint32_t)sizeof(cur))) {
+            irq_restore(irq_flags);
+            return -EFAULT;
         }
-        t = t->next;
-        if (t == current_task) {
-            break;
+        if (cur != cmp_val) {
+            irq_restore(irq_flags);
+            return -EAGAIN;
         }
     }
+    uint32_t n = (key2 == key) ? futex_wake_key(key, nr_wake, 0, 0)
+                               : futex_wake_key(key, nr_wake, key2, nr_requeue);
+    irq_restore(irq_flags);
+    return (int32_t)(n & 0x7FFFFFFFu);
+}
+
+interrupt_frame_t* tasking_wait(interrupt_frame_t* frame, uint32_t pid) {
+    if (!enabled || !current_task || !frame) {
+        return frame;
+    }
+    if (pid == 0 || pid == current_task->id || pid == current_task->tgid) {
+        frame->eax = (uint32_t)-1;
+        return frame;
+    }
 
+    task_t* target = task_find_by_pid(pid);
     if (!target) {
         frame->eax = (uint32_t)-1;
         return frame;
     }
 
     // POSIX-ish: only allow waiting on direct children.
-    if (target->ppid != current_task->id) {
+    if (target->ppid != current_task->tgid || task_is_thread(target)) {
         frame->eax = (uint32_t)-1;
         return frame;
     }
@@ -1679,7 +2734,7 @@ interrupt_frame_t* tasking_wait(interrupt_frame_t* frame, uint32_t pid) {
         return frame;
     }
 
-    current_task->state = TASK_STATE_WAITING;
+    task_set_state(current_task, TASK_STATE_WAITING);
     current_task->wait_pid = pid;
     current_task->wait_status_user = NULL;
     current_task->wait_return_pid = false;
@@ -1705,7 +2760,7 @@ interrupt_frame_t* tasking_waitpid(interrupt_frame_t* frame, int32_t pid, void*
 
     if (pid > 0) {
         task_t* target = task_find_by_pid((uint32_t)pid);
-        if (!target || target->ppid != current_task->id || !target->user) {
+        if (!target || target->ppid != current_task->tgid || !target->user || task_is_thread(target)) {
             frame->eax = (uint32_t)-ECHILD;
             return frame;
         }
@@ -1739,7 +2794,7 @@ interrupt_frame_t* tasking_waitpid(interrupt_frame_t* frame, int32_t pid, void*
             return frame;
         }
 
-        current_task->state = TASK_STATE_WAITING;
+        task_set_state(current_task, TASK_STATE_WAITING);
         current_task->wait_pid = (uint32_t)pid;
         current_task->wait_status_user = status_user;
         current_task->wait_return_pid = true;
@@ -1750,19 +2805,15 @@ interrupt_frame_t* tasking_waitpid(interrupt_frame_t* frame, int32_t pid, void*
     // pid == -1: wait for any child.
     bool any_child = false;
     task_t* zombie = NULL;
-    task_t* t = current_task->next;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t || t == current_task) {
-            break;
-        }
-        if (t->user && t->ppid == current_task->id && !t->waited) {
+    task_t* leader = task_group_first(current_task->tgid);
+    for (task_t* t = leader ? leader->children : NULL; t; t = t->sibling_next) {
+        if (t->user && !t->waited) {
             any_child = true;
             if (t->state == TASK_STATE_ZOMBIE) {
                 zombie = t;
                 break;
             }
         }
-        t = t->next;
     }
 
     if (zombie) {
@@ -1795,7 +2846,7 @@ interrupt_frame_t* tasking_waitpid(interrupt_frame_t* frame, int32_t pid, void*
         return frame;
     }
 
-    current_task->state = TASK_STATE_WAITING;
+    task_set_state(current_task, TASK_STATE_WAITING);
     current_task->wait_pid = WAIT_ANY_PID;
     current_task->wait_status_user = status_user;
     current_task->wait_return_pid = true;
@@ -1831,44 +2882,26 @@ int32_t tasking_kill(int32_t pid, int32_t sig) {
 
     uint32_t flags = irq_save();
 
-    task_t* t = current_task;
     bool any_match = false;
     bool any_signaled = false;
     bool any_perm_denied = false;
-    for (uint32_t i = 0; i < TASK_MAX_SCAN; i++) {
-        if (!t) {
-            break;
-        }
-        bool match = false;
-        if (target_group) {
-            match = (target_pgid != 0 && t->pgid == target_pgid);
-        } else {
-            match = (t->id == target_pid);
-        }
-
-        if (match) {
+    task_t* t = target_group ? task_find_any_by_pgid(target_pgid) : task_find_by_pid(target_pid);
+    while (t) {
+        // Group members share a hash bucket with other groups; skip those.
+        if (!target_group || t->pgid == target_pgid) {
             any_match = true;
             if (!t->user) {
                 any_perm_denied = true;
             } else if (current_task->uid != 0u && t->uid != current_task->uid) {
                 any_perm_denied = true;
-            } else if (sig != 0) {
-                task_queue_signal(t, sig);
-                any_signaled = true;
-                if (!target_group) {
-                    break;
-                }
             } else {
-                any_signaled = true;
-                if (!target_group) {
-                    break;
+                if (sig != 0) {
+                    task_queue_signal(t, sig);
                 }
+                any_signaled = true;
             }
         }
-        t = t->next;
-        if (t == current_task) {
-            break;
-        }
+        t = target_group ? t->pgrp_next : NULL;
     }
 
     irq_restore(flags);
@@ -1920,7 +2953,7 @@ int32_t tasking_setpgid(int32_t pid, int32_t pgid) {
     }
 
     // Only allow changing our own pgid or that of a direct child.
-    if (target != current_task && target->ppid != current_task->id) {
+    if (target != current_task && target->ppid != current_task->tgid) {
         irq_restore(flags);
         return -EPERM;
     }
@@ -1932,7 +2965,7 @@ int32_t tasking_setpgid(int32_t pid, int32_t pgid) {
         return -ESRCH;
     }
 
-    target->pgid = upgid;
+    task_set_pgid(target, upgid);
     irq_restore(flags);
     return 0;
 }
@@ -1952,9 +2985,9 @@ int32_t tasking_signal_set_handler(int32_t sig, uint32_t handler, uint32_t* out_
         return -EINVAL;
     }
     if (out_old) {
-        *out_old = current_task->sig_handlers[sig];
+        *out_old = current_task->sighand->handlers[sig];
     }
-    current_task->sig_handlers[sig] = handler;
+    current_task->sighand->handlers[sig] = handler;
     return 0;
 }
 
@@ -2052,7 +3085,7 @@ interrupt_frame_t* tasking_deliver_pending_signals(interrupt_frame_t* frame) {
     // Consume the pending bit now; if delivery fails we'll terminate.
     current_task->sig_pending &= ~(1u << (uint32_t)sig);
 
-    uint32_t handler = current_task->sig_handlers[sig];
+    uint32_t handler = current_task->sighand->handlers[sig];
     if (handler == VOS_SIG_IGN) {
         return frame;
     }
@@ -2097,8 +3130,10 @@ interrupt_frame_t* tasking_deliver_pending_signals(interrupt_frame_t* frame) {
     uint32_t total = 8u + (uint32_t)sizeof(sf) + (uint32_t)sizeof(stub);
     uint32_t new_esp = old_user_esp - total;
 
+    // Only the main stack has a known guard page; thread stacks live in
+    // mmap'd memory and rely on copy_to_user() below to catch overflow.
     uint32_t stack_guard_bottom = USER_STACK_TOP - (USER_STACK_PAGES + 1u) * PAGE_SIZE;
-    if (new_esp < stack_guard_bottom + PAGE_SIZE) {
+    if (old_user_esp > stack_guard_bottom && new_esp < stack_guard_bottom + PAGE_SIZE) {
         return tasking_exit(frame, -EFAULT);
     }
 
@@ -2147,7 +3182,7 @@ interrupt_frame_t* tasking_sbrk(interrupt_frame_t* frame, int32_t increment) {
         return frame;
     }
 
-    uint32_t old_brk = current_task->user_brk;
+    uint32_t old_brk = current_task->mm->user_brk;
     if (increment == 0) {
         frame->eax = old_brk;
         return frame;
@@ -2172,7 +3207,7 @@ interrupt_frame_t* tasking_sbrk(interrupt_frame_t* frame, int32_t increment) {
 
     uint32_t stack_guard_bottom = USER_STACK_TOP - (USER_STACK_PAGES + 1u) * PAGE_SIZE;
 
-    if (new_brk < USER_BASE || new_brk < current_task->user_brk_min || new_brk > stack_guard_bottom) {
+    if (new_brk < USER_BASE || new_brk < current_task->mm->user_brk_min || new_brk > stack_guard_bottom) {
         frame->eax = (uint32_t)-1;
         return frame;
     }
@@ -2183,8 +3218,8 @@ interrupt_frame_t* tasking_sbrk(interrupt_frame_t* frame, int32_t increment) {
         uint32_t start = (old_brk + PAGE_SIZE - 1u) & ~(PAGE_SIZE - 1u);
         uint32_t end = (new_brk + PAGE_SIZE - 1u) & ~(PAGE_SIZE - 1u);
 
-        // Allocate any required page tables before allocating physical frames for the
-        // heap pages, otherwise early_alloc() page tables could overlap frames.
+        // Allocate any required page tables before allocating physical frames
+        // for the heap pages.
         if (end > start) {
             paging_prepare_range(start, end - start, PAGE_PRESENT | PAGE_RW | PAGE_USER);
         }
@@ -2227,7 +3262,7 @@ interrupt_frame_t* tasking_sbrk(interrupt_frame_t* frame, int32_t increment) {
         }
     }
 
-    current_task->user_brk = new_brk;
+    current_task->mm->user_brk = new_brk;
     irq_restore(irq_flags);
     frame->eax = old_brk;
     return frame;
@@ -2288,12 +3323,12 @@ static void vm_insert_sorted(task_t* t, vm_area_t* node) {
     if (!t || !node) {
         return;
     }
-    if (!t->vm_areas || node->start < t->vm_areas->start) {
-        node->next = t->vm_areas;
-        t->vm_areas = node;
+    if (!t->mm->vm_areas || node->start < t->mm->vm_areas->start) {
+        node->next = t->mm->vm_areas;
+        t->mm->vm_areas = node;
         return;
     }
-    vm_area_t* cur = t->vm_areas;
+    vm_area_t* cur = t->mm->vm_areas;
     while (cur->next && cur->next->start <= node->start) {
         cur = cur->next;
     }
@@ -2401,7 +3436,7 @@ int32_t tasking_mmap(uint32_t addr_hint, uint32_t length, uint32_t prot, uint32_
         }
 
         uint32_t f = irq_save();
-        fd_entry_t* ent = &current_task->fds[fd];
+        fd_entry_t* ent = &current_task->files->fds[fd];
         if (ent->kind == FD_KIND_VFS) {
             file = ent->handle;
         }
@@ -2452,19 +3487,19 @@ int32_t tasking_mmap(uint32_t addr_hint, uint32_t length, uint32_t prot, uint32_
         if (start < USER_BASE || end > user_max) {
             return -EINVAL;
         }
-        if (start < current_task->user_brk) {
+        if (start < current_task->mm->user_brk) {
             return -EINVAL;
         }
-        if (vm_overlap_any(current_task->vm_areas, start, end)) {
+        if (vm_overlap_any(current_task->mm->vm_areas, start, end)) {
             return -EINVAL;
         }
     } else {
-        uint32_t top = current_task->mmap_top;
+        uint32_t top = current_task->mm->mmap_top;
         if (top == 0) {
             top = user_max;
         }
         // Ensure we don't collide with the current heap.
-        if (top <= current_task->user_brk + size) {
+        if (top <= current_task->mm->user_brk + size) {
             return -ENOMEM;
         }
         start = u32_align_down(top - size, PAGE_SIZE);
@@ -2473,13 +3508,10 @@ int32_t tasking_mmap(uint32_t addr_hint, uint32_t length, uint32_t prot, uint32_
         }
     }
 
-    uint32_t map_flags = PAGE_PRESENT | PAGE_USER;
-    if ((prot & VOS_PROT_WRITE) != 0) {
-        map_flags |= PAGE_RW;
-    }
-
+    // Map writable so the kernel (which honours CR0.WP) can zero and fill
+    // the pages; read-only mappings lose PAGE_RW once they're populated.
     uint32_t irq_flags = irq_save();
-    int32_t rc = user_map_zero_pages(start, start + size, map_flags);
+    int32_t rc = user_map_zero_pages(start, start + size, PAGE_PRESENT | PAGE_RW | PAGE_USER);
     if (rc < 0) {
         irq_restore(irq_flags);
         return rc;
@@ -2499,7 +3531,7 @@ int32_t tasking_mmap(uint32_t addr_hint, uint32_t length, uint32_t prot, uint32_
     vm_insert_sorted(current_task, node);
 
     if ((flags & VOS_MAP_FIXED) == 0) {
-        current_task->mmap_top = start;
+        current_task->mm->mmap_top = start;
     }
 
     irq_restore(irq_flags);
@@ -2550,6 +3582,9 @@ int32_t tasking_mmap(uint32_t addr_hint, uint32_t length, uint32_t prot, uint32_
         }
     }
 
+    if ((prot & VOS_PROT_WRITE) == 0) {
+        (void)tasking_mprotect_pages(start, start + size, prot);
+    }
     return 0;
 }
 
@@ -2580,7 +3615,7 @@ int32_t tasking_munmap(uint32_t addr, uint32_t length) {
     uint32_t irq_flags = irq_save();
 
     vm_area_t* prev = NULL;
-    vm_area_t* cur = current_task->vm_areas;
+    vm_area_t* cur = current_task->mm->vm_areas;
     while (cur) {
         uint32_t a = cur->start;
         uint32_t b = cur->start + cur->size;
@@ -2607,7 +3642,7 @@ int32_t tasking_munmap(uint32_t addr, uint32_t length) {
             if (prev) {
                 prev->next = next;
             } else {
-                current_task->vm_areas = next;
+                current_task->mm->vm_areas = next;
             }
             kfree(cur);
             cur = next;
@@ -2694,12 +3729,11 @@ uint32_t tasking_spawn_user_pid(uint32_t entry, uint32_t user_esp, uint32_t* pag
         return 0;
     }
 
-    t->ppid = current_task->id;
+    t->ppid = current_task->tgid;
 
     // Inherit the caller's current working directory and terminal settings
     // so userland behaves like a normal process tree.
-    strncpy(t->cwd, current_task->cwd, sizeof(t->cwd) - 1u);
-    t->cwd[sizeof(t->cwd) - 1u] = '\0';
+    cwd_set(t, current_task->cwd);
     t->tty = current_task->tty;
     t->uid = current_task->uid;
     t->gid = current_task->gid;
@@ -2713,7 +3747,8 @@ bool tasking_spawn_user(uint32_t entry, uint32_t user_esp, uint32_t* page_direct
     return tasking_spawn_user_pid(entry, user_esp, page_directory, user_brk) != 0;
 }
 
-int32_t tasking_fork(interrupt_frame_t* frame) {
+int32_t tasking_clone(interrupt_frame_t* frame, uint32_t flags, uint32_t child_stack,
+                      void* parent_tid_user, uint32_t tls, void* child_tid_user) {
     if (!enabled || !current_task || !frame) {
         return -EINVAL;
     }
@@ -2721,76 +3756,125 @@ int32_t tasking_fork(interrupt_frame_t* frame) {
         return -EPERM;
     }
 
+    // The low byte carries the exit signal on Linux; children always report
+    // through wait/waitpid here, so it is ignored.
+    flags &= ~0xFFu;
+    if ((flags & ~VOS_CLONE_SUPPORTED) != 0) {
+        return -EINVAL;
+    }
+    // Same rules as Linux: shared handlers need a shared address space, and a
+    // thread must share its group's handlers.
+    if ((flags & VOS_CLONE_SIGHAND) && !(flags & VOS_CLONE_VM)) {
+        return -EINVAL;
+    }
+    if ((flags & VOS_CLONE_THREAD) && !(flags & VOS_CLONE_SIGHAND)) {
+        return -EINVAL;
+    }
+    // Two tasks running on the same user stack would corrupt each other.
+    if ((flags & VOS_CLONE_VM) && child_stack == 0) {
+        return -EINVAL;
+    }
+    if (child_stack != 0 && (child_stack < USER_BASE || child_stack > USER_LIMIT)) {
+        return -EINVAL;
+    }
+
+    int32_t rc = -ENOMEM;
+    task_mm_t* mm = NULL;
+    sighand_t* sighand = NULL;
+    task_t* child = NULL;
+    uint32_t stack_top_addr = 0;
+
     uint32_t irq_flags = irq_save();
 
-    uint32_t* child_dir = fork_clone_user_directory(current_task);
-    if (!child_dir) {
-        irq_restore(irq_flags);
-        return -ENOMEM;
+    if (flags & VOS_CLONE_VM) {
+        mm = current_task->mm;
+        mm_get(mm);
+    } else {
+        uint32_t* child_dir = fork_clone_user_directory(current_task);
+        if (!child_dir) {
+            goto fail;
+        }
+        mm = mm_create(child_dir, current_task->mm->user_brk);
+        if (!mm) {
+            free_user_pages_in_directory(child_dir);
+            goto fail;
+        }
+        mm->user_brk_min = current_task->mm->user_brk_min;
+        mm->mmap_top = current_task->mm->mmap_top;
+        if (current_task->mm->vm_areas) {
+            mm->vm_areas = vm_clone_areas(current_task->mm->vm_areas);
+            if (!mm->vm_areas) {
+                goto fail;
+            }
+        }
     }
 
-    vm_area_t* vm_clone = NULL;
-    if (current_task->vm_areas) {
-        vm_clone = vm_clone_areas(current_task->vm_areas);
-        if (!vm_clone) {
-            free_user_pages_in_directory(child_dir);
-            irq_restore(irq_flags);
-            return -ENOMEM;
+    if (flags & VOS_CLONE_SIGHAND) {
+        sighand = current_task->sighand;
+        sighand->refs++;
+    } else {
+        sighand = sighand_create(current_task->sighand);
+        if (!sighand) {
+            goto fail;
         }
     }
 
-    uint32_t stack_top_addr = 0;
     if (!kstack_alloc(&stack_top_addr)) {
-        task_free_vm_areas(vm_clone);
-        free_user_pages_in_directory(child_dir);
-        irq_restore(irq_flags);
-        return -ENOMEM;
+        stack_top_addr = 0;
+        goto fail;
+    }
+
+    child = (task_t*)kmalloc(sizeof(task_t));
+    if (!child) {
+        goto fail;
+    }
+    memset(child, 0, sizeof(*child));
+
+    if (flags & VOS_CLONE_FILES) {
+        child->files = current_task->files;
+        child->files->refs++;
+    } else if (!fd_clone(child, current_task)) {
+        goto fail;
     }
 
     // Copy the current user context into the child, adjusting EAX so the
-    // fork() return value is 0 in the child.
+    // clone()/fork() return value is 0 in the child.
     uint32_t frame_bytes = (uint32_t)sizeof(interrupt_frame_t) + 8u; // user esp + ss
     uint32_t child_sp_addr = stack_top_addr - frame_bytes;
     memcpy((void*)child_sp_addr, frame, frame_bytes);
     interrupt_frame_t* child_frame = (interrupt_frame_t*)child_sp_addr;
     child_frame->eax = 0;
-
-    task_t* child = (task_t*)kmalloc(sizeof(task_t));
-    if (!child) {
-        task_t tmp;
-        memset(&tmp, 0, sizeof(tmp));
-        tmp.kstack_top = stack_top_addr;
-        task_free_kstack(&tmp);
-        task_free_vm_areas(vm_clone);
-        free_user_pages_in_directory(child_dir);
-        irq_restore(irq_flags);
-        return -ENOMEM;
+    if (child_stack != 0) {
+        frame_set_user_esp(child_frame, child_stack);
     }
 
-    memset(child, 0, sizeof(*child));
+    bool thread = (flags & VOS_CLONE_THREAD) != 0;
+
     child->id = ++next_id;
-    child->ppid = current_task->id;
+    child->tgid = thread ? current_task->tgid : child->id;
+    child->ppid = thread ? current_task->ppid : current_task->tgid;
     child->pgid = current_task->pgid;
     child->esp = child_sp_addr;
     child->kstack_top = stack_top_addr;
-    child->page_directory = child_dir;
+    child->page_directory = mm->page_directory;
     child->user = true;
     child->uid = current_task->uid;
     child->gid = current_task->gid;
-    child->user_brk = current_task->user_brk;
-    child->user_brk_min = current_task->user_brk_min;
-    child->vm_areas = vm_clone;
-    child->mmap_top = current_task->mmap_top;
-    strncpy(child->cwd, current_task->cwd, sizeof(child->cwd) - 1u);
-    child->cwd[sizeof(child->cwd) - 1u] = '\0';
+    child->mm = mm;
+    child->tls_base = current_task->tls_base;
+    if (flags & VOS_CLONE_SETTLS) {
+        child->tls_base = tls;
+        child_frame->gs = GDT_TLS_SELECTOR;
+    }
+    child->clear_tid_user = (flags & VOS_CLONE_CHILD_CLEARTID) ? child_tid_user : NULL;
+    cwd_set(child, current_task->cwd);
     child->tty = current_task->tty;
-    child->tty_line_len = 0;
-    child->tty_line_off = 0;
-    child->tty_line_ready = false;
     child->sig_pending = 0;
     child->sig_mask = current_task->sig_mask;
-    memcpy(child->sig_handlers, current_task->sig_handlers, sizeof(child->sig_handlers));
+    child->sighand = sighand;
     child->state = TASK_STATE_RUNNABLE;
+    child->start_tick = timer_get_ticks();
+    child->state_since = child->start_tick;
     child->wake_tick = 0;
     child->wait_pid = 0;
     child->wait_status_user = NULL;
@@ -2798,18 +3882,72 @@ int32_t tasking_fork(interrupt_frame_t* frame) {
     child->exit_code = 0;
     child->waited = false;
     child->kill_pending = false;
+    child->kill_alone = false;
     child->kill_exit_code = 0;
-    child->alarm_tick = current_task->alarm_tick;
+    child->alarm_tick = thread ? 0u : current_task->alarm_tick;
     child->cpu_ticks = 0;
     child->console = current_task->console;
+    if (current_task->fpu) {
+        child->fpu = (fpu_state_t*)kmalloc(sizeof(fpu_state_t));
+        if (!child->fpu) {
+            goto fail;
+        }
+        if (fpu_owner == current_task) {
+            fpu_save(current_task->fpu);
+        }
+        memcpy(child->fpu, current_task->fpu, sizeof(*child->fpu));
+    }
     task_set_name(child, current_task->name);
-    fd_clone(child, current_task);
     child->next = NULL;
 
+    if ((flags & VOS_CLONE_PARENT_SETTID) && parent_tid_user) {
+        if (!copy_to_user(parent_tid_user, &child->id, (uint32_t)sizeof(child->id))) {
+            rc = -EFAULT;
+            goto fail;
+        }
+    }
+
     task_append(child);
     int32_t pid = (int32_t)child->id;
     irq_restore(irq_flags);
     return pid;
+
+fail:
+    if (child) {
+        cwd_put(child->cwd);
+        task_close_fds(child);
+        kfree(child->fpu);
+        kfree(child);
+    }
+    if (stack_top_addr) {
+        task_t tmp;
+        memset(&tmp, 0, sizeof(tmp));
+        tmp.kstack_top = stack_top_addr;
+        task_free_kstack(&tmp);
+    }
+    sighand_put(sighand);
+    mm_put(mm);
+    irq_restore(irq_flags);
+    return rc;
+}
+
+int32_t tasking_fork(interrupt_frame_t* frame) {
+    return tasking_clone(frame, 0, 0, NULL, 0, NULL);
+}
+
+int32_t tasking_set_tls(interrupt_frame_t* frame, uint32_t base) {
+    if (!enabled || !current_task || !frame || !current_task->user) {
+        return -EINVAL;
+    }
+
+    uint32_t irq_flags = irq_save();
+    current_task->tls_base = base;
+    gdt_set_tls_base(base);
+    irq_restore(irq_flags);
+
+    // The syscall return path pops gs, which reloads the segment base.
+    frame->gs = GDT_TLS_SELECTOR;
+    return (int32_t)GDT_TLS_SELECTOR;
 }
 
 static void task_close_cloexec_fds(void) {
@@ -2818,7 +3956,7 @@ static void task_close_cloexec_fds(void) {
     }
 
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        uint32_t flags = current_task->fds[fd].fd_flags;
+        uint32_t flags = current_task->files->fds[fd].fd_flags;
         if ((flags & VOS_FD_CLOEXEC) != 0) {
             (void)tasking_fd_close(fd);
         }
@@ -2833,6 +3971,10 @@ int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* c
     if (!current_task->user || !frame_from_user(frame)) {
         return -EPERM;
     }
+    // Only the main thread may exec; it takes the rest of the group down.
+    if (task_is_thread(current_task)) {
+        return -EINVAL;
+    }
     if (!path) {
         return -EINVAL;
     }
@@ -2841,7 +3983,7 @@ int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* c
     }
 
     vfs_handle_t* h = NULL;
-    int32_t rc = vfs_open_path(current_task->cwd, path, 0, &h);
+    int32_t rc = vfs_open_path(task_cwd(current_task), path, 0, &h);
     if (rc < 0) {
         return rc;
     }
@@ -2889,7 +4031,7 @@ int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* c
     }
 
     char abs[VFS_PATH_MAX];
-    rc = vfs_path_resolve(current_task->cwd, path, abs);
+    rc = vfs_path_resolve(task_cwd(current_task), path, abs);
     if (rc < 0) {
         kfree(image);
         return rc;
@@ -2930,25 +4072,54 @@ int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* c
         return -ENOEXEC;
     }
 
+    task_mm_t* new_mm = mm_create(user_dir, brk);
+    bool shared_sighand = current_task->sighand->refs > 1;
+    sighand_t* new_sighand = shared_sighand ? sighand_create(NULL) : NULL;
+    if (!new_mm || (shared_sighand && !new_sighand)) {
+        paging_switch_directory(prev_dir);
+        if (new_mm) {
+            kfree(new_mm);
+        }
+        if (new_sighand) {
+            kfree(new_sighand);
+        }
+        free_user_pages_in_directory(user_dir);
+        return -ENOMEM;
+    }
+
     // Success - stay in user_dir (we're already switched to it) and update
     // current_task->page_directory atomically with the switch we already made.
 
+    // Any other threads die with the old image.
+    task_kill_group_siblings(current_task, 0);
+
     // Close file descriptors flagged close-on-exec.
     task_close_cloexec_fds();
 
     // Tear down the previous user image.
-    uint32_t* old_dir = current_task->page_directory;
-    vm_area_t* old_areas = current_task->vm_areas;
-    current_task->vm_areas = NULL;
+    task_mm_t* old_mm = current_task->mm;
 
+    current_task->mm = new_mm;
     current_task->page_directory = user_dir;
-    current_task->user_brk = brk;
-    current_task->user_brk_min = brk;
-    current_task->mmap_top = USER_STACK_TOP - (USER_STACK_PAGES + 1u) * PAGE_SIZE;
+    current_task->tls_base = 0;
+    current_task->clear_tid_user = NULL;
     current_task->sig_pending = 0;
+    // The new image starts with a clean FPU on its first use.
+    if (fpu_owner == current_task) {
+        fpu_owner = NULL;
+        fpu_set_ts();
+    }
+    kfree(current_task->fpu);
+    current_task->fpu = NULL;
     // Reset signal handlers to default on execve (POSIX requirement)
-    memset(current_task->sig_handlers, 0, sizeof(current_task->sig_handlers));
+    if (shared_sighand) {
+        sighand_put(current_task->sighand);
+        current_task->sighand = new_sighand;
+    } else {
+        memset(current_task->sighand->handlers, 0, sizeof(current_task->sighand->handlers));
+    }
     current_task->kill_pending = false;
+    current_task->kill_alone = false;
     current_task->kill_exit_code = 0;
     current_task->wait_pid = 0;
     current_task->wait_status_user = NULL;
@@ -2958,11 +4129,12 @@ int32_t tasking_execve(interrupt_frame_t* frame, const char* path, const char* c
     // (We're already in user_dir from the ELF loading above.)
     frame->eax = 0;
     frame->eip = entry;
+    frame->gs = 0x23u;
     frame_set_user_esp(frame, user_esp);
 
-    // Free user pages from the old address space and any mmap metadata.
-    free_user_pages_in_directory(old_dir);
-    task_free_vm_areas(old_areas);
+    // Free user pages from the old address space (unless surviving threads
+    // still hold it) and any mmap metadata.
+    mm_put(old_mm);
 
     return 0;
 }
@@ -2977,7 +4149,7 @@ int32_t tasking_spawn_exec(const char* path, const char* const* argv, uint32_t a
 
     // Open the file via the mount-aware VFS so /disk works too.
     vfs_handle_t* h = NULL;
-    int32_t rc = vfs_open_path(current_task->cwd, path, 0, &h);
+    int32_t rc = vfs_open_path(task_cwd(current_task), path, 0, &h);
     if (rc < 0) {
         return rc;
     }
@@ -3025,7 +4197,7 @@ int32_t tasking_spawn_exec(const char* path, const char* const* argv, uint32_t a
     }
 
     char abs[VFS_PATH_MAX];
-    rc = vfs_path_resolve(current_task->cwd, path, abs);
+    rc = vfs_path_resolve(task_cwd(current_task), path, abs);
     if (rc < 0) {
         kfree(image);
         return rc;
@@ -3061,7 +4233,7 @@ int32_t tasking_spawn_exec(const char* path, const char* const* argv, uint32_t a
     kfree(image);
 
     if (!ok) {
-        // Note: user_dir allocated via early_alloc cannot be freed.
+        // Note: user_dir from paging_alloc_table() is not freed.
         // This is a known limitation - page directories are never reclaimed.
         free_user_pages_in_directory(user_dir);  // At least free the user pages
         return -ENOEXEC;
@@ -3074,6 +4246,29 @@ int32_t tasking_spawn_exec(const char* path, const char* const* argv, uint32_t a
     return (int32_t)pid;
 }
 
+// Put an open VFS handle in the lowest free slot; closes it on EMFILE.
+static int32_t fd_install_vfs(vfs_handle_t* h, uint32_t flags) {
+    uint32_t irq_flags = irq_save();
+    for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
+        if (current_task->files->fds[fd].kind == FD_KIND_FREE) {
+            current_task->files->fds[fd].kind = FD_KIND_VFS;
+            current_task->files->fds[fd].fd_flags = 0;
+            current_task->files->fds[fd].fl_flags = flags;
+            current_task->files->fds[fd].handle = h;
+            current_task->files->fds[fd].pipe = NULL;
+            current_task->files->fds[fd].pipe_write_end = false;
+            current_task->files->fds[fd].pending_len = 0;
+            current_task->files->fds[fd].pending_off = 0;
+            irq_restore(irq_flags);
+            return fd;
+        }
+    }
+    irq_restore(irq_flags);
+
+    (void)vfs_close(h);
+    return -EMFILE;
+}
+
 int32_t tasking_fd_open(const char* path, uint32_t flags) {
     if (!current_task || !path) {
         return -EINVAL;
@@ -3092,15 +4287,15 @@ int32_t tasking_fd_open(const char* path, uint32_t flags) {
     if (dev_kind != FD_KIND_FREE) {
         uint32_t irq_flags = irq_save();
         for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-            if (current_task->fds[fd].kind == FD_KIND_FREE) {
-                current_task->fds[fd].kind = dev_kind;
-                current_task->fds[fd].fd_flags = 0;
-                current_task->fds[fd].fl_flags = flags;
-                current_task->fds[fd].handle = NULL;
-                current_task->fds[fd].pipe = NULL;
-                current_task->fds[fd].pipe_write_end = false;
-                current_task->fds[fd].pending_len = 0;
-                current_task->fds[fd].pending_off = 0;
+            if (current_task->files->fds[fd].kind == FD_KIND_FREE) {
+                current_task->files->fds[fd].kind = dev_kind;
+                current_task->files->fds[fd].fd_flags = 0;
+                current_task->files->fds[fd].fl_flags = flags;
+                current_task->files->fds[fd].handle = NULL;
+                current_task->files->fds[fd].pipe = NULL;
+                current_task->files->fds[fd].pipe_write_end = false;
+                current_task->files->fds[fd].pending_len = 0;
+                current_task->files->fds[fd].pending_off = 0;
                 irq_restore(irq_flags);
                 return fd;
             }
@@ -3108,32 +4303,141 @@ int32_t tasking_fd_open(const char* path, uint32_t flags) {
         irq_restore(irq_flags);
         return -EMFILE;
     }
-
-    vfs_handle_t* h = NULL;
-    int32_t rc = vfs_open_path(current_task->cwd, path, flags, &h);
+
+    vfs_handle_t* h = NULL;
+    int32_t rc = vfs_open_path(task_cwd(current_task), path, flags, &h);
+    if (rc < 0) {
+        return rc;
+    }
+    return fd_install_vfs(h, flags);
+}
+
+// Start directory of an *at() call. Returns NULL with *out_rc = 0 when the
+// lookup is relative to the cwd; otherwise a referenced directory handle
+// the caller releases with vfs_close().
+static vfs_handle_t* at_dir_get(int32_t dirfd, const char* path, int32_t* out_rc) {
+    *out_rc = 0;
+    if (dirfd == VOS_AT_FDCWD || (path && path[0] == '/')) {
+        return NULL;
+    }
+    if (dirfd < 0 || dirfd >= (int32_t)TASK_MAX_FDS) {
+        *out_rc = -EBADF;
+        return NULL;
+    }
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[dirfd];
+    vfs_handle_t* h = (ent->kind == FD_KIND_VFS) ? ent->handle : NULL;
+    fd_kind_t kind = ent->kind;
+    if (h) {
+        vfs_ref(h);
+    }
+    irq_restore(irq_flags);
+    if (!h) {
+        *out_rc = (kind == FD_KIND_FREE) ? -EBADF : -ENOTDIR;
+    }
+    return h;
+}
+
+int32_t tasking_fd_openat(int32_t dirfd, const char* path, uint32_t flags) {
+    if (!current_task || !path) {
+        return -EINVAL;
+    }
+    int32_t rc;
+    vfs_handle_t* dir = at_dir_get(dirfd, path, &rc);
+    if (!dir) {
+        // Relative to the cwd or absolute: same as open(), /dev nodes included.
+        return (rc < 0) ? rc : tasking_fd_open(path, flags);
+    }
+
+    vfs_handle_t* h = NULL;
+    rc = vfs_open_at(task_cwd(current_task), dir, path, flags, &h);
+    (void)vfs_close(dir);
+    if (rc < 0) {
+        return rc;
+    }
+    return fd_install_vfs(h, flags);
+}
+
+int32_t tasking_fstatat(int32_t dirfd, const char* path, void* st_user, uint32_t flags) {
+    if (!current_task || !path || !st_user) {
+        return -EINVAL;
+    }
+    int32_t rc;
+    vfs_handle_t* dir = at_dir_get(dirfd, path, &rc);
+    if (rc < 0) {
+        return rc;
+    }
+
+    vfs_stat_t st;
+    bool follow = (flags & VOS_AT_SYMLINK_NOFOLLOW) == 0;
+    rc = vfs_stat_at(task_cwd(current_task), dir, path, follow, &st);
+    if (dir) {
+        (void)vfs_close(dir);
+    }
+    if (rc < 0) {
+        return rc;
+    }
+    if (!copy_to_user(st_user, &st, (uint32_t)sizeof(st))) {
+        return -EFAULT;
+    }
+    return 0;
+}
+
+int32_t tasking_mkdirat(int32_t dirfd, const char* path) {
+    if (!current_task || !path) {
+        return -EINVAL;
+    }
+    int32_t rc;
+    vfs_handle_t* dir = at_dir_get(dirfd, path, &rc);
     if (rc < 0) {
         return rc;
     }
+    rc = vfs_mkdir_at(task_cwd(current_task), dir, path);
+    if (dir) {
+        (void)vfs_close(dir);
+    }
+    return rc;
+}
 
-    uint32_t irq_flags = irq_save();
-    for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        if (current_task->fds[fd].kind == FD_KIND_FREE) {
-            current_task->fds[fd].kind = FD_KIND_VFS;
-            current_task->fds[fd].fd_flags = 0;
-            current_task->fds[fd].fl_flags = flags;
-            current_task->fds[fd].handle = h;
-            current_task->fds[fd].pipe = NULL;
-            current_task->fds[fd].pipe_write_end = false;
-            current_task->fds[fd].pending_len = 0;
-            current_task->fds[fd].pending_off = 0;
-            irq_restore(irq_flags);
-            return fd;
-        }
+int32_t tasking_unlinkat(int32_t dirfd, const char* path, uint32_t flags) {
+    if (!current_task || !path) {
+        return -EINVAL;
     }
-    irq_restore(irq_flags);
+    if ((flags & ~VOS_AT_REMOVEDIR) != 0) {
+        return -EINVAL;
+    }
+    int32_t rc;
+    vfs_handle_t* dir = at_dir_get(dirfd, path, &rc);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = vfs_unlink_at(task_cwd(current_task), dir, path, (flags & VOS_AT_REMOVEDIR) != 0);
+    if (dir) {
+        (void)vfs_close(dir);
+    }
+    return rc;
+}
 
-    (void)vfs_close(h);
-    return -EMFILE;
+int32_t tasking_renameat(int32_t old_dirfd, const char* old_path, int32_t new_dirfd, const char* new_path) {
+    if (!current_task || !old_path || !new_path) {
+        return -EINVAL;
+    }
+    int32_t rc;
+    vfs_handle_t* old_dir = at_dir_get(old_dirfd, old_path, &rc);
+    if (rc < 0) {
+        return rc;
+    }
+    vfs_handle_t* new_dir = at_dir_get(new_dirfd, new_path, &rc);
+    if (rc == 0) {
+        rc = vfs_rename_at(task_cwd(current_task), old_dir, old_path, new_dir, new_path);
+    }
+    if (old_dir) {
+        (void)vfs_close(old_dir);
+    }
+    if (new_dir) {
+        (void)vfs_close(new_dir);
+    }
+    return rc;
 }
 
 int32_t tasking_fd_close(int32_t fd) {
@@ -3145,7 +4449,7 @@ int32_t tasking_fd_close(int32_t fd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     if (ent->kind == FD_KIND_FREE) {
         irq_restore(irq_flags);
         return -EBADF;
@@ -3154,6 +4458,7 @@ int32_t tasking_fd_close(int32_t fd) {
     vfs_handle_t* h = NULL;
     pipe_obj_t* p = NULL;
     bool pipe_we = false;
+    epoll_t* ep = ent->epoll;
 
     if (ent->kind == FD_KIND_VFS) {
         h = ent->handle;
@@ -3168,10 +4473,12 @@ int32_t tasking_fd_close(int32_t fd) {
     ent->handle = NULL;
     ent->pipe = NULL;
     ent->pipe_write_end = false;
+    ent->epoll = NULL;
     ent->pending_len = 0;
     ent->pending_off = 0;
     irq_restore(irq_flags);
 
+    epoll_put(ep);
     if (h) {
         return vfs_close(h);
     }
@@ -3317,14 +4624,15 @@ static int32_t tty_deliver_canon_line(void* dst_user, uint32_t len) {
         return 0;
     }
 
-    if (!current_task->tty_line_ready || current_task->tty_line_off >= current_task->tty_line_len) {
-        current_task->tty_line_ready = false;
-        current_task->tty_line_len = 0;
-        current_task->tty_line_off = 0;
+    tty_ldisc_t* ld = tty_ldisc_current();
+    if (!ld->ready || ld->off >= ld->len) {
+        ld->ready = false;
+        ld->len = 0;
+        ld->off = 0;
         return 0;
     }
 
-    uint32_t avail = (uint32_t)(current_task->tty_line_len - current_task->tty_line_off);
+    uint32_t avail = (uint32_t)(ld->len - ld->off);
     uint32_t to_copy = len;
     if (to_copy > avail) {
         to_copy = avail;
@@ -3333,15 +4641,15 @@ static int32_t tty_deliver_canon_line(void* dst_user, uint32_t len) {
         return 0;
     }
 
-    if (!copy_to_user(dst_user, current_task->tty_line + current_task->tty_line_off, to_copy)) {
+    if (!copy_to_user(dst_user, ld->line + ld->off, to_copy)) {
         return -EFAULT;
     }
 
-    current_task->tty_line_off = (uint16_t)(current_task->tty_line_off + to_copy);
-    if (current_task->tty_line_off >= current_task->tty_line_len) {
-        current_task->tty_line_ready = false;
-        current_task->tty_line_len = 0;
-        current_task->tty_line_off = 0;
+    ld->off = (uint16_t)(ld->off + to_copy);
+    if (ld->off >= ld->len) {
+        ld->ready = false;
+        ld->len = 0;
+        ld->off = 0;
     }
 
     return (int32_t)to_copy;
@@ -3356,9 +4664,10 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
     }
 
     bool echo = (current_task->tty.c_lflag & VOS_ECHO) != 0;
+    tty_ldisc_t* ld = tty_ldisc_current();
 
     // If a line is already buffered, deliver it.
-    if (current_task->tty_line_ready) {
+    if (ld->ready) {
         return tty_deliver_canon_line(dst_user, len);
     }
 
@@ -3367,9 +4676,9 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
     }
 
     // Start a fresh line.
-    current_task->tty_line_len = 0;
-    current_task->tty_line_off = 0;
-    current_task->tty_line_ready = false;
+    ld->len = 0;
+    ld->off = 0;
+    ld->ready = false;
 
     for (;;) {
         if (tasking_current_should_interrupt()) {
@@ -3393,10 +4702,10 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
 
         if ((uint8_t)key == cc_eof) {
             // EOF: return 0 if no buffered bytes, otherwise return the line so far.
-            if (current_task->tty_line_len == 0) {
+            if (ld->len == 0) {
                 return 0;
             }
-            current_task->tty_line_ready = true;
+            ld->ready = true;
             break;
         }
 
@@ -3404,16 +4713,16 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
             if (echo) {
                 tty_echo_key('\n');
             }
-            if (current_task->tty_line_len < (uint16_t)VOS_TTY_LINE_MAX) {
-                current_task->tty_line[current_task->tty_line_len++] = (uint8_t)'\n';
+            if (ld->len < (uint16_t)VOS_TTY_LINE_MAX) {
+                ld->line[ld->len++] = (uint8_t)'\n';
             }
-            current_task->tty_line_ready = true;
+            ld->ready = true;
             break;
         }
 
         if (key == '\b' || (uint8_t)key == cc_erase) {
-            if (current_task->tty_line_len != 0) {
-                current_task->tty_line_len--;
+            if (ld->len != 0) {
+                ld->len--;
                 if (echo) {
                     tty_echo_key('\b');
                 }
@@ -3427,7 +4736,7 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
             continue;
         }
 
-        uint32_t space = (uint32_t)VOS_TTY_LINE_MAX - (uint32_t)current_task->tty_line_len;
+        uint32_t space = (uint32_t)VOS_TTY_LINE_MAX - (uint32_t)ld->len;
         if (space == 0) {
             continue;
         }
@@ -3436,7 +4745,7 @@ static int32_t tty_read_canonical(void* dst_user, uint32_t len, bool nonblock) {
         }
 
         for (uint32_t i = 0; i < seq_len; i++) {
-            current_task->tty_line[current_task->tty_line_len++] = seq[i];
+            ld->line[ld->len++] = seq[i];
         }
 
         if (echo) {
@@ -3506,7 +4815,46 @@ static bool tty_wait_getchar_timeout(uint32_t timeout_ticks, char* out) {
     }
 }
 
-int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len) {
+// Transfer between user memory and a VFS handle through a bounce buffer.
+// A negative `off` uses (and advances) the handle's file position.
+static int32_t fd_vfs_io(vfs_handle_t* h, void* user, uint32_t len, int32_t off, bool write) {
+    uint32_t total = 0;
+    uint8_t tmp[256];
+    while (total < len) {
+        uint32_t chunk = len - total;
+        if (chunk > (uint32_t)sizeof(tmp)) {
+            chunk = (uint32_t)sizeof(tmp);
+        }
+        uint8_t* u = (uint8_t*)user + total;
+        uint32_t done = 0;
+        int32_t rc;
+        if (write) {
+            if (!copy_from_user(tmp, u, chunk)) {
+                return (total != 0) ? (int32_t)total : -EFAULT;
+            }
+            rc = (off < 0) ? vfs_write(h, tmp, chunk, &done)
+                           : vfs_pwrite(h, tmp, chunk, (uint32_t)off + total, &done);
+        } else {
+            rc = (off < 0) ? vfs_read(h, tmp, chunk, &done)
+                           : vfs_pread(h, tmp, chunk, (uint32_t)off + total, &done);
+            if (rc == 0 && done != 0 && !copy_to_user(u, tmp, done)) {
+                return (total != 0) ? (int32_t)total : -EFAULT;
+            }
+        }
+        if (rc < 0) {
+            return (total != 0) ? (int32_t)total : rc;
+        }
+        total += done;
+        if (done != chunk) {
+            break;
+        }
+    }
+    return (int32_t)total;
+}
+
+// `fl_extra` is OR-ed into the descriptor's status flags for this call
+// (readv passes O_NONBLOCK once it has data).
+static int32_t fd_read(int32_t fd, void* dst_user, uint32_t len, uint32_t fl_extra) {
     if (!current_task || !dst_user) {
         return -EFAULT;
     }
@@ -3518,11 +4866,11 @@ int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
 
     // FD_KIND_TTY reads behave like stdin
     if (ent->kind == FD_KIND_STDIN || ent->kind == FD_KIND_TTY) {
-        uint32_t fl_flags = ent->fl_flags;
+        uint32_t fl_flags = ent->fl_flags | fl_extra;
         irq_restore(irq_flags);
 
         bool nonblock = (fl_flags & VOS_O_NONBLOCK) != 0;
@@ -3668,7 +5016,7 @@ int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len) {
 
     if (ent->kind == FD_KIND_PIPE && ent->pipe) {
         pipe_obj_t* p = ent->pipe;
-        uint32_t fl_flags = ent->fl_flags;
+        uint32_t fl_flags = ent->fl_flags | fl_extra;
         irq_restore(irq_flags);
 
         uint32_t total = 0;
@@ -3740,141 +5088,476 @@ int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len) {
         irq_restore(irq_flags);
         return -EBADF;
     }
+    vfs_handle_t* h = ent->handle;
+    irq_restore(irq_flags);
+    return fd_vfs_io(h, dst_user, len, -1, false);
+}
+
+int32_t tasking_fd_read(int32_t fd, void* dst_user, uint32_t len) {
+    return fd_read(fd, dst_user, len, 0);
+}
+
+int32_t tasking_fd_write(int32_t fd, const void* src_user, uint32_t len) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (!src_user) {
+        return -EFAULT;
+    }
+
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    fd_kind_t kind = ent->kind;
+    vfs_handle_t* h = ent->handle;
+    uint32_t fl_flags = ent->fl_flags;
     irq_restore(irq_flags);
 
     uint32_t total = 0;
+    uint8_t tmp[128];
+
+    // FD_KIND_TTY writes behave like stdout
+    if (kind == FD_KIND_STDOUT || kind == FD_KIND_STDERR || kind == FD_KIND_TTY) {
+        // Only output if this task's console matches the active console
+        bool output_visible = (current_task->console == (uint8_t)screen_console_active());
+        while (total < len) {
+            uint32_t chunk = len - total;
+            if (chunk > (uint32_t)sizeof(tmp)) {
+                chunk = (uint32_t)sizeof(tmp);
+            }
+            if (!copy_from_user(tmp, (const uint8_t*)src_user + total, chunk)) {
+                return (total != 0) ? (int32_t)total : -EFAULT;
+            }
+            if (output_visible) {
+                for (uint32_t i = 0; i < chunk; i++) {
+                    screen_putchar((char)tmp[i]);
+                }
+            }
+            total += chunk;
+        }
+        return (int32_t)total;
+    }
+
+    // /dev/null and /dev/zero accept all writes (discard data)
+    if (kind == FD_KIND_NULL || kind == FD_KIND_ZERO) {
+        return (int32_t)len;  // Pretend we wrote everything
+    }
+
+    if (kind == FD_KIND_PIPE && ent->pipe) {
+        pipe_obj_t* p = ent->pipe;
+        uint8_t tmp[128];
+
+        while (total < len) {
+            if (tasking_current_should_interrupt()) {
+                return (total != 0) ? (int32_t)total : -EINTR;
+            }
+            uint32_t chunk = len - total;
+            if (chunk > (uint32_t)sizeof(tmp)) {
+                chunk = (uint32_t)sizeof(tmp);
+            }
+            if (!copy_from_user(tmp, (const uint8_t*)src_user + total, chunk)) {
+                return (total != 0) ? (int32_t)total : -EFAULT;
+            }
+
+            uint32_t wrote = 0;
+            int32_t rc = pipe_write_some(p, tmp, chunk, &wrote);
+            if (rc < 0) {
+                return (total != 0) ? (int32_t)total : rc;
+            }
+            if (wrote != 0) {
+                total += wrote;
+                continue;
+            }
+
+            // Full: block unless we already wrote something.
+            if (total != 0) {
+                break;
+            }
+            if ((fl_flags & VOS_O_NONBLOCK) != 0) {
+                return -EAGAIN;
+            }
+            wait_for_event();
+        }
+
+        return (int32_t)total;
+    }
+
+    if (kind != FD_KIND_VFS || !h) {
+        return -EBADF;
+    }
+    return fd_vfs_io(h, (void*)src_user, len, -1, true);
+}
+
+// pread/pwrite: only regular files have a position to bypass.
+static int32_t fd_positional(int32_t fd, void* user, uint32_t len, int32_t off, bool write) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+    if (off < 0) {
+        return -EINVAL;
+    }
+
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    fd_kind_t kind = ent->kind;
+    vfs_handle_t* h = ent->handle;
+    irq_restore(irq_flags);
+
+    if (kind == FD_KIND_FREE) {
+        return -EBADF;
+    }
+    if (kind != FD_KIND_VFS || !h) {
+        return -ESPIPE;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (!user) {
+        return -EFAULT;
+    }
+    return fd_vfs_io(h, user, len, off, write);
+}
+
+int32_t tasking_fd_pread(int32_t fd, void* dst_user, uint32_t len, int32_t off) {
+    return fd_positional(fd, dst_user, len, off, false);
+}
+
+int32_t tasking_fd_pwrite(int32_t fd, const void* src_user, uint32_t len, int32_t off) {
+    return fd_positional(fd, (void*)src_user, len, off, true);
+}
+
+// One side of a kernel-side transfer (sendfile/splice), snapshotted from
+// the fd table.
+typedef struct fd_xfer_end {
+    fd_kind_t kind;
+    vfs_handle_t* h;
+    pipe_obj_t* pipe;
+    uint32_t fl_flags;
+} fd_xfer_end_t;
+
+static int32_t fd_xfer_end_get(int32_t fd, bool write, fd_xfer_end_t* out) {
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    out->kind = ent->kind;
+    out->h = ent->handle;
+    out->pipe = ent->pipe;
+    out->fl_flags = ent->fl_flags;
+    bool write_end = ent->pipe_write_end;
+    irq_restore(irq_flags);
+
+    switch (out->kind) {
+        case FD_KIND_FREE:
+            return -EBADF;
+        case FD_KIND_VFS:
+            return out->h ? 0 : -EBADF;
+        case FD_KIND_PIPE:
+            return (out->pipe && write_end == write) ? 0 : -EBADF;
+        case FD_KIND_STDOUT:
+        case FD_KIND_STDERR:
+        case FD_KIND_TTY:
+        case FD_KIND_NULL:
+            // Terminal input is not a byte source we can splice from.
+            return write ? 0 : -EINVAL;
+        default:
+            return -EINVAL;
+    }
+}
+
+static int32_t fd_xfer_put(const fd_xfer_end_t* out, const uint8_t* data, uint32_t n, int32_t* off) {
+    uint32_t wrote = 0;
+    int32_t rc = 0;
+    switch (out->kind) {
+        case FD_KIND_VFS:
+            if (off) {
+                rc = vfs_pwrite(out->h, data, n, (uint32_t)*off, &wrote);
+                *off += (int32_t)wrote;
+            } else {
+                rc = vfs_write(out->h, data, n, &wrote);
+            }
+            return (rc < 0) ? rc : (int32_t)wrote;
+        case FD_KIND_PIPE:
+            rc = pipe_write_some(out->pipe, data, n, &wrote);
+            return (rc < 0) ? rc : (int32_t)wrote;
+        case FD_KIND_STDOUT:
+        case FD_KIND_STDERR:
+        case FD_KIND_TTY:
+            if (current_task->console == (uint8_t)screen_console_active()) {
+                for (uint32_t i = 0; i < n; i++) {
+                    screen_putchar((char)data[i]);
+                }
+            }
+            return (int32_t)n;
+        default:
+            return (int32_t)n;  // /dev/null
+    }
+}
+
+// Move up to `len` bytes from `in` to `out` without going through user
+// memory. File data is handed to the destination straight from the VFS
+// handle's buffer (a page-cache page stays pinned while the destination
+// writes, which may evict pages); pipe data goes through one small kernel
+// buffer. A non-NULL offset is used (and updated) instead of the file
+// position.
+static int32_t fd_xfer(const fd_xfer_end_t* in, int32_t* in_off,
+                       const fd_xfer_end_t* out, int32_t* out_off, uint32_t len) {
+    if (in->kind == FD_KIND_VFS && out->kind == FD_KIND_VFS && in->h == out->h) {
+        return -EINVAL;
+    }
+    bool nonblock = ((in->fl_flags | out->fl_flags) & VOS_O_NONBLOCK) != 0;
     uint8_t tmp[256];
+    uint32_t total = 0;
+
     while (total < len) {
-        uint32_t chunk = len - total;
-        if (chunk > (uint32_t)sizeof(tmp)) {
-            chunk = (uint32_t)sizeof(tmp);
+        if (tasking_current_should_interrupt()) {
+            return (total != 0) ? (int32_t)total : -EINTR;
         }
+        uint32_t want = len - total;
 
-        uint32_t got = 0;
-        int32_t rc = vfs_read(ent->handle, tmp, chunk, &got);
-        if (rc < 0) {
-            return (total != 0) ? (int32_t)total : rc;
+        // Take no more from the source than a pipe destination has room
+        // for, so nothing read is ever dropped.
+        if (out->kind == FD_KIND_PIPE) {
+            uint32_t f = irq_save();
+            uint32_t readers = out->pipe->readers;
+            uint32_t space = PIPE_BUF_SIZE - out->pipe->used;
+            irq_restore(f);
+            if (readers == 0) {
+                return (total != 0) ? (int32_t)total : -EPIPE;
+            }
+            if (space == 0) {
+                if (total != 0) {
+                    break;
+                }
+                if (nonblock) {
+                    return -EAGAIN;
+                }
+                wait_for_event();
+                continue;
+            }
+            if (want > space) {
+                want = space;
+            }
+        }
+
+        const uint8_t* data = NULL;
+        uint32_t n = 0;
+        uint32_t pos = 0;
+        if (in->kind == FD_KIND_VFS) {
+            if (in_off) {
+                pos = (uint32_t)*in_off;
+            } else {
+                (void)vfs_lseek(in->h, 0, VOS_SEEK_CUR, &pos);
+            }
+            int32_t rc = vfs_peek(in->h, pos, &data, &n);
+            if (rc < 0) {
+                return (total != 0) ? (int32_t)total : rc;
+            }
+            if (n == 0) {
+                break;  // EOF
+            }
+        } else {
+            if (want > (uint32_t)sizeof(tmp)) {
+                want = (uint32_t)sizeof(tmp);
+            }
+            n = pipe_read_some(in->pipe, tmp, want);
+            if (n == 0) {
+                uint32_t f = irq_save();
+                uint32_t writers = in->pipe->writers;
+                irq_restore(f);
+                if (writers == 0 || total != 0) {
+                    break;
+                }
+                if (nonblock) {
+                    return -EAGAIN;
+                }
+                wait_for_event();
+                continue;
+            }
+            data = tmp;
+        }
+        if (n > want) {
+            n = want;
+        }
+
+        int32_t wrote = fd_xfer_put(out, data, n, out_off);
+        if (in->kind == FD_KIND_VFS) {
+            vfs_peek_done(in->h, pos);
         }
-        if (got == 0) {
-            break;
+        if (wrote < 0) {
+            return (total != 0) ? (int32_t)total : wrote;
+        }
+        if (in->kind == FD_KIND_VFS) {
+            if (in_off) {
+                *in_off += wrote;
+            } else {
+                (void)vfs_lseek(in->h, (int32_t)(pos + (uint32_t)wrote), VOS_SEEK_SET, NULL);
+            }
         }
-        if (!copy_to_user((uint8_t*)dst_user + total, tmp, got)) {
-            return (total != 0) ? (int32_t)total : -EFAULT;
+        total += (uint32_t)wrote;
+        if ((uint32_t)wrote < n) {
+            break;
         }
-        total += got;
     }
     return (int32_t)total;
 }
 
-int32_t tasking_fd_write(int32_t fd, const void* src_user, uint32_t len) {
+static bool xfer_off_get(const int32_t* off_user, int32_t* off) {
+    if (!copy_from_user(off, off_user, sizeof(*off))) {
+        return false;
+    }
+    return *off >= 0;
+}
+
+int32_t tasking_sendfile(int32_t out_fd, int32_t in_fd, int32_t* off_user, uint32_t count) {
     if (!current_task) {
         return -EINVAL;
     }
-    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
-        return -EBADF;
+    fd_xfer_end_t in;
+    fd_xfer_end_t out;
+    int32_t rc = fd_xfer_end_get(in_fd, false, &in);
+    if (rc < 0) {
+        return rc;
     }
-    if (len == 0) {
-        return 0;
+    rc = fd_xfer_end_get(out_fd, true, &out);
+    if (rc < 0) {
+        return rc;
     }
-    if (!src_user) {
-        return -EFAULT;
+    // Like Linux, the source has to be a file.
+    if (in.kind != FD_KIND_VFS) {
+        return -EINVAL;
     }
 
-    uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
-    fd_kind_t kind = ent->kind;
-    vfs_handle_t* h = ent->handle;
-    uint32_t fl_flags = ent->fl_flags;
-    irq_restore(irq_flags);
+    int32_t off = 0;
+    if (off_user && !xfer_off_get(off_user, &off)) {
+        return off < 0 ? -EINVAL : -EFAULT;
+    }
+    int32_t n = fd_xfer(&in, off_user ? &off : NULL, &out, NULL, count);
+    if (off_user && n > 0 && !copy_to_user(off_user, &off, sizeof(off))) {
+        return -EFAULT;
+    }
+    return n;
+}
 
-    uint32_t total = 0;
-    uint8_t tmp[128];
+int32_t tasking_splice(int32_t in_fd, int32_t* in_off_user, int32_t out_fd, int32_t* out_off_user,
+                       uint32_t len) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    fd_xfer_end_t in;
+    fd_xfer_end_t out;
+    int32_t rc = fd_xfer_end_get(in_fd, false, &in);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = fd_xfer_end_get(out_fd, true, &out);
+    if (rc < 0) {
+        return rc;
+    }
+    if (in.kind != FD_KIND_PIPE && out.kind != FD_KIND_PIPE) {
+        return -EINVAL;
+    }
+    if ((in_off_user && in.kind != FD_KIND_VFS) || (out_off_user && out.kind != FD_KIND_VFS)) {
+        return -ESPIPE;
+    }
 
-    // FD_KIND_TTY writes behave like stdout
-    if (kind == FD_KIND_STDOUT || kind == FD_KIND_STDERR || kind == FD_KIND_TTY) {
-        // Only output if this task's console matches the active console
-        bool output_visible = (current_task->console == (uint8_t)screen_console_active());
-        while (total < len) {
-            uint32_t chunk = len - total;
-            if (chunk > (uint32_t)sizeof(tmp)) {
-                chunk = (uint32_t)sizeof(tmp);
-            }
-            if (!copy_from_user(tmp, (const uint8_t*)src_user + total, chunk)) {
-                return (total != 0) ? (int32_t)total : -EFAULT;
-            }
-            if (output_visible) {
-                for (uint32_t i = 0; i < chunk; i++) {
-                    screen_putchar((char)tmp[i]);
-                }
-            }
-            total += chunk;
+    int32_t in_off = 0;
+    int32_t out_off = 0;
+    if (in_off_user && !xfer_off_get(in_off_user, &in_off)) {
+        return in_off < 0 ? -EINVAL : -EFAULT;
+    }
+    if (out_off_user && !xfer_off_get(out_off_user, &out_off)) {
+        return out_off < 0 ? -EINVAL : -EFAULT;
+    }
+    int32_t n = fd_xfer(&in, in_off_user ? &in_off : NULL, &out, out_off_user ? &out_off : NULL, len);
+    if (n > 0) {
+        if (in_off_user && !copy_to_user(in_off_user, &in_off, sizeof(in_off))) {
+            return -EFAULT;
+        }
+        if (out_off_user && !copy_to_user(out_off_user, &out_off, sizeof(out_off))) {
+            return -EFAULT;
         }
-        return (int32_t)total;
     }
+    return n;
+}
 
-    // /dev/null and /dev/zero accept all writes (discard data)
-    if (kind == FD_KIND_NULL || kind == FD_KIND_ZERO) {
-        return (int32_t)len;  // Pretend we wrote everything
+// Copy in an iovec array and check every segment once, before any data
+// moves, so a bad pointer fails the whole call instead of a partial one.
+static int32_t iov_fetch(vos_iovec_t* iov, const void* iov_user, int32_t iovcnt) {
+    if (iovcnt < 0 || iovcnt > (int32_t)VOS_IOV_MAX) {
+        return -EINVAL;
     }
+    if (iovcnt == 0) {
+        return 0;
+    }
+    if (!copy_from_user(iov, iov_user, (uint32_t)iovcnt * sizeof(iov[0]))) {
+        return -EFAULT;
+    }
+    uint32_t total = 0;
+    for (int32_t i = 0; i < iovcnt; i++) {
+        if (iov[i].len > 0x7FFFFFFFu - total) {
+            return -EINVAL;
+        }
+        total += iov[i].len;
+        if (iov[i].len != 0 && !access_ok((const void*)iov[i].base, iov[i].len)) {
+            return -EFAULT;
+        }
+    }
+    return 0;
+}
 
-    if (kind == FD_KIND_PIPE && ent->pipe) {
-        pipe_obj_t* p = ent->pipe;
-        uint8_t tmp[128];
-
-        while (total < len) {
-            if (tasking_current_should_interrupt()) {
-                return (total != 0) ? (int32_t)total : -EINTR;
-            }
-            uint32_t chunk = len - total;
-            if (chunk > (uint32_t)sizeof(tmp)) {
-                chunk = (uint32_t)sizeof(tmp);
-            }
-            if (!copy_from_user(tmp, (const uint8_t*)src_user + total, chunk)) {
-                return (total != 0) ? (int32_t)total : -EFAULT;
-            }
-
-            uint32_t wrote = 0;
-            int32_t rc = pipe_write_some(p, tmp, chunk, &wrote);
-            if (rc < 0) {
-                return (total != 0) ? (int32_t)total : rc;
-            }
-            if (wrote != 0) {
-                total += wrote;
-                continue;
-            }
+int32_t tasking_fd_readv(int32_t fd, const void* iov_user, int32_t iovcnt) {
+    vos_iovec_t iov[VOS_IOV_MAX];
+    int32_t rc = iov_fetch(iov, iov_user, iovcnt);
+    if (rc < 0) {
+        return rc;
+    }
 
-            // Full: block unless we already wrote something.
-            if (total != 0) {
-                break;
-            }
-            if ((fl_flags & VOS_O_NONBLOCK) != 0) {
-                return -EAGAIN;
-            }
-            wait_for_event();
+    uint32_t total = 0;
+    for (int32_t i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0) {
+            continue;
+        }
+        // Block for the first bytes only, like a single read() of the sum.
+        int32_t n = fd_read(fd, (void*)iov[i].base, iov[i].len, total != 0 ? VOS_O_NONBLOCK : 0);
+        if (n < 0) {
+            return (total != 0) ? (int32_t)total : n;
+        }
+        total += (uint32_t)n;
+        if ((uint32_t)n < iov[i].len) {
+            break;
         }
-
-        return (int32_t)total;
     }
+    return (int32_t)total;
+}
 
-    if (kind != FD_KIND_VFS || !h) {
-        return -EBADF;
+int32_t tasking_fd_writev(int32_t fd, const void* iov_user, int32_t iovcnt) {
+    vos_iovec_t iov[VOS_IOV_MAX];
+    int32_t rc = iov_fetch(iov, iov_user, iovcnt);
+    if (rc < 0) {
+        return rc;
     }
 
-    while (total < len) {
-        uint32_t chunk = len - total;
-        if (chunk > (uint32_t)sizeof(tmp)) {
-            chunk = (uint32_t)sizeof(tmp);
-        }
-        if (!copy_from_user(tmp, (const uint8_t*)src_user + total, chunk)) {
-            return (total != 0) ? (int32_t)total : -EFAULT;
+    uint32_t total = 0;
+    for (int32_t i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0) {
+            continue;
         }
-        uint32_t wrote = 0;
-        int32_t rc = vfs_write(h, tmp, chunk, &wrote);
-        if (rc < 0) {
-            return (total != 0) ? (int32_t)total : rc;
+        int32_t n = tasking_fd_write(fd, (const void*)iov[i].base, iov[i].len);
+        if (n < 0) {
+            return (total != 0) ? (int32_t)total : n;
         }
-        total += wrote;
-        if (wrote != chunk) {
+        total += (uint32_t)n;
+        if ((uint32_t)n < iov[i].len) {
             break;
         }
     }
@@ -3890,7 +5573,7 @@ int32_t tasking_fd_lseek(int32_t fd, int32_t offset, int32_t whence) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -3916,7 +5599,7 @@ int32_t tasking_fd_fstat(int32_t fd, void* st_user) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     fd_kind_t kind = ent->kind;
     vfs_handle_t* h = ent->handle;
     irq_restore(irq_flags);
@@ -3949,7 +5632,7 @@ int32_t tasking_stat(const char* path, void* st_user) {
     }
 
     vfs_stat_t st;
-    int32_t rc = vfs_stat_path(current_task->cwd, path, &st);
+    int32_t rc = vfs_stat_path(task_cwd(current_task), path, &st);
     if (rc < 0) {
         return rc;
     }
@@ -3965,7 +5648,7 @@ int32_t tasking_lstat(const char* path, void* st_user) {
     }
 
     vfs_stat_t st;
-    int32_t rc = vfs_lstat_path(current_task->cwd, path, &st);
+    int32_t rc = vfs_lstat_path(task_cwd(current_task), path, &st);
     if (rc < 0) {
         return rc;
     }
@@ -3987,7 +5670,7 @@ int32_t tasking_access(const char* path, int32_t mode) {
     }
 
     vfs_stat_t st;
-    int32_t rc = vfs_stat_path(current_task->cwd, path, &st);
+    int32_t rc = vfs_stat_path(task_cwd(current_task), path, &st);
     if (rc < 0) {
         return rc;  // File doesn't exist or other error
     }
@@ -4019,7 +5702,7 @@ int32_t tasking_statfs(const char* path, void* st_user) {
     }
 
     vfs_statfs_t st;
-    int32_t rc = vfs_statfs_path(current_task->cwd, path, &st);
+    int32_t rc = vfs_statfs_path(task_cwd(current_task), path, &st);
     if (rc < 0) {
         return rc;
     }
@@ -4033,7 +5716,7 @@ int32_t tasking_mkdir(const char* path) {
     if (!current_task || !path) {
         return -EINVAL;
     }
-    return vfs_mkdir_path(current_task->cwd, path);
+    return vfs_mkdir_path(task_cwd(current_task), path);
 }
 
 int32_t tasking_readdir(int32_t fd, void* dirent_user) {
@@ -4045,7 +5728,7 @@ int32_t tasking_readdir(int32_t fd, void* dirent_user) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -4066,13 +5749,94 @@ int32_t tasking_readdir(int32_t fd, void* dirent_user) {
     return 1;
 }
 
+int32_t tasking_getdents(int32_t fd, void* buf_user, uint32_t len) {
+    if (!current_task || !buf_user) {
+        return -EFAULT;
+    }
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    vfs_handle_t* h = ent->handle;
+    fd_kind_t kind = ent->kind;
+    irq_restore(irq_flags);
+
+    if (kind != FD_KIND_VFS || !h) {
+        return -EBADF;
+    }
+    if (!access_ok(buf_user, len)) {
+        return -EFAULT;
+    }
+
+    // Records are packed into a kernel buffer and copied out a batch at a
+    // time; the largest one always fits.
+    uint8_t tmp[512];
+    uint32_t fill = 0;
+    uint32_t done = 0;
+    for (;;) {
+        uint32_t pos = 0;
+        (void)vfs_lseek(h, 0, VOS_SEEK_CUR, &pos);
+        vfs_dirent_t de;
+        int32_t rc = vfs_readdir(h, &de);
+        if (rc < 0) {
+            if (done + fill == 0) {
+                return rc;
+            }
+            break;
+        }
+        if (rc == 0) {
+            break;
+        }
+
+        de.name[sizeof(de.name) - 1u] = '\0';
+        uint32_t name_len = (uint32_t)strlen(de.name);
+        uint32_t reclen = ((uint32_t)sizeof(vos_dirent_rec_t) + name_len + 1u + 3u) & ~3u;
+        if (done + fill + reclen > len) {
+            // Doesn't fit: leave it for the next call.
+            (void)vfs_lseek(h, (int32_t)pos, VOS_SEEK_SET, NULL);
+            if (done + fill == 0) {
+                return -EINVAL;
+            }
+            break;
+        }
+        if (fill + reclen > sizeof(tmp)) {
+            if (!copy_to_user((uint8_t*)buf_user + done, tmp, fill)) {
+                return -EFAULT;
+            }
+            done += fill;
+            fill = 0;
+        }
+
+        vos_dirent_rec_t* r = (vos_dirent_rec_t*)(tmp + fill);
+        memset(r, 0, reclen);
+        r->reclen = (uint16_t)reclen;
+        r->type = de.is_symlink ? VOS_DT_LNK : (de.is_dir ? VOS_DT_DIR : VOS_DT_REG);
+        r->name_len = (uint8_t)name_len;
+        r->mode = de.mode;
+        r->wtime = de.wtime;
+        r->wdate = de.wdate;
+        r->size = de.size;
+        r->uid = de.uid;
+        r->gid = de.gid;
+        memcpy(r->name, de.name, name_len);
+        fill += reclen;
+    }
+
+    if (fill != 0 && !copy_to_user((uint8_t*)buf_user + done, tmp, fill)) {
+        return -EFAULT;
+    }
+    return (int32_t)(done + fill);
+}
+
 int32_t tasking_chdir(const char* path) {
     if (!current_task || !path) {
         return -EINVAL;
     }
 
     vfs_stat_t st;
-    int32_t rc = vfs_stat_path(current_task->cwd, path, &st);
+    int32_t rc = vfs_stat_path(task_cwd(current_task), path, &st);
     if (rc < 0) {
         return rc;
     }
@@ -4081,13 +5845,17 @@ int32_t tasking_chdir(const char* path) {
     }
 
     char abs[VFS_PATH_MAX];
-    rc = vfs_path_resolve(current_task->cwd, path, abs);
+    rc = vfs_path_resolve(task_cwd(current_task), path, abs);
     if (rc < 0) {
         return rc;
     }
 
-    strncpy(current_task->cwd, abs, sizeof(current_task->cwd) - 1u);
-    current_task->cwd[sizeof(current_task->cwd) - 1u] = '\0';
+    task_cwd_t* c = cwd_create(abs);
+    if (!c) {
+        return -ENOMEM;
+    }
+    cwd_set(current_task, c);
+    cwd_put(c);
     return 0;
 }
 
@@ -4096,11 +5864,12 @@ int32_t tasking_getcwd(void* dst_user, uint32_t len) {
         return -EFAULT;
     }
 
-    uint32_t need = (uint32_t)strlen(current_task->cwd) + 1u;
+    const char* cwd = task_cwd(current_task);
+    uint32_t need = (uint32_t)strlen(cwd) + 1u;
     if (len < need) {
         return -ERANGE;
     }
-    if (!copy_to_user(dst_user, current_task->cwd, need)) {
+    if (!copy_to_user(dst_user, cwd, need)) {
         return -EFAULT;
     }
     return (int32_t)(need - 1u);
@@ -4110,35 +5879,35 @@ int32_t tasking_unlink(const char* path) {
     if (!current_task || !path) {
         return -EINVAL;
     }
-    return vfs_unlink_path(current_task->cwd, path);
+    return vfs_unlink_path(task_cwd(current_task), path);
 }
 
 int32_t tasking_rename(const char* old_path, const char* new_path) {
     if (!current_task || !old_path || !new_path) {
         return -EINVAL;
     }
-    return vfs_rename_path(current_task->cwd, old_path, new_path);
+    return vfs_rename_path(task_cwd(current_task), old_path, new_path);
 }
 
 int32_t tasking_rmdir(const char* path) {
     if (!current_task || !path) {
         return -EINVAL;
     }
-    return vfs_rmdir_path(current_task->cwd, path);
+    return vfs_rmdir_path(task_cwd(current_task), path);
 }
 
 int32_t tasking_truncate(const char* path, uint32_t new_size) {
     if (!current_task || !path) {
         return -EINVAL;
     }
-    return vfs_truncate_path(current_task->cwd, path, new_size);
+    return vfs_truncate_path(task_cwd(current_task), path, new_size);
 }
 
 int32_t tasking_symlink(const char* target, const char* linkpath) {
     if (!current_task || !target || !linkpath) {
         return -EINVAL;
     }
-    return vfs_symlink_path(current_task->cwd, target, linkpath);
+    return vfs_symlink_path(task_cwd(current_task), target, linkpath);
 }
 
 int32_t tasking_readlink(const char* path, void* dst_user, uint32_t cap) {
@@ -4159,7 +5928,7 @@ int32_t tasking_readlink(const char* path, void* dst_user, uint32_t cap) {
         return -ENOMEM;
     }
 
-    int32_t n = vfs_readlink_path(current_task->cwd, path, tmp, kcap);
+    int32_t n = vfs_readlink_path(task_cwd(current_task), path, tmp, kcap);
     if (n < 0) {
         kfree(tmp);
         return n;
@@ -4178,7 +5947,7 @@ int32_t tasking_chmod(const char* path, uint16_t mode) {
     if (!current_task || !path) {
         return -EINVAL;
     }
-    return vfs_chmod_path(current_task->cwd, path, mode);
+    return vfs_chmod_path(task_cwd(current_task), path, mode);
 }
 
 int32_t tasking_fd_fchmod(int32_t fd, uint16_t mode) {
@@ -4190,7 +5959,7 @@ int32_t tasking_fd_fchmod(int32_t fd, uint16_t mode) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -4209,7 +5978,7 @@ int32_t tasking_chown(const char* path, uint32_t uid, uint32_t gid) {
     if (current_task->uid != 0) {
         return -EPERM;
     }
-    return vfs_chown_path(current_task->cwd, path, uid, gid);
+    return vfs_chown_path(task_cwd(current_task), path, uid, gid);
 }
 
 int32_t tasking_lchown(const char* path, uint32_t uid, uint32_t gid) {
@@ -4220,7 +5989,7 @@ int32_t tasking_lchown(const char* path, uint32_t uid, uint32_t gid) {
     if (current_task->uid != 0) {
         return -EPERM;
     }
-    return vfs_lchown_path(current_task->cwd, path, uid, gid);
+    return vfs_lchown_path(task_cwd(current_task), path, uid, gid);
 }
 
 int32_t tasking_fd_fchown(int32_t fd, uint32_t uid, uint32_t gid) {
@@ -4236,7 +6005,7 @@ int32_t tasking_fd_fchown(int32_t fd, uint32_t uid, uint32_t gid) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -4256,7 +6025,7 @@ int32_t tasking_fd_ftruncate(int32_t fd, uint32_t new_size) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -4276,7 +6045,7 @@ int32_t tasking_fd_fsync(int32_t fd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     vfs_handle_t* h = ent->handle;
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
@@ -4287,6 +6056,42 @@ int32_t tasking_fd_fsync(int32_t fd) {
     return vfs_fsync(h);
 }
 
+int32_t tasking_fd_on_disk(int32_t fd) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    if (ent->kind == FD_KIND_FREE) {
+        irq_restore(irq_flags);
+        return -EBADF;
+    }
+    bool on_disk = ent->kind == FD_KIND_VFS && vfs_handle_on_disk(ent->handle);
+    irq_restore(irq_flags);
+    return on_disk ? 1 : 0;
+}
+
+int32_t tasking_fd_can_block(int32_t fd) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    if (fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return -EBADF;
+    }
+
+    uint32_t irq_flags = irq_save();
+    fd_kind_t kind = current_task->files->fds[fd].kind;
+    irq_restore(irq_flags);
+    if (kind == FD_KIND_FREE) {
+        return -EBADF;
+    }
+    return (kind == FD_KIND_STDIN || kind == FD_KIND_TTY || kind == FD_KIND_PIPE) ? 1 : 0;
+}
+
 int32_t tasking_fd_dup(int32_t oldfd) {
     if (!current_task) {
         return -EINVAL;
@@ -4300,7 +6105,7 @@ int32_t tasking_fd_dup(int32_t oldfd) {
     bool pipe_we = false;
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* src = &current_task->fds[oldfd];
+    fd_entry_t* src = &current_task->files->fds[oldfd];
     if (src->kind == FD_KIND_FREE) {
         irq_restore(irq_flags);
         return -EBADF;
@@ -4308,7 +6113,7 @@ int32_t tasking_fd_dup(int32_t oldfd) {
 
     int32_t newfd = -1;
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        if (current_task->fds[fd].kind == FD_KIND_FREE) {
+        if (current_task->files->fds[fd].kind == FD_KIND_FREE) {
             newfd = fd;
             break;
         }
@@ -4318,13 +6123,15 @@ int32_t tasking_fd_dup(int32_t oldfd) {
         return -EMFILE;
     }
 
-    fd_entry_t* dst = &current_task->fds[newfd];
+    fd_entry_t* dst = &current_task->files->fds[newfd];
     dst->kind = src->kind;
     dst->fd_flags = 0; // dup() clears close-on-exec
     dst->fl_flags = src->fl_flags;
     dst->handle = src->handle;
     dst->pipe = src->pipe;
     dst->pipe_write_end = src->pipe_write_end;
+    dst->epoll = src->epoll;
+    epoll_get(dst->epoll);
     dst->pending_len = 0;
     dst->pending_off = 0;
 
@@ -4359,13 +6166,13 @@ int32_t tasking_fd_dup2(int32_t oldfd, int32_t newfd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* src = &current_task->fds[oldfd];
+    fd_entry_t* src = &current_task->files->fds[oldfd];
     if (src->kind == FD_KIND_FREE) {
         irq_restore(irq_flags);
         return -EBADF;
     }
 
-    bool need_close = current_task->fds[newfd].kind != FD_KIND_FREE;
+    bool need_close = current_task->files->fds[newfd].kind != FD_KIND_FREE;
     irq_restore(irq_flags);
 
     if (need_close) {
@@ -4380,19 +6187,21 @@ int32_t tasking_fd_dup2(int32_t oldfd, int32_t newfd) {
     bool pipe_we = false;
 
     irq_flags = irq_save();
-    src = &current_task->fds[oldfd];
+    src = &current_task->files->fds[oldfd];
     if (src->kind == FD_KIND_FREE) {
         irq_restore(irq_flags);
         return -EBADF;
     }
 
-    fd_entry_t* dst = &current_task->fds[newfd];
+    fd_entry_t* dst = &current_task->files->fds[newfd];
     dst->kind = src->kind;
     dst->fd_flags = 0; // dup2() clears close-on-exec
     dst->fl_flags = src->fl_flags;
     dst->handle = src->handle;
     dst->pipe = src->pipe;
     dst->pipe_write_end = src->pipe_write_end;
+    dst->epoll = src->epoll;
+    epoll_get(dst->epoll);
     dst->pending_len = 0;
     dst->pending_off = 0;
 
@@ -4437,7 +6246,7 @@ int32_t tasking_fd_fcntl(int32_t fd, int32_t cmd, int32_t arg) {
         bool pipe_we = false;
 
         uint32_t irq_flags = irq_save();
-        fd_entry_t* src = &current_task->fds[fd];
+        fd_entry_t* src = &current_task->files->fds[fd];
         if (src->kind == FD_KIND_FREE) {
             irq_restore(irq_flags);
             return -EBADF;
@@ -4445,7 +6254,7 @@ int32_t tasking_fd_fcntl(int32_t fd, int32_t cmd, int32_t arg) {
 
         int32_t newfd = -1;
         for (int32_t cand = minfd; cand < (int32_t)TASK_MAX_FDS; cand++) {
-            if (current_task->fds[cand].kind == FD_KIND_FREE) {
+            if (current_task->files->fds[cand].kind == FD_KIND_FREE) {
                 newfd = cand;
                 break;
             }
@@ -4455,13 +6264,15 @@ int32_t tasking_fd_fcntl(int32_t fd, int32_t cmd, int32_t arg) {
             return -EMFILE;
         }
 
-        fd_entry_t* dst = &current_task->fds[newfd];
+        fd_entry_t* dst = &current_task->files->fds[newfd];
         dst->kind = src->kind;
         dst->fd_flags = (cmd == VOS_F_DUPFD_CLOEXEC) ? VOS_FD_CLOEXEC : 0;
         dst->fl_flags = src->fl_flags;
         dst->handle = src->handle;
         dst->pipe = src->pipe;
         dst->pipe_write_end = src->pipe_write_end;
+        dst->epoll = src->epoll;
+        epoll_get(dst->epoll);
         dst->pending_len = 0;
         dst->pending_off = 0;
 
@@ -4484,7 +6295,7 @@ int32_t tasking_fd_fcntl(int32_t fd, int32_t cmd, int32_t arg) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     if (ent->kind == FD_KIND_FREE) {
         irq_restore(irq_flags);
         return -EBADF;
@@ -4541,7 +6352,7 @@ int32_t tasking_fd_is_readable(int32_t fd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
 
     switch (ent->kind) {
         case FD_KIND_FREE:
@@ -4602,6 +6413,12 @@ int32_t tasking_fd_is_readable(int32_t fd) {
             return (has_data || no_writers) ? 1 : 0;
         }
 
+        case FD_KIND_EPOLL: {
+            bool ready = epoll_has_ready(ent->epoll);
+            irq_restore(irq_flags);
+            return ready ? 1 : 0;
+        }
+
         default:
             irq_restore(irq_flags);
             return -1;
@@ -4617,7 +6434,7 @@ int32_t tasking_fd_is_writable(int32_t fd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
 
     switch (ent->kind) {
         case FD_KIND_FREE:
@@ -4660,6 +6477,10 @@ int32_t tasking_fd_is_writable(int32_t fd) {
             return has_space ? 1 : 0;
         }
 
+        case FD_KIND_EPOLL:
+            irq_restore(irq_flags);
+            return 0;
+
         default:
             irq_restore(irq_flags);
             return -1;
@@ -4675,7 +6496,7 @@ int32_t tasking_fd_isatty(int32_t fd) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
 
@@ -4688,7 +6509,7 @@ const char* tasking_get_cwd(void) {
     if (!current_task) {
         return "/";
     }
-    return current_task->cwd;
+    return task_cwd(current_task);
 }
 
 int32_t tasking_pipe(void* pipefds_user) {
@@ -4706,7 +6527,7 @@ int32_t tasking_pipe(void* pipefds_user) {
 
     uint32_t irq_flags = irq_save();
     for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
-        if (current_task->fds[fd].kind != FD_KIND_FREE) {
+        if (current_task->files->fds[fd].kind != FD_KIND_FREE) {
             continue;
         }
         if (rfd < 0) {
@@ -4723,7 +6544,7 @@ int32_t tasking_pipe(void* pipefds_user) {
         return -EMFILE;
     }
 
-    fd_entry_t* r = &current_task->fds[rfd];
+    fd_entry_t* r = &current_task->files->fds[rfd];
     r->kind = FD_KIND_PIPE;
     r->fd_flags = 0;
     r->fl_flags = 0; // O_RDONLY
@@ -4733,7 +6554,7 @@ int32_t tasking_pipe(void* pipefds_user) {
     r->pending_len = 0;
     r->pending_off = 0;
 
-    fd_entry_t* w = &current_task->fds[wfd];
+    fd_entry_t* w = &current_task->files->fds[wfd];
     w->kind = FD_KIND_PIPE;
     w->fd_flags = 0;
     w->fl_flags = 1; // O_WRONLY
@@ -4755,6 +6576,75 @@ int32_t tasking_pipe(void* pipefds_user) {
     return 0;
 }
 
+poll_head_t* tasking_fd_poll_head(int32_t fd) {
+    if (!current_task || fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return NULL;
+    }
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    poll_head_t* h = NULL;
+    switch (ent->kind) {
+        case FD_KIND_STDIN:
+        case FD_KIND_TTY:
+            h = keyboard_poll_head();
+            break;
+        case FD_KIND_PIPE:
+            h = ent->pipe ? &ent->pipe->poll : NULL;
+            break;
+        case FD_KIND_EPOLL:
+            h = epoll_poll_head(ent->epoll);
+            break;
+        default:
+            break;
+    }
+    irq_restore(irq_flags);
+    return h;
+}
+
+int32_t tasking_epoll_create(uint32_t flags) {
+    if (!current_task) {
+        return -EINVAL;
+    }
+    epoll_t* ep = epoll_create();
+    if (!ep) {
+        return -ENOMEM;
+    }
+
+    uint32_t irq_flags = irq_save();
+    for (int32_t fd = 0; fd < (int32_t)TASK_MAX_FDS; fd++) {
+        fd_entry_t* ent = &current_task->files->fds[fd];
+        if (ent->kind != FD_KIND_FREE) {
+            continue;
+        }
+        ent->kind = FD_KIND_EPOLL;
+        ent->fd_flags = (flags & 1u) ? VOS_FD_CLOEXEC : 0;
+        ent->fl_flags = 0;
+        ent->handle = NULL;
+        ent->pipe = NULL;
+        ent->pipe_write_end = false;
+        ent->epoll = ep;
+        ent->pending_len = 0;
+        ent->pending_off = 0;
+        irq_restore(irq_flags);
+        return fd;
+    }
+    irq_restore(irq_flags);
+    epoll_put(ep);
+    return -EMFILE;
+}
+
+epoll_t* tasking_fd_epoll(int32_t fd) {
+    if (!current_task || fd < 0 || fd >= (int32_t)TASK_MAX_FDS) {
+        return NULL;
+    }
+    uint32_t irq_flags = irq_save();
+    fd_entry_t* ent = &current_task->files->fds[fd];
+    epoll_t* ep = ent->kind == FD_KIND_EPOLL ? ent->epoll : NULL;
+    epoll_get(ep);
+    irq_restore(irq_flags);
+    return ep;
+}
+
 int32_t tasking_fd_ioctl(int32_t fd, uint32_t req, void* argp_user) {
     if (!current_task) {
         return -EINVAL;
@@ -4764,7 +6654,7 @@ int32_t tasking_fd_ioctl(int32_t fd, uint32_t req, void* argp_user) {
     }
 
     uint32_t irq_flags = irq_save();
-    fd_entry_t* ent = &current_task->fds[fd];
+    fd_entry_t* ent = &current_task->files->fds[fd];
     fd_kind_t kind = ent->kind;
     irq_restore(irq_flags);
 
@@ -4840,13 +6730,14 @@ int32_t tasking_fd_ioctl(int32_t fd, uint32_t req, void* argp_user) {
             // here breaks multi-byte keys (arrows, function keys, etc.).
             if (req == VOS_TCSETSF) {
                 irq_flags = irq_save();
-                ent = &current_task->fds[fd];
+                ent = &current_task->files->fds[fd];
                 ent->pending_len = 0;
                 ent->pending_off = 0;
                 irq_restore(irq_flags);
-                current_task->tty_line_len = 0;
-                current_task->tty_line_off = 0;
-                current_task->tty_line_ready = false;
+                tty_ldisc_t* ld = tty_ldisc_current();
+                ld->len = 0;
+                ld->off = 0;
+                ld->ready = false;
             }
             return 0;
         }
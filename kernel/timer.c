@@ -1,17 +1,195 @@
 #include "timer.h"
 #include "interrupts.h"
 #include "io.h"
+#include "paging.h"
+#include "rtc.h"
+#include "serial.h"
+#include "vdso.h"
 
 #define PIT_BASE_HZ 1193182u
 #define PIT_CHANNEL0_DATA 0x40
+#define PIT_CHANNEL2_DATA 0x42
 #define PIT_COMMAND       0x43
+#define PIT_CH2_GATE_PORT 0x61
+
+// TSC calibration: count cycles across a 10 ms one-shot on PIT channel 2.
+#define TSC_CALIBRATE_HZ   100u
+#define TSC_CALIBRATE_SPIN 50000000u
+#define TSC_MIN_PER_TICK   10000u   // slower than this isn't worth using
+#define TSC_SHIFT          24u
+#define TSC_MAX_BAD_TICKS  8u
 
 static volatile uint32_t timer_ticks = 0;
+static volatile uint32_t timer_ticks_hi = 0; // wraps of timer_ticks
 static uint32_t timer_hz = 0;
+static uint32_t ns_per_tick = 0;             // exact PIT period
+
+// Between ticks the TSC interpolates: ns = (cycles * tsc_mult) >> TSC_SHIFT.
+// tsc_per_tick == 0 means the PIT tick is the only clock source.
+static volatile uint64_t tick_tsc = 0;       // TSC at the last tick
+static volatile uint32_t tsc_per_tick = 0;
+static uint32_t tsc_mult = 0;
+static uint32_t tsc_khz = 0;
+static uint32_t tsc_bad_ticks = 0;
+
+static uint64_t realtime_base_ns = 0;
+static bool realtime_valid = false;
+
+// Published to user space at VDSO_TIME_VA. The kernel writes it through its
+// identity mapping; processes only get a read-only alias.
+static union {
+    vdso_time_t time;
+    uint8_t page[PAGE_SIZE];
+} time_page __attribute__((aligned(PAGE_SIZE)));
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// 64/32 division without libgcc: two divl steps.
+static uint64_t div_u64_u32(uint64_t n, uint32_t d, uint32_t* rem) {
+    uint32_t hi = (uint32_t)(n >> 32);
+    uint32_t lo = (uint32_t)n;
+    uint32_t qhi = hi / d;
+    uint32_t r = hi % d;
+    uint32_t qlo;
+    __asm__ ("divl %4" : "=a"(qlo), "=d"(r) : "a"(lo), "d"(r), "rm"(d));
+    if (rem) {
+        *rem = r;
+    }
+    return ((uint64_t)qhi << 32) | qlo;
+}
+
+static bool cpu_has_tsc(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0u), "c"(0u));
+    if (eax < 1u) {
+        return false;
+    }
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1u), "c"(0u));
+    return (edx & (1u << 4)) != 0;
+}
+
+static bool cpu_tsc_invariant(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000u), "c"(0u));
+    if (eax < 0x80000007u) {
+        return false;
+    }
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000007u), "c"(0u));
+    return (edx & (1u << 8)) != 0;
+}
+
+// Cycles elapsed over `latch` PIT input clocks, or 0 if channel 2 never fired.
+static uint32_t tsc_measure(uint32_t latch) {
+    uint8_t gate = inb(PIT_CH2_GATE_PORT);
+    // Gate channel 2 on, keep the speaker disconnected.
+    outb(PIT_CH2_GATE_PORT, (uint8_t)((gate & ~0x02u) | 0x01u));
+
+    // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count).
+    outb(PIT_COMMAND, 0xB0);
+    outb(PIT_CHANNEL2_DATA, (uint8_t)(latch & 0xFF));
+    outb(PIT_CHANNEL2_DATA, (uint8_t)((latch >> 8) & 0xFF));
+
+    uint64_t start = rdtsc();
+    uint32_t spins = 0;
+    while ((inb(PIT_CH2_GATE_PORT) & 0x20u) == 0) {
+        if (++spins >= TSC_CALIBRATE_SPIN) {
+            outb(PIT_CH2_GATE_PORT, gate);
+            return 0;
+        }
+    }
+    uint64_t end = rdtsc();
+
+    outb(PIT_CH2_GATE_PORT, gate);
+    uint64_t cycles = end - start;
+    return (cycles >> 32) ? 0 : (uint32_t)cycles;
+}
+
+static void tsc_calibrate(uint32_t divisor) {
+    tsc_per_tick = 0;
+    tsc_khz = 0;
+    if (!cpu_has_tsc()) {
+        serial_write_string("[TIMER] no TSC, using PIT ticks\n");
+        return;
+    }
+
+    uint32_t flags = irq_save();
+    uint32_t latch = PIT_BASE_HZ / TSC_CALIBRATE_HZ;
+    // Take the fastest of a few runs; slower ones were disturbed (SMIs, host).
+    uint32_t best = 0;
+    for (uint32_t i = 0; i < 3u; i++) {
+        uint32_t c = tsc_measure(latch);
+        if (c != 0 && (best == 0 || c < best)) {
+            best = c;
+        }
+    }
+    irq_restore(flags);
+
+    if (best == 0) {
+        serial_write_string("[TIMER] TSC calibration failed, using PIT ticks\n");
+        return;
+    }
+
+    uint32_t per_tick = (uint32_t)div_u64_u32((uint64_t)best * divisor, latch, NULL);
+    if (per_tick < TSC_MIN_PER_TICK) {
+        serial_write_string("[TIMER] TSC too slow, using PIT ticks\n");
+        return;
+    }
+
+    tsc_khz = (uint32_t)div_u64_u32((uint64_t)best * PIT_BASE_HZ, latch * 1000u, NULL);
+    tsc_mult = (uint32_t)div_u64_u32((uint64_t)ns_per_tick << TSC_SHIFT, per_tick, NULL);
+    tsc_bad_ticks = 0;
+    tick_tsc = rdtsc();
+    tsc_per_tick = per_tick;
+
+    serial_write_string("[TIMER] TSC ");
+    serial_write_dec((int32_t)(tsc_khz / 1000u));
+    serial_write_string(" MHz");
+    serial_write_string(cpu_tsc_invariant() ? " (invariant)\n" : "\n");
+}
+
+// Callers run with interrupts off, so the seqlock writer is never nested.
+static void time_page_publish(void) {
+    vdso_time_t* tp = &time_page.time;
+    tp->seq++;
+    __asm__ volatile ("" ::: "memory");
+
+    tp->ticks = ((uint64_t)timer_ticks_hi << 32) | timer_ticks;
+    tp->ns_per_tick = ns_per_tick;
+    tp->tick_tsc = tick_tsc;
+    tp->tsc_per_tick = tsc_per_tick;
+    tp->tsc_mult = tsc_mult;
+    tp->tsc_shift = TSC_SHIFT;
+    tp->realtime_base_ns = realtime_base_ns;
+    tp->flags = (tsc_per_tick ? VDSO_TIME_TSC : 0u) | (realtime_valid ? VDSO_TIME_REALTIME : 0u);
+
+    __asm__ volatile ("" ::: "memory");
+    tp->seq++;
+}
 
 static void pit_irq_handler(interrupt_frame_t* frame) {
     (void)frame;
-    timer_ticks++;
+    if (tsc_per_tick) {
+        // A TSC that runs backwards or far slower than calibrated (frequency
+        // scaling, migration between unsynced sockets) can't interpolate.
+        uint64_t now = rdtsc();
+        if (now <= tick_tsc || now - tick_tsc < tsc_per_tick / 2u) {
+            if (++tsc_bad_ticks >= TSC_MAX_BAD_TICKS) {
+                tsc_per_tick = 0;
+                serial_write_string("[TIMER] TSC unstable, using PIT ticks\n");
+            }
+        } else {
+            tsc_bad_ticks = 0;
+        }
+        tick_tsc = now;
+    }
+    if (++timer_ticks == 0) {
+        timer_ticks_hi++;
+    }
+    time_page_publish();
 }
 
 void timer_init(uint32_t hz) {
@@ -28,7 +206,16 @@ void timer_init(uint32_t hz) {
     }
 
     timer_ticks = 0;
+    timer_ticks_hi = 0;
     timer_hz = PIT_BASE_HZ / divisor;
+    ns_per_tick = (uint32_t)div_u64_u32((uint64_t)divisor * 1000000000u, PIT_BASE_HZ, NULL);
+
+    tsc_calibrate(divisor);
+
+    time_page.time.version = VDSO_TIME_VERSION;
+    time_page_publish();
+    paging_map_page(VDSO_TIME_VA, (uint32_t)&time_page, PAGE_PRESENT | PAGE_USER);
+    (void)timer_sync_realtime();
 
     irq_register_handler(0, pit_irq_handler);
 
@@ -48,17 +235,102 @@ uint32_t timer_get_ticks(void) {
     return ticks;
 }
 
-uint32_t timer_uptime_ms(void) {
-    uint32_t hz = timer_get_hz();
-    if (hz == 0) {
-        return 0;
+static uint64_t timer_ticks64(void) {
+    uint32_t flags = irq_save();
+    uint64_t ticks = ((uint64_t)timer_ticks_hi << 32) | timer_ticks;
+    irq_restore(flags);
+    return ticks;
+}
+
+uint32_t timer_tsc_khz(void) {
+    return tsc_per_tick ? tsc_khz : 0;
+}
+
+uint64_t timer_read_tsc(void) {
+    return tsc_per_tick ? rdtsc() : 0;
+}
+
+uint64_t timer_monotonic_ns(void) {
+    uint32_t flags = irq_save();
+    uint64_t ticks = ((uint64_t)timer_ticks_hi << 32) | timer_ticks;
+    uint32_t per_tick = tsc_per_tick;
+    uint32_t frac = 0;
+    if (per_tick) {
+        // Clamp to one tick so the clock never runs ahead of a late IRQ0;
+        // this keeps readings monotonic across the tick boundary.
+        uint64_t cycles = rdtsc() - tick_tsc;
+        if (cycles >= per_tick) {
+            frac = ns_per_tick;
+        } else {
+            frac = (uint32_t)(((uint64_t)(uint32_t)cycles * tsc_mult) >> TSC_SHIFT);
+            if (frac > ns_per_tick) {
+                frac = ns_per_tick;
+            }
+        }
+    }
+    irq_restore(flags);
+    return ticks * ns_per_tick + frac;
+}
+
+void timer_ns_split(uint64_t ns, uint32_t* sec, uint32_t* nsec) {
+    uint32_t rem = 0;
+    uint64_t s = div_u64_u32(ns, 1000000000u, &rem);
+    if (sec) {
+        *sec = (uint32_t)s;
+    }
+    if (nsec) {
+        *nsec = rem;
+    }
+}
+
+uint32_t timer_deadline_tick(uint64_t deadline_ns) {
+    if (ns_per_tick == 0) {
+        return timer_get_ticks();
+    }
+
+    // First tick at or after the deadline, so sleeps never end early.
+    uint32_t rem = 0;
+    uint64_t tick = div_u64_u32(deadline_ns, ns_per_tick, &rem);
+    if (rem) {
+        tick++;
+    }
+
+    uint64_t now = timer_ticks64();
+    if (tick <= now) {
+        return (uint32_t)now;
+    }
+    // Keep wake_tick comparisons well-defined for absurdly long sleeps.
+    if (tick - now > 0x7FFFFFFFu) {
+        tick = now + 0x7FFFFFFFu;
+    }
+    return (uint32_t)tick;
+}
+
+bool timer_sync_realtime(void) {
+    rtc_datetime_t dt;
+    if (!rtc_read_datetime(&dt)) {
+        return false;
     }
 
-    uint32_t ticks = timer_get_ticks();
-    uint32_t seconds = ticks / hz;
-    uint32_t rem = ticks % hz;
-    uint32_t ms = (rem * 1000u) / hz;
-    return seconds * 1000u + ms;
+    uint32_t flags = irq_save();
+    realtime_base_ns = (uint64_t)rtc_datetime_to_unix(&dt) * 1000000000u - timer_monotonic_ns();
+    realtime_valid = true;
+    time_page_publish();
+    irq_restore(flags);
+    return true;
+}
+
+bool timer_realtime_ns(uint64_t* out) {
+    if (!realtime_valid) {
+        return false;
+    }
+    *out = realtime_base_ns + timer_monotonic_ns();
+    return true;
+}
+
+uint32_t timer_uptime_ms(void) {
+    uint64_t ms = div_u64_u32(timer_monotonic_ns(), 1000000u, NULL);
+    return (uint32_t)ms;
 }
 
 void timer_sleep_ms(uint32_t ms) {
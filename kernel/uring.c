@@ -0,0 +1,376 @@
+#include "uring.h"
+#include "task.h"
+#include "usercopy.h"
+#include "kheap.h"
+#include "kerrno.h"
+#include "string.h"
+#include "io.h"
+#include "vfs.h"
+
+#define URING_PATH_MAX 128u
+
+// Syscall number the worker uses to sleep (see kernel/syscall.c).
+#define URING_SYS_SLEEP 3u
+#define URING_IDLE_MS   1000u
+
+struct uring {
+    uint32_t user;          // user address of the shared header
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sq_head;       // authoritative copies; user space only reads them
+    uint32_t cq_tail;
+    uint32_t inflight;      // handed to the worker, completion not posted yet
+    uint32_t overflow;
+};
+
+typedef struct uring_work {
+    struct uring_work* next;
+    uring_t* ring;
+    task_io_ctx_t* ctx;
+    uring_sqe_t sqe;
+    char path[URING_PATH_MAX];
+} uring_work_t;
+
+// One worker serves every ring; disk I/O is serialized by the driver anyway.
+static uring_work_t* work_head = NULL;
+static uring_work_t* work_tail = NULL;
+static uint32_t worker_pid = 0;
+
+static uring_header_t* ring_header(const uring_t* r) {
+    return (uring_header_t*)r->user;
+}
+
+static uring_sqe_t* ring_sqes(const uring_t* r) {
+    return (uring_sqe_t*)(r->user + (uint32_t)sizeof(uring_header_t));
+}
+
+static uring_cqe_t* ring_cqes(const uring_t* r) {
+    return (uring_cqe_t*)((uint32_t)ring_sqes(r) + r->sq_entries * (uint32_t)sizeof(uring_sqe_t));
+}
+
+static bool is_pow2(uint32_t v) {
+    return v != 0 && (v & (v - 1u)) == 0;
+}
+
+int32_t uring_setup(uint32_t ring_user, uint32_t sq_entries, uint32_t cq_entries) {
+    if (cq_entries == 0) {
+        cq_entries = sq_entries * 2u;
+    }
+    if (!is_pow2(sq_entries) || !is_pow2(cq_entries) || sq_entries > URING_MAX_ENTRIES ||
+        cq_entries > 2u * URING_MAX_ENTRIES || cq_entries < sq_entries) {
+        return -EINVAL;
+    }
+    if (ring_user == 0 || (ring_user & 7u) != 0) {
+        return -EINVAL;
+    }
+
+    uring_t* old = tasking_uring();
+    if (old && old->inflight != 0) {
+        return -EBUSY;
+    }
+
+    uint32_t size = (uint32_t)sizeof(uring_header_t) + sq_entries * (uint32_t)sizeof(uring_sqe_t) +
+                    cq_entries * (uint32_t)sizeof(uring_cqe_t);
+    uring_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.sq_entries = sq_entries;
+    hdr.cq_entries = cq_entries;
+    // Probe the whole block once so later faults mean user space unmapped it.
+    uint8_t probe = 0;
+    if (!copy_from_user(&probe, (const void*)(ring_user + size - 1u), 1u) ||
+        !copy_to_user((void*)(ring_user + size - 1u), &probe, 1u) ||
+        !copy_to_user((void*)ring_user, &hdr, (uint32_t)sizeof(hdr))) {
+        return -EFAULT;
+    }
+
+    uring_t* r = old;
+    if (!r) {
+        r = (uring_t*)kmalloc(sizeof(*r));
+        if (!r) {
+            return -ENOMEM;
+        }
+    }
+    memset(r, 0, sizeof(*r));
+    r->user = ring_user;
+    r->sq_entries = sq_entries;
+    r->cq_entries = cq_entries;
+    if (!tasking_set_uring(r)) {
+        kfree(r);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+void uring_release(uring_t* r) {
+    kfree(r);
+}
+
+// Post a completion. Runs in the submitting process or in the worker while
+// it has adopted that process's address space.
+static void uring_post(uring_t* r, uint64_t user_data, int32_t res) {
+    uring_header_t* hdr = ring_header(r);
+    uint32_t flags = irq_save();
+    uint32_t head = 0;
+    if (!copy_from_user(&head, (const void*)&hdr->cq_head, sizeof(head)) ||
+        r->cq_tail - head >= r->cq_entries) {
+        r->overflow++;
+        (void)copy_to_user((void*)&hdr->cq_overflow, &r->overflow, sizeof(r->overflow));
+        irq_restore(flags);
+        return;
+    }
+
+    uring_cqe_t cqe;
+    cqe.user_data = user_data;
+    cqe.res = res;
+    cqe.flags = 0;
+    // The entry must be visible before the tail that publishes it.
+    if (copy_to_user(&ring_cqes(r)[r->cq_tail & (r->cq_entries - 1u)], &cqe, sizeof(cqe))) {
+        r->cq_tail++;
+        (void)copy_to_user((void*)&hdr->cq_tail, &r->cq_tail, sizeof(r->cq_tail));
+    }
+    irq_restore(flags);
+}
+
+// READ/WRITE at an explicit offset leave the file position where it was.
+static int32_t uring_rw(const uring_sqe_t* sqe, bool write) {
+    if (sqe->off != URING_OFF_CUR) {
+        if (sqe->off > 0x7FFFFFFFu) {
+            return -EINVAL;
+        }
+        return write ? tasking_fd_pwrite(sqe->fd, (const void*)sqe->addr, sqe->len, (int32_t)sqe->off)
+                     : tasking_fd_pread(sqe->fd, (void*)sqe->addr, sqe->len, (int32_t)sqe->off);
+    }
+    return write ? tasking_fd_write(sqe->fd, (const void*)sqe->addr, sqe->len)
+                 : tasking_fd_read(sqe->fd, (void*)sqe->addr, sqe->len);
+}
+
+static int32_t uring_exec(const uring_sqe_t* sqe, const char* path) {
+    switch (sqe->opcode) {
+        case URING_OP_NOP:
+            return 0;
+        case URING_OP_READ:
+            return uring_rw(sqe, false);
+        case URING_OP_WRITE:
+            return uring_rw(sqe, true);
+        case URING_OP_OPEN:
+            return tasking_fd_open(path, sqe->op_flags);
+        case URING_OP_CLOSE:
+            return tasking_fd_close(sqe->fd);
+        case URING_OP_STAT:
+            return tasking_stat(path, (void*)sqe->off);
+        case URING_OP_FSTAT:
+            return tasking_fd_fstat(sqe->fd, (void*)sqe->addr);
+        case URING_OP_FSYNC:
+            return tasking_fd_fsync(sqe->fd);
+        default:
+            return -EINVAL;
+    }
+}
+
+// The worker is shared by every ring, so it must never wait on input that
+// only another process or the keyboard can provide: one such read would
+// stall every other ring with no way to cancel it. URING_SQE_ASYNC is
+// refused for READ/WRITE on those descriptors. Returns 0 or -errno.
+static int32_t uring_async_allowed(const uring_sqe_t* sqe) {
+    if ((sqe->flags & URING_SQE_ASYNC) == 0 ||
+        (sqe->opcode != URING_OP_READ && sqe->opcode != URING_OP_WRITE)) {
+        return 0;
+    }
+    int32_t rc = tasking_fd_can_block(sqe->fd);
+    if (rc < 0) {
+        return rc;
+    }
+    return rc ? -EAGAIN : 0;
+}
+
+// Only work that may wait for the disk goes to the worker: file data is
+// already in memory once a handle is open, and tty/pipe reads block the
+// submitter exactly like the plain syscalls do.
+static bool uring_wants_async(const uring_sqe_t* sqe, const char* path) {
+    if (sqe->flags & URING_SQE_ASYNC) {
+        return true;
+    }
+    switch (sqe->opcode) {
+        case URING_OP_OPEN:
+        case URING_OP_STAT:
+            return vfs_path_on_disk(tasking_get_cwd(), path);
+        case URING_OP_CLOSE:
+        case URING_OP_FSYNC:
+            return tasking_fd_on_disk(sqe->fd) == 1;
+        default:
+            return false;
+    }
+}
+
+static void uring_worker(void) {
+    for (;;) {
+        // Work runs with interrupts off like a syscall body (the VFS and the
+        // disk driver are not reentrant). Checking the queue and going to
+        // sleep under cli also means an enqueue can't slip in between.
+        cli();
+        uring_work_t* w = work_head;
+        if (!w) {
+            uint32_t ret;
+            __asm__ volatile ("int $0x80" : "=a"(ret) : "a"(URING_SYS_SLEEP), "b"(URING_IDLE_MS) : "memory");
+            (void)ret;
+            sti();
+            continue;
+        }
+        work_head = w->next;
+        if (!work_head) {
+            work_tail = NULL;
+        }
+
+        tasking_io_ctx_enter(w->ctx);
+        int32_t res = uring_exec(&w->sqe, w->path);
+        uring_post(w->ring, w->sqe.user_data, res);
+        w->ring->inflight--;
+        tasking_io_ctx_leave(w->ctx);
+
+        tasking_io_ctx_put(w->ctx);
+        kfree(w);
+        sti();
+    }
+}
+
+static bool uring_queue(uring_t* r, task_io_ctx_t* ctx, const uring_sqe_t* sqe, const char* path) {
+    if (worker_pid == 0) {
+        worker_pid = tasking_spawn_kernel(uring_worker, "uringd");
+        if (worker_pid == 0) {
+            return false;
+        }
+    }
+
+    uring_work_t* w = (uring_work_t*)kmalloc(sizeof(*w));
+    if (!w) {
+        return false;
+    }
+    w->next = NULL;
+    w->ring = r;
+    w->ctx = ctx;
+    w->sqe = *sqe;
+    strncpy(w->path, path, URING_PATH_MAX);
+
+    tasking_io_ctx_hold(ctx);
+    uint32_t flags = irq_save();
+    r->inflight++;
+    if (work_tail) {
+        work_tail->next = w;
+    } else {
+        work_head = w;
+    }
+    work_tail = w;
+    irq_restore(flags);
+    tasking_wake(worker_pid);
+    return true;
+}
+
+static uint32_t uring_ready(const uring_t* r) {
+    uint32_t head = 0;
+    if (!copy_from_user(&head, (const void*)&ring_header(r)->cq_head, sizeof(head))) {
+        return 0;
+    }
+    return r->cq_tail - head;
+}
+
+int32_t uring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    if (flags & ~URING_ENTER_GETEVENTS) {
+        return -EINVAL;
+    }
+    uring_t* r = tasking_uring();
+    if (!r) {
+        return -EINVAL;
+    }
+
+    uring_header_t* hdr = ring_header(r);
+    uint32_t tail = 0;
+    if (!copy_from_user(&tail, (const void*)&hdr->sq_tail, sizeof(tail))) {
+        return -EFAULT;
+    }
+    uint32_t queued = tail - r->sq_head;
+    if (queued > r->sq_entries) {
+        return -EINVAL;
+    }
+    if (to_submit > queued) {
+        to_submit = queued;
+    }
+
+    // Never accept more than the completion queue can hold: every consumed
+    // entry is guaranteed a slot for its result.
+    uint32_t used = uring_ready(r) + r->inflight;
+    uint32_t room = used < r->cq_entries ? r->cq_entries - used : 0;
+    if (to_submit > room) {
+        to_submit = room;
+    }
+
+    task_io_ctx_t* ctx = NULL;
+    uint32_t submitted = 0;
+    while (submitted < to_submit) {
+        uring_sqe_t sqe;
+        if (!copy_from_user(&sqe, &ring_sqes(r)[r->sq_head & (r->sq_entries - 1u)], sizeof(sqe))) {
+            break;
+        }
+        r->sq_head++;
+        (void)copy_to_user((void*)&hdr->sq_head, &r->sq_head, sizeof(r->sq_head));
+        submitted++;
+
+        char path[URING_PATH_MAX];
+        path[0] = '\0';
+        if (sqe.opcode == URING_OP_OPEN || sqe.opcode == URING_OP_STAT) {
+            int32_t rc = strncpy_from_user(path, (const char*)sqe.addr, sizeof(path));
+            if (rc < 0) {
+                uring_post(r, sqe.user_data, rc);
+                continue;
+            }
+        }
+
+        int32_t rc = uring_async_allowed(&sqe);
+        if (rc < 0) {
+            uring_post(r, sqe.user_data, rc);
+            continue;
+        }
+        if (uring_wants_async(&sqe, path)) {
+            if (!ctx) {
+                ctx = tasking_io_ctx_get();
+            }
+            if (ctx && uring_queue(r, ctx, &sqe, path)) {
+                continue;
+            }
+        }
+        uring_post(r, sqe.user_data, uring_exec(&sqe, path));
+
+        // An inline read may have been cut short by a signal.
+        if (tasking_current_should_interrupt()) {
+            break;
+        }
+    }
+    tasking_io_ctx_put(ctx);
+
+    if (submitted == 0 && to_submit != 0) {
+        return -EFAULT;
+    }
+    if ((flags & URING_ENTER_GETEVENTS) == 0 || min_complete == 0) {
+        return (int32_t)submitted;
+    }
+
+    bool were_enabled = irq_are_enabled();
+    if (!were_enabled) {
+        sti();
+    }
+    int32_t rc = (int32_t)submitted;
+    // Stop waiting once nothing is left in flight: no more completions can
+    // arrive without another submission.
+    while (uring_ready(r) < min_complete && r->inflight != 0) {
+        if (tasking_current_should_interrupt()) {
+            if (submitted == 0) {
+                rc = -EINTR;
+            }
+            break;
+        }
+        hlt();
+    }
+    if (!were_enabled) {
+        cli();
+    }
+    return rc;
+}
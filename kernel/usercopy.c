@@ -1,37 +1,168 @@
 #include "usercopy.h"
+#include "kerrno.h"
 #include "paging.h"
-#include "string.h"
+
+// VOS user address range (matches kernel/elf.c).
+#define USER_BASE  0x02000000u
+#define USER_LIMIT 0xC0000000u
+
+// Every instruction below that touches user memory has an __ex_table entry.
+// If it faults, the page-fault handler resumes at the entry's fixup label
+// with the registers as they were at the fault.
+//
+// A range check is enough because a user address space maps only user pages
+// inside [USER_BASE, USER_LIMIT): page tables and other kernel memory stay
+// below USER_BASE (see paging_alloc_table). Unmapped pages fault, and so do
+// writes to read-only ones since CR0.WP is set.
+typedef struct ex_entry {
+    uint32_t insn;
+    uint32_t fixup;
+} ex_entry_t;
+
+extern const ex_entry_t __ex_table_start[];
+extern const ex_entry_t __ex_table_end[];
+
+static bool user_range_ok(uint32_t addr, uint32_t len) {
+    uint32_t end = addr + len;
+    return end >= addr && addr >= USER_BASE && end <= USER_LIMIT && paging_in_user_space();
+}
+
+bool access_ok(const void* user, uint32_t len) {
+    return user_range_ok((uint32_t)user, len);
+}
+
+// Copy `n` bytes; returns how many were left uncopied (0 on success).
+static uint32_t copy_user_raw(void* dst, const void* src, uint32_t n) {
+    uint32_t d0, d1, d2;
+    __asm__ volatile (
+        "   movl %%ecx, %%edx\n"
+        "   shrl $2, %%ecx\n"
+        "   andl $3, %%edx\n"
+        "1: rep movsl\n"
+        "   movl %%edx, %%ecx\n"
+        "2: rep movsb\n"
+        "   jmp 4f\n"
+        "3: leal (%%edx,%%ecx,4), %%ecx\n"
+        "4:\n"
+        ".section __ex_table,\"a\"\n"
+        "   .balign 4\n"
+        "   .long 1b, 3b\n"
+        "   .long 2b, 4b\n"
+        ".previous\n"
+        : "=&c"(n), "=&D"(d0), "=&S"(d1), "=&d"(d2)
+        : "0"(n), "1"(dst), "2"(src)
+        : "memory");
+    return n;
+}
 
 bool copy_from_user(void* dst, const void* src_user, uint32_t len) {
     if (len == 0) {
         return true;
     }
-    if (!dst || !src_user) {
+    if (!dst || !user_range_ok((uint32_t)src_user, len)) {
         return false;
     }
-
-    uint32_t addr = (uint32_t)src_user;
-    if (!paging_user_accessible_range(addr, len, false)) {
-        return false;
-    }
-
-    memcpy(dst, (const void*)addr, len);
-    return true;
+    return copy_user_raw(dst, src_user, len) == 0;
 }
 
 bool copy_to_user(void* dst_user, const void* src, uint32_t len) {
     if (len == 0) {
         return true;
     }
-    if (!dst_user || !src) {
+    if (!src || !user_range_ok((uint32_t)dst_user, len)) {
         return false;
     }
+    return copy_user_raw(dst_user, src, len) == 0;
+}
 
-    uint32_t addr = (uint32_t)dst_user;
-    if (!paging_user_accessible_range(addr, len, true)) {
-        return false;
+int32_t strncpy_from_user(char* dst, const char* src_user, uint32_t cap) {
+    if (!dst || cap == 0) {
+        return -EINVAL;
     }
+    uint32_t addr = (uint32_t)src_user;
+    if (!user_range_ok(addr, 1u)) {
+        return -EFAULT;
+    }
+    // Never read past the end of user space, even for a large `cap`.
+    uint32_t n = cap > USER_LIMIT - addr ? USER_LIMIT - addr : cap;
+    bool clipped = n < cap;
+
+    uint32_t left, d0, d1, d2;
+    uint32_t faulted = 0;
+    __asm__ volatile (
+        "1: lodsb\n"
+        "   stosb\n"
+        "   testb %%al, %%al\n"
+        "   jz 3f\n"
+        "   decl %%ecx\n"
+        "   jnz 1b\n"
+        "   jmp 3f\n"
+        "2: movl $1, %%edx\n"
+        "3:\n"
+        ".section __ex_table,\"a\"\n"
+        "   .balign 4\n"
+        "   .long 1b, 2b\n"
+        ".previous\n"
+        : "=&c"(left), "=&S"(d0), "=&D"(d1), "=&a"(d2), "=&d"(faulted)
+        : "0"(n), "1"(src_user), "2"(dst), "4"(0u)
+        : "memory");
+
+    if (faulted) {
+        return -EFAULT;
+    }
+    if (left == 0) {
+        // No terminator within `n` bytes.
+        dst[n - 1u] = '\0';
+        return clipped ? -EFAULT : -ENAMETOOLONG;
+    }
+    return (int32_t)(n - left);
+}
+
+int32_t strnlen_user(const char* src_user, uint32_t cap) {
+    if (cap == 0) {
+        return -EINVAL;
+    }
+    uint32_t addr = (uint32_t)src_user;
+    if (!user_range_ok(addr, 1u)) {
+        return -EFAULT;
+    }
+    uint32_t n = cap > USER_LIMIT - addr ? USER_LIMIT - addr : cap;
+    bool clipped = n < cap;
+
+    uint32_t left, d0, d1;
+    uint32_t faulted = 0;
+    __asm__ volatile (
+        "1: lodsb\n"
+        "   testb %%al, %%al\n"
+        "   jz 3f\n"
+        "   decl %%ecx\n"
+        "   jnz 1b\n"
+        "   jmp 3f\n"
+        "2: movl $1, %%edx\n"
+        "3:\n"
+        ".section __ex_table,\"a\"\n"
+        "   .balign 4\n"
+        "   .long 1b, 2b\n"
+        ".previous\n"
+        : "=&c"(left), "=&S"(d0), "=&a"(d1), "=&d"(faulted)
+        : "0"(n), "1"(src_user), "3"(0u)
+        : "memory");
+
+    if (faulted) {
+        return -EFAULT;
+    }
+    if (left == 0) {
+        return clipped ? -EFAULT : -ENAMETOOLONG;
+    }
+    return (int32_t)(n - left);
+}
 
-    memcpy((void*)addr, src, len);
-    return true;
+bool usercopy_fixup(interrupt_frame_t* frame) {
+    for (const ex_entry_t* e = __ex_table_start; e < __ex_table_end; e++) {
+        if (e->insn == frame->eip) {
+            frame->eip = e->fixup;
+            return true;
+        }
+    }
+    return false;
 }
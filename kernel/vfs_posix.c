@@ -1,9 +1,12 @@
 #include "vfs.h"
 
+#include "bcache.h"
 #include "ctype.h"
+#include "dcache.h"
 #include "kerrno.h"
 #include "kheap.h"
 #include "minixfs.h"
+#include "pagecache.h"
 #include "paging.h"
 #include "pmm.h"
 #include "ramfs.h"
@@ -97,8 +100,12 @@ struct vfs_handle {
     uint32_t off;
     uint32_t refcount;
     char abs_path[VFS_PATH_MAX];
+    uint32_t ino;           // minixfs inode, else 0
+    uint32_t gen;           // minixfs_generation(ino) when the handle was opened
 
-    // File state.
+    // File state. minixfs files go through the page cache; the others are
+    // held whole in memory.
+    pagecache_inode_t* pc;
     const uint8_t* ro_data; // not owned (initramfs/rom)
     uint8_t* buf;           // owned (copy-on-write / writable backends)
     uint32_t size;
@@ -112,6 +119,8 @@ struct vfs_handle {
 };
 
 static void abs_dirname(const char* abs, char out[VFS_PATH_MAX]);
+static int32_t open_dir_handle(vfs_backend_t backend, const char* abs_path, uint32_t ino, uint32_t flags, vfs_handle_t** out);
+static int32_t open_minix_file(const char* abs_path, uint32_t ino, uint32_t flags, vfs_handle_t** out);
 
 static bool ci_eq(const char* a, const char* b) {
     if (!a || !b) {
@@ -181,6 +190,7 @@ bool vfs_pivot_root(void) {
         return false;
     }
     g_root_pivoted = true;
+    dcache_invalidate_all();
     return true;
 }
 
@@ -740,10 +750,25 @@ enum {
     VFS_SYMLINK_MAX_DEPTH = 8,
 };
 
-static int32_t vfs_lstat_abs(const char* abs_path, vfs_stat_t* out) {
-    if (!abs_path || abs_path[0] != '/' || !out) {
-        return -EINVAL;
-    }
+static void minix_stat_to_vfs(const minixfs_stat_t* mst, vfs_stat_t* out) {
+    out->is_dir = MINIX_S_ISDIR(mst->mode) ? 1u : 0u;
+    out->is_symlink = MINIX_S_ISLNK(mst->mode) ? 1u : 0u;
+    out->size = mst->size;
+    out->mode = (uint16_t)(mst->mode & 07777u);
+    out->uid = mst->uid;
+    out->gid = mst->gid;
+    unix_to_fat_ts(mst->mtime, &out->wtime, &out->wdate);
+}
+
+// Ask the backend. *out_fs is set even when the path does not exist, and
+// *out_node is the minixfs inode number.
+static int32_t vfs_lstat_abs_uncached(const char* abs_path, vfs_stat_t* out, uint8_t* out_fs, uint32_t* out_node) {
+    uint8_t fs_dummy;
+    uint32_t node_dummy;
+    if (!out_fs) out_fs = &fs_dummy;
+    if (!out_node) out_node = &node_dummy;
+    *out_fs = DCACHE_FS_INITRAMFS;
+    *out_node = 0;
     memset(out, 0, sizeof(*out));
 
     // After pivot_root: /initramfs/* goes to old initramfs
@@ -767,17 +792,13 @@ static int32_t vfs_lstat_abs(const char* abs_path, vfs_stat_t* out) {
         if (!minixfs_is_ready()) {
             return -EIO;
         }
+        *out_fs = DCACHE_FS_MINIXFS;
         minixfs_stat_t mst;
         if (!minixfs_stat(abs_path, &mst)) {
             return -ENOENT;
         }
-        out->is_dir = MINIX_S_ISDIR(mst.mode) ? 1u : 0u;
-        out->is_symlink = MINIX_S_ISLNK(mst.mode) ? 1u : 0u;
-        out->size = mst.size;
-        out->mode = (uint16_t)(mst.mode & 07777u);
-        out->uid = mst.uid;
-        out->gid = mst.gid;
-        unix_to_fat_ts(mst.mtime, &out->wtime, &out->wdate);
+        *out_node = mst.ino;
+        minix_stat_to_vfs(&mst, out);
         return 0;
     }
 
@@ -788,21 +809,18 @@ static int32_t vfs_lstat_abs(const char* abs_path, vfs_stat_t* out) {
         }
         const char* rel = abs_path + 5;  // skip "/disk"
         if (*rel == '\0') rel = "/";
+        *out_fs = DCACHE_FS_MINIXFS;
         minixfs_stat_t mst;
         if (!minixfs_stat(rel, &mst)) {
             return -ENOENT;
         }
-        out->is_dir = MINIX_S_ISDIR(mst.mode) ? 1u : 0u;
-        out->is_symlink = MINIX_S_ISLNK(mst.mode) ? 1u : 0u;
-        out->size = mst.size;
-        out->mode = (uint16_t)(mst.mode & 07777u);
-        out->uid = mst.uid;
-        out->gid = mst.gid;
-        unix_to_fat_ts(mst.mtime, &out->wtime, &out->wdate);
+        *out_node = mst.ino;
+        minix_stat_to_vfs(&mst, out);
         return 0;
     }
 
     if (abs_is_mount(abs_path, "/ram")) {
+        *out_fs = DCACHE_FS_RAMFS;
         bool is_dir = false;
         uint32_t size = 0;
         uint16_t wtime = 0;
@@ -835,6 +853,112 @@ static int32_t vfs_lstat_abs(const char* abs_path, vfs_stat_t* out) {
     return initramfs_stat_abs(abs_path, out);
 }
 
+static int32_t dentry_fill(dentry_t* d, const char* abs_path) {
+    vfs_stat_t st;
+    uint8_t fs = DCACHE_FS_INITRAMFS;
+    uint32_t node = 0;
+    int32_t rc = vfs_lstat_abs_uncached(abs_path, &st, &fs, &node);
+    if (rc == 0) {
+        dcache_set_positive(d, fs, node, st.is_dir != 0, st.is_symlink != 0);
+    } else if (rc == -ENOENT) {
+        dcache_set_negative(d, fs);
+    }
+    return rc;  // other errors (-EIO) are not cached
+}
+
+// Walk `abs_path` through the dentry cache, asking the backends only for
+// components that are not cached. *out is NULL when the cache cannot hold
+// the path (long names, every entry busy); the caller then goes to the
+// backend itself.
+static int32_t vfs_dentry_lookup(const char* abs_path, dentry_t** out) {
+    *out = NULL;
+    dentry_t* d = dcache_root();
+    if (!dcache_valid(d)) {
+        int32_t rc = dentry_fill(d, "/");
+        if (rc < 0 && rc != -ENOENT) {
+            return rc;
+        }
+    }
+
+    char prefix[VFS_PATH_MAX];
+    uint32_t i = 1;
+    while (abs_path[i] != '\0') {
+        if (d->state == DENTRY_NEGATIVE) {
+            return -ENOENT;
+        }
+        uint32_t start = i;
+        while (abs_path[i] != '\0' && abs_path[i] != '/') {
+            i++;
+        }
+        uint32_t len = i - start;
+        if (len != 0) {
+            d = dcache_child(d, abs_path + start, len);
+            if (!d || i >= sizeof(prefix)) {
+                return 0;
+            }
+            if (!dcache_valid(d)) {
+                memcpy(prefix, abs_path, i);
+                prefix[i] = '\0';
+                int32_t rc = dentry_fill(d, prefix);
+                if (rc < 0 && rc != -ENOENT) {
+                    return rc;
+                }
+            }
+        }
+        if (abs_path[i] == '/') {
+            i++;
+        }
+    }
+
+    if (d->state == DENTRY_NEGATIVE) {
+        return -ENOENT;
+    }
+    *out = d;
+    return 0;
+}
+
+static int32_t vfs_lstat_abs(const char* abs_path, vfs_stat_t* out) {
+    if (!abs_path || abs_path[0] != '/' || !out) {
+        return -EINVAL;
+    }
+    memset(out, 0, sizeof(*out));
+
+    dentry_t* d = NULL;
+    int32_t rc = vfs_dentry_lookup(abs_path, &d);
+    if (rc < 0) {
+        return rc;
+    }
+    // A cached minixfs entry skips the directory scans; the attributes still
+    // come from the inode. ramfs and initramfs lookups are in memory.
+    if (d && d->fs == DCACHE_FS_MINIXFS && d->node != 0) {
+        minixfs_stat_t mst;
+        if (!minixfs_stat_ino(d->node, &mst)) {
+            return -EIO;
+        }
+        minix_stat_to_vfs(&mst, out);
+        return 0;
+    }
+    return vfs_lstat_abs_uncached(abs_path, out, NULL, NULL);
+}
+
+// Existence and type only, which is all that symlink resolution needs.
+static int32_t vfs_lstat_is_symlink(const char* abs_path, bool* out_is_symlink) {
+    *out_is_symlink = false;
+    dentry_t* d = NULL;
+    int32_t rc = vfs_dentry_lookup(abs_path, &d);
+    if (rc < 0) {
+        return rc;
+    }
+    if (d) {
+        *out_is_symlink = d->is_symlink;
+        return 0;
+    }
+    vfs_stat_t st;
+    rc = vfs_lstat_abs_uncached(abs_path, &st, NULL, NULL);
+    *out_is_symlink = rc == 0 && st.is_symlink;
+    return rc;
+}
+
 static int32_t vfs_readlink_abs(const char* abs_path, char* out, uint32_t cap, uint32_t* out_len) {
     if (out_len) {
         *out_len = 0;
@@ -1005,13 +1129,13 @@ static int32_t vfs_resolve_symlinks_abs(const char* abs_in, bool follow_final, c
                 continue;
             }
 
-            vfs_stat_t st;
-            int32_t rc = vfs_lstat_abs(prefix, &st);
+            bool is_symlink = false;
+            int32_t rc = vfs_lstat_is_symlink(prefix, &is_symlink);
             if (rc < 0) {
                 return rc;
             }
 
-            if (st.is_symlink && (follow_final || !last)) {
+            if (is_symlink && (follow_final || !last)) {
                 char target[VFS_PATH_MAX];
                 uint32_t target_len = 0;
                 rc = vfs_readlink_abs(prefix, target, sizeof(target) - 1u, &target_len);
@@ -1121,6 +1245,379 @@ static int32_t vfs_prepare_create_path(const char* cwd, const char* path, char o
     return 0;
 }
 
+// Where an *_at() walk through minixfs ended: entry `name` of directory
+// inode `dir`, with `ino` its inode or 0 if there is no such entry. When
+// the walk leaves minixfs (".." above /disk, a mount or alias at the
+// pivoted root, an absolute symlink), `dir` is 0 and the path-based calls
+// finish the job from absolute path `abs`.
+typedef struct {
+    uint32_t dir;
+    uint32_t ino;
+    char name[VFS_NAME_MAX];
+    char abs[VFS_PATH_MAX];
+} at_walk_t;
+
+static bool at_name_is_dot(const char* name) {
+    return strcmp(name, ".") == 0 || strcmp(name, "..") == 0;
+}
+
+// With the root pivoted, names at the minixfs root that the VFS sends
+// elsewhere: /ram, /initramfs and the /disk, /tmp and /etc aliases.
+static bool at_root_name_redirected(const char* name) {
+    char abs[VFS_PATH_MAX];
+    char tmp[VFS_PATH_MAX];
+    abs[0] = '/';
+    strncpy(abs + 1, name, sizeof(abs) - 2u);
+    abs[sizeof(abs) - 1u] = '\0';
+    return abs_apply_posix_aliases(abs, tmp) != abs ||
+           abs_is_mount(abs, "/ram") || abs_is_mount(abs, "/initramfs");
+}
+
+// Walk relative `path` from minixfs directory inode `start` one entry at a
+// time. Symlinks other than a final one that is not followed are expanded
+// in place; relative targets continue from the directory holding the link.
+static int32_t at_walk(uint32_t start, const char* path, bool follow_final, at_walk_t* w) {
+    char buf[VFS_PATH_MAX];
+    if (strlen(path) >= sizeof(buf)) {
+        return -ENAMETOOLONG;
+    }
+    strncpy(buf, path, sizeof(buf) - 1u);
+    buf[sizeof(buf) - 1u] = '\0';
+
+    const char* p = buf;
+    while (*p == '/') {
+        p++;
+    }
+    if (*p == '\0') {
+        return -ENOENT;
+    }
+
+    uint32_t cur = start;
+    uint32_t links = 0;
+    for (;;) {
+        const char* end = p;
+        while (*end != '\0' && *end != '/') {
+            end++;
+        }
+        const char* rest = end;
+        while (*rest == '/') {
+            rest++;
+        }
+        bool last = *rest == '\0';
+
+        uint32_t len = (uint32_t)(end - p);
+        if (len >= VFS_NAME_MAX) {
+            return -ENAMETOOLONG;
+        }
+        memcpy(w->name, p, len);
+        w->name[len] = '\0';
+
+        if (cur == MINIX_ROOT_INO) {
+            // Before pivot_root the minixfs root is /disk, whose parent is "/".
+            if (!g_root_pivoted && strcmp(w->name, "..") == 0) {
+                w->dir = 0;
+                return vfs_path_resolve("/", last ? "/" : rest, w->abs);
+            }
+            if (g_root_pivoted && at_root_name_redirected(w->name)) {
+                w->dir = 0;
+                return vfs_path_resolve("/", p, w->abs);
+            }
+        }
+
+        w->dir = cur;
+        w->ino = minixfs_lookup_at(cur, w->name);
+        if (w->ino == 0) {
+            return last ? 0 : -ENOENT;
+        }
+        minixfs_stat_t st;
+        if (!minixfs_stat_ino(w->ino, &st)) {
+            return -EIO;
+        }
+
+        if (MINIX_S_ISLNK(st.mode) && (follow_final || !last)) {
+            if (++links > VFS_SYMLINK_MAX_DEPTH) {
+                return -ELOOP;
+            }
+            // next = target "/" rest
+            char next[VFS_PATH_MAX];
+            uint32_t rlen = (uint32_t)strlen(rest);
+            if (st.size == 0) {
+                return -ENOENT;
+            }
+            if (st.size + 1u + rlen >= sizeof(next)) {
+                return -ENAMETOOLONG;
+            }
+            if (minixfs_pread(w->ino, 0, (uint8_t*)next, st.size) != (int32_t)st.size) {
+                return -EIO;
+            }
+            next[st.size] = '/';
+            memcpy(next + st.size + 1u, rest, rlen + 1u);
+            if (next[0] == '/') {
+                w->dir = 0;
+                return vfs_path_resolve("/", next, w->abs);
+            }
+            memcpy(buf, next, st.size + 1u + rlen + 1u);
+            p = buf;
+            continue;
+        }
+
+        if (last) {
+            return 0;
+        }
+        if (!MINIX_S_ISDIR(st.mode)) {
+            return -ENOTDIR;
+        }
+        cur = w->ino;
+        p = rest;
+    }
+}
+
+// Start an *_at() lookup. Absolute paths, lookups from the cwd and
+// directories on ramfs and initramfs, which name nodes only by path, end
+// in an absolute path. A minixfs directory is walked from the inode its
+// handle holds, and gives -ENOENT once it was removed, even if the inode
+// number is in use again.
+static int32_t at_start(const char* cwd, vfs_handle_t* dir, const char* path, bool follow_final, at_walk_t* w) {
+    w->dir = 0;
+    w->ino = 0;
+    if (!path) {
+        return -EINVAL;
+    }
+    if (!dir || path[0] == '/') {
+        return vfs_path_resolve(cwd, path, w->abs);
+    }
+    if (dir->kind != VFS_HANDLE_DIR) {
+        return -ENOTDIR;
+    }
+    if (dir->backend != VFS_BACKEND_MINIXFS) {
+        return vfs_path_resolve(dir->abs_path, path, w->abs);
+    }
+    if (!minixfs_is_ready()) {
+        return -EIO;
+    }
+    minixfs_stat_t st;
+    if (minixfs_generation(dir->ino) != dir->gen || !minixfs_stat_ino(dir->ino, &st) ||
+        st.nlinks == 0 || !MINIX_S_ISDIR(st.mode)) {
+        return -ENOENT;
+    }
+    return at_walk(dir->ino, path, follow_final, w);
+}
+
+// Turn a walk that ended in a path into an entry of a minixfs directory,
+// for renames between a minixfs handle and a path. -EXDEV off minixfs.
+static int32_t at_walk_to_minix(at_walk_t* w) {
+    char eff[VFS_PATH_MAX];
+    int32_t rc = vfs_prepare_create_path("/", w->abs, eff);
+    if (rc < 0) {
+        return rc;
+    }
+    const char* rel = eff;
+    if (abs_is_mount(eff, "/disk")) {
+        rel = eff + 5;  // skip "/disk"
+    } else if (!g_root_pivoted || abs_is_mount(eff, "/ram") || abs_is_mount(eff, "/initramfs")) {
+        return -EXDEV;
+    }
+
+    const char* base = strrchr(rel, '/');
+    base = base ? base + 1 : rel;
+    if (base[0] == '\0') {
+        return -EPERM;  // the minixfs root itself
+    }
+    if (strlen(base) >= VFS_NAME_MAX) {
+        return -ENAMETOOLONG;
+    }
+    char parent[VFS_PATH_MAX];
+    abs_dirname(rel, parent);
+    w->dir = minixfs_lookup(parent);
+    if (w->dir == 0) {
+        return -ENOENT;
+    }
+    strncpy(w->name, base, VFS_NAME_MAX - 1u);
+    w->name[VFS_NAME_MAX - 1u] = '\0';
+    w->ino = minixfs_lookup_at(w->dir, w->name);
+    return 0;
+}
+
+int32_t vfs_open_at(const char* cwd, vfs_handle_t* dir, const char* path, uint32_t flags, vfs_handle_t** out) {
+    if (!out) {
+        return -EINVAL;
+    }
+    bool excl = (flags & VFS_O_CREAT) && (flags & VFS_O_EXCL);
+    at_walk_t w;
+    int32_t rc = at_start(cwd, dir, path, !excl, &w);
+    if (rc < 0) {
+        return rc;
+    }
+    if (w.dir == 0) {
+        return vfs_open_path("/", w.abs, flags, out);
+    }
+
+    uint32_t acc = flags & VFS_O_ACCMODE;
+    bool want_write = (acc == VFS_O_WRONLY || acc == VFS_O_RDWR);
+    bool want_dir = (flags & VFS_O_DIRECTORY) != 0;
+
+    // The handle's path only names it; minixfs handles work on the inode.
+    char abs[VFS_PATH_MAX];
+    rc = vfs_path_resolve(dir->abs_path, path, abs);
+    if (rc < 0) {
+        return rc;
+    }
+
+    uint32_t ino = w.ino;
+    if (ino != 0) {
+        if (excl) {
+            return -EEXIST;
+        }
+        minixfs_stat_t st;
+        if (!minixfs_stat_ino(ino, &st)) {
+            return -EIO;
+        }
+        if (MINIX_S_ISDIR(st.mode)) {
+            if (want_write) {
+                return -EISDIR;
+            }
+            return open_dir_handle(VFS_BACKEND_MINIXFS, abs, ino, flags, out);
+        }
+        if (want_dir) {
+            return -ENOTDIR;
+        }
+        if (!MINIX_S_ISREG(st.mode)) {
+            return -ENOENT;
+        }
+    } else {
+        if (want_dir || (flags & VFS_O_CREAT) == 0) {
+            return -ENOENT;
+        }
+        ino = minixfs_create_at(w.dir, w.name);
+        if (ino == 0) {
+            return -EIO;
+        }
+    }
+    return open_minix_file(abs, ino, flags, out);
+}
+
+int32_t vfs_stat_at(const char* cwd, vfs_handle_t* dir, const char* path, bool follow, vfs_stat_t* out) {
+    if (!out) {
+        return -EINVAL;
+    }
+    at_walk_t w;
+    int32_t rc = at_start(cwd, dir, path, follow, &w);
+    if (rc < 0) {
+        return rc;
+    }
+    if (w.dir == 0) {
+        return follow ? vfs_stat_path("/", w.abs, out) : vfs_lstat_path("/", w.abs, out);
+    }
+    if (w.ino == 0) {
+        return -ENOENT;
+    }
+    minixfs_stat_t mst;
+    if (!minixfs_stat_ino(w.ino, &mst)) {
+        return -EIO;
+    }
+    memset(out, 0, sizeof(*out));
+    minix_stat_to_vfs(&mst, out);
+    return 0;
+}
+
+int32_t vfs_mkdir_at(const char* cwd, vfs_handle_t* dir, const char* path) {
+    at_walk_t w;
+    int32_t rc = at_start(cwd, dir, path, false, &w);
+    if (rc < 0) {
+        return rc;
+    }
+    if (w.dir == 0) {
+        return vfs_mkdir_path("/", w.abs);
+    }
+    if (w.ino != 0) {
+        return -EEXIST;
+    }
+    if (!minixfs_mkdir_at(w.dir, w.name)) {
+        return -EIO;
+    }
+    return 0;
+}
+
+int32_t vfs_unlink_at(const char* cwd, vfs_handle_t* dir, const char* path, bool rmdir) {
+    at_walk_t w;
+    int32_t rc = at_start(cwd, dir, path, false, &w);
+    if (rc < 0) {
+        return rc;
+    }
+    if (w.dir == 0) {
+        return rmdir ? vfs_rmdir_path("/", w.abs) : vfs_unlink_path("/", w.abs);
+    }
+    if (w.ino == 0) {
+        return -ENOENT;
+    }
+    if (at_name_is_dot(w.name)) {
+        return rmdir ? -EINVAL : -EISDIR;
+    }
+    minixfs_stat_t st;
+    if (!minixfs_stat_ino(w.ino, &st)) {
+        return -EIO;
+    }
+
+    if (rmdir) {
+        if (!MINIX_S_ISDIR(st.mode)) {
+            return -ENOTDIR;
+        }
+        if (!minixfs_rmdir_at(w.dir, w.name)) {
+            return -EIO;
+        }
+        return 0;
+    }
+
+    if (MINIX_S_ISDIR(st.mode)) {
+        return -EISDIR;
+    }
+    if (!minixfs_unlink_at(w.dir, w.name)) {
+        return -EIO;
+    }
+    if (st.nlinks <= 1u) {
+        pagecache_forget(w.ino);  // the inode is free now
+    }
+    return 0;
+}
+
+int32_t vfs_rename_at(const char* cwd, vfs_handle_t* old_dir, const char* old_path,
+                      vfs_handle_t* new_dir, const char* new_path) {
+    at_walk_t wo;
+    at_walk_t wn;
+    int32_t rc = at_start(cwd, old_dir, old_path, false, &wo);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = at_start(cwd, new_dir, new_path, false, &wn);
+    if (rc < 0) {
+        return rc;
+    }
+    if (wo.dir == 0 && wn.dir == 0) {
+        return vfs_rename_path("/", wo.abs, wn.abs);
+    }
+
+    // At least one side is on minixfs, so both must be.
+    if (wo.dir == 0 && (rc = at_walk_to_minix(&wo)) < 0) {
+        return rc;
+    }
+    if (wn.dir == 0 && (rc = at_walk_to_minix(&wn)) < 0) {
+        return rc;
+    }
+    if (wo.ino == 0) {
+        return -ENOENT;
+    }
+    if (at_name_is_dot(wo.name) || at_name_is_dot(wn.name)) {
+        return -EINVAL;
+    }
+    if (wn.ino != 0) {
+        return -EEXIST;
+    }
+    if (!minixfs_rename_at(wo.dir, wo.name, wn.dir, wn.name)) {
+        return -EIO;
+    }
+    return 0;
+}
+
 int32_t vfs_lstat_path(const char* cwd, const char* path, vfs_stat_t* out) {
     if (!out) {
         return -EINVAL;
@@ -1424,7 +1921,8 @@ static int32_t handle_alloc(vfs_handle_t** out) {
     return 0;
 }
 
-static int32_t open_dir_handle(vfs_backend_t backend, const char* abs_path, uint32_t flags, vfs_handle_t** out) {
+// `ino` is a minixfs directory's inode, or 0 to look it up from abs_path.
+static int32_t open_dir_handle(vfs_backend_t backend, const char* abs_path, uint32_t ino, uint32_t flags, vfs_handle_t** out) {
     (void)flags;
     vfs_handle_t* h = NULL;
     int32_t rc = handle_alloc(&h);
@@ -1448,13 +1946,18 @@ static int32_t open_dir_handle(vfs_backend_t backend, const char* abs_path, uint
             kfree(h);
             return -ENOMEM;
         }
-        // abs_path is like "/disk/foo", skip "/disk"
-        const char* rel = abs_path;
-        if (ci_starts_with(abs_path, "/disk")) {
-            rel = abs_path + 5;
-            if (*rel == '\0') rel = "/";
+        if (ino == 0) {
+            // abs_path is like "/disk/foo", skip "/disk"
+            const char* rel = abs_path;
+            if (ci_starts_with(abs_path, "/disk")) {
+                rel = abs_path + 5;
+                if (*rel == '\0') rel = "/";
+            }
+            ino = minixfs_lookup(rel);
         }
-        count = minixfs_readdir(rel, dents, VFS_MAX_DIR_ENTRIES);
+        h->ino = ino;
+        h->gen = minixfs_generation(ino);
+        count = minixfs_readdir_ino(ino, dents, VFS_MAX_DIR_ENTRIES);
         if (count > 0) {
             h->ents = (vfs_dirent_t*)kcalloc(count, sizeof(vfs_dirent_t));
             if (!h->ents) {
@@ -1466,24 +1969,8 @@ static int32_t open_dir_handle(vfs_backend_t backend, const char* abs_path, uint
                 strncpy(h->ents[i].name, dents[i].name, VFS_NAME_MAX - 1u);
                 h->ents[i].name[VFS_NAME_MAX - 1u] = '\0';
                 h->ents[i].is_dir = dents[i].is_dir ? 1u : 0u;
-                // Get full info via stat
-                char full_path[VFS_PATH_MAX];
-                if (rel[0] == '/' && rel[1] == '\0') {
-                    full_path[0] = '/';
-                    strncpy(full_path + 1, dents[i].name, VFS_PATH_MAX - 2);
-                    full_path[VFS_PATH_MAX - 1] = '\0';
-                } else {
-                    strncpy(full_path, rel, VFS_PATH_MAX - 1);
-                    full_path[VFS_PATH_MAX - 1] = '\0';
-                    size_t len = strlen(full_path);
-                    if (len + 2 < VFS_PATH_MAX) {
-                        full_path[len] = '/';
-                        strncpy(full_path + len + 1, dents[i].name, VFS_PATH_MAX - len - 2);
-                        full_path[VFS_PATH_MAX - 1] = '\0';
-                    }
-                }
                 minixfs_stat_t mst;
-                if (minixfs_stat(full_path, &mst)) {
+                if (minixfs_stat_ino(dents[i].inode, &mst)) {
                     h->ents[i].is_symlink = MINIX_S_ISLNK(mst.mode) ? 1u : 0u;
                     h->ents[i].mode = (uint16_t)(mst.mode & 07777u);
                     h->ents[i].size = mst.size;
@@ -1556,6 +2043,7 @@ static int32_t open_file_handle(vfs_backend_t backend, const char* abs_path, uin
     strncpy(h->abs_path, abs_path ? abs_path : "/", sizeof(h->abs_path) - 1u);
     h->abs_path[sizeof(h->abs_path) - 1u] = '\0';
 
+    h->pc = NULL;
     h->ro_data = data;
     h->buf = NULL;
     h->size = size;
@@ -1576,6 +2064,38 @@ static bool handle_writable(const vfs_handle_t* h) {
     return acc == VFS_O_WRONLY || acc == VFS_O_RDWR;
 }
 
+static uint32_t handle_size(const vfs_handle_t* h) {
+    return h->pc ? pagecache_size(h->pc) : h->size;
+}
+
+// Open existing minixfs regular file `ino` (0: missing) through the page cache.
+static int32_t open_minix_file(const char* abs_path, uint32_t ino, uint32_t flags, vfs_handle_t** out) {
+    if (ino == 0) {
+        return -ENOENT;
+    }
+    pagecache_inode_t* pc = pagecache_get(ino);
+    if (!pc) {
+        return -ENOMEM;
+    }
+
+    uint32_t acc = flags & VFS_O_ACCMODE;
+    int32_t rc = 0;
+    if ((flags & VFS_O_TRUNC) && (acc == VFS_O_WRONLY || acc == VFS_O_RDWR)) {
+        rc = pagecache_truncate(pc, 0);
+    }
+    if (rc == 0) {
+        rc = open_file_handle(VFS_BACKEND_MINIXFS, abs_path, flags, NULL, pagecache_size(pc), out);
+    }
+    if (rc < 0) {
+        (void)pagecache_put(pc);
+        return rc;
+    }
+    (*out)->pc = pc;
+    (*out)->ino = ino;
+    (*out)->gen = minixfs_generation(ino);
+    return 0;
+}
+
 static int32_t handle_ensure_buf(vfs_handle_t* h) {
     if (!h) {
         return -EINVAL;
@@ -1763,7 +2283,7 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
             int32_t stat_rc = initramfs_stat_abs(rel, &st);
             if (stat_rc < 0) return stat_rc;
             if (want_dir && !st.is_dir) return -ENOTDIR;
-            if (st.is_dir) return open_dir_handle(VFS_BACKEND_INITRAMFS, eff, flags, out);
+            if (st.is_dir) return open_dir_handle(VFS_BACKEND_INITRAMFS, eff, 0, flags, out);
 
             const uint8_t* data = NULL;
             uint32_t size = 0;
@@ -1783,32 +2303,16 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
                 if (want_dir && !is_dir) return -ENOTDIR;
                 if (is_dir) {
                     if (want_write) return -EISDIR;
-                    return open_dir_handle(VFS_BACKEND_MINIXFS, eff, flags, out);
+                    return open_dir_handle(VFS_BACKEND_MINIXFS, eff, 0, flags, out);
                 }
                 if ((flags & VFS_O_CREAT) && (flags & VFS_O_EXCL)) return -EEXIST;
-                if (want_write && (flags & VFS_O_TRUNC)) {
-                    if (!minixfs_write_file(eff, NULL, 0)) return -EIO;
-                }
             } else {
                 if (want_dir) return -ENOENT;
                 if ((flags & VFS_O_CREAT) == 0) return -ENOENT;
                 if (!minixfs_write_file(eff, NULL, 0)) return -EIO;
             }
 
-            uint8_t* data = NULL;
-            uint32_t size = 0;
-            if ((flags & VFS_O_TRUNC) == 0) {
-                data = minixfs_read_file(eff, &size);
-            }
-            rc = open_file_handle(VFS_BACKEND_MINIXFS, eff, flags, data, size, out);
-            if (rc < 0) {
-                if (data) kfree(data);
-                return rc;
-            }
-            (*out)->buf = data;
-            (*out)->cap = size;
-            (*out)->ro_data = (*out)->buf;
-            return 0;
+            return open_minix_file(eff, minixfs_lookup(eff), flags, out);
         }
     }
 
@@ -1831,16 +2335,11 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
                 if (want_write) {
                     return -EISDIR;
                 }
-                return open_dir_handle(VFS_BACKEND_MINIXFS, eff, flags, out);
+                return open_dir_handle(VFS_BACKEND_MINIXFS, eff, 0, flags, out);
             }
             if ((flags & VFS_O_CREAT) && (flags & VFS_O_EXCL)) {
                 return -EEXIST;
             }
-            if (want_write && (flags & VFS_O_TRUNC)) {
-                if (!minixfs_write_file(rel, NULL, 0)) {
-                    return -EIO;
-                }
-            }
         } else {
             if (want_dir) {
                 return -ENOENT;
@@ -1854,22 +2353,7 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
             }
         }
 
-        uint8_t* data = NULL;
-        uint32_t size = 0;
-        if ((flags & VFS_O_TRUNC) == 0) {
-            data = minixfs_read_file(rel, &size);
-            // data may be NULL for empty files
-        }
-
-        rc = open_file_handle(VFS_BACKEND_MINIXFS, eff, flags, data, size, out);
-        if (rc < 0) {
-            if (data) kfree(data);
-            return rc;
-        }
-        (*out)->buf = data;
-        (*out)->cap = size;
-        (*out)->ro_data = (*out)->buf;
-        return 0;
+        return open_minix_file(eff, minixfs_lookup(rel), flags, out);
     }
 
     // /ram
@@ -1885,7 +2369,7 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
                 if (want_write) {
                     return -EISDIR;
                 }
-                return open_dir_handle(VFS_BACKEND_RAMFS, eff, flags, out);
+                return open_dir_handle(VFS_BACKEND_RAMFS, eff, 0, flags, out);
             }
             if ((flags & VFS_O_CREAT) && (flags & VFS_O_EXCL)) {
                 return -EEXIST;
@@ -1930,7 +2414,7 @@ int32_t vfs_open_path(const char* cwd, const char* path, uint32_t flags, vfs_han
         return -ENOTDIR;
     }
     if (st.is_dir) {
-        return open_dir_handle(VFS_BACKEND_INITRAMFS, eff, flags, out);
+        return open_dir_handle(VFS_BACKEND_INITRAMFS, eff, 0, flags, out);
     }
 
     const uint8_t* data = NULL;
@@ -1963,15 +2447,11 @@ int32_t vfs_close(vfs_handle_t* h) {
     }
 
     int32_t rc = 0;
-    if (h->kind == VFS_HANDLE_FILE && h->dirty && handle_writable(h)) {
-        if (h->backend == VFS_BACKEND_MINIXFS) {
-            // h->abs_path is "/disk/...", extract relative path
-            const char* rel = h->abs_path + 5;
-            if (*rel == '\0') rel = "/";
-            if (!minixfs_write_file(rel, h->buf, h->size)) {
-                rc = -EIO;
-            }
-        } else if (h->backend == VFS_BACKEND_RAMFS) {
+    if (h->pc) {
+        rc = pagecache_put(h->pc);
+        h->pc = NULL;
+    } else if (h->kind == VFS_HANDLE_FILE && h->dirty && handle_writable(h)) {
+        if (h->backend == VFS_BACKEND_RAMFS) {
             if (!ramfs_write_file(h->abs_path, h->buf, h->size, true)) {
                 rc = -EIO;
             }
@@ -1992,7 +2472,8 @@ int32_t vfs_close(vfs_handle_t* h) {
     return rc;
 }
 
-int32_t vfs_read(vfs_handle_t* h, void* dst, uint32_t len, uint32_t* out_read) {
+// Read/write at `off` without touching the handle position.
+static int32_t handle_read_at(vfs_handle_t* h, void* dst, uint32_t len, uint32_t off, uint32_t* out_read) {
     if (out_read) {
         *out_read = 0;
     }
@@ -2002,12 +2483,10 @@ int32_t vfs_read(vfs_handle_t* h, void* dst, uint32_t len, uint32_t* out_read) {
     if (h->kind != VFS_HANDLE_FILE) {
         return -EISDIR;
     }
-    if (len == 0) {
-        return 0;
+    if (h->pc) {
+        return pagecache_read(h->pc, off, dst, len, out_read);
     }
-
-    uint32_t off = h->off;
-    if (off >= h->size) {
+    if (len == 0 || off >= h->size) {
         return 0;
     }
 
@@ -2023,14 +2502,13 @@ int32_t vfs_read(vfs_handle_t* h, void* dst, uint32_t len, uint32_t* out_read) {
     }
 
     memcpy(dst, src + off, n);
-    h->off = off + n;
     if (out_read) {
         *out_read = n;
     }
     return 0;
 }
 
-int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_written) {
+static int32_t handle_write_at(vfs_handle_t* h, const void* src, uint32_t len, uint32_t off, uint32_t* out_written) {
     if (out_written) {
         *out_written = 0;
     }
@@ -2049,9 +2527,8 @@ int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_
     if (len == 0) {
         return 0;
     }
-
-    if ((h->flags & VFS_O_APPEND) != 0) {
-        h->off = h->size;
+    if (h->pc) {
+        return pagecache_write(h->pc, off, src, len, out_written);
     }
 
     int32_t rc = handle_ensure_buf(h);
@@ -2059,7 +2536,6 @@ int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_
         return rc;
     }
 
-    uint32_t off = h->off;
     uint32_t end = off + len;
     if (end < off) {
         return -EOVERFLOW;
@@ -2076,7 +2552,6 @@ int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_
     }
 
     memcpy(h->buf + off, src, len);
-    h->off = off + len;
     if (end > h->size) {
         h->size = end;
     }
@@ -2087,6 +2562,75 @@ int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_
     return 0;
 }
 
+int32_t vfs_read(vfs_handle_t* h, void* dst, uint32_t len, uint32_t* out_read) {
+    uint32_t n = 0;
+    int32_t rc = handle_read_at(h, dst, len, h ? h->off : 0, &n);
+    if (rc == 0) {
+        h->off += n;
+    }
+    if (out_read) {
+        *out_read = n;
+    }
+    return rc;
+}
+
+int32_t vfs_write(vfs_handle_t* h, const void* src, uint32_t len, uint32_t* out_written) {
+    if (h && len != 0 && (h->flags & VFS_O_APPEND) != 0) {
+        h->off = handle_size(h);
+    }
+    uint32_t n = 0;
+    int32_t rc = handle_write_at(h, src, len, h ? h->off : 0, &n);
+    if (rc == 0) {
+        h->off += n;
+    }
+    if (out_written) {
+        *out_written = n;
+    }
+    return rc;
+}
+
+int32_t vfs_pread(vfs_handle_t* h, void* dst, uint32_t len, uint32_t off, uint32_t* out_read) {
+    return handle_read_at(h, dst, len, off, out_read);
+}
+
+int32_t vfs_pwrite(vfs_handle_t* h, const void* src, uint32_t len, uint32_t off, uint32_t* out_written) {
+    return handle_write_at(h, src, len, off, out_written);
+}
+
+int32_t vfs_peek(vfs_handle_t* h, uint32_t off, const uint8_t** out_data, uint32_t* out_len) {
+    if (out_data) {
+        *out_data = NULL;
+    }
+    if (out_len) {
+        *out_len = 0;
+    }
+    if (!h || !out_data || !out_len) {
+        return -EINVAL;
+    }
+    if (h->kind != VFS_HANDLE_FILE) {
+        return -EISDIR;
+    }
+    if (h->pc) {
+        return pagecache_peek(h->pc, off, out_data, out_len);
+    }
+    if (off >= h->size) {
+        return 0;
+    }
+    const uint8_t* src = h->ro_data ? h->ro_data : h->buf;
+    if (!src) {
+        return -EIO;
+    }
+    *out_data = src + off;
+    *out_len = h->size - off;
+    return 0;
+}
+
+void vfs_peek_done(vfs_handle_t* h, uint32_t off) {
+    if (h && h->kind == VFS_HANDLE_FILE && h->pc) {
+        pagecache_unpin(h->pc, off);
+    }
+}
+
 int32_t vfs_lseek(vfs_handle_t* h, int32_t offset, int32_t whence, uint32_t* out_new_off) {
     if (out_new_off) {
         *out_new_off = 0;
@@ -2094,17 +2638,17 @@ int32_t vfs_lseek(vfs_handle_t* h, int32_t offset, int32_t whence, uint32_t* out
     if (!h) {
         return -EINVAL;
     }
-    if (h->kind != VFS_HANDLE_FILE) {
-        return -ESPIPE;
-    }
+    // A directory's position is the index of its next entry, so
+    // rewinddir/seekdir/telldir and getdents restarts work.
+    bool dir = (h->kind == VFS_HANDLE_DIR);
 
     int64_t base = 0;
     if (whence == VFS_SEEK_SET) {
         base = 0;
     } else if (whence == VFS_SEEK_CUR) {
-        base = (int64_t)h->off;
+        base = (int64_t)(dir ? h->ent_index : h->off);
     } else if (whence == VFS_SEEK_END) {
-        base = (int64_t)h->size;
+        base = (int64_t)(dir ? h->ent_count : handle_size(h));
     } else {
         return -EINVAL;
     }
@@ -2117,6 +2661,14 @@ int32_t vfs_lseek(vfs_handle_t* h, int32_t offset, int32_t whence, uint32_t* out
         return -EOVERFLOW;
     }
 
+    if (dir) {
+        h->ent_index = (pos > (int64_t)h->ent_count) ? h->ent_count : (uint32_t)pos;
+        if (out_new_off) {
+            *out_new_off = h->ent_index;
+        }
+        return 0;
+    }
+
     h->off = (uint32_t)pos;
     if (out_new_off) {
         *out_new_off = h->off;
@@ -2132,16 +2684,14 @@ int32_t vfs_fstat(vfs_handle_t* h, vfs_stat_t* out) {
     out->is_dir = (h->kind == VFS_HANDLE_DIR) ? 1u : 0u;
     out->is_symlink = 0;
     out->mode = out->is_dir ? 0755 : 0644;
-    out->size = (h->kind == VFS_HANDLE_FILE) ? h->size : 0;
+    out->size = (h->kind == VFS_HANDLE_FILE) ? handle_size(h) : 0;
 
     uint16_t wtime = 0;
     uint16_t wdate = 0;
 
     if (h->backend == VFS_BACKEND_MINIXFS) {
-        const char* rel = h->abs_path + 5;  // skip "/disk"
-        if (*rel == '\0') rel = "/";
         minixfs_stat_t mst;
-        if (minixfs_stat(rel, &mst)) {
+        if (minixfs_stat_ino(h->ino, &mst)) {
             out->mode = (uint16_t)(mst.mode & 07777u);
             out->uid = mst.uid;
             out->gid = mst.gid;
@@ -2238,9 +2788,14 @@ int32_t vfs_unlink_path(const char* cwd, const char* path) {
         if (!minixfs_is_file(rel)) {
             return -ENOENT;
         }
+        minixfs_stat_t mst;
+        bool last_link = minixfs_stat(rel, &mst) && mst.nlinks <= 1u;
         if (!minixfs_unlink(rel)) {
             return -EIO;
         }
+        if (last_link) {
+            pagecache_forget(mst.ino);  // the inode is free now
+        }
         return 0;
     }
 
@@ -2416,9 +2971,14 @@ int32_t vfs_rename_path(const char* cwd, const char* old_path, const char* new_p
         }
         const char* old_rel = old_eff + 5;  // skip "/disk"
         const char* new_rel = new_eff + 5;
+        uint32_t old_ino = minixfs_lookup(old_rel);
+        uint32_t new_ino = minixfs_lookup(new_rel);
         if (!minixfs_rename(old_rel, new_rel)) {
             return -EIO;
         }
+        if (new_ino != 0 && new_ino != old_ino) {
+            pagecache_forget(new_ino);  // replaced and freed
+        }
         return 0;
     }
 
@@ -2443,6 +3003,14 @@ int32_t vfs_ftruncate(vfs_handle_t* h, uint32_t new_size) {
         return -EROFS;
     }
 
+    if (h->pc) {
+        int32_t rc = pagecache_truncate(h->pc, new_size);
+        if (rc == 0 && h->off > new_size) {
+            h->off = new_size;
+        }
+        return rc;
+    }
+
     int32_t rc = handle_ensure_buf(h);
     if (rc < 0) {
         return rc;
@@ -2480,17 +3048,16 @@ int32_t vfs_fsync(vfs_handle_t* h) {
     if (h->backend == VFS_BACKEND_INITRAMFS) {
         return -EROFS;
     }
-    if (!h->dirty) {
-        return 0;
-    }
 
     int32_t rc = 0;
-    if (h->backend == VFS_BACKEND_MINIXFS) {
-        const char* rel = h->abs_path + 5;  // skip "/disk"
-        if (*rel == '\0') rel = "/";
-        if (!minixfs_write_file(rel, h->buf, h->size)) {
+    if (h->pc) {
+        rc = pagecache_sync(h->pc);
+        // Earlier writes may still sit dirty in the buffer cache.
+        if (rc == 0 && !bcache_sync()) {
             rc = -EIO;
         }
+    } else if (!h->dirty) {
+        return 0;
     } else if (h->backend == VFS_BACKEND_RAMFS) {
         if (!ramfs_write_file(h->abs_path, h->buf, h->size, true)) {
             rc = -EIO;
@@ -2513,24 +3080,24 @@ int32_t vfs_fchmod(vfs_handle_t* h, uint16_t mode) {
         return -EROFS;
     }
 
-    vfs_stat_t st;
-    int32_t rc = vfs_lstat_abs(h->abs_path, &st);
-    if (rc < 0) {
-        return rc;
-    }
-
     mode &= 07777u;
 
     if (h->backend == VFS_BACKEND_MINIXFS) {
         if (!minixfs_is_ready()) {
             return -EIO;
         }
-        if (!minixfs_chmod(h->abs_path + 5, mode)) {  // skip "/disk"
+        if (!minixfs_chmod_ino(h->ino, mode)) {
             return -EIO;
         }
         return 0;
     }
 
+    vfs_stat_t st;
+    int32_t rc = vfs_lstat_abs(h->abs_path, &st);
+    if (rc < 0) {
+        return rc;
+    }
+
     if (h->backend == VFS_BACKEND_RAMFS) {
         if (!ramfs_set_meta(h->abs_path, false, mode)) {
             return -EIO;
@@ -2553,7 +3120,7 @@ int32_t vfs_fchown(vfs_handle_t* h, uint32_t uid, uint32_t gid) {
         if (!minixfs_is_ready()) {
             return -EIO;
         }
-        if (!minixfs_chown(h->abs_path + 5, (uint16_t)uid, (uint16_t)gid)) {  // skip "/disk"
+        if (!minixfs_chown_ino(h->ino, (uint16_t)uid, (uint16_t)gid)) {
             return -EIO;
         }
         return 0;
@@ -2605,3 +3172,23 @@ int32_t vfs_handle_set_flags(vfs_handle_t* h, uint32_t flags) {
     h->flags = flags;
     return 0;
 }
+
+bool vfs_path_on_disk(const char* cwd, const char* path) {
+    if (!minixfs_is_ready()) {
+        return false;
+    }
+    char abs[VFS_PATH_MAX];
+    if (vfs_path_resolve(cwd, path, abs) < 0) {
+        return false;
+    }
+    char tmp[VFS_PATH_MAX];
+    const char* aliased = abs_apply_posix_aliases(abs, tmp);
+    if (g_root_pivoted) {
+        return !abs_is_mount(aliased, "/initramfs") && !abs_is_mount(aliased, "/ram");
+    }
+    return abs_is_mount(aliased, "/disk");
+}
+
+bool vfs_handle_on_disk(const vfs_handle_t* h) {
+    return h && h->backend == VFS_BACKEND_MINIXFS;
+}
@@ -0,0 +1,93 @@
+#include "vsyscall.h"
+#include "gdt.h"
+#include "paging.h"
+#include "serial.h"
+#include "string.h"
+#include "usercopy.h"
+#include "vdso.h"
+
+#define IA32_SYSENTER_CS  0x174u
+#define IA32_SYSENTER_ESP 0x175u
+#define IA32_SYSENTER_EIP 0x176u
+
+#define CPUID_EDX_SEP (1u << 11)
+
+#define VSYSCALL_CODE_OFFSET 16u   // entry pointer first, code after it
+
+extern void sysenter_entry(void);
+extern void sysenter_entry_end(void);
+extern const uint8_t vsyscall_sysenter_start[];
+extern const uint8_t vsyscall_sysenter_ret[];
+extern const uint8_t vsyscall_sysenter_end[];
+extern const uint8_t vsyscall_int80_start[];
+extern const uint8_t vsyscall_int80_end[];
+
+// Where SYSEXIT-able frames return to; read by the SYSENTER stub.
+uint32_t sysenter_return_eip = 0;
+
+static bool sysenter = false;
+static uint8_t vsyscall_page[PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+static inline void wrmsr(uint32_t msr, uint32_t value) {
+    __asm__ volatile ("wrmsr" : : "c"(msr), "a"(value), "d"(0u));
+}
+
+static bool cpu_has_sysenter(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0u), "c"(0u));
+    if (eax < 1u) {
+        return false;
+    }
+    __asm__ volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1u), "c"(0u));
+    if ((edx & CPUID_EDX_SEP) == 0) {
+        return false;
+    }
+    // Early Pentium Pro parts report SEP without implementing it.
+    uint32_t family = (eax >> 8) & 0xFu;
+    uint32_t model = (eax >> 4) & 0xFu;
+    uint32_t stepping = eax & 0xFu;
+    return !(family == 6u && model < 3u && stepping < 3u);
+}
+
+void vsyscall_init(void) {
+    sysenter = cpu_has_sysenter();
+
+    const uint8_t* start = sysenter ? vsyscall_sysenter_start : vsyscall_int80_start;
+    const uint8_t* end = sysenter ? vsyscall_sysenter_end : vsyscall_int80_end;
+    uint32_t entry = VDSO_SYSCALL_VA + VSYSCALL_CODE_OFFSET;
+
+    memset(vsyscall_page, 0, sizeof(vsyscall_page));
+    memcpy(vsyscall_page, &entry, sizeof(entry));
+    memcpy(vsyscall_page + VSYSCALL_CODE_OFFSET, start, (uint32_t)(end - start));
+    paging_map_page(VDSO_SYSCALL_VA, (uint32_t)vsyscall_page, PAGE_PRESENT | PAGE_USER);
+
+    if (sysenter) {
+        sysenter_return_eip = entry + (uint32_t)(vsyscall_sysenter_ret - vsyscall_sysenter_start);
+        wrmsr(IA32_SYSENTER_CS, 0x08u);
+        wrmsr(IA32_SYSENTER_ESP, tss_get_esp0());
+        wrmsr(IA32_SYSENTER_EIP, (uint32_t)sysenter_entry);
+    }
+
+    serial_write_string(sysenter ? "[VSYSCALL] sysenter\n" : "[VSYSCALL] int 0x80\n");
+}
+
+bool vsyscall_has_sysenter(void) {
+    return sysenter;
+}
+
+void vsyscall_set_kernel_stack(uint32_t stack_top) {
+    if (sysenter) {
+        wrmsr(IA32_SYSENTER_ESP, stack_top);
+    }
+}
+
+void vsyscall_fixup_frame(interrupt_frame_t* frame) {
+    uint32_t ebp;
+    if (copy_from_user(&ebp, (const void*)frame->ebp, sizeof(ebp))) {
+        frame->ebp = ebp;
+    }
+}
+
+bool vsyscall_in_entry(uint32_t eip) {
+    return sysenter && eip >= (uint32_t)sysenter_entry && eip <= (uint32_t)sysenter_entry_end;
+}
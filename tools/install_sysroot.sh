@@ -64,6 +64,7 @@ VTCC="$ROOT_DIR/build/user/tcc.elf"
 VTCC1="$ROOT_DIR/build/user/libtcc1.a"
 VTCC_INC="$ROOT_DIR/third_party/tcc/include"
 VSYSCALL_H="$ROOT_DIR/user/syscall.h"
+VVOSTIME_H="$ROOT_DIR/user/vos_time.h"
 VTERMIOS_H="$ROOT_DIR/user/sys/termios.h"
 VIOCTL_H="$ROOT_DIR/user/sys/ioctl.h"
 VUTSNAME_H="$ROOT_DIR/user/sys/utsname.h"
@@ -366,6 +367,7 @@ if [[ -d "$SBASE_BIN_DIR" ]]; then
 fi
 
 copy_one "$VSYSCALL_H" ::/usr/include/syscall.h
+copy_one "$VVOSTIME_H" ::/usr/include/vos_time.h
 copy_one "$VTERMIOS_H" ::/usr/include/sys/termios.h
 copy_one "$VIOCTL_H" ::/usr/include/sys/ioctl.h
 copy_one "$VUTSNAME_H" ::/usr/include/sys/utsname.h
@@ -41,6 +41,10 @@ struct _DIR {
     int fd;                         /* Directory file descriptor */
     int eof;                        /* End of directory flag */
     struct dirent de;               /* Current entry */
+    long loc;                       /* Index of the next entry (telldir) */
+    int buf_pos;                    /* Next record in buf */
+    int buf_len;                    /* Bytes of getdents records in buf */
+    char buf[2048] __attribute__((aligned(4)));
 };
 
 #ifdef __cplusplus
@@ -15,6 +15,9 @@
 #include <sys/utsname.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include <sys/select.h>
 #include <sys/wait.h>
 #include <dirent.h>
@@ -23,8 +26,12 @@
 #include <termios.h>
 #include <time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/times.h>
 
+#include "vos_time.h"
+
 // Wait status macros - ensure these are defined
 #ifndef WIFEXITED
 #define WIFEXITED(s)   (((s) & 0x7f) == 0)
@@ -741,6 +748,12 @@ struct group* getgrgid(gid_t gid) {
     return out;
 }
 
+// Syscall instruction: call the kernel's trampoline page (include/vdso.h),
+// which enters through SYSENTER when the CPU has it and int 0x80 otherwise.
+// Same register ABI as int 0x80; only eax is modified.
+#define VOS_VSYSCALL 0xED001000u
+#define VOS_SYSCALL  "call *0xED001000"
+
 // VOS syscall numbers (kernel/syscall.c)
 enum {
     SYS_WRITE = 0,
@@ -833,6 +846,26 @@ enum {
     SYS_CHOWN = 95,
     SYS_FCHOWN = 96,
     SYS_LCHOWN = 97,
+    SYS_CLONE = 103,
+    SYS_THREAD_EXIT = 104,
+    SYS_GETTID = 105,
+    SYS_SET_TLS = 106,
+    SYS_FUTEX = 107,
+    SYS_EPOLL_CREATE = 111,
+    SYS_EPOLL_CTL = 112,
+    SYS_EPOLL_WAIT = 113,
+    SYS_READV = 114,
+    SYS_WRITEV = 115,
+    SYS_PREAD = 116,
+    SYS_PWRITE = 117,
+    SYS_SENDFILE = 118,
+    SYS_SPLICE = 119,
+    SYS_GETDENTS = 120,
+    SYS_OPENAT = 121,
+    SYS_FSTATAT = 122,
+    SYS_MKDIRAT = 123,
+    SYS_UNLINKAT = 124,
+    SYS_RENAMEAT = 125,
 };
 
 // For select() syscall
@@ -846,6 +879,11 @@ typedef struct vos_timeval_internal {
     int tv_usec;
 } vos_timeval_internal_t;
 
+typedef struct vos_timespec_internal {
+    int tv_sec;
+    int tv_nsec;
+} vos_timespec_internal_t;
+
 typedef struct vos_stat {
     unsigned char is_dir;
     unsigned char is_symlink;
@@ -866,21 +904,25 @@ typedef struct vos_rtc_datetime {
     unsigned char second;
 } vos_rtc_datetime_t;
 
-#define VOS_NAME_MAX 64
-typedef struct vos_dirent {
-    char name[VOS_NAME_MAX];
-    unsigned char is_dir;
-    unsigned char is_symlink;
+// SYS_GETDENTS record (see kernel/task.c).
+typedef struct vos_dirent_rec {
+    unsigned short reclen;
+    unsigned char type;
+    unsigned char name_len;
     unsigned short mode;
-    unsigned int size;
     unsigned short wtime;
     unsigned short wdate;
-} vos_dirent_t;
+    unsigned short reserved;
+    unsigned int size;
+    unsigned int uid;
+    unsigned int gid;
+    char name[];
+} vos_dirent_rec_t;
 
 static inline int vos_sys_sleep(unsigned int ms) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SLEEP), "b"(ms)
         : "memory"
@@ -891,7 +933,7 @@ static inline int vos_sys_sleep(unsigned int ms) {
 static inline int vos_sys_alarm(unsigned int seconds) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_ALARM), "b"(seconds)
         : "memory"
@@ -902,7 +944,7 @@ static inline int vos_sys_alarm(unsigned int seconds) {
 static inline int vos_sys_write(int fd, const void* buf, unsigned int len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WRITE), "b"(fd), "c"(buf), "d"(len)
         : "memory"
@@ -910,12 +952,12 @@ static inline int vos_sys_write(int fd, const void* buf, unsigned int len) {
     return ret;
 }
 
-static inline int vos_sys_readdir(int fd, vos_dirent_t* ent) {
+static inline int vos_sys_getdents(int fd, void* buf, unsigned int len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
-        : "a"(SYS_READDIR), "b"(fd), "c"(ent)
+        : "a"(SYS_GETDENTS), "b"(fd), "c"(buf), "d"(len)
         : "memory"
     );
     return ret;
@@ -924,7 +966,7 @@ static inline int vos_sys_readdir(int fd, vos_dirent_t* ent) {
 static inline int vos_sys_rtc_get(vos_rtc_datetime_t* dt) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RTC_GET), "b"(dt)
         : "memory"
@@ -935,7 +977,7 @@ static inline int vos_sys_rtc_get(vos_rtc_datetime_t* dt) {
 static inline int vos_sys_rtc_set(const vos_rtc_datetime_t* dt) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RTC_SET), "b"(dt)
         : "memory"
@@ -946,7 +988,7 @@ static inline int vos_sys_rtc_set(const vos_rtc_datetime_t* dt) {
 static inline unsigned int vos_sys_uptime_ms(void) {
     unsigned int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_UPTIME_MS)
         : "memory"
@@ -954,9 +996,31 @@ static inline unsigned int vos_sys_uptime_ms(void) {
     return ret;
 }
 
+static inline int vos_sys_gettimeofday(vos_timeval_internal_t* tv) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_GETTIMEOFDAY), "b"(tv)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_clock_gettime(int clockid, vos_timespec_internal_t* tp) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_CLOCK_GETTIME), "b"(clockid), "c"(tp)
+        : "memory"
+    );
+    return ret;
+}
+
 __attribute__((noreturn)) static inline void vos_sys_exit(int code) {
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         :
         : "a"(SYS_EXIT), "b"(code)
         : "memory"
@@ -969,7 +1033,7 @@ __attribute__((noreturn)) static inline void vos_sys_exit(int code) {
 static inline void* vos_sys_sbrk(int incr) {
     void* ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SBRK), "b"(incr)
         : "memory"
@@ -980,7 +1044,7 @@ static inline void* vos_sys_sbrk(int incr) {
 static inline void* vos_sys_mmap(void* addr, unsigned int length, unsigned int prot, unsigned int flags, int fd) {
     void* ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MMAP), "b"(addr), "c"(length), "d"(prot), "S"(flags), "D"(fd)
         : "memory"
@@ -991,7 +1055,7 @@ static inline void* vos_sys_mmap(void* addr, unsigned int length, unsigned int p
 static inline int vos_sys_munmap(void* addr, unsigned int length) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MUNMAP), "b"(addr), "c"(length)
         : "memory"
@@ -1002,7 +1066,7 @@ static inline int vos_sys_munmap(void* addr, unsigned int length) {
 static inline int vos_sys_mprotect(void* addr, unsigned int length, unsigned int prot) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MPROTECT), "b"(addr), "c"(length), "d"(prot)
         : "memory"
@@ -1013,7 +1077,7 @@ static inline int vos_sys_mprotect(void* addr, unsigned int length, unsigned int
 static inline int vos_sys_open(const char* path, int flags) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_OPEN), "b"(path), "c"(flags)
         : "memory"
@@ -1024,7 +1088,7 @@ static inline int vos_sys_open(const char* path, int flags) {
 static inline int vos_sys_read(int fd, void* buf, unsigned int len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_READ), "b"(fd), "c"(buf), "d"(len)
         : "memory"
@@ -1035,7 +1099,7 @@ static inline int vos_sys_read(int fd, void* buf, unsigned int len) {
 static inline int vos_sys_close(int fd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CLOSE), "b"(fd)
         : "memory"
@@ -1046,7 +1110,7 @@ static inline int vos_sys_close(int fd) {
 static inline int vos_sys_lseek(int fd, int offset, int whence) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_LSEEK), "b"(fd), "c"(offset), "d"(whence)
         : "memory"
@@ -1057,7 +1121,7 @@ static inline int vos_sys_lseek(int fd, int offset, int whence) {
 static inline int vos_sys_fstat(int fd, vos_stat_t* st) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FSTAT), "b"(fd), "c"(st)
         : "memory"
@@ -1068,7 +1132,7 @@ static inline int vos_sys_fstat(int fd, vos_stat_t* st) {
 static inline int vos_sys_stat(const char* path, vos_stat_t* st) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_STAT), "b"(path), "c"(st)
         : "memory"
@@ -1079,7 +1143,7 @@ static inline int vos_sys_stat(const char* path, vos_stat_t* st) {
 static inline int vos_sys_lstat(const char* path, vos_stat_t* st) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_LSTAT), "b"(path), "c"(st)
         : "memory"
@@ -1090,7 +1154,7 @@ static inline int vos_sys_lstat(const char* path, vos_stat_t* st) {
 static inline int vos_sys_symlink(const char* target, const char* linkpath) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SYMLINK), "b"(target), "c"(linkpath)
         : "memory"
@@ -1101,7 +1165,7 @@ static inline int vos_sys_symlink(const char* target, const char* linkpath) {
 static inline int vos_sys_readlink(const char* path, char* buf, unsigned int cap) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_READLINK), "b"(path), "c"(buf), "d"(cap)
         : "memory"
@@ -1112,7 +1176,7 @@ static inline int vos_sys_readlink(const char* path, char* buf, unsigned int cap
 static inline int vos_sys_chmod(const char* path, unsigned int mode) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CHMOD), "b"(path), "c"(mode)
         : "memory"
@@ -1123,7 +1187,7 @@ static inline int vos_sys_chmod(const char* path, unsigned int mode) {
 static inline int vos_sys_fchmod(int fd, unsigned int mode) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FCHMOD), "b"(fd), "c"(mode)
         : "memory"
@@ -1134,7 +1198,7 @@ static inline int vos_sys_fchmod(int fd, unsigned int mode) {
 static inline int vos_sys_chown(const char* path, unsigned int uid, unsigned int gid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CHOWN), "b"(path), "c"(uid), "d"(gid)
         : "memory"
@@ -1145,7 +1209,7 @@ static inline int vos_sys_chown(const char* path, unsigned int uid, unsigned int
 static inline int vos_sys_fchown(int fd, unsigned int uid, unsigned int gid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FCHOWN), "b"(fd), "c"(uid), "d"(gid)
         : "memory"
@@ -1156,7 +1220,7 @@ static inline int vos_sys_fchown(int fd, unsigned int uid, unsigned int gid) {
 static inline int vos_sys_lchown(const char* path, unsigned int uid, unsigned int gid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_LCHOWN), "b"(path), "c"(uid), "d"(gid)
         : "memory"
@@ -1167,7 +1231,7 @@ static inline int vos_sys_lchown(const char* path, unsigned int uid, unsigned in
 static inline int vos_sys_mkdir(const char* path) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MKDIR), "b"(path)
         : "memory"
@@ -1178,7 +1242,7 @@ static inline int vos_sys_mkdir(const char* path) {
 static inline int vos_sys_chdir(const char* path) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CHDIR), "b"(path)
         : "memory"
@@ -1189,7 +1253,7 @@ static inline int vos_sys_chdir(const char* path) {
 static inline int vos_sys_getcwd(char* buf, unsigned int len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETCWD), "b"(buf), "c"(len)
         : "memory"
@@ -1200,7 +1264,7 @@ static inline int vos_sys_getcwd(char* buf, unsigned int len) {
 static inline int vos_sys_ioctl(int fd, unsigned int req, void* argp) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_IOCTL), "b"(fd), "c"(req), "d"(argp)
         : "memory"
@@ -1211,7 +1275,7 @@ static inline int vos_sys_ioctl(int fd, unsigned int req, void* argp) {
 static inline int vos_sys_unlink(const char* path) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_UNLINK), "b"(path)
         : "memory"
@@ -1222,7 +1286,7 @@ static inline int vos_sys_unlink(const char* path) {
 static inline int vos_sys_rename(const char* oldp, const char* newp) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RENAME), "b"(oldp), "c"(newp)
         : "memory"
@@ -1233,7 +1297,7 @@ static inline int vos_sys_rename(const char* oldp, const char* newp) {
 static inline int vos_sys_rmdir(const char* path) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RMDIR), "b"(path)
         : "memory"
@@ -1244,7 +1308,7 @@ static inline int vos_sys_rmdir(const char* path) {
 static inline int vos_sys_truncate(const char* path, unsigned int size) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_TRUNCATE), "b"(path), "c"(size)
         : "memory"
@@ -1255,7 +1319,7 @@ static inline int vos_sys_truncate(const char* path, unsigned int size) {
 static inline int vos_sys_ftruncate(int fd, unsigned int size) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FTRUNCATE), "b"(fd), "c"(size)
         : "memory"
@@ -1266,7 +1330,7 @@ static inline int vos_sys_ftruncate(int fd, unsigned int size) {
 static inline int vos_sys_fsync(int fd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FSYNC), "b"(fd)
         : "memory"
@@ -1277,7 +1341,7 @@ static inline int vos_sys_fsync(int fd) {
 static inline int vos_sys_dup(int oldfd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_DUP), "b"(oldfd)
         : "memory"
@@ -1288,7 +1352,7 @@ static inline int vos_sys_dup(int oldfd) {
 static inline int vos_sys_dup2(int oldfd, int newfd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_DUP2), "b"(oldfd), "c"(newfd)
         : "memory"
@@ -1299,7 +1363,7 @@ static inline int vos_sys_dup2(int oldfd, int newfd) {
 static inline int vos_sys_pipe(int* fds) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_PIPE), "b"(fds)
         : "memory"
@@ -1310,7 +1374,7 @@ static inline int vos_sys_pipe(int* fds) {
 static inline int vos_sys_fcntl(int fd, int cmd, int arg) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FCNTL), "b"(fd), "c"(cmd), "d"(arg)
         : "memory"
@@ -1321,7 +1385,7 @@ static inline int vos_sys_fcntl(int fd, int cmd, int arg) {
 static inline int vos_sys_getpid(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETPID)
         : "memory"
@@ -1332,7 +1396,7 @@ static inline int vos_sys_getpid(void) {
 static inline int vos_sys_getppid(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETPPID)
         : "memory"
@@ -1343,7 +1407,7 @@ static inline int vos_sys_getppid(void) {
 static inline int vos_sys_getpgrp(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETPGRP)
         : "memory"
@@ -1354,7 +1418,7 @@ static inline int vos_sys_getpgrp(void) {
 static inline int vos_sys_setpgid(int pid, int pgid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETPGID), "b"(pid), "c"(pgid)
         : "memory"
@@ -1365,7 +1429,7 @@ static inline int vos_sys_setpgid(int pid, int pgid) {
 static inline int vos_sys_wait(int pid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WAIT), "b"(pid)
         : "memory"
@@ -1376,7 +1440,7 @@ static inline int vos_sys_wait(int pid) {
 static inline int vos_sys_waitpid(int pid, int* status, int options) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WAITPID), "b"(pid), "c"(status), "d"(options)
         : "memory"
@@ -1387,7 +1451,7 @@ static inline int vos_sys_waitpid(int pid, int* status, int options) {
 static inline int vos_sys_fork(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FORK)
         : "memory"
@@ -1399,7 +1463,7 @@ static inline int vos_sys_execve(const char* path, const char* const* argv, unsi
                                   const char* const* envp, unsigned int envc) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_EXECVE), "b"(path), "c"(argv), "d"(argc), "S"(envp), "D"(envc)
         : "memory"
@@ -1410,7 +1474,7 @@ static inline int vos_sys_execve(const char* path, const char* const* argv, unsi
 static inline int vos_sys_spawn(const char* path, const char* const* argv, unsigned int argc) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SPAWN), "b"(path), "c"(argv), "d"(argc)
         : "memory"
@@ -1421,7 +1485,7 @@ static inline int vos_sys_spawn(const char* path, const char* const* argv, unsig
 static inline int vos_sys_kill(int pid, int sig) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_KILL), "b"(pid), "c"(sig)
         : "memory"
@@ -1432,7 +1496,7 @@ static inline int vos_sys_kill(int pid, int sig) {
 static inline intptr_t vos_sys_signal(int sig, uintptr_t handler) {
     intptr_t ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SIGNAL), "b"(sig), "c"(handler)
         : "memory"
@@ -1443,7 +1507,7 @@ static inline intptr_t vos_sys_signal(int sig, uintptr_t handler) {
 static inline int vos_sys_sigprocmask(int how, const sigset_t* set, sigset_t* oldset) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SIGPROCMASK), "b"(how), "c"(set), "d"(oldset)
         : "memory"
@@ -1454,7 +1518,7 @@ static inline int vos_sys_sigprocmask(int how, const sigset_t* set, sigset_t* ol
 static inline int vos_sys_getuid(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETUID)
         : "memory"
@@ -1465,7 +1529,7 @@ static inline int vos_sys_getuid(void) {
 static inline int vos_sys_getgid(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETGID)
         : "memory"
@@ -1476,7 +1540,7 @@ static inline int vos_sys_getgid(void) {
 static inline int vos_sys_setuid(int uid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETUID), "b"(uid)
         : "memory"
@@ -1487,7 +1551,7 @@ static inline int vos_sys_setuid(int uid) {
 static inline int vos_sys_setgid(int gid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETGID), "b"(gid)
         : "memory"
@@ -1495,6 +1559,221 @@ static inline int vos_sys_setgid(int gid) {
     return ret;
 }
 
+static inline int vos_sys_yield(void) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_YIELD)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_gettid(void) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_GETTID)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_set_tls(const void* base) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SET_TLS), "b"(base)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_futex(volatile int* uaddr, int op, int val, const void* timeout_or_val2,
+                                volatile int* uaddr2) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_FUTEX), "b"(uaddr), "c"(op), "d"(val), "S"(timeout_or_val2), "D"(uaddr2)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_thread_exit(int code) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_THREAD_EXIT), "b"(code)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_epoll_create(int flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_EPOLL_CREATE), "b"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_EPOLL_CTL), "b"(epfd), "c"(op), "d"(fd), "S"(event)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_EPOLL_WAIT), "b"(epfd), "c"(events), "d"(maxevents), "S"(timeout)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_readv(int fd, const struct iovec* iov, int iovcnt) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_READV), "b"(fd), "c"(iov), "d"(iovcnt)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_writev(int fd, const struct iovec* iov, int iovcnt) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_WRITEV), "b"(fd), "c"(iov), "d"(iovcnt)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_pread(int fd, void* buf, unsigned int len, int off) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_PREAD), "b"(fd), "c"(buf), "d"(len), "S"(off)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_pwrite(int fd, const void* buf, unsigned int len, int off) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_PWRITE), "b"(fd), "c"(buf), "d"(len), "S"(off)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_sendfile(int out_fd, int in_fd, off_t* off, unsigned int count) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SENDFILE), "b"(out_fd), "c"(in_fd), "d"(off), "S"(count)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_splice(int in_fd, off_t* in_off, int out_fd, off_t* out_off, unsigned int len) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SPLICE), "b"(in_fd), "c"(in_off), "d"(out_fd), "S"(out_off), "D"(len)
+        : "memory"
+    );
+    return ret;
+}
+
+// Kernel *at() ABI (Linux values; newlib's AT_* constants differ).
+#define VOS_AT_FDCWD            (-100)
+#define VOS_AT_SYMLINK_NOFOLLOW 0x100
+#define VOS_AT_REMOVEDIR        0x200
+
+static inline int vos_sys_openat(int dirfd, const char* path, int flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_OPENAT), "b"(dirfd), "c"(path), "d"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_fstatat(int dirfd, const char* path, vos_stat_t* st, int flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_FSTATAT), "b"(dirfd), "c"(path), "d"(st), "S"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_mkdirat(int dirfd, const char* path) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_MKDIRAT), "b"(dirfd), "c"(path)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_unlinkat(int dirfd, const char* path, int flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_UNLINKAT), "b"(dirfd), "c"(path), "d"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int vos_sys_renameat(int olddirfd, const char* oldp, int newdirfd, const char* newp) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_RENAMEAT), "b"(olddirfd), "c"(oldp), "d"(newdirfd), "S"(newp)
+        : "memory"
+    );
+    return ret;
+}
+
 static int is_leap(int year) {
     if ((year % 4) != 0) return 0;
     if ((year % 100) != 0) return 1;
@@ -1692,6 +1971,63 @@ int write(int file, const void* ptr, size_t len) {
     return n;
 }
 
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt) {
+    int n = vos_sys_readv(fd, iov, iovcnt);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
+    int n = vos_sys_writev(fd, iov, iovcnt);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t pread(int fd, void* buf, size_t len, off_t off) {
+    int n = vos_sys_pread(fd, buf, (unsigned int)len, (int)off);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t pwrite(int fd, const void* buf, size_t len, off_t off) {
+    int n = vos_sys_pwrite(fd, buf, (unsigned int)len, (int)off);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+    int n = vos_sys_sendfile(out_fd, in_fd, offset, (unsigned int)count);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags) {
+    // The kernel takes five arguments; the SPLICE_F_* hints are not needed
+    // and O_NONBLOCK on either descriptor already makes the call non-blocking.
+    (void)flags;
+    int n = vos_sys_splice(fd_in, off_in, fd_out, off_out, (unsigned int)len);
+    if (n < 0) {
+        errno = -n;
+        return -1;
+    }
+    return n;
+}
+
 void* sbrk(ptrdiff_t incr) {
     void* p = vos_sys_sbrk((int)incr);
     if ((unsigned int)p == 0xFFFFFFFFu) {
@@ -1800,36 +2136,45 @@ int lstat(const char* path, struct stat* st) {
     return 0;
 }
 
+// Best-effort absolute path for an *at() result, used for st_ino/st_dev and
+// the fd path table. The lookup itself is done by the kernel from dirfd.
+static const char* at_abs_path(char abs[VOS_PATH_MAX], int dirfd, const char* path) {
+    if (path_is_abs(path)) {
+        return path;
+    }
+    if (dirfd == AT_FDCWD) {
+        return (path_make_abs(abs, path) == 0) ? abs : NULL;
+    }
+    const char* base = fd_path_get(dirfd);
+    if (!base || path_join(abs, base, path) < 0) {
+        return NULL;
+    }
+    return abs;
+}
+
 int fstatat(int dirfd, const char* path, struct stat* st, int flags) {
     if (!path || !st) {
         errno = EINVAL;
         return -1;
     }
-
-    char abs[VOS_PATH_MAX];
-    const char* eff = path;
-    if (!path_is_abs(path)) {
-        if (dirfd == AT_FDCWD) {
-            if (path_make_abs(abs, path) < 0) {
-                return -1;
-            }
-        } else {
-            const char* base = fd_path_get(dirfd);
-            if (!base) {
-                errno = EBADF;
-                return -1;
-            }
-            if (path_join(abs, base, path) < 0) {
-                return -1;
-            }
+    if (dirfd == AT_FDCWD || path_is_abs(path)) {
+        if ((flags & AT_SYMLINK_NOFOLLOW) != 0) {
+            return lstat(path, st);
         }
-        eff = abs;
+        return stat(path, st);
     }
 
-    if ((flags & AT_SYMLINK_NOFOLLOW) != 0) {
-        return lstat(eff, st);
+    vos_stat_t vst;
+    int vflags = (flags & AT_SYMLINK_NOFOLLOW) ? VOS_AT_SYMLINK_NOFOLLOW : 0;
+    int rc = vos_sys_fstatat(dirfd, path, &vst, vflags);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
     }
-    return stat(eff, st);
+
+    char abs[VOS_PATH_MAX];
+    fill_stat_common(st, &vst, at_abs_path(abs, dirfd, path));
+    return 0;
 }
 
 int openat(int dirfd, const char* path, int flags, ...) {
@@ -1837,34 +2182,56 @@ int openat(int dirfd, const char* path, int flags, ...) {
     va_start(ap, flags);
     int mode = va_arg(ap, int);
     va_end(ap);
-    (void)mode;
 
     if (!path) {
         errno = EINVAL;
         return -1;
     }
+    if (dirfd == AT_FDCWD || path_is_abs(path)) {
+        return open(path, flags, mode);
+    }
 
+    int rc = vos_sys_openat(dirfd, path, flags);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
     char abs[VOS_PATH_MAX];
-    const char* eff = path;
-    if (!path_is_abs(path)) {
-        if (dirfd == AT_FDCWD) {
-            if (path_make_abs(abs, path) < 0) {
-                return -1;
-            }
-        } else {
-            const char* base = fd_path_get(dirfd);
-            if (!base) {
-                errno = EBADF;
-                return -1;
-            }
-            if (path_join(abs, base, path) < 0) {
-                return -1;
-            }
-        }
-        eff = abs;
+    fd_path_set(rc, at_abs_path(abs, dirfd, path));
+    return rc;
+}
+
+int mkdirat(int dirfd, const char* path, mode_t mode) {
+    if (!path) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (dirfd == AT_FDCWD || path_is_abs(path)) {
+        return mkdir(path, mode);
+    }
+    int rc = vos_sys_mkdirat(dirfd, path);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
     }
+    return 0;
+}
 
-    return open(eff, flags, 0);
+int renameat(int olddirfd, const char* oldp, int newdirfd, const char* newp) {
+    if (!oldp || !newp) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((olddirfd == AT_FDCWD || path_is_abs(oldp)) && (newdirfd == AT_FDCWD || path_is_abs(newp))) {
+        return rename(oldp, newp);
+    }
+    int rc = vos_sys_renameat(olddirfd == AT_FDCWD ? VOS_AT_FDCWD : olddirfd, oldp,
+                              newdirfd == AT_FDCWD ? VOS_AT_FDCWD : newdirfd, newp);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    return 0;
 }
 
 int creat(const char* path, mode_t mode) {
@@ -1942,31 +2309,19 @@ int unlinkat(int dirfd, const char* path, int flags) {
         errno = EINVAL;
         return -1;
     }
-
-    char abs[VOS_PATH_MAX];
-    const char* eff = path;
-    if (!path_is_abs(path)) {
-        if (dirfd == AT_FDCWD) {
-            if (path_make_abs(abs, path) < 0) {
-                return -1;
-            }
-        } else {
-            const char* base = fd_path_get(dirfd);
-            if (!base) {
-                errno = EBADF;
-                return -1;
-            }
-            if (path_join(abs, base, path) < 0) {
-                return -1;
-            }
+    if (dirfd == AT_FDCWD || path_is_abs(path)) {
+        if ((flags & AT_REMOVEDIR) != 0) {
+            return rmdir(path);
         }
-        eff = abs;
+        return unlink(path);
     }
 
-    if ((flags & AT_REMOVEDIR) != 0) {
-        return rmdir(eff);
+    int rc = vos_sys_unlinkat(dirfd, path, (flags & AT_REMOVEDIR) ? VOS_AT_REMOVEDIR : 0);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
     }
-    return unlink(eff);
+    return 0;
 }
 
 int futimens(int fd, const struct timespec times[2]) {
@@ -2115,15 +2470,22 @@ int gettimeofday(struct timeval* tv, void* tz) {
         return -1;
     }
 
-    vos_rtc_datetime_t dt;
-    int rc = vos_sys_rtc_get(&dt);
+    uint64_t ns;
+    if (vos_time_read(NULL, &ns) == 0) {
+        tv->tv_sec = (time_t)(ns / 1000000000u);
+        tv->tv_usec = (suseconds_t)((ns % 1000000000u) / 1000u);
+        return 0;
+    }
+
+    vos_timeval_internal_t ktv;
+    int rc = vos_sys_gettimeofday(&ktv);
     if (rc < 0) {
         errno = -rc;
         return -1;
     }
 
-    tv->tv_sec = ymdhms_to_epoch((int)dt.year, (int)dt.month, (int)dt.day, (int)dt.hour, (int)dt.minute, (int)dt.second);
-    tv->tv_usec = 0;
+    tv->tv_sec = (time_t)ktv.tv_sec;
+    tv->tv_usec = (suseconds_t)ktv.tv_usec;
     return 0;
 }
 
@@ -2143,27 +2505,34 @@ int clock_gettime(clockid_t clock_id, struct timespec* tp) {
         return -1;
     }
 
+    int kclock;
+    if (clock_id == CLOCK_REALTIME) {
+        kclock = 0;
 #ifdef CLOCK_MONOTONIC
-    if (clock_id == CLOCK_MONOTONIC) {
-        unsigned int ms = vos_sys_uptime_ms();
-        tp->tv_sec = (time_t)(ms / 1000u);
-        tp->tv_nsec = (long)((ms % 1000u) * 1000000u);
-        return 0;
-    }
+    } else if (clock_id == CLOCK_MONOTONIC) {
+        kclock = 1;
 #endif
+    } else {
+        errno = EINVAL;
+        return -1;
+    }
 
-    if (clock_id == CLOCK_REALTIME) {
-        struct timeval tv;
-        if (gettimeofday(&tv, NULL) < 0) {
-            return -1;
-        }
-        tp->tv_sec = tv.tv_sec;
-        tp->tv_nsec = (long)tv.tv_usec * 1000L;
+    uint64_t ns;
+    if ((kclock == 0 ? vos_time_read(NULL, &ns) : vos_time_read(&ns, NULL)) == 0) {
+        tp->tv_sec = (time_t)(ns / 1000000000u);
+        tp->tv_nsec = (long)(ns % 1000000000u);
         return 0;
     }
 
-    errno = EINVAL;
-    return -1;
+    vos_timespec_internal_t kts;
+    int rc = vos_sys_clock_gettime(kclock, &kts);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    tp->tv_sec = (time_t)kts.tv_sec;
+    tp->tv_nsec = (long)kts.tv_nsec;
+    return 0;
 }
 
 int clock_settime(clockid_t clock_id, const struct timespec* tp) {
@@ -2258,6 +2627,8 @@ DIR* fdopendir(int fd) {
     memset(d, 0, sizeof(*d));
     d->fd = fd;
     d->eof = 0;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    d->loc = (pos > 0) ? (long)pos : 0;
     return d;
 }
 
@@ -2279,39 +2650,68 @@ struct dirent* readdir(DIR* dirp) {
         errno = EINVAL;
         return NULL;
     }
-    if (dirp->eof) {
-        return NULL;
-    }
 
-    vos_dirent_t de;
-    int rc = vos_sys_readdir(dirp->fd, &de);
-    if (rc < 0) {
-        errno = -rc;
-        return NULL;
-    }
-    if (rc == 0) {
-        dirp->eof = 1;
-        return NULL;
+    // Entries come from the kernel a bufferful at a time.
+    if (dirp->buf_pos >= dirp->buf_len) {
+        if (dirp->eof) {
+            return NULL;
+        }
+        int n = vos_sys_getdents(dirp->fd, dirp->buf, sizeof(dirp->buf));
+        if (n < 0) {
+            errno = -n;
+            return NULL;
+        }
+        if (n == 0) {
+            dirp->eof = 1;
+            return NULL;
+        }
+        dirp->buf_pos = 0;
+        dirp->buf_len = n;
     }
 
-    memset(&dirp->de, 0, sizeof(dirp->de));
+    const vos_dirent_rec_t* r = (const vos_dirent_rec_t*)(dirp->buf + dirp->buf_pos);
+    dirp->buf_pos += r->reclen;
+    dirp->loc++;
+
+    unsigned int name_len = r->name_len;
+    if (name_len > sizeof(dirp->de.d_name) - 1u) {
+        name_len = sizeof(dirp->de.d_name) - 1u;
+    }
     dirp->de.d_ino = 0;
     dirp->de.d_reclen = (unsigned short)sizeof(struct dirent);
-    dirp->de.d_type = de.is_dir ? DT_DIR : DT_REG;
-    strncpy(dirp->de.d_name, de.name, sizeof(dirp->de.d_name) - 1u);
-    dirp->de.d_name[sizeof(dirp->de.d_name) - 1u] = '\0';
+    dirp->de.d_type = r->type;
+    memcpy(dirp->de.d_name, r->name, name_len);
+    dirp->de.d_name[name_len] = '\0';
     return &dirp->de;
 }
 
-void rewinddir(DIR* dirp) {
-    // Our VFS doesn't support seekable directory streams yet.
-    // Best-effort: just mark "not EOF" and rely on reopening if needed.
-    if (!dirp) {
+// Directory positions are entry indexes (the kernel's lseek on a directory
+// uses the same numbering).
+void seekdir(DIR* dirp, long loc) {
+    if (!dirp || loc < 0) {
+        return;
+    }
+    if (lseek(dirp->fd, (off_t)loc, SEEK_SET) < 0) {
         return;
     }
+    dirp->loc = loc;
+    dirp->buf_pos = 0;
+    dirp->buf_len = 0;
     dirp->eof = 0;
 }
 
+long telldir(DIR* dirp) {
+    if (!dirp) {
+        errno = EINVAL;
+        return -1;
+    }
+    return dirp->loc;
+}
+
+void rewinddir(DIR* dirp) {
+    seekdir(dirp, 0);
+}
+
 int dirfd(DIR* dirp) {
     if (!dirp) {
         errno = EINVAL;
@@ -2535,6 +2935,46 @@ int mprotect(void* addr, size_t length, int prot) {
     return 0;
 }
 
+int epoll_create1(int flags) {
+    if ((flags & ~EPOLL_CLOEXEC) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    int rc = vos_sys_epoll_create(flags);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    fd_path_clear(rc);
+    return rc;
+}
+
+int epoll_create(int size) {
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+    int rc = vos_sys_epoll_ctl(epfd, op, fd, event);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    return 0;
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout) {
+    int rc = vos_sys_epoll_wait(epfd, events, maxevents, timeout);
+    if (rc < 0) {
+        errno = -rc;
+        return -1;
+    }
+    return rc;
+}
+
 int tcgetattr(int fd, struct termios* termios_p) {
     if (!termios_p) {
         errno = EINVAL;
@@ -3000,7 +3440,7 @@ static inline int vos_sys_select(int nfds, vos_fd_set_internal_t* readfds,
                                   vos_timeval_internal_t* timeout) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SELECT), "b"(nfds), "c"(readfds), "d"(writefds), "S"(exceptfds), "D"(timeout)
         : "memory"
@@ -3388,3 +3828,588 @@ int pclose(FILE *stream) {
 
     return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
 }
+
+// ---------------------------------------------------------------------------
+// POSIX threads (SYS_CLONE + per-thread %gs)
+// ---------------------------------------------------------------------------
+
+#define VOS_CLONE_VM             0x00000100u
+#define VOS_CLONE_FS             0x00000200u
+#define VOS_CLONE_FILES          0x00000400u
+#define VOS_CLONE_SIGHAND        0x00000800u
+#define VOS_CLONE_THREAD         0x00010000u
+#define VOS_CLONE_SETTLS         0x00080000u
+#define VOS_CLONE_PARENT_SETTID  0x00100000u
+#define VOS_CLONE_CHILD_CLEARTID 0x00200000u
+
+#define VOS_FUTEX_WAIT    0
+#define VOS_FUTEX_WAKE    1
+#define VOS_FUTEX_REQUEUE 3
+#define VOS_FUTEX_ALL     0x7FFFFFFF
+
+#define VOS_THREAD_STACK_DEFAULT (256u * 1024u)
+#define VOS_THREAD_STACK_MIN     (16u * 1024u)
+
+// Thread control block. %gs:0 points at the block itself (see pthread_self).
+struct vos_pthread {
+    struct vos_pthread* self;
+    void* (*start)(void*);
+    void* arg;
+    void* retval;
+    volatile int tid;               // set by clone, cleared by the kernel at exit
+    volatile int detached;
+    void* stack;
+    size_t stack_size;
+    const void* specific[PTHREAD_KEYS_MAX];
+    struct vos_pthread* next;       // vos_threads list
+};
+
+static struct vos_pthread vos_main_thread;
+static struct vos_pthread* vos_threads;
+static volatile int vos_threads_lock;
+static int vos_threads_started;
+
+static void (*vos_key_destructors[PTHREAD_KEYS_MAX])(void*);
+static volatile int vos_key_used[PTHREAD_KEYS_MAX];
+
+int sched_yield(void) {
+    (void)vos_sys_yield();
+    return 0;
+}
+
+static void vos_futex_wait(volatile int* addr, int val) {
+    (void)vos_sys_futex(addr, VOS_FUTEX_WAIT, val, NULL, NULL);
+}
+
+static void vos_futex_wake(volatile int* addr, int count) {
+    (void)vos_sys_futex(addr, VOS_FUTEX_WAKE, count, NULL, NULL);
+}
+
+static void vos_spin_lock(volatile int* lock) {
+    while (__sync_lock_test_and_set(lock, 1)) {
+        (void)vos_sys_yield();
+    }
+}
+
+static void vos_spin_unlock(volatile int* lock) {
+    __sync_lock_release(lock);
+}
+
+// The main thread gets its control block on the first pthread_create(); until
+// then nothing else can be running, so pthread_self() doesn't need %gs.
+static int vos_threads_init(void) {
+    if (vos_threads_started) {
+        return 0;
+    }
+    vos_main_thread.self = &vos_main_thread;
+    vos_main_thread.tid = vos_sys_gettid();
+    int rc = vos_sys_set_tls(&vos_main_thread);
+    if (rc < 0) {
+        return -rc;
+    }
+    vos_threads_started = 1;
+    return 0;
+}
+
+static void vos_thread_free(struct vos_pthread* t) {
+    if (t->stack) {
+        (void)vos_sys_munmap(t->stack, (unsigned int)t->stack_size);
+    }
+    free(t);
+}
+
+static void vos_thread_unlink(struct vos_pthread* t) {
+    vos_spin_lock(&vos_threads_lock);
+    for (struct vos_pthread** pp = &vos_threads; *pp; pp = &(*pp)->next) {
+        if (*pp == t) {
+            *pp = t->next;
+            break;
+        }
+    }
+    vos_spin_unlock(&vos_threads_lock);
+}
+
+// Release detached threads whose kernel task is gone (tid cleared on exit).
+static void vos_threads_reap(void) {
+    struct vos_pthread* dead = NULL;
+
+    vos_spin_lock(&vos_threads_lock);
+    struct vos_pthread** pp = &vos_threads;
+    while (*pp) {
+        struct vos_pthread* t = *pp;
+        if (t->detached && t->tid == 0) {
+            *pp = t->next;
+            t->next = dead;
+            dead = t;
+        } else {
+            pp = &t->next;
+        }
+    }
+    vos_spin_unlock(&vos_threads_lock);
+
+    while (dead) {
+        struct vos_pthread* next = dead->next;
+        vos_thread_free(dead);
+        dead = next;
+    }
+}
+
+static void vos_thread_run_destructors(struct vos_pthread* self) {
+    for (unsigned int i = 0; i < PTHREAD_KEYS_MAX; i++) {
+        const void* value = self->specific[i];
+        if (value && vos_key_used[i] && vos_key_destructors[i]) {
+            self->specific[i] = NULL;
+            vos_key_destructors[i]((void*)value);
+        }
+    }
+}
+
+// Entry point of every new thread, called from vos_clone_thread() on the new
+// stack. Not static so the asm can name it.
+__attribute__((noreturn, used)) void __vos_pthread_start(struct vos_pthread* t) {
+    pthread_exit(t->start(t->arg));
+}
+
+static int vos_clone_thread(struct vos_pthread* t, uint32_t* child_sp) {
+    unsigned int flags = VOS_CLONE_VM | VOS_CLONE_FS | VOS_CLONE_FILES | VOS_CLONE_SIGHAND |
+                         VOS_CLONE_THREAD | VOS_CLONE_SETTLS | VOS_CLONE_PARENT_SETTID |
+                         VOS_CLONE_CHILD_CLEARTID;
+    int ret;
+    // The child resumes here with eax = 0 on child_sp, where `t` is already
+    // stored as the argument for __vos_pthread_start(). This one stays on
+    // int 0x80: the trampoline would return through the new, empty stack.
+    __asm__ volatile (
+        "int $0x80\n\t"
+        "testl %%eax, %%eax\n\t"
+        "jnz 1f\n\t"
+        "xorl %%ebp, %%ebp\n\t"
+        "call __vos_pthread_start\n\t"
+        "ud2\n"
+        "1:"
+        : "=a"(ret)
+        : "a"(SYS_CLONE), "b"(flags), "c"(child_sp), "d"(&t->tid), "S"(t), "D"(&t->tid)
+        : "memory"
+    );
+    return ret;
+}
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr,
+                   void* (*start_routine)(void*), void* arg) {
+    if (!thread || !start_routine) {
+        return EINVAL;
+    }
+
+    int rc = vos_threads_init();
+    if (rc != 0) {
+        return rc;
+    }
+    vos_threads_reap();
+
+    size_t stack_size = (attr && attr->stacksize) ? attr->stacksize : VOS_THREAD_STACK_DEFAULT;
+    if (stack_size < VOS_THREAD_STACK_MIN) {
+        stack_size = VOS_THREAD_STACK_MIN;
+    }
+    stack_size = (stack_size + 0xFFFu) & ~(size_t)0xFFFu;
+
+    struct vos_pthread* t = (struct vos_pthread*)calloc(1, sizeof(*t));
+    if (!t) {
+        return EAGAIN;
+    }
+
+    void* stack = vos_sys_mmap(NULL, (unsigned int)stack_size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1);
+    if ((uintptr_t)stack >= 0xFFFFF000u) {
+        free(t);
+        return EAGAIN;
+    }
+
+    t->self = t;
+    t->start = start_routine;
+    t->arg = arg;
+    t->detached = (attr && attr->detachstate == PTHREAD_CREATE_DETACHED) ? 1 : 0;
+    t->stack = stack;
+    t->stack_size = stack_size;
+
+    // Keep the thread's initial stack 16-byte aligned at the call.
+    uint32_t* sp = (uint32_t*)((uint8_t*)stack + stack_size) - 4;
+    sp[0] = (uint32_t)(uintptr_t)t;
+
+    vos_spin_lock(&vos_threads_lock);
+    t->next = vos_threads;
+    vos_threads = t;
+    vos_spin_unlock(&vos_threads_lock);
+
+    rc = vos_clone_thread(t, sp);
+    if (rc < 0) {
+        vos_thread_unlink(t);
+        vos_thread_free(t);
+        return -rc;
+    }
+
+    *thread = t;
+    return 0;
+}
+
+int pthread_join(pthread_t thread, void** retval) {
+    if (!thread || thread == &vos_main_thread) {
+        return EINVAL;
+    }
+    if (thread == pthread_self()) {
+        return EDEADLK;
+    }
+    if (thread->detached) {
+        return EINVAL;
+    }
+
+    // The kernel clears tid and wakes the futex when the thread exits.
+    int tid;
+    while ((tid = thread->tid) != 0) {
+        vos_futex_wait(&thread->tid, tid);
+    }
+
+    if (retval) {
+        *retval = thread->retval;
+    }
+    vos_thread_unlink(thread);
+    vos_thread_free(thread);
+    return 0;
+}
+
+int pthread_detach(pthread_t thread) {
+    if (!thread || thread == &vos_main_thread) {
+        return EINVAL;
+    }
+    if (thread->detached) {
+        return EINVAL;
+    }
+    thread->detached = 1;
+    vos_threads_reap();
+    return 0;
+}
+
+void pthread_exit(void* retval) {
+    struct vos_pthread* self = pthread_self();
+    self->retval = retval;
+    vos_thread_run_destructors(self);
+
+    if (self == &vos_main_thread) {
+        // Wait for the other threads, then exit the process normally so
+        // atexit handlers and stdio buffers still run.
+        while (vos_sys_thread_exit(0) == -EINTR) {
+        }
+        exit(0);
+    }
+
+    for (;;) {
+        (void)vos_sys_thread_exit(0);
+    }
+}
+
+pthread_t pthread_self(void) {
+    if (!vos_threads_started) {
+        return &vos_main_thread;
+    }
+    struct vos_pthread* self;
+    __asm__ volatile ("movl %%gs:0, %0" : "=r"(self));
+    return self;
+}
+
+int pthread_equal(pthread_t a, pthread_t b) {
+    return a == b;
+}
+
+int pthread_attr_init(pthread_attr_t* attr) {
+    if (!attr) {
+        return EINVAL;
+    }
+    attr->detachstate = PTHREAD_CREATE_JOINABLE;
+    attr->stacksize = 0;
+    return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t* attr) {
+    (void)attr;
+    return 0;
+}
+
+int pthread_attr_setdetachstate(pthread_attr_t* attr, int state) {
+    if (!attr || (state != PTHREAD_CREATE_JOINABLE && state != PTHREAD_CREATE_DETACHED)) {
+        return EINVAL;
+    }
+    attr->detachstate = state;
+    return 0;
+}
+
+int pthread_attr_getdetachstate(const pthread_attr_t* attr, int* state) {
+    if (!attr || !state) {
+        return EINVAL;
+    }
+    *state = attr->detachstate;
+    return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t* attr, size_t size) {
+    if (!attr || size < VOS_THREAD_STACK_MIN) {
+        return EINVAL;
+    }
+    attr->stacksize = size;
+    return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t* attr, size_t* size) {
+    if (!attr || !size) {
+        return EINVAL;
+    }
+    *size = attr->stacksize ? attr->stacksize : VOS_THREAD_STACK_DEFAULT;
+    return 0;
+}
+
+int pthread_mutexattr_init(pthread_mutexattr_t* attr) {
+    if (!attr) {
+        return EINVAL;
+    }
+    attr->type = PTHREAD_MUTEX_DEFAULT;
+    return 0;
+}
+
+int pthread_mutexattr_destroy(pthread_mutexattr_t* attr) {
+    (void)attr;
+    return 0;
+}
+
+int pthread_mutexattr_settype(pthread_mutexattr_t* attr, int type) {
+    if (!attr || type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK) {
+        return EINVAL;
+    }
+    attr->type = type;
+    return 0;
+}
+
+int pthread_mutexattr_gettype(const pthread_mutexattr_t* attr, int* type) {
+    if (!attr || !type) {
+        return EINVAL;
+    }
+    *type = attr->type;
+    return 0;
+}
+
+int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr) {
+    if (!mutex) {
+        return EINVAL;
+    }
+    mutex->lock = 0;
+    mutex->type = attr ? attr->type : PTHREAD_MUTEX_DEFAULT;
+    mutex->owner = NULL;
+    mutex->count = 0;
+    return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t* mutex) {
+    if (!mutex) {
+        return EINVAL;
+    }
+    return mutex->lock ? EBUSY : 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex) {
+    if (!mutex) {
+        return EINVAL;
+    }
+    pthread_t self = pthread_self();
+    if (mutex->lock && mutex->owner == self) {
+        if (mutex->type == PTHREAD_MUTEX_RECURSIVE) {
+            mutex->count++;
+            return 0;
+        }
+        if (mutex->type == PTHREAD_MUTEX_ERRORCHECK) {
+            return EDEADLK;
+        }
+    }
+    if (!__sync_bool_compare_and_swap(&mutex->lock, 0, 1)) {
+        return EBUSY;
+    }
+    mutex->owner = self;
+    mutex->count = 1;
+    return 0;
+}
+
+// Slow path: mark the lock contended (2) so the holder's unlock wakes us.
+static void vos_mutex_lock_contended(pthread_mutex_t* mutex) {
+    while (__sync_lock_test_and_set(&mutex->lock, 2) != 0) {
+        vos_futex_wait(&mutex->lock, 2);
+    }
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    int rc = pthread_mutex_trylock(mutex);
+    if (rc != EBUSY) {
+        return rc;
+    }
+    vos_mutex_lock_contended(mutex);
+    mutex->owner = pthread_self();
+    mutex->count = 1;
+    return 0;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t* mutex) {
+    if (!mutex) {
+        return EINVAL;
+    }
+    if (!mutex->lock || mutex->owner != pthread_self()) {
+        return EPERM;
+    }
+    if (--mutex->count != 0) {
+        return 0;
+    }
+    mutex->owner = NULL;
+    if (__sync_fetch_and_sub(&mutex->lock, 1) != 1) {
+        // There were waiters.
+        __sync_lock_release(&mutex->lock);
+        vos_futex_wake(&mutex->lock, 1);
+    }
+    return 0;
+}
+
+int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr) {
+    (void)attr;
+    if (!cond) {
+        return EINVAL;
+    }
+    cond->seq = 0;
+    cond->mutex = NULL;
+    return 0;
+}
+
+int pthread_cond_destroy(pthread_cond_t* cond) {
+    (void)cond;
+    return 0;
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    if (!cond || !mutex) {
+        return EINVAL;
+    }
+    pthread_t self = pthread_self();
+    if (!mutex->lock || mutex->owner != self) {
+        return EPERM;
+    }
+
+    int seq = cond->seq;
+    cond->mutex = mutex;
+
+    // Release the mutex fully, even when it is held recursively.
+    unsigned int count = mutex->count;
+    mutex->count = 1;
+    (void)pthread_mutex_unlock(mutex);
+
+    vos_futex_wait(&cond->seq, seq);
+
+    // A broadcast may have requeued us onto the mutex word, so take the
+    // mutex in the contended state to keep the wake chain going.
+    vos_mutex_lock_contended(mutex);
+    mutex->owner = self;
+    mutex->count = count;
+    return 0;
+}
+
+int pthread_cond_signal(pthread_cond_t* cond) {
+    if (!cond) {
+        return EINVAL;
+    }
+    __sync_fetch_and_add(&cond->seq, 1);
+    vos_futex_wake(&cond->seq, 1);
+    return 0;
+}
+
+int pthread_cond_broadcast(pthread_cond_t* cond) {
+    if (!cond) {
+        return EINVAL;
+    }
+    __sync_fetch_and_add(&cond->seq, 1);
+    pthread_mutex_t* mutex = cond->mutex;
+    if (!mutex) {
+        vos_futex_wake(&cond->seq, VOS_FUTEX_ALL);
+        return 0;
+    }
+    // Wake one waiter and move the rest onto the mutex: they could only
+    // contend for it anyway (no thundering herd).
+    (void)vos_sys_futex(&cond->seq, VOS_FUTEX_REQUEUE, 1, (const void*)(uintptr_t)VOS_FUTEX_ALL,
+                        &mutex->lock);
+    return 0;
+}
+
+int pthread_once(pthread_once_t* once, void (*init_routine)(void)) {
+    if (!once || !init_routine) {
+        return EINVAL;
+    }
+    if (once->state == 2) {
+        return 0;
+    }
+    if (__sync_bool_compare_and_swap(&once->state, 0, 1)) {
+        init_routine();
+        __sync_synchronize();
+        once->state = 2;
+        vos_futex_wake(&once->state, VOS_FUTEX_ALL);
+        return 0;
+    }
+    while (once->state == 1) {
+        vos_futex_wait(&once->state, 1);
+    }
+    return 0;
+}
+
+int pthread_key_create(pthread_key_t* key, void (*destructor)(void*)) {
+    if (!key) {
+        return EINVAL;
+    }
+    for (unsigned int i = 0; i < PTHREAD_KEYS_MAX; i++) {
+        if (__sync_bool_compare_and_swap(&vos_key_used[i], 0, 1)) {
+            vos_key_destructors[i] = destructor;
+            *key = i;
+            return 0;
+        }
+    }
+    return EAGAIN;
+}
+
+int pthread_key_delete(pthread_key_t key) {
+    if (key >= PTHREAD_KEYS_MAX || !vos_key_used[key]) {
+        return EINVAL;
+    }
+    vos_key_destructors[key] = NULL;
+    vos_key_used[key] = 0;
+    return 0;
+}
+
+void* pthread_getspecific(pthread_key_t key) {
+    if (key >= PTHREAD_KEYS_MAX) {
+        return NULL;
+    }
+    return (void*)pthread_self()->specific[key];
+}
+
+int pthread_setspecific(pthread_key_t key, const void* value) {
+    if (key >= PTHREAD_KEYS_MAX || !vos_key_used[key]) {
+        return EINVAL;
+    }
+    pthread_self()->specific[key] = value;
+    return 0;
+}
+
+// newlib brackets every heap operation with these; its defaults do nothing,
+// which stops being safe once threads share the heap.
+static pthread_mutex_t vos_malloc_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
+
+void __malloc_lock(struct _reent* r) {
+    (void)r;
+    if (vos_threads_started) {
+        (void)pthread_mutex_lock(&vos_malloc_mutex);
+    }
+}
+
+void __malloc_unlock(struct _reent* r) {
+    (void)r;
+    if (vos_threads_started) {
+        (void)pthread_mutex_unlock(&vos_malloc_mutex);
+    }
+}
@@ -1,5 +1,6 @@
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -19,37 +20,52 @@ int main(int argc, char** argv) {
     (void)argc;
     (void)argv;
 
-    int count = sys_task_count();
-    if (count < 0) {
-        errno = -count;
+    // Grow the buffer until the whole task list fits; tasks may be created
+    // between the calls.
+    vos_task_stat_t* tasks = NULL;
+    int cap = 0;
+    int total;
+    for (;;) {
+        total = vos_task_snapshot_all(tasks, (uint32_t)cap);
+        if (total < 0 || total <= cap) {
+            break;
+        }
+        vos_task_stat_t* grown = realloc(tasks, (size_t)(total + 8) * sizeof(*tasks));
+        if (!grown) {
+            total = -ENOMEM;
+            break;
+        }
+        tasks = grown;
+        cap = total + 8;
+    }
+    if (total < 0) {
+        errno = -total;
         fprintf(stderr, "ps: %s\n", strerror(errno));
         return 1;
     }
 
     int cur = getpid();
 
-    puts("PID   USER  STATE  TICKS    EIP       NAME");
-    for (uint32_t i = 0; i < (uint32_t)count; i++) {
-        vos_task_info_t ti;
-        int rc = sys_task_info(i, &ti);
-        if (rc < 0) {
-            continue;
-        }
+    puts("PID   PPID  USER  STATE  TICKS    RSS(K)  NAME");
+    for (int i = 0; i < total; i++) {
+        const vos_task_stat_t* t = &tasks[i];
+        const vos_task_info_t* ti = &t->info;
 
-        const char* user = ti.user ? "user" : "kern";
-        const char* st = state_str(ti.state);
+        const char* user = ti->user ? "user" : "kern";
+        const char* st = state_str(ti->state);
 
-        char mark = (ti.pid == (uint32_t)cur) ? '*' : ' ';
-        printf("%c%-4lu %-5s %-5s %-8lu 0x%08lx %s\n",
+        char mark = (ti->pid == (uint32_t)cur) ? '*' : ' ';
+        printf("%c%-4lu %-5lu %-5s %-5s %-8lu %-7lu %s\n",
                mark,
-               (unsigned long)ti.pid,
+               (unsigned long)ti->pid,
+               (unsigned long)t->ppid,
                user,
                st,
-               (unsigned long)ti.cpu_ticks,
-               (unsigned long)ti.eip,
-               ti.name);
+               (unsigned long)ti->cpu_ticks,
+               (unsigned long)t->rss_pages * 4u,
+               ti->name);
     }
 
+    free(tasks);
     return 0;
 }
-
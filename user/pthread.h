@@ -0,0 +1,146 @@
+/*
+ * pthread.h - POSIX threads for VOS
+ *
+ * Threads are kernel tasks created with SYS_CLONE that share the address
+ * space, file table and signal handlers of their process. Each thread's
+ * control block is reachable through %gs (SYS_SET_TLS). Blocking
+ * synchronization sleeps in the kernel on SYS_FUTEX.
+ * The actual implementation is in newlib_syscalls.c
+ */
+#ifndef _PTHREAD_H
+#define _PTHREAD_H
+
+#include <sys/types.h>
+#include <stddef.h>
+
+/*
+ * newlib may already have declared placeholder pthread types in
+ * <sys/types.h>; map the standard names onto the VOS definitions.
+ */
+#define pthread_t           vos_pthread_t
+#define pthread_attr_t      vos_pthread_attr_t
+#define pthread_mutex_t     vos_pthread_mutex_t
+#define pthread_mutexattr_t vos_pthread_mutexattr_t
+#define pthread_cond_t      vos_pthread_cond_t
+#define pthread_condattr_t  vos_pthread_condattr_t
+#define pthread_once_t      vos_pthread_once_t
+#define pthread_key_t       vos_pthread_key_t
+
+#undef PTHREAD_CREATE_DETACHED
+#undef PTHREAD_CREATE_JOINABLE
+#undef PTHREAD_MUTEX_NORMAL
+#undef PTHREAD_MUTEX_RECURSIVE
+#undef PTHREAD_MUTEX_ERRORCHECK
+#undef PTHREAD_MUTEX_DEFAULT
+#undef PTHREAD_MUTEX_INITIALIZER
+#undef PTHREAD_RECURSIVE_MUTEX_INITIALIZER
+#undef PTHREAD_COND_INITIALIZER
+#undef PTHREAD_ONCE_INIT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque thread handle */
+typedef struct vos_pthread* pthread_t;
+
+typedef struct {
+    int detachstate;
+    size_t stacksize;
+} pthread_attr_t;
+
+#define PTHREAD_CREATE_JOINABLE 0
+#define PTHREAD_CREATE_DETACHED 1
+
+/* Mutexes */
+#define PTHREAD_MUTEX_NORMAL     0
+#define PTHREAD_MUTEX_RECURSIVE  1
+#define PTHREAD_MUTEX_ERRORCHECK 2
+#define PTHREAD_MUTEX_DEFAULT    PTHREAD_MUTEX_NORMAL
+
+typedef struct {
+    volatile int lock;              /* futex: 0 = free, 1 = held, 2 = held with waiters */
+    int type;                       /* PTHREAD_MUTEX_* */
+    pthread_t owner;
+    unsigned int count;             /* recursion depth */
+} pthread_mutex_t;
+
+typedef struct {
+    int type;
+} pthread_mutexattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER           { 0, PTHREAD_MUTEX_NORMAL, NULL, 0 }
+#define PTHREAD_RECURSIVE_MUTEX_INITIALIZER { 0, PTHREAD_MUTEX_RECURSIVE, NULL, 0 }
+
+/* Condition variables */
+typedef struct {
+    volatile int seq;               /* futex: bumped by signal/broadcast */
+    pthread_mutex_t* mutex;         /* mutex of the last waiter (broadcast requeues onto it) */
+} pthread_cond_t;
+
+typedef struct {
+    int unused;
+} pthread_condattr_t;
+
+#define PTHREAD_COND_INITIALIZER { 0, NULL }
+
+/* One-time initialization */
+typedef struct {
+    volatile int state;             /* futex: 0 = not run, 1 = running, 2 = done */
+} pthread_once_t;
+
+#define PTHREAD_ONCE_INIT { 0 }
+
+/* Thread-specific data */
+#define PTHREAD_KEYS_MAX 32
+typedef unsigned int pthread_key_t;
+
+/* Threads */
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr,
+                   void* (*start_routine)(void*), void* arg);
+int pthread_join(pthread_t thread, void** retval);
+int pthread_detach(pthread_t thread);
+void pthread_exit(void* retval) __attribute__((noreturn));
+pthread_t pthread_self(void);
+int pthread_equal(pthread_t a, pthread_t b);
+
+int pthread_attr_init(pthread_attr_t* attr);
+int pthread_attr_destroy(pthread_attr_t* attr);
+int pthread_attr_setdetachstate(pthread_attr_t* attr, int state);
+int pthread_attr_getdetachstate(const pthread_attr_t* attr, int* state);
+int pthread_attr_setstacksize(pthread_attr_t* attr, size_t size);
+int pthread_attr_getstacksize(const pthread_attr_t* attr, size_t* size);
+
+/* Mutexes */
+int pthread_mutexattr_init(pthread_mutexattr_t* attr);
+int pthread_mutexattr_destroy(pthread_mutexattr_t* attr);
+int pthread_mutexattr_settype(pthread_mutexattr_t* attr, int type);
+int pthread_mutexattr_gettype(const pthread_mutexattr_t* attr, int* type);
+
+int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr);
+int pthread_mutex_destroy(pthread_mutex_t* mutex);
+int pthread_mutex_lock(pthread_mutex_t* mutex);
+int pthread_mutex_trylock(pthread_mutex_t* mutex);
+int pthread_mutex_unlock(pthread_mutex_t* mutex);
+
+/* Condition variables */
+int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr);
+int pthread_cond_destroy(pthread_cond_t* cond);
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+int pthread_cond_signal(pthread_cond_t* cond);
+int pthread_cond_broadcast(pthread_cond_t* cond);
+
+/* One-time initialization */
+int pthread_once(pthread_once_t* once, void (*init_routine)(void));
+
+/* Thread-specific data */
+int pthread_key_create(pthread_key_t* key, void (*destructor)(void*));
+int pthread_key_delete(pthread_key_t key);
+void* pthread_getspecific(pthread_key_t key);
+int pthread_setspecific(pthread_key_t key, const void* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PTHREAD_H */
@@ -3,10 +3,8 @@
 
 #include "SDL_stdinc.h"
 
-// Mutex (no-op for VOS - single threaded)
-typedef struct SDL_mutex {
-    int dummy;
-} SDL_mutex;
+// Mutex (recursive, backed by pthreads)
+typedef struct SDL_mutex SDL_mutex;
 
 SDL_mutex* SDL_CreateMutex(void);
 void SDL_DestroyMutex(SDL_mutex *mutex);
@@ -14,10 +12,8 @@ int SDL_LockMutex(SDL_mutex *mutex);
 int SDL_UnlockMutex(SDL_mutex *mutex);
 int SDL_TryLockMutex(SDL_mutex *mutex);
 
-// Semaphore stubs
-typedef struct SDL_sem {
-    int value;
-} SDL_sem;
+// Semaphore
+typedef struct SDL_sem SDL_sem;
 
 SDL_sem* SDL_CreateSemaphore(Uint32 initial_value);
 void SDL_DestroySemaphore(SDL_sem *sem);
@@ -26,10 +22,8 @@ int SDL_SemTryWait(SDL_sem *sem);
 int SDL_SemPost(SDL_sem *sem);
 Uint32 SDL_SemValue(SDL_sem *sem);
 
-// Condition variable stubs
-typedef struct SDL_cond {
-    int dummy;
-} SDL_cond;
+// Condition variable
+typedef struct SDL_cond SDL_cond;
 
 SDL_cond* SDL_CreateCond(void);
 void SDL_DestroyCond(SDL_cond *cond);
@@ -37,7 +31,7 @@ int SDL_CondSignal(SDL_cond *cond);
 int SDL_CondBroadcast(SDL_cond *cond);
 int SDL_CondWait(SDL_cond *cond, SDL_mutex *mutex);
 
-// Thread stubs (VOS has no threads)
+// Threads (pthreads on top of SYS_CLONE)
 typedef struct SDL_Thread SDL_Thread;
 typedef int (*SDL_ThreadFunction)(void *data);
 
@@ -1,159 +1,254 @@
 /*
- * SDL_mutex.c - VOS SDL2 mutex/thread stubs
+ * SDL_mutex.c - VOS SDL2 mutex/semaphore/condition/thread support
  *
- * VOS is single-threaded, so these are no-op stubs.
- * They exist to allow SDL2 applications that use mutexes
- * to compile and run (without actual thread safety).
+ * Built on the pthreads layer in newlib_syscalls.c: SDL threads are
+ * kernel threads created with SYS_CLONE, and the synchronization
+ * objects wrap pthread mutexes and condition variables.
  */
 
 #include "SDL2/SDL_mutex.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 
-/* Mutex functions - no-op since VOS is single-threaded */
+struct SDL_mutex {
+    pthread_mutex_t mutex;
+};
+
+struct SDL_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Uint32 value;
+};
+
+struct SDL_cond {
+    pthread_cond_t cond;
+};
+
+struct SDL_Thread {
+    pthread_t thread;
+    SDL_ThreadFunction fn;
+    void *data;
+    int status;
+    int refs;       /* thread + creator; the last one out frees it */
+};
+
+/* Mutex functions - SDL mutexes are recursive */
 
 SDL_mutex* SDL_CreateMutex(void) {
     SDL_mutex *mutex = (SDL_mutex*)malloc(sizeof(SDL_mutex));
     if (mutex) {
-        mutex->dummy = 0;
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&mutex->mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
     }
     return mutex;
 }
 
 void SDL_DestroyMutex(SDL_mutex *mutex) {
     if (mutex) {
+        pthread_mutex_destroy(&mutex->mutex);
         free(mutex);
     }
 }
 
 int SDL_LockMutex(SDL_mutex *mutex) {
-    (void)mutex;
-    return 0;  /* Success */
+    if (!mutex) {
+        return -1;
+    }
+    return pthread_mutex_lock(&mutex->mutex) == 0 ? 0 : -1;
 }
 
 int SDL_UnlockMutex(SDL_mutex *mutex) {
-    (void)mutex;
-    return 0;  /* Success */
+    if (!mutex) {
+        return -1;
+    }
+    return pthread_mutex_unlock(&mutex->mutex) == 0 ? 0 : -1;
 }
 
 int SDL_TryLockMutex(SDL_mutex *mutex) {
-    (void)mutex;
-    return 0;  /* Success - always acquired since no contention */
+    if (!mutex) {
+        return -1;
+    }
+    int rc = pthread_mutex_trylock(&mutex->mutex);
+    if (rc == 0) {
+        return 0;
+    }
+    return rc == EBUSY ? SDL_MUTEX_TIMEDOUT : -1;
 }
 
-/* Semaphore functions - maintain counter for compatibility */
+/* Semaphore functions */
 
 SDL_sem* SDL_CreateSemaphore(Uint32 initial_value) {
     SDL_sem *sem = (SDL_sem*)malloc(sizeof(SDL_sem));
     if (sem) {
-        sem->value = (int)initial_value;
+        pthread_mutex_init(&sem->lock, NULL);
+        pthread_cond_init(&sem->cond, NULL);
+        sem->value = initial_value;
     }
     return sem;
 }
 
 void SDL_DestroySemaphore(SDL_sem *sem) {
     if (sem) {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->lock);
         free(sem);
     }
 }
 
 int SDL_SemWait(SDL_sem *sem) {
-    if (sem && sem->value > 0) {
-        sem->value--;
-        return 0;  /* Success */
+    if (!sem) {
+        return -1;
     }
-    /* In a real threaded environment, this would block.
-     * Since VOS is single-threaded, we just return success
-     * to avoid deadlock. */
-    if (sem) {
-        sem->value--;
+    pthread_mutex_lock(&sem->lock);
+    while (sem->value == 0) {
+        pthread_cond_wait(&sem->cond, &sem->lock);
     }
+    sem->value--;
+    pthread_mutex_unlock(&sem->lock);
     return 0;
 }
 
 int SDL_SemTryWait(SDL_sem *sem) {
-    if (sem && sem->value > 0) {
+    if (!sem) {
+        return -1;
+    }
+    int rc = SDL_MUTEX_TIMEDOUT;  /* Would block */
+    pthread_mutex_lock(&sem->lock);
+    if (sem->value > 0) {
         sem->value--;
-        return 0;  /* Success */
+        rc = 0;
     }
-    return SDL_MUTEX_TIMEDOUT;  /* Would block */
+    pthread_mutex_unlock(&sem->lock);
+    return rc;
 }
 
 int SDL_SemPost(SDL_sem *sem) {
-    if (sem) {
-        sem->value++;
+    if (!sem) {
+        return -1;
     }
-    return 0;  /* Success */
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return 0;
 }
 
 Uint32 SDL_SemValue(SDL_sem *sem) {
-    if (sem) {
-        return (Uint32)(sem->value > 0 ? sem->value : 0);
+    if (!sem) {
+        return 0;
     }
-    return 0;
+    pthread_mutex_lock(&sem->lock);
+    Uint32 value = sem->value;
+    pthread_mutex_unlock(&sem->lock);
+    return value;
 }
 
-/* Condition variable functions - no-op stubs */
+/* Condition variable functions */
 
 SDL_cond* SDL_CreateCond(void) {
     SDL_cond *cond = (SDL_cond*)malloc(sizeof(SDL_cond));
     if (cond) {
-        cond->dummy = 0;
+        pthread_cond_init(&cond->cond, NULL);
     }
     return cond;
 }
 
 void SDL_DestroyCond(SDL_cond *cond) {
     if (cond) {
+        pthread_cond_destroy(&cond->cond);
         free(cond);
     }
 }
 
 int SDL_CondSignal(SDL_cond *cond) {
-    (void)cond;
-    return 0;  /* Success */
+    if (!cond) {
+        return -1;
+    }
+    return pthread_cond_signal(&cond->cond) == 0 ? 0 : -1;
 }
 
 int SDL_CondBroadcast(SDL_cond *cond) {
-    (void)cond;
-    return 0;  /* Success */
+    if (!cond) {
+        return -1;
+    }
+    return pthread_cond_broadcast(&cond->cond) == 0 ? 0 : -1;
 }
 
 int SDL_CondWait(SDL_cond *cond, SDL_mutex *mutex) {
-    (void)cond;
-    (void)mutex;
-    /* In a real threaded environment, this would block.
-     * Since VOS is single-threaded, we just return success. */
-    return 0;
+    if (!cond || !mutex) {
+        return -1;
+    }
+    return pthread_cond_wait(&cond->cond, &mutex->mutex) == 0 ? 0 : -1;
 }
 
-/* Thread functions - VOS has no threads, return NULL/0 */
+/* Thread functions */
+
+static void SDL_ReleaseThread(SDL_Thread *thread) {
+    if (__sync_sub_and_fetch(&thread->refs, 1) == 0) {
+        free(thread);
+    }
+}
+
+static void* SDL_RunThread(void *arg) {
+    SDL_Thread *thread = (SDL_Thread*)arg;
+    thread->status = thread->fn(thread->data);
+    SDL_ReleaseThread(thread);
+    return NULL;
+}
 
 SDL_Thread* SDL_CreateThread(SDL_ThreadFunction fn, const char *name, void *data) {
-    (void)fn;
     (void)name;
-    (void)data;
-    /* Cannot create threads in VOS - return NULL to indicate failure */
-    return NULL;
+    if (!fn) {
+        return NULL;
+    }
+
+    SDL_Thread *thread = (SDL_Thread*)calloc(1, sizeof(SDL_Thread));
+    if (!thread) {
+        return NULL;
+    }
+    thread->fn = fn;
+    thread->data = data;
+    thread->refs = 2;
+
+    if (pthread_create(&thread->thread, NULL, SDL_RunThread, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
 }
 
 void SDL_WaitThread(SDL_Thread *thread, int *status) {
-    (void)thread;
+    if (!thread) {
+        return;
+    }
+    pthread_join(thread->thread, NULL);
     if (status) {
-        *status = 0;
+        *status = thread->status;
     }
+    SDL_ReleaseThread(thread);
 }
 
 void SDL_DetachThread(SDL_Thread *thread) {
-    /* VOS has no threads - no-op */
-    (void)thread;
+    if (!thread) {
+        return;
+    }
+    pthread_detach(thread->thread);
+    SDL_ReleaseThread(thread);
 }
 
+/* Thread ids are the pthread handles, as in SDL's own pthread backend. */
 Uint32 SDL_GetThreadID(SDL_Thread *thread) {
-    (void)thread;
-    return 0;
+    if (!thread) {
+        return SDL_ThreadID();
+    }
+    return (Uint32)(uintptr_t)thread->thread;
 }
 
 Uint32 SDL_ThreadID(void) {
-    /* Return a constant "main thread" ID */
-    return 1;
+    return (Uint32)(uintptr_t)pthread_self();
 }
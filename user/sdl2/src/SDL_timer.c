@@ -1,8 +1,8 @@
 /*
  * SDL_timer.c - SDL2 Timer Subsystem Implementation for VOS
  *
- * Uses VOS syscalls for timing functionality:
- * - sys_uptime_ms() for getting milliseconds since boot
+ * Clocks are read from the kernel time page (vos_time_read), falling back to
+ * sys_uptime_ms()/sys_clock_gettime() if it is unavailable.
  * - sys_nanosleep() for precise delays
  */
 
@@ -13,26 +13,43 @@
 /* Ticks value at SDL initialization time */
 static Uint32 sdl_start_ticks = 0;
 
+/* Nanoseconds since boot. */
+static Uint64 SDL_MonotonicNs(void) {
+    uint64_t ns;
+    if (vos_time_read(&ns, NULL) == 0) {
+        return ns;
+    }
+    vos_timespec_t ts;
+    if (sys_clock_gettime(VOS_CLOCK_MONOTONIC, &ts) < 0) {
+        return (Uint64)sys_uptime_ms() * 1000000u;
+    }
+    return (Uint64)ts.tv_sec * 1000000000u + (Uint64)ts.tv_nsec;
+}
+
+static Uint32 SDL_UptimeMs(void) {
+    return (Uint32)(SDL_MonotonicNs() / 1000000u);
+}
+
 /**
  * Initialize the timer subsystem.
  * Records the starting tick count for relative time calculations.
  */
 void SDL_Timer_Init(void) {
-    sdl_start_ticks = sys_uptime_ms();
+    sdl_start_ticks = SDL_UptimeMs();
 }
 
 /**
  * Get milliseconds since SDL initialization (32-bit).
  */
 Uint32 SDL_GetTicks(void) {
-    return sys_uptime_ms() - sdl_start_ticks;
+    return SDL_UptimeMs() - sdl_start_ticks;
 }
 
 /**
  * Get milliseconds since SDL initialization (64-bit).
  */
 Uint64 SDL_GetTicks64(void) {
-    return (Uint64)(sys_uptime_ms() - sdl_start_ticks);
+    return (Uint64)(SDL_UptimeMs() - sdl_start_ticks);
 }
 
 /**
@@ -48,18 +65,18 @@ void SDL_Delay(Uint32 ms) {
 
 /**
  * Get high resolution performance counter.
- * Returns milliseconds since boot (VOS resolution).
+ * Returns nanoseconds since boot from the kernel's TSC-interpolated clock.
  */
 Uint64 SDL_GetPerformanceCounter(void) {
-    return (Uint64)sys_uptime_ms();
+    return SDL_MonotonicNs();
 }
 
 /**
  * Get performance counter frequency.
- * Returns 1000 since VOS provides millisecond resolution.
+ * The counter is in nanoseconds.
  */
 Uint64 SDL_GetPerformanceFrequency(void) {
-    return 1000;  /* millisecond resolution */
+    return 1000000000u;
 }
 
 /**
@@ -0,0 +1,270 @@
+// strace - trace the syscalls of a process
+// Usage: strace [-c] command [args...]
+//        strace [-c] -p pid
+//        strace -H syscall
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "syscall.h"
+
+#define BATCH 64
+
+static vos_syscall_stats_t stats;
+static vos_strace_entry_t entries[BATCH];
+static volatile sig_atomic_t interrupted = 0;
+
+// -c summary, tallied from the trace entries of the traced process only.
+static uint32_t sum_calls[VOS_SYSCALL_STATS_MAX];
+static uint32_t sum_errors[VOS_SYSCALL_STATS_MAX];
+static uint64_t sum_cycles[VOS_SYSCALL_STATS_MAX];
+
+static bool summary = false;
+static uint32_t next_seq = 0;
+static uint32_t lost = 0;
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-c] command [args...]\n", prog);
+    fprintf(stderr, "       %s [-c] -p pid\n", prog);
+    fprintf(stderr, "       %s -H syscall\n", prog);
+    exit(1);
+}
+
+static void on_sigint(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static const char* syscall_name(uint32_t num) {
+    if (num < stats.num_syscalls && num < VOS_SYSCALL_STATS_MAX && stats.names[num][0]) {
+        return stats.names[num];
+    }
+    return "?";
+}
+
+static unsigned long cycles_to_us(uint64_t cycles) {
+    if (!stats.tsc_khz) {
+        return 0;
+    }
+    return (unsigned long)(cycles * 1000u / stats.tsc_khz);
+}
+
+static void print_entry(const vos_strace_entry_t* e, int pid) {
+    if ((int)e->tid != pid) {
+        fprintf(stderr, "[%lu] ", (unsigned long)e->tid);
+    }
+    fprintf(stderr, "%s(%#lx, %#lx, %#lx) = %ld", syscall_name(e->num),
+            (unsigned long)e->args[0], (unsigned long)e->args[1], (unsigned long)e->args[2],
+            (long)e->ret);
+    if (stats.tsc_khz) {
+        fprintf(stderr, " <%lu us>", cycles_to_us(e->cycles));
+    }
+    fputc('\n', stderr);
+}
+
+// Drain the kernel ring; returns how many entries were read.
+static int drain(int pid) {
+    int total = 0;
+    for (;;) {
+        int n = sys_strace_read(entries, BATCH);
+        if (n <= 0) {
+            return total;
+        }
+        for (int i = 0; i < n; i++) {
+            const vos_strace_entry_t* e = &entries[i];
+            if (e->seq != next_seq) {
+                lost += e->seq - next_seq;
+                if (!summary) {
+                    fprintf(stderr, "... %lu entries lost ...\n", (unsigned long)(e->seq - next_seq));
+                }
+            }
+            next_seq = e->seq + 1u;
+
+            if (summary) {
+                if (e->num < VOS_SYSCALL_STATS_MAX) {
+                    sum_calls[e->num]++;
+                    sum_cycles[e->num] += e->cycles;
+                    if (e->ret < 0) {
+                        sum_errors[e->num]++;
+                    }
+                }
+            } else {
+                print_entry(e, pid);
+            }
+        }
+        total += n;
+    }
+}
+
+static void print_summary(void) {
+    fprintf(stderr, "%-16s %8s %8s %12s %10s\n", "syscall", "calls", "errors", "total us", "avg us");
+    uint32_t calls = 0;
+    uint64_t cycles = 0;
+    for (uint32_t i = 0; i < VOS_SYSCALL_STATS_MAX; i++) {
+        if (!sum_calls[i]) {
+            continue;
+        }
+        fprintf(stderr, "%-16s %8lu %8lu %12lu %10lu\n", syscall_name(i),
+                (unsigned long)sum_calls[i], (unsigned long)sum_errors[i],
+                cycles_to_us(sum_cycles[i]), cycles_to_us(sum_cycles[i] / sum_calls[i]));
+        calls += sum_calls[i];
+        cycles += sum_cycles[i];
+    }
+    fprintf(stderr, "%-16s %8lu %8s %12lu\n", "total", (unsigned long)calls, "", cycles_to_us(cycles));
+    if (lost) {
+        fprintf(stderr, "(%lu entries lost)\n", (unsigned long)lost);
+    }
+    if (!stats.tsc_khz) {
+        fprintf(stderr, "(no TSC: times unavailable)\n");
+    }
+}
+
+static int show_histogram(const char* name) {
+    uint32_t num = VOS_SYSCALL_STATS_MAX;
+    for (uint32_t i = 0; i < stats.num_syscalls && i < VOS_SYSCALL_STATS_MAX; i++) {
+        if (strcmp(stats.names[i], name) == 0) {
+            num = i;
+            break;
+        }
+    }
+    if (num == VOS_SYSCALL_STATS_MAX) {
+        char* end;
+        long n = strtol(name, &end, 10);
+        if (*end != '\0' || n < 0 || n >= (long)stats.num_syscalls) {
+            fprintf(stderr, "strace: unknown syscall '%s'\n", name);
+            return 1;
+        }
+        num = (uint32_t)n;
+    }
+
+    uint32_t hist[VOS_STRACE_HIST_BUCKETS];
+    int rc = sys_syscall_hist(num, hist);
+    if (rc < 0) {
+        fprintf(stderr, "strace: histogram: %s\n", strerror(-rc));
+        return 1;
+    }
+
+    uint32_t peak = 0;
+    for (int b = 0; b < VOS_STRACE_HIST_BUCKETS; b++) {
+        if (hist[b] > peak) {
+            peak = hist[b];
+        }
+    }
+    printf("%s: %lu calls\n", syscall_name(num), (unsigned long)stats.counts[num]);
+    if (!stats.tsc_khz || peak == 0) {
+        printf("(no timed calls)\n");
+        return 0;
+    }
+    printf("%14s %10s\n", "cycles >=", "count");
+    for (int b = 0; b < VOS_STRACE_HIST_BUCKETS; b++) {
+        if (!hist[b]) {
+            continue;
+        }
+        char bar[41];
+        int len = (int)((uint64_t)hist[b] * 40u / peak);
+        memset(bar, '#', (size_t)len);
+        bar[len] = '\0';
+        printf("%14lu %10lu %s\n", b ? 1ul << b : 0ul, (unsigned long)hist[b], bar);
+    }
+    return 0;
+}
+
+static int trace_pid(int pid) {
+    int rc = sys_strace_attach(pid);
+    if (rc < 0) {
+        fprintf(stderr, "strace: attach %d: %s\n", pid, strerror(-rc));
+        return 1;
+    }
+    while (!interrupted && kill(pid, 0) == 0) {
+        if (drain(pid) == 0) {
+            usleep(10000);
+        }
+    }
+    drain(pid);
+    sys_strace_attach(0);
+    return 0;
+}
+
+static int trace_command(char** argv) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("strace: fork");
+        return 1;
+    }
+    if (pid == 0) {
+        // Attach from the child so the trace starts at execve().
+        int rc = sys_strace_attach(getpid());
+        if (rc < 0) {
+            fprintf(stderr, "strace: attach: %s\n", strerror(-rc));
+            _exit(127);
+        }
+        execvp(argv[0], argv);
+        fprintf(stderr, "strace: %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+
+    int status = 0;
+    for (;;) {
+        if (drain(pid) > 0) {
+            continue;
+        }
+        pid_t w = waitpid(pid, &status, WNOHANG);
+        if (w == pid) {
+            break;
+        }
+        if (w < 0 && errno != EINTR) {
+            break;
+        }
+        usleep(10000);
+    }
+    drain(pid);
+    sys_strace_attach(0);
+
+    if (WIFEXITED(status)) {
+        fprintf(stderr, "+++ exited with %d +++\n", WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+        fprintf(stderr, "+++ killed by signal %d +++\n", WTERMSIG(status));
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int pid = 0;
+    const char* hist_name = NULL;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            summary = true;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pid = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            hist_name = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (sys_syscall_stats(&stats) < 0) {
+        fprintf(stderr, "strace: cannot read syscall table\n");
+        return 1;
+    }
+    if (hist_name) {
+        return show_histogram(hist_name);
+    }
+    if ((pid > 0) == (i < argc)) {
+        usage(argv[0]);
+    }
+
+    signal(SIGINT, on_sigint);
+    int rc = pid > 0 ? trace_pid(pid) : trace_command(&argv[i]);
+    if (rc == 0 && summary) {
+        print_summary();
+    }
+    return rc;
+}
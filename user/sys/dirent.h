@@ -6,7 +6,7 @@
 // Minimal dirent support for VOS/newlib.
 // Newlib's upstream i686-elf headers ship a <dirent.h> wrapper but disable
 // <sys/dirent.h> for bare-metal targets. VOS provides a small implementation
-// backed by SYS_READDIR.
+// backed by SYS_GETDENTS.
 
 #ifndef DT_UNKNOWN
 #define DT_UNKNOWN 0
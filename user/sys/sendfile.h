@@ -0,0 +1,24 @@
+#ifndef VOS_SYS_SENDFILE_H
+#define VOS_SYS_SENDFILE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+// Linux declares splice() in <fcntl.h>; newlib's has no room for it.
+#define SPLICE_F_MOVE     0x01
+#define SPLICE_F_NONBLOCK 0x02
+#define SPLICE_F_MORE     0x04
+
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef VOS_SYS_UIO_H
+#define VOS_SYS_UIO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOV_MAX 64
+#define UIO_MAXIOV IOV_MAX
+
+struct iovec {
+    void* iov_base;
+    size_t iov_len;
+};
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
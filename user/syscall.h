@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "vos_time.h"
+
 typedef struct vos_rtc_datetime {
     uint16_t year;
     uint8_t month;
@@ -25,6 +27,20 @@ typedef struct vos_task_info {
     char name[16];
 } vos_task_info_t;
 
+// SYS_TASK_SNAPSHOT record. Times are in timer ticks.
+typedef struct vos_task_stat {
+    vos_task_info_t info;
+    uint32_t tgid;
+    uint32_t ppid;
+    uint32_t uid;
+    uint32_t sys_ticks;       // part of info.cpu_ticks spent in the kernel
+    uint32_t rss_pages;       // 4 KB user pages mapped
+    uint32_t faults;
+    uint32_t switches;        // times scheduled in
+    uint32_t start_tick;
+    uint32_t state_ticks[4];  // indexed by info.state: run, sleep, wait, zombie
+} vos_task_stat_t;
+
 typedef struct vos_font_info {
     char name[32];
     uint32_t width;
@@ -69,6 +85,10 @@ typedef struct vos_sched_stats {
     uint32_t sleeping;
     uint32_t waiting;
     uint32_t zombie;
+    uint32_t kstacks_in_use;    // kernel stacks owned by tasks
+    uint32_t kstacks_cached;    // freed stacks kept mapped for reuse
+    uint32_t kstack_size;
+    uint32_t kstack_max_depth;  // deepest kernel stack use seen, in bytes
 } vos_sched_stats_t;
 
 typedef struct vos_descriptor_info {
@@ -79,13 +99,33 @@ typedef struct vos_descriptor_info {
     uint32_t tss_esp0;
 } vos_descriptor_info_t;
 
-#define VOS_SYSCALL_STATS_MAX 80
+#define VOS_SYSCALL_STATS_MAX 128
 typedef struct vos_syscall_stats {
     uint32_t num_syscalls;                  // Total number of syscalls supported
+    uint32_t tsc_khz;                       // TSC cycles per ms; 0 = no timing
     uint32_t counts[VOS_SYSCALL_STATS_MAX]; // Count for each syscall
     char names[VOS_SYSCALL_STATS_MAX][16];  // Name of each syscall
+    uint64_t total_cycles[VOS_SYSCALL_STATS_MAX]; // Time spent, entry to resume
+    uint64_t max_cycles[VOS_SYSCALL_STATS_MAX];   // Slowest single call
 } vos_syscall_stats_t;
 
+// SYS_SYSCALL_TRACE: one process at a time can have its completed syscalls
+// logged to a kernel ring, and per-syscall log2 latency histograms can be read.
+#define VOS_STRACE_ATTACH 0                 // trace pid (0 = stop); resets the ring
+#define VOS_STRACE_READ   1                 // drain entries
+#define VOS_STRACE_HIST   2                 // histogram of one syscall
+#define VOS_STRACE_HIST_BUCKETS 32          // bucket b: [2^b, 2^(b+1)) cycles
+
+typedef struct vos_strace_entry {
+    uint32_t seq;                           // gaps mean entries were lost
+    uint32_t tid;
+    uint32_t num;
+    uint32_t args[5];                       // ebx, ecx, edx, esi, edi
+    int32_t ret;
+    uint32_t reserved;
+    uint64_t cycles;
+} vos_strace_entry_t;
+
 // Disk/mount information for sysview
 #define VOS_MAX_DISKS 8
 typedef struct vos_disk_info {
@@ -102,8 +142,19 @@ typedef struct vos_disk_info {
 typedef struct vos_disks_info {
     uint32_t count;                         // Number of mounted filesystems
     vos_disk_info_t disks[VOS_MAX_DISKS];   // Info for each mount
+    uint32_t cache_buffers;                 // Buffer cache (512-byte sectors)
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t cache_writebacks;              // Sectors written back to disk
+    uint32_t cache_dirty;                   // Sectors waiting for write-back
 } vos_disks_info_t;
 
+// Syscall instruction: call the kernel's trampoline page (include/vdso.h),
+// which enters through SYSENTER when the CPU has it and int 0x80 otherwise.
+// Same register ABI as int 0x80; only eax is modified.
+#define VOS_VSYSCALL 0xED001000u
+#define VOS_SYSCALL  "call *0xED001000"
+
 enum {
     SYS_WRITE = 0,
     SYS_EXIT = 1,
@@ -208,8 +259,60 @@ enum {
     SYS_DISK_INFO = 100,
     SYS_SET_CONSOLE = 101,
     SYS_PIVOT_ROOT = 102,
+    SYS_CLONE = 103,
+    SYS_THREAD_EXIT = 104,
+    SYS_GETTID = 105,
+    SYS_SET_TLS = 106,
+    SYS_FUTEX = 107,
+    SYS_URING_SETUP = 108,
+    SYS_URING_ENTER = 109,
+    SYS_SYSCALL_TRACE = 110,
+    SYS_EPOLL_CREATE = 111,
+    SYS_EPOLL_CTL = 112,
+    SYS_EPOLL_WAIT = 113,
+    SYS_READV = 114,
+    SYS_WRITEV = 115,
+    SYS_PREAD = 116,
+    SYS_PWRITE = 117,
+    SYS_SENDFILE = 118,
+    SYS_SPLICE = 119,
+    SYS_GETDENTS = 120,
+    SYS_OPENAT = 121,
+    SYS_FSTATAT = 122,
+    SYS_MKDIRAT = 123,
+    SYS_UNLINKAT = 124,
+    SYS_RENAMEAT = 125,
+    SYS_TASK_SNAPSHOT = 126,
 };
 
+// Directory-relative path syscalls.
+#define VOS_AT_FDCWD            (-100)
+#define VOS_AT_SYMLINK_NOFOLLOW 0x100
+#define VOS_AT_REMOVEDIR        0x200
+
+// SYS_GETDENTS record: header, NUL-terminated name, padded to 4 bytes.
+typedef struct vos_dirent_rec {
+    uint16_t reclen;
+    uint8_t type;       // DT_DIR, DT_REG or DT_LNK
+    uint8_t name_len;
+    uint16_t mode;
+    uint16_t wtime;
+    uint16_t wdate;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t uid;
+    uint32_t gid;
+    char name[];
+} vos_dirent_rec_t;
+
+// readv/writev segment; same layout as struct iovec.
+typedef struct vos_iovec {
+    void* base;
+    uint32_t len;
+} vos_iovec_t;
+
+#define VOS_IOV_MAX 64
+
 // For select() syscall
 typedef struct vos_timeval {
     int32_t tv_sec;
@@ -267,7 +370,7 @@ typedef struct vos_pollfd {
 static inline int sys_write(int fd, const char* buf, uint32_t len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WRITE), "b"(fd), "c"(buf), "d"(len)
         : "memory"
@@ -277,7 +380,7 @@ static inline int sys_write(int fd, const char* buf, uint32_t len) {
 
 static inline void sys_yield(void) {
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         :
         : "a"(SYS_YIELD)
         : "memory"
@@ -287,7 +390,7 @@ static inline void sys_yield(void) {
 static inline int sys_sleep(uint32_t ms) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SLEEP), "b"(ms)
         : "memory"
@@ -298,7 +401,7 @@ static inline int sys_sleep(uint32_t ms) {
 static inline int sys_wait(uint32_t pid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WAIT), "b"(pid)
         : "memory"
@@ -309,7 +412,7 @@ static inline int sys_wait(uint32_t pid) {
 static inline int sys_waitpid(int pid, int* status, int options) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_WAITPID), "b"(pid), "c"(status), "d"(options)
         : "memory"
@@ -320,7 +423,7 @@ static inline int sys_waitpid(int pid, int* status, int options) {
 static inline int sys_statfs(const char* path, vos_statfs_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_STATFS), "b"(path), "c"(out)
         : "memory"
@@ -331,7 +434,7 @@ static inline int sys_statfs(const char* path, vos_statfs_t* out) {
 static inline int sys_kill(int pid, int code) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_KILL), "b"(pid), "c"(code)
         : "memory"
@@ -342,7 +445,7 @@ static inline int sys_kill(int pid, int code) {
 static inline int sys_getppid(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETPPID)
         : "memory"
@@ -353,7 +456,7 @@ static inline int sys_getppid(void) {
 static inline int sys_getpgrp(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETPGRP)
         : "memory"
@@ -364,7 +467,7 @@ static inline int sys_getpgrp(void) {
 static inline int sys_setpgid(int pid, int pgid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETPGID), "b"(pid), "c"(pgid)
         : "memory"
@@ -375,7 +478,7 @@ static inline int sys_setpgid(int pid, int pgid) {
 static inline void* sys_sbrk(int32_t increment) {
     void* ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SBRK), "b"(increment)
         : "memory"
@@ -386,7 +489,7 @@ static inline void* sys_sbrk(int32_t increment) {
 static inline int sys_readfile(const char* path, void* buf, uint32_t buf_len, uint32_t offset) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_READFILE), "b"(path), "c"(buf), "d"(buf_len), "S"(offset)
         : "memory"
@@ -397,7 +500,7 @@ static inline int sys_readfile(const char* path, void* buf, uint32_t buf_len, ui
 static inline int sys_open(const char* path, uint32_t flags) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_OPEN), "b"(path), "c"(flags)
         : "memory"
@@ -408,7 +511,7 @@ static inline int sys_open(const char* path, uint32_t flags) {
 static inline int sys_read(int fd, void* buf, uint32_t len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_READ), "b"(fd), "c"(buf), "d"(len)
         : "memory"
@@ -419,7 +522,7 @@ static inline int sys_read(int fd, void* buf, uint32_t len) {
 static inline int sys_close(int fd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CLOSE), "b"(fd)
         : "memory"
@@ -429,7 +532,7 @@ static inline int sys_close(int fd) {
 
 __attribute__((noreturn)) static inline void sys_exit(int code) {
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         :
         : "a"(SYS_EXIT), "b"(code)
         : "memory"
@@ -442,7 +545,7 @@ __attribute__((noreturn)) static inline void sys_exit(int code) {
 static inline int sys_fork(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FORK)
         : "memory"
@@ -453,7 +556,7 @@ static inline int sys_fork(void) {
 static inline int sys_execve(const char* path, const char* const* argv, uint32_t argc) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_EXECVE), "b"(path), "c"(argv), "d"(argc)
         : "memory"
@@ -464,7 +567,7 @@ static inline int sys_execve(const char* path, const char* const* argv, uint32_t
 static inline int sys_spawn(const char* path, const char* const* argv, uint32_t argc) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SPAWN), "b"(path), "c"(argv), "d"(argc)
         : "memory"
@@ -475,7 +578,7 @@ static inline int sys_spawn(const char* path, const char* const* argv, uint32_t
 static inline uint32_t sys_uptime_ms(void) {
     uint32_t ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_UPTIME_MS)
         : "memory"
@@ -486,7 +589,7 @@ static inline uint32_t sys_uptime_ms(void) {
 static inline int sys_rtc_get(vos_rtc_datetime_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RTC_GET), "b"(out)
         : "memory"
@@ -497,7 +600,7 @@ static inline int sys_rtc_get(vos_rtc_datetime_t* out) {
 static inline int sys_rtc_set(const vos_rtc_datetime_t* dt) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_RTC_SET), "b"(dt)
         : "memory"
@@ -508,7 +611,7 @@ static inline int sys_rtc_set(const vos_rtc_datetime_t* dt) {
 static inline int sys_task_count(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_TASK_COUNT)
         : "memory"
@@ -519,7 +622,7 @@ static inline int sys_task_count(void) {
 static inline int sys_task_info(uint32_t index, vos_task_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_TASK_INFO), "b"(index), "c"(out)
         : "memory"
@@ -527,10 +630,50 @@ static inline int sys_task_info(uint32_t index, vos_task_info_t* out) {
     return ret;
 }
 
+// Records the kernel copies per SYS_TASK_SNAPSHOT call.
+#define VOS_TASK_SNAPSHOT_BATCH 256u
+
+// Copy up to `max` task records (at most VOS_TASK_SNAPSHOT_BATCH), skipping
+// the first `start` tasks. Returns the total number of tasks.
+static inline int sys_task_snapshot(vos_task_stat_t* out, uint32_t max, uint32_t start) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_TASK_SNAPSHOT), "b"(out), "c"(max), "d"(start)
+        : "memory"
+    );
+    return ret;
+}
+
+// Copy up to `max` task records, paging past the per-call batch limit.
+// Returns the number of tasks, which is larger than `max` if the buffer was
+// too small, or -errno.
+static inline int vos_task_snapshot_all(vos_task_stat_t* out, uint32_t max) {
+    uint32_t got = 0;
+    for (;;) {
+        int total = sys_task_snapshot(out + got, max - got, got);
+        if (total < 0) {
+            return total;
+        }
+        uint32_t n = (uint32_t)total > got ? (uint32_t)total - got : 0;
+        if (n > max - got) {
+            n = max - got;
+        }
+        if (n > VOS_TASK_SNAPSHOT_BATCH) {
+            n = VOS_TASK_SNAPSHOT_BATCH;
+        }
+        got += n;
+        if (n == 0 || got >= max || got >= (uint32_t)total) {
+            return total;
+        }
+    }
+}
+
 static inline int sys_screen_is_fb(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SCREEN_IS_FB)
         : "memory"
@@ -541,7 +684,7 @@ static inline int sys_screen_is_fb(void) {
 static inline int sys_gfx_clear(uint32_t bg) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_CLEAR), "b"(bg)
         : "memory"
@@ -552,7 +695,7 @@ static inline int sys_gfx_clear(uint32_t bg) {
 static inline int sys_gfx_pset(int32_t x, int32_t y, uint32_t color) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_PSET), "b"(x), "c"(y), "d"(color)
         : "memory"
@@ -563,7 +706,7 @@ static inline int sys_gfx_pset(int32_t x, int32_t y, uint32_t color) {
 static inline int sys_gfx_line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_LINE), "b"(x0), "c"(y0), "d"(x1), "S"(y1), "D"(color)
         : "memory"
@@ -574,7 +717,7 @@ static inline int sys_gfx_line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, u
 static inline int sys_gfx_blit_rgba(int32_t x, int32_t y, uint32_t w, uint32_t h, const void* rgba) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_BLIT_RGBA), "b"(x), "c"(y), "d"(w), "S"(h), "D"(rgba)
         : "memory"
@@ -586,7 +729,7 @@ static inline int sys_gfx_blit_rgba(int32_t x, int32_t y, uint32_t w, uint32_t h
 static inline int sys_gfx_flip(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_FLIP)
         : "memory"
@@ -598,7 +741,7 @@ static inline int sys_gfx_flip(void) {
 static inline int sys_gfx_double_buffer(int enable) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GFX_DOUBLE_BUFFER), "b"(enable)
         : "memory"
@@ -609,7 +752,7 @@ static inline int sys_gfx_double_buffer(int enable) {
 static inline uint32_t sys_mem_total_kb(void) {
     uint32_t ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MEM_TOTAL_KB)
         : "memory"
@@ -620,7 +763,7 @@ static inline uint32_t sys_mem_total_kb(void) {
 static inline int sys_cpu_vendor(char* buf, uint32_t len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CPU_VENDOR), "b"(buf), "c"(len)
         : "memory"
@@ -631,7 +774,7 @@ static inline int sys_cpu_vendor(char* buf, uint32_t len) {
 static inline int sys_cpu_brand(char* buf, uint32_t len) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CPU_BRAND), "b"(buf), "c"(len)
         : "memory"
@@ -642,7 +785,7 @@ static inline int sys_cpu_brand(char* buf, uint32_t len) {
 static inline int sys_vfs_file_count(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_VFS_FILE_COUNT)
         : "memory"
@@ -653,7 +796,7 @@ static inline int sys_vfs_file_count(void) {
 static inline int sys_font_count(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FONT_COUNT)
         : "memory"
@@ -664,7 +807,7 @@ static inline int sys_font_count(void) {
 static inline int sys_font_get_current(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FONT_GET)
         : "memory"
@@ -675,7 +818,7 @@ static inline int sys_font_get_current(void) {
 static inline int sys_font_info(uint32_t index, vos_font_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FONT_INFO), "b"(index), "c"(out)
         : "memory"
@@ -686,7 +829,7 @@ static inline int sys_font_info(uint32_t index, vos_font_info_t* out) {
 static inline int sys_font_set(uint32_t index) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_FONT_SET), "b"(index)
         : "memory"
@@ -698,7 +841,7 @@ static inline void* sys_mmap(void* addr, uint32_t length, uint32_t prot, uint32_
     (void)offset; // file-backed mappings aren't supported yet
     void* ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MMAP), "b"(addr), "c"(length), "d"(prot), "S"(flags), "D"(fd)
         : "memory"
@@ -709,7 +852,7 @@ static inline void* sys_mmap(void* addr, uint32_t length, uint32_t prot, uint32_
 static inline int sys_munmap(void* addr, uint32_t length) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MUNMAP), "b"(addr), "c"(length)
         : "memory"
@@ -720,7 +863,7 @@ static inline int sys_munmap(void* addr, uint32_t length) {
 static inline int sys_mprotect(void* addr, uint32_t length, uint32_t prot) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_MPROTECT), "b"(addr), "c"(length), "d"(prot)
         : "memory"
@@ -731,7 +874,7 @@ static inline int sys_mprotect(void* addr, uint32_t length, uint32_t prot) {
 static inline uint32_t sys_getuid(void) {
     uint32_t ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETUID)
         : "memory"
@@ -742,7 +885,7 @@ static inline uint32_t sys_getuid(void) {
 static inline uint32_t sys_getgid(void) {
     uint32_t ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETGID)
         : "memory"
@@ -753,7 +896,7 @@ static inline uint32_t sys_getgid(void) {
 static inline int sys_setuid(uint32_t uid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETUID), "b"(uid)
         : "memory"
@@ -764,7 +907,7 @@ static inline int sys_setuid(uint32_t uid) {
 static inline int sys_setgid(uint32_t gid) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SETGID), "b"(gid)
         : "memory"
@@ -776,7 +919,7 @@ static inline int sys_setgid(uint32_t gid) {
 static inline int sys_pmm_info(vos_pmm_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_PMM_INFO), "b"(out)
         : "memory"
@@ -787,7 +930,7 @@ static inline int sys_pmm_info(vos_pmm_info_t* out) {
 static inline int sys_heap_info(vos_heap_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_HEAP_INFO), "b"(out)
         : "memory"
@@ -798,7 +941,7 @@ static inline int sys_heap_info(vos_heap_info_t* out) {
 static inline int sys_timer_info(vos_timer_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_TIMER_INFO), "b"(out)
         : "memory"
@@ -809,7 +952,7 @@ static inline int sys_timer_info(vos_timer_info_t* out) {
 static inline int sys_irq_stats(vos_irq_stats_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_IRQ_STATS), "b"(out)
         : "memory"
@@ -820,7 +963,7 @@ static inline int sys_irq_stats(vos_irq_stats_t* out) {
 static inline int sys_sched_stats(vos_sched_stats_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SCHED_STATS), "b"(out)
         : "memory"
@@ -831,7 +974,7 @@ static inline int sys_sched_stats(vos_sched_stats_t* out) {
 static inline int sys_descriptor_info(vos_descriptor_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_DESCRIPTOR_INFO), "b"(out)
         : "memory"
@@ -842,7 +985,7 @@ static inline int sys_descriptor_info(vos_descriptor_info_t* out) {
 static inline int sys_syscall_stats(vos_syscall_stats_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SYSCALL_STATS), "b"(out)
         : "memory"
@@ -853,7 +996,7 @@ static inline int sys_syscall_stats(vos_syscall_stats_t* out) {
 static inline int sys_disk_info(vos_disks_info_t* out) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_DISK_INFO), "b"(out)
         : "memory"
@@ -865,7 +1008,7 @@ static inline int sys_select(int nfds, vos_fd_set_t* readfds, vos_fd_set_t* writ
                              vos_fd_set_t* exceptfds, vos_timeval_t* timeout) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SELECT), "b"(nfds), "c"(readfds), "d"(writefds), "S"(exceptfds), "D"(timeout)
         : "memory"
@@ -877,7 +1020,7 @@ static inline int sys_select(int nfds, vos_fd_set_t* readfds, vos_fd_set_t* writ
 static inline int sys_theme_count(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_THEME_COUNT)
         : "memory"
@@ -888,7 +1031,7 @@ static inline int sys_theme_count(void) {
 static inline int sys_theme_get_current(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_THEME_GET)
         : "memory"
@@ -899,7 +1042,7 @@ static inline int sys_theme_get_current(void) {
 static inline int sys_theme_info(uint32_t index, char* name, uint32_t name_cap) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_THEME_INFO), "b"(index), "c"(name), "d"(name_cap)
         : "memory"
@@ -910,7 +1053,7 @@ static inline int sys_theme_info(uint32_t index, char* name, uint32_t name_cap)
 static inline int sys_theme_set(uint32_t index) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_THEME_SET), "b"(index)
         : "memory"
@@ -924,7 +1067,7 @@ static inline int sys_gettimeofday(vos_timeval_t* tv, void* tz) {
     (void)tz;  // timezone ignored
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_GETTIMEOFDAY), "b"(tv)
         : "memory"
@@ -935,7 +1078,7 @@ static inline int sys_gettimeofday(vos_timeval_t* tv, void* tz) {
 static inline int sys_clock_gettime(int clockid, vos_timespec_t* tp) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_CLOCK_GETTIME), "b"(clockid), "c"(tp)
         : "memory"
@@ -946,7 +1089,7 @@ static inline int sys_clock_gettime(int clockid, vos_timespec_t* tp) {
 static inline int sys_nanosleep(const vos_timespec_t* req, vos_timespec_t* rem) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_NANOSLEEP), "b"(req), "c"(rem)
         : "memory"
@@ -957,7 +1100,7 @@ static inline int sys_nanosleep(const vos_timespec_t* req, vos_timespec_t* rem)
 static inline int sys_access(const char* path, int mode) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_ACCESS), "b"(path), "c"(mode)
         : "memory"
@@ -968,7 +1111,7 @@ static inline int sys_access(const char* path, int mode) {
 static inline int sys_isatty(int fd) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_ISATTY), "b"(fd)
         : "memory"
@@ -979,7 +1122,7 @@ static inline int sys_isatty(int fd) {
 static inline int sys_uname(vos_utsname_t* buf) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_UNAME), "b"(buf)
         : "memory"
@@ -990,7 +1133,7 @@ static inline int sys_uname(vos_utsname_t* buf) {
 static inline int sys_poll(vos_pollfd_t* fds, uint32_t nfds, int timeout_ms) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_POLL), "b"(fds), "c"(nfds), "d"(timeout_ms)
         : "memory"
@@ -1002,7 +1145,7 @@ static inline int sys_poll(vos_pollfd_t* fds, uint32_t nfds, int timeout_ms) {
 static inline int sys_beep(uint32_t frequency, uint32_t duration_ms) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_BEEP), "b"(frequency), "c"(duration_ms)
         : "memory"
@@ -1017,7 +1160,7 @@ static inline int sys_beep(uint32_t frequency, uint32_t duration_ms) {
 static inline int sys_audio_open(uint32_t sample_rate, uint8_t bits, uint8_t channels) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_AUDIO_OPEN), "b"(sample_rate), "c"(bits), "d"(channels)
         : "memory"
@@ -1030,7 +1173,7 @@ static inline int sys_audio_open(uint32_t sample_rate, uint8_t bits, uint8_t cha
 static inline int sys_audio_write(int handle, const void* samples, uint32_t bytes) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_AUDIO_WRITE), "b"(handle), "c"(samples), "d"(bytes)
         : "memory"
@@ -1042,7 +1185,7 @@ static inline int sys_audio_write(int handle, const void* samples, uint32_t byte
 static inline int sys_audio_close(int handle) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_AUDIO_CLOSE), "b"(handle)
         : "memory"
@@ -1054,7 +1197,7 @@ static inline int sys_audio_close(int handle) {
 static inline int sys_set_console(int console) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_SET_CONSOLE), "b"(console)
         : "memory"
@@ -1066,7 +1209,7 @@ static inline int sys_set_console(int console) {
 static inline int sys_pivot_root(void) {
     int ret;
     __asm__ volatile (
-        "int $0x80"
+        VOS_SYSCALL
         : "=a"(ret)
         : "a"(SYS_PIVOT_ROOT)
         : "memory"
@@ -1074,4 +1217,308 @@ static inline int sys_pivot_root(void) {
     return ret;
 }
 
+// Threads. SYS_CLONE switches stacks under the caller, so it has no plain C
+// wrapper here; use pthread_create() from <pthread.h>.
+static inline int sys_gettid(void) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_GETTID)
+        : "memory"
+    );
+    return ret;
+}
+
+// Point the %gs TLS segment at `base`; returns the selector to load.
+static inline int sys_set_tls(const void* base) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SET_TLS), "b"(base)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_thread_exit(int code) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_THREAD_EXIT), "b"(code)
+        : "memory"
+    );
+    return ret;
+}
+
+// futex(uaddr, op, val, timeout_or_val2, uaddr2). FUTEX_CMP_REQUEUE also
+// needs val3 in %ebp and has no wrapper here.
+#define FUTEX_WAIT         0
+#define FUTEX_WAKE         1
+#define FUTEX_REQUEUE      3
+#define FUTEX_CMP_REQUEUE  4
+#define FUTEX_PRIVATE_FLAG 128
+
+static inline int sys_futex(volatile int* uaddr, int op, int val, const void* timeout_or_val2,
+                            volatile int* uaddr2) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_FUTEX), "b"(uaddr), "c"(op), "d"(val), "S"(timeout_or_val2), "D"(uaddr2)
+        : "memory"
+    );
+    return ret;
+}
+
+// Batched syscall ring. One block of memory holds the header, sq_entries
+// submission entries and cq_entries completion entries (VOS_URING_SIZE).
+// Queue SQEs at sq_tail, call sys_uring_enter(), then reap CQEs from
+// cq_head up to cq_tail. Disk-bound opens, stats, closes and fsyncs (and
+// anything flagged VOS_URING_SQE_ASYNC) complete from a kernel worker. The
+// worker is shared, so an ASYNC READ/WRITE on a tty or pipe is refused with
+// -EAGAIN; submit it without the flag to run it in the caller.
+enum {
+    VOS_URING_OP_NOP   = 0,
+    VOS_URING_OP_READ  = 1,   // fd, addr = buffer, len, off
+    VOS_URING_OP_WRITE = 2,   // fd, addr = buffer, len, off
+    VOS_URING_OP_OPEN  = 3,   // addr = path, op_flags = O_* flags
+    VOS_URING_OP_CLOSE = 4,   // fd
+    VOS_URING_OP_STAT  = 5,   // addr = path, off = struct stat*
+    VOS_URING_OP_FSTAT = 6,   // fd, addr = struct stat*
+    VOS_URING_OP_FSYNC = 7,   // fd
+};
+
+#define VOS_URING_SQE_ASYNC  0x01u
+#define VOS_URING_OFF_CUR    0xFFFFFFFFu   // use (and advance) the file position
+#define VOS_URING_GETEVENTS  0x01u
+
+typedef struct vos_uring {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    volatile uint32_t cq_overflow;
+    uint32_t reserved;
+} vos_uring_t;
+
+typedef struct vos_uring_sqe {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t fd;
+    uint32_t off;
+    uint32_t addr;
+    uint32_t len;
+    uint32_t op_flags;
+    uint64_t user_data;
+} vos_uring_sqe_t;
+
+typedef struct vos_uring_cqe {
+    uint64_t user_data;
+    int32_t res;
+    uint32_t flags;
+} vos_uring_cqe_t;
+
+#define VOS_URING_SIZE(sq, cq) \
+    (sizeof(vos_uring_t) + (sq) * sizeof(vos_uring_sqe_t) + (cq) * sizeof(vos_uring_cqe_t))
+
+static inline vos_uring_sqe_t* vos_uring_sqes(vos_uring_t* ring) {
+    return (vos_uring_sqe_t*)(ring + 1);
+}
+
+static inline vos_uring_cqe_t* vos_uring_cqes(vos_uring_t* ring) {
+    return (vos_uring_cqe_t*)(vos_uring_sqes(ring) + ring->sq_entries);
+}
+
+// Entry counts must be powers of two; cq_entries 0 means 2 * sq_entries.
+static inline int sys_uring_setup(vos_uring_t* ring, unsigned int sq_entries, unsigned int cq_entries) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_URING_SETUP), "b"(ring), "c"(sq_entries), "d"(cq_entries)
+        : "memory"
+    );
+    return ret;
+}
+
+// Returns the number of SQEs consumed, or -errno.
+static inline int sys_uring_enter(unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_URING_ENTER), "b"(to_submit), "c"(min_complete), "d"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_syscall_trace(int op, unsigned int arg0, unsigned int arg1) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SYSCALL_TRACE), "b"(op), "c"(arg0), "d"(arg1)
+        : "memory"
+    );
+    return ret;
+}
+
+// Start tracing `pid` (0 stops tracing).
+static inline int sys_strace_attach(int pid) {
+    return sys_syscall_trace(VOS_STRACE_ATTACH, (unsigned int)pid, 0);
+}
+
+// Returns the number of entries copied, or -errno.
+static inline int sys_strace_read(vos_strace_entry_t* out, unsigned int max) {
+    return sys_syscall_trace(VOS_STRACE_READ, (unsigned int)out, max);
+}
+
+static inline int sys_syscall_hist(unsigned int num, uint32_t out[VOS_STRACE_HIST_BUCKETS]) {
+    return sys_syscall_trace(VOS_STRACE_HIST, num, (unsigned int)out);
+}
+
+static inline int sys_readv(int fd, const vos_iovec_t* iov, int iovcnt) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_READV), "b"(fd), "c"(iov), "d"(iovcnt)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_writev(int fd, const vos_iovec_t* iov, int iovcnt) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_WRITEV), "b"(fd), "c"(iov), "d"(iovcnt)
+        : "memory"
+    );
+    return ret;
+}
+
+// Read/write at `off` without moving the file position.
+static inline int sys_pread(int fd, void* buf, uint32_t len, int32_t off) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_PREAD), "b"(fd), "c"(buf), "d"(len), "S"(off)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_pwrite(int fd, const void* buf, uint32_t len, int32_t off) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_PWRITE), "b"(fd), "c"(buf), "d"(len), "S"(off)
+        : "memory"
+    );
+    return ret;
+}
+
+// Copy up to `count` bytes from file `in_fd` to `out_fd` inside the kernel.
+// A non-NULL `off` is used and advanced instead of in_fd's position.
+static inline int sys_sendfile(int out_fd, int in_fd, int32_t* off, uint32_t count) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SENDFILE), "b"(out_fd), "c"(in_fd), "d"(off), "S"(count)
+        : "memory"
+    );
+    return ret;
+}
+
+// Like sendfile, but one side must be a pipe (either direction).
+static inline int sys_splice(int in_fd, int32_t* in_off, int out_fd, int32_t* out_off, uint32_t len) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_SPLICE), "b"(in_fd), "c"(in_off), "d"(out_fd), "S"(out_off), "D"(len)
+        : "memory"
+    );
+    return ret;
+}
+
+// Fill `buf` with directory records; returns bytes used, 0 at the end.
+static inline int sys_getdents(int fd, void* buf, uint32_t len) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_GETDENTS), "b"(fd), "c"(buf), "d"(len)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_openat(int dirfd, const char* path, uint32_t flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_OPENAT), "b"(dirfd), "c"(path), "d"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_fstatat(int dirfd, const char* path, void* st, uint32_t flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_FSTATAT), "b"(dirfd), "c"(path), "d"(st), "S"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_mkdirat(int dirfd, const char* path) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_MKDIRAT), "b"(dirfd), "c"(path)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_unlinkat(int dirfd, const char* path, uint32_t flags) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_UNLINKAT), "b"(dirfd), "c"(path), "d"(flags)
+        : "memory"
+    );
+    return ret;
+}
+
+static inline int sys_renameat(int olddirfd, const char* oldp, int newdirfd, const char* newp) {
+    int ret;
+    __asm__ volatile (
+        VOS_SYSCALL
+        : "=a"(ret)
+        : "a"(SYS_RENAMEAT), "b"(olddirfd), "c"(oldp), "d"(newdirfd), "S"(newp)
+        : "memory"
+    );
+    return ret;
+}
+
 #endif
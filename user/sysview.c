@@ -4,6 +4,7 @@
 #define TB_IMPL
 #include <termbox2.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -60,6 +61,28 @@ static const char* view_names[] = {
 static vos_syscall_stats_t prev_stats = {0};
 static int have_prev_stats = 0;
 
+// Process table, fetched once per refresh. The buffer grows to fit.
+static vos_task_stat_t* tasks = NULL;
+static int tasks_cap = 0;
+
+static int load_tasks(void) {
+    for (;;) {
+        int n = vos_task_snapshot_all(tasks, (uint32_t)tasks_cap);
+        if (n < 0) {
+            return 0;
+        }
+        if (n <= tasks_cap) {
+            return n;
+        }
+        vos_task_stat_t* grown = realloc(tasks, (size_t)(n + 8) * sizeof(*tasks));
+        if (!grown) {
+            return tasks_cap;   // show what fits
+        }
+        tasks = grown;
+        tasks_cap = n + 8;
+    }
+}
+
 // Helper to draw a string at position
 static void draw_str(int x, int y, uintattr_t fg, const char* str) {
     tb_print(x, y, fg, C_BG, str);
@@ -248,6 +271,15 @@ static void draw_dashboard(void) {
     draw_fmt(col2 + 2, row + 6, C_LABEL, "Ctx Sw:");
     draw_fmt(col2 + 11, row + 6, C_VALUE, "%lu", (unsigned long)sched.context_switches);
 
+    draw_fmt(col2 + 2, row + 7, C_LABEL, "KStacks:");
+    draw_fmt(col2 + 11, row + 7, C_VALUE, "%lu used, %lu cached",
+             (unsigned long)sched.kstacks_in_use, (unsigned long)sched.kstacks_cached);
+    uintattr_t kstk_color = C_VALUE;
+    if (sched.kstack_max_depth >= sched.kstack_size / 4 * 3) kstk_color = C_BAD;
+    draw_fmt(col2 + 2, row + 8, C_LABEL, "KStk max:");
+    draw_fmt(col2 + 12, row + 8, kstk_color, "%lu / %lu B",
+             (unsigned long)sched.kstack_max_depth, (unsigned long)sched.kstack_size);
+
     // === PROCESSES BOX ===
     row = 14;
     int proc_h = height - row - 1;
@@ -265,12 +297,11 @@ static void draw_dashboard(void) {
     draw_hline(col1 + 2, row + 4, width - 6, C_DIM);
 
     int cur_pid = getpid();
-    int count = sys_task_count();
+    int count = load_tasks();
     int max_procs = proc_h - 6;
 
     for (int i = 0; i < count && i < max_procs; i++) {
-        vos_task_info_t ti;
-        if (sys_task_info(i, &ti) < 0) continue;
+        const vos_task_info_t ti = tasks[i].info;
 
         const char* st;
         uintattr_t sc;
@@ -374,16 +405,15 @@ static void draw_processes(void) {
     draw_fmt(44, row + 1, C_DIM, "Waiting:%lu", (unsigned long)sched.waiting);
     draw_fmt(57, row + 1, C_BAD, "Zombie:%lu", (unsigned long)sched.zombie);
 
-    draw_str(3, row + 3, C_DIM, "  PID  TYPE  STATE   CPU TICKS   EIP        ESP        NAME");
+    draw_str(3, row + 3, C_DIM, "  PID  TYPE  STATE   CPU TICKS   EIP        ESP        RSS(K)  NAME");
     draw_hline(3, row + 4, width - 8, C_DIM);
 
     int cur_pid = getpid();
-    int count = sys_task_count();
+    int count = load_tasks();
     int max = height - row - 6;
 
     for (int i = 0; i < count && i < max; i++) {
-        vos_task_info_t ti;
-        if (sys_task_info(i, &ti) < 0) continue;
+        const vos_task_info_t ti = tasks[i].info;
 
         const char* st;
         uintattr_t sc;
@@ -404,7 +434,8 @@ static void draw_processes(void) {
         draw_fmt(23, row + 5 + i, C_DIM, "%-10lu", (unsigned long)ti.cpu_ticks);
         draw_fmt(34, row + 5 + i, C_DIM, "0x%08lx", (unsigned long)ti.eip);
         draw_fmt(45, row + 5 + i, C_DIM, "0x%08lx", (unsigned long)ti.esp);
-        draw_str(56, row + 5 + i, C_VALUE, ti.name);
+        draw_fmt(56, row + 5 + i, C_DIM, "%-7lu", (unsigned long)tasks[i].rss_pages * 4u);
+        draw_str(64, row + 5 + i, C_VALUE, ti.name);
     }
 }
 
@@ -444,6 +475,9 @@ static void draw_interrupts(void) {
 static void draw_syscalls(void) {
     vos_syscall_stats_t stats;
     sys_syscall_stats(&stats);
+    if (stats.num_syscalls > VOS_SYSCALL_STATS_MAX) {
+        stats.num_syscalls = VOS_SYSCALL_STATS_MAX;
+    }
 
     int row = 3;
     draw_box(1, row, width - 2, height - 4, C_BOX, "SYSCALL ACTIVITY");
@@ -459,8 +493,8 @@ static void draw_syscalls(void) {
 
     draw_str(3, row + 2, C_DIM, "Watch syscalls in real-time! Compile a C program to see activity.");
 
-    draw_str(3, row + 4, C_DIM, "#    Name            Count       Delta");
-    draw_hline(3, row + 5, 50, C_DIM);
+    draw_str(3, row + 4, C_DIM, "#    Name            Count       Delta     Avg us    Max us");
+    draw_hline(3, row + 5, 70, C_DIM);
 
     int displayed = 0;
     int max = height - row - 8;
@@ -479,6 +513,13 @@ static void draw_syscalls(void) {
             if (delta > 0) {
                 draw_fmt(40, row + 6 + displayed, C_GOOD, "+%lu", (unsigned long)delta);
             }
+            if (stats.tsc_khz) {
+                // Blocking calls include the time they spent asleep.
+                uint64_t avg_us = stats.total_cycles[i] * 1000u / stats.tsc_khz / stats.counts[i];
+                uint64_t max_us = stats.max_cycles[i] * 1000u / stats.tsc_khz;
+                draw_fmt(50, row + 6 + displayed, C_VALUE, "%-8lu  %lu",
+                         (unsigned long)avg_us, (unsigned long)max_us);
+            }
             displayed++;
         }
     }
@@ -498,6 +539,14 @@ static void draw_disks(void) {
     draw_fmt(3, row + 1, C_LABEL, "Total Mounts:");
     draw_fmt(18, row + 1, C_VALUE, "%lu", (unsigned long)disks.count);
 
+    uint32_t lookups = disks.cache_hits + disks.cache_misses;
+    uint32_t hit_pct = lookups ? (uint32_t)((uint64_t)disks.cache_hits * 100u / lookups) : 0;
+    draw_fmt(24, row + 1, C_LABEL, "Cache:");
+    draw_fmt(31, row + 1, C_VALUE, "%lu%% hits (%lu/%lu)  dirty %lu/%lu  written %lu",
+             (unsigned long)hit_pct, (unsigned long)disks.cache_hits, (unsigned long)lookups,
+             (unsigned long)disks.cache_dirty, (unsigned long)disks.cache_buffers,
+             (unsigned long)disks.cache_writebacks);
+
     draw_str(3, row + 3, C_DIM, "Mount Point      Type       Total       Used       Free      Use%");
     draw_hline(3, row + 4, 70, C_DIM);
 
@@ -597,7 +646,7 @@ static void draw_help(void) {
     y++;
 
     draw_str(3, y++, C_LABEL, "[SYSCALLS]");
-    draw_str(3, y++, C_DIM, "User programs use 'int 0x80' to request kernel services.");
+    draw_str(3, y++, C_DIM, "User programs enter via SYSENTER (int 0x80 fallback) for kernel services.");
     draw_str(3, y++, C_DIM, "Examples: read(), write(), fork(), execve(), mmap()");
     y++;
 
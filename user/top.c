@@ -1,5 +1,6 @@
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <termios.h>
 #include <unistd.h>
@@ -16,35 +17,103 @@ static const char* state_str(uint32_t state) {
     }
 }
 
+// One snapshot per refresh; %CPU is the tick delta against the previous one.
+// The buffers grow to fit the task list.
+static vos_task_stat_t* tasks = NULL;
+static uint32_t* prev_pid = NULL;
+static uint32_t* prev_ticks = NULL;
+static int tasks_cap = 0;
+static int prev_count = 0;
+static uint32_t prev_now = 0;
+
+static int grow_tasks(int cap) {
+    vos_task_stat_t* t = realloc(tasks, (size_t)cap * sizeof(*tasks));
+    if (!t) {
+        return -ENOMEM;
+    }
+    tasks = t;
+    uint32_t* p = realloc(prev_pid, (size_t)cap * sizeof(*prev_pid));
+    if (!p) {
+        return -ENOMEM;
+    }
+    prev_pid = p;
+    p = realloc(prev_ticks, (size_t)cap * sizeof(*prev_ticks));
+    if (!p) {
+        return -ENOMEM;
+    }
+    prev_ticks = p;
+    tasks_cap = cap;
+    return 0;
+}
+
+static int load_tasks(void) {
+    for (;;) {
+        int total = vos_task_snapshot_all(tasks, (uint32_t)tasks_cap);
+        if (total < 0 || total <= tasks_cap) {
+            return total;
+        }
+        int rc = grow_tasks(total + 8);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+}
+
+static uint32_t prev_cpu_ticks(uint32_t pid) {
+    for (int i = 0; i < prev_count; i++) {
+        if (prev_pid[i] == pid) {
+            return prev_ticks[i];
+        }
+    }
+    return 0;
+}
+
 static int print_ps_once(void) {
-    int count = sys_task_count();
+    int count = load_tasks();
     if (count < 0) {
         errno = -count;
         fprintf(stderr, "top: %s\n", strerror(errno));
         return -1;
     }
 
+    vos_timer_info_t timer;
+    if (sys_timer_info(&timer) < 0) {
+        timer.ticks = 0;
+        timer.hz = 0;
+    }
+    uint32_t elapsed = timer.ticks - prev_now;
+
     int cur = getpid();
-    puts("PID   USER  STATE  TICKS    EIP       NAME");
-    for (uint32_t i = 0; i < (uint32_t)count; i++) {
-        vos_task_info_t ti;
-        if (sys_task_info(i, &ti) < 0) {
-            continue;
-        }
+    puts("PID   USER  STATE  %CPU  TIME(s)  RSS(K)  NAME");
+    for (int i = 0; i < count; i++) {
+        const vos_task_stat_t* t = &tasks[i];
+        const vos_task_info_t* ti = &t->info;
 
-        const char* user = ti.user ? "user" : "kern";
-        const char* st = state_str(ti.state);
-        char mark = (ti.pid == (uint32_t)cur) ? '*' : ' ';
+        const char* user = ti->user ? "user" : "kern";
+        const char* st = state_str(ti->state);
+        char mark = (ti->pid == (uint32_t)cur) ? '*' : ' ';
 
-        printf("%c%-4lu %-5s %-5s %-8lu 0x%08lx %s\n",
+        uint32_t used = ti->cpu_ticks - prev_cpu_ticks(ti->pid);
+        unsigned long pct = (prev_now != 0 && elapsed != 0) ? (unsigned long)(used * 100u / elapsed) : 0;
+        unsigned long secs = timer.hz ? (unsigned long)(ti->cpu_ticks / timer.hz) : 0;
+
+        printf("%c%-4lu %-5s %-5s %4lu  %7lu  %6lu  %s\n",
                mark,
-               (unsigned long)ti.pid,
+               (unsigned long)ti->pid,
                user,
                st,
-               (unsigned long)ti.cpu_ticks,
-               (unsigned long)ti.eip,
-               ti.name);
+               pct,
+               secs,
+               (unsigned long)t->rss_pages * 4u,
+               ti->name);
+    }
+
+    for (int i = 0; i < count; i++) {
+        prev_pid[i] = tasks[i].info.pid;
+        prev_ticks[i] = tasks[i].info.cpu_ticks;
     }
+    prev_count = count;
+    prev_now = timer.ticks;
     return 0;
 }
 
@@ -61,17 +61,20 @@ static int read_dir(const char* path, bool show_all, tree_entry_t** out_ents, si
             cap = new_cap;
         }
 
-        char full[512];
-        if (strcmp(path, "/") == 0) {
-            snprintf(full, sizeof(full), "/%s", name);
-        } else {
-            snprintf(full, sizeof(full), "%s/%s", path, name);
-        }
+        // readdir() reports the type; only fall back to lstat() without it.
+        bool is_dir = (de->d_type == DT_DIR);
+        if (de->d_type == DT_UNKNOWN) {
+            char full[512];
+            if (strcmp(path, "/") == 0) {
+                snprintf(full, sizeof(full), "/%s", name);
+            } else {
+                snprintf(full, sizeof(full), "%s/%s", path, name);
+            }
 
-        struct stat st;
-        bool is_dir = false;
-        if (lstat(full, &st) == 0) {
-            is_dir = S_ISDIR(st.st_mode);
+            struct stat st;
+            if (lstat(full, &st) == 0) {
+                is_dir = S_ISDIR(st.st_mode);
+            }
         }
 
         ents[count].name = strdup(name);
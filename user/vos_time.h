@@ -0,0 +1,85 @@
+#ifndef USER_VOS_TIME_H
+#define USER_VOS_TIME_H
+
+#include <stdint.h>
+
+// Kernel time page: mapped read-only into every process and updated on each
+// timer tick, so clocks can be read without a syscall. This is the only
+// user-side copy of the layout (syscall.h and the newlib glue both include
+// it); keep it in sync with include/vdso.h.
+#define VOS_TIME_PAGE          0xED000000u
+#define VOS_TIME_PAGE_VERSION  1u
+#define VOS_TIME_TSC           0x1u
+#define VOS_TIME_REALTIME      0x2u
+
+typedef struct vos_time_page {
+    volatile uint32_t seq;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t ns_per_tick;
+    uint64_t ticks;
+    uint64_t tick_tsc;
+    uint32_t tsc_per_tick;
+    uint32_t tsc_mult;
+    uint32_t tsc_shift;
+    uint32_t reserved;
+    uint64_t realtime_base_ns;
+} vos_time_page_t;
+
+// Nanoseconds since boot (and, if `realtime` is non-NULL, since the epoch).
+// Returns 0, or -1 if the page is unusable and callers should fall back to
+// SYS_CLOCK_GETTIME.
+static inline int vos_time_read(uint64_t* monotonic, uint64_t* realtime) {
+    const vos_time_page_t* tp = (const vos_time_page_t*)VOS_TIME_PAGE;
+    if (tp->version != VOS_TIME_PAGE_VERSION) {
+        return -1;
+    }
+
+    uint32_t seq, flags, ns_per_tick, tsc_per_tick, tsc_mult, tsc_shift;
+    uint64_t ticks, tick_tsc, base, now_tsc = 0;
+    do {
+        seq = tp->seq;
+        __asm__ volatile ("" ::: "memory");
+        flags = tp->flags;
+        ns_per_tick = tp->ns_per_tick;
+        ticks = tp->ticks;
+        tick_tsc = tp->tick_tsc;
+        tsc_per_tick = tp->tsc_per_tick;
+        tsc_mult = tp->tsc_mult;
+        tsc_shift = tp->tsc_shift;
+        base = tp->realtime_base_ns;
+        if (flags & VOS_TIME_TSC) {
+            uint32_t lo, hi;
+            __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+            now_tsc = ((uint64_t)hi << 32) | lo;
+        }
+        __asm__ volatile ("" ::: "memory");
+    } while ((seq & 1u) || tp->seq != seq);
+
+    // Same interpolation as the kernel: never more than one tick ahead.
+    uint32_t frac = 0;
+    if (flags & VOS_TIME_TSC) {
+        uint64_t cycles = now_tsc - tick_tsc;
+        frac = ns_per_tick;
+        if (cycles < tsc_per_tick) {
+            uint32_t ns = (uint32_t)(((uint64_t)(uint32_t)cycles * tsc_mult) >> tsc_shift);
+            if (ns < frac) {
+                frac = ns;
+            }
+        }
+    }
+
+    uint64_t mono = ticks * ns_per_tick + frac;
+    if (monotonic) {
+        *monotonic = mono;
+    }
+    if (realtime) {
+        if (!(flags & VOS_TIME_REALTIME)) {
+            return -1;
+        }
+        *realtime = base + mono;
+    }
+    return 0;
+}
+
+#endif